@@ -0,0 +1,100 @@
+//
+//  SQRLBundleDifference.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// The key in a change for the path of the changed item, relative to the roots
+// of the trees being compared.
+extern NSString * const SQRLBundleDifferenceChangePathKey;
+
+// The key in a change for how the item changed, one of the
+// `SQRLBundleDifferenceChangeKind` constants.
+extern NSString * const SQRLBundleDifferenceChangeKindKey;
+
+// The key in a change for the inode number of the target item before the
+// change was applied. Only present for replacements.
+extern NSString * const SQRLBundleDifferenceChangeTargetInodeKey;
+
+// The key in a change for the permissions, ownership, flags, and extended
+// attributes of the target directory before the change was applied. Only
+// present for attribute changes.
+extern NSString * const SQRLBundleDifferenceChangeTargetMetadataKey;
+
+// The item exists in both trees, but differs.
+extern NSString * const SQRLBundleDifferenceChangeKindReplace;
+
+// The item only exists in the source tree.
+extern NSString * const SQRLBundleDifferenceChangeKindAdd;
+
+// The item only exists in the target tree.
+extern NSString * const SQRLBundleDifferenceChangeKindRemove;
+
+// The item is a directory in both trees, but its permissions, ownership,
+// flags, or extended attributes differ.
+extern NSString * const SQRLBundleDifferenceChangeKindAttributes;
+
+// Updates a tree in place to match another on the same volume, by renaming
+// only the items that differ between them.
+//
+// Each change to an item is a single atomic rename, and moves the replaced item
+// into the source tree, so the source tree ends up holding everything needed to
+// revert. Changes to a directory's metadata record what they replaced instead.
+// Changes are JSON-compatible dictionaries, so they can be journaled before
+// they're applied.
+//
+// Items beneath an added, removed, or replaced directory are carried along
+// with it, rather than being changed individually. Directories that exist in
+// both trees are never moved, but are given the source's metadata once
+// everything within them has been changed.
+@interface SQRLBundleDifference : NSObject
+
+// Initializes the receiver to compare the given trees.
+//
+// targetURL - The tree to update in place. This must not be nil.
+// sourceURL - The tree to update it from, which must be on the same volume as
+//             `targetURL`. This must not be nil.
+- (instancetype)initWithTargetURL:(NSURL *)targetURL sourceURL:(NSURL *)sourceURL;
+
+// The tree to update in place.
+@property (nonatomic, copy, readonly) NSURL *targetURL;
+
+// The tree to update it from.
+@property (nonatomic, copy, readonly) NSURL *sourceURL;
+
+// Compares the trees, reading the contents of files that might be equal.
+//
+// Items are only equal if their type, permissions, owner, group, file flags,
+// and extended attributes are, as well as their contents.
+//
+// Returns a signal which sends an array of changes then completes, or errors,
+// on a background thread.
+- (RACSignal *)changes;
+
+// Applies changes from -changes, leaving the target tree matching the source.
+//
+// changes - The changes to apply. This must not be nil.
+//
+// Returns a signal which synchronously completes, or errors in
+// `NSPOSIXErrorDomain` after applying some of the changes.
+- (RACSignal *)applyChanges:(NSArray *)changes;
+
+// Reverts changes from -applyChanges:, whether or not they were all applied.
+//
+// Whether each change was applied is determined from the trees, so this is
+// safe to run after being interrupted partway through either applying or
+// reverting.
+//
+// changes - The changes to revert. This must not be nil.
+//
+// Returns a signal which synchronously completes, or errors in
+// `NSPOSIXErrorDomain`.
+- (RACSignal *)revertChanges:(NSArray *)changes;
+
+@end
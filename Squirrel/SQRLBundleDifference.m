@@ -0,0 +1,549 @@
+//
+//  SQRLBundleDifference.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLBundleDifference.h"
+
+#import <ReactiveObjC/EXTScope.h>
+#import <ReactiveObjC/RACSignal+Operations.h>
+#import <fcntl.h>
+#import <stdio.h>
+#import <sys/stat.h>
+#import <sys/xattr.h>
+#import <unistd.h>
+
+#import "SQRLFileTreeWalker.h"
+
+NSString * const SQRLBundleDifferenceChangePathKey = @"path";
+NSString * const SQRLBundleDifferenceChangeKindKey = @"kind";
+NSString * const SQRLBundleDifferenceChangeTargetInodeKey = @"targetInode";
+NSString * const SQRLBundleDifferenceChangeTargetMetadataKey = @"targetMetadata";
+
+NSString * const SQRLBundleDifferenceChangeKindReplace = @"replace";
+NSString * const SQRLBundleDifferenceChangeKindAdd = @"add";
+NSString * const SQRLBundleDifferenceChangeKindRemove = @"remove";
+NSString * const SQRLBundleDifferenceChangeKindAttributes = @"attributes";
+
+// Keys in the metadata of a directory.
+static NSString * const SQRLBundleDifferenceMetadataModeKey = @"mode";
+static NSString * const SQRLBundleDifferenceMetadataOwnerKey = @"uid";
+static NSString * const SQRLBundleDifferenceMetadataGroupKey = @"gid";
+static NSString * const SQRLBundleDifferenceMetadataFlagsKey = @"flags";
+static NSString * const SQRLBundleDifferenceMetadataExtendedAttributesKey = @"xattrs";
+
+// The size of the buffers used to compare file contents.
+static const size_t SQRLBundleDifferenceComparisonBufferSize = 1024 * 1024;
+
+// The file flags that are compared and copied. Others, like UF_COMPRESSED,
+// describe how an item is stored rather than the item itself.
+static const u_int32_t SQRLBundleDifferenceComparedFlags = UF_NODUMP | UF_IMMUTABLE | UF_APPEND | UF_OPAQUE | UF_HIDDEN;
+
+@interface SQRLBundleDifference ()
+
+// Finds the change needed to make the target item at `path` match the source
+// item, if any.
+//
+// path     - The path of an item in the source tree, relative to `sourceURL`.
+//            This must not be nil.
+// errorRef - If not NULL, set to any error that occurs.
+//
+// Returns the change, NSNull if none is needed, or nil if an error occurred.
+- (id)changeForSourceItemAtPath:(NSString *)path error:(NSError **)errorRef;
+
+// Whether the regular files at the given paths have the same contents.
+- (BOOL)isFileAtPath:(NSString *)firstPath equalToFileAtPath:(NSString *)secondPath error:(NSError **)errorRef;
+
+// Whether the symbolic links at the given paths point to the same place.
+- (BOOL)isLinkAtPath:(NSString *)firstPath equalToLinkAtPath:(NSString *)secondPath;
+
+// Creates an error in `NSPOSIXErrorDomain` for the given path.
+- (NSError *)errorForPOSIXCode:(int)code path:(NSString *)path;
+
+@end
+
+// Returns whether the item at `path` is a directory, without following
+// symbolic links.
+static BOOL SQRLBundleDifferenceIsDirectory(NSString *path) {
+	struct stat info;
+	return lstat(path.fileSystemRepresentation, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// Returns whether an item exists at `path`, without following symbolic links.
+static BOOL SQRLBundleDifferenceItemExists(NSString *path) {
+	struct stat info;
+	return lstat(path.fileSystemRepresentation, &info) == 0;
+}
+
+// Reads the extended attributes of the item at `path`, without following
+// symbolic links.
+//
+// Returns a dictionary of attribute names to `NSData` values, or nil if they
+// couldn't be read.
+static NSDictionary *SQRLBundleDifferenceExtendedAttributes(NSString *path) {
+	const char *fileSystemPath = path.fileSystemRepresentation;
+
+	ssize_t namesLength = listxattr(fileSystemPath, NULL, 0, XATTR_NOFOLLOW);
+	if (namesLength < 0) return nil;
+	if (namesLength == 0) return @{};
+
+	NSMutableData *names = [NSMutableData dataWithLength:(NSUInteger)namesLength];
+	namesLength = listxattr(fileSystemPath, names.mutableBytes, names.length, XATTR_NOFOLLOW);
+	if (namesLength < 0) return nil;
+
+	NSMutableDictionary *attributes = [NSMutableDictionary dictionary];
+	const char *name = names.bytes;
+	const char *namesEnd = name + namesLength;
+
+	for (; name < namesEnd; name += strlen(name) + 1) {
+		ssize_t valueLength = getxattr(fileSystemPath, name, NULL, 0, 0, XATTR_NOFOLLOW);
+		if (valueLength < 0) return nil;
+
+		NSMutableData *value = [NSMutableData dataWithLength:(NSUInteger)valueLength];
+		if (valueLength > 0 && getxattr(fileSystemPath, name, value.mutableBytes, value.length, 0, XATTR_NOFOLLOW) != valueLength) return nil;
+
+		attributes[@(name)] = value;
+	}
+
+	return attributes;
+}
+
+// Returns whether two items have the same permissions, ownership, flags, and
+// extended attributes.
+static BOOL SQRLBundleDifferenceHasSameMetadata(NSString *firstPath, const struct stat *firstInfo, NSString *secondPath, const struct stat *secondInfo) {
+	// Symbolic links' permissions are never used.
+	if (!S_ISLNK(firstInfo->st_mode) && (firstInfo->st_mode & ALLPERMS) != (secondInfo->st_mode & ALLPERMS)) return NO;
+	if (firstInfo->st_uid != secondInfo->st_uid || firstInfo->st_gid != secondInfo->st_gid) return NO;
+	if ((firstInfo->st_flags & SQRLBundleDifferenceComparedFlags) != (secondInfo->st_flags & SQRLBundleDifferenceComparedFlags)) return NO;
+
+	NSDictionary *firstAttributes = SQRLBundleDifferenceExtendedAttributes(firstPath);
+	NSDictionary *secondAttributes = SQRLBundleDifferenceExtendedAttributes(secondPath);
+	return firstAttributes != nil && [firstAttributes isEqual:secondAttributes];
+}
+
+// Reads the metadata of the directory at `path` into a JSON-compatible
+// dictionary, or returns nil and sets `errno` if it couldn't be read.
+static NSDictionary *SQRLBundleDifferenceDirectoryMetadata(NSString *path) {
+	struct stat info;
+	if (lstat(path.fileSystemRepresentation, &info) != 0) return nil;
+
+	NSDictionary *attributes = SQRLBundleDifferenceExtendedAttributes(path);
+	if (attributes == nil) return nil;
+
+	NSMutableDictionary *encodedAttributes = [NSMutableDictionary dictionaryWithCapacity:attributes.count];
+	[attributes enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSData *value, BOOL *stop) {
+		encodedAttributes[name] = [value base64EncodedStringWithOptions:0];
+	}];
+
+	return @{
+		SQRLBundleDifferenceMetadataModeKey: @(info.st_mode & ALLPERMS),
+		SQRLBundleDifferenceMetadataOwnerKey: @(info.st_uid),
+		SQRLBundleDifferenceMetadataGroupKey: @(info.st_gid),
+		SQRLBundleDifferenceMetadataFlagsKey: @(info.st_flags & SQRLBundleDifferenceComparedFlags),
+		SQRLBundleDifferenceMetadataExtendedAttributesKey: encodedAttributes,
+	};
+}
+
+// Gives the directory at `path` the metadata from
+// SQRLBundleDifferenceDirectoryMetadata().
+//
+// Ownership can only be given away when running as root, so failing to change
+// it is logged rather than treated as an error.
+//
+// Returns whether the metadata was set. If not, `errno` is set to the reason.
+static BOOL SQRLBundleDifferenceSetDirectoryMetadata(NSString *path, NSDictionary *metadata) {
+	const char *fileSystemPath = path.fileSystemRepresentation;
+
+	struct stat info;
+	if (lstat(fileSystemPath, &info) != 0) return NO;
+
+	// Nothing else can be changed while the directory is immutable.
+	u_int32_t otherFlags = info.st_flags & ~SQRLBundleDifferenceComparedFlags;
+	if ((info.st_flags & (UF_IMMUTABLE | UF_APPEND)) != 0 && lchflags(fileSystemPath, otherFlags) != 0) return NO;
+
+	uid_t owner = (uid_t)[metadata[SQRLBundleDifferenceMetadataOwnerKey] unsignedIntValue];
+	gid_t group = (gid_t)[metadata[SQRLBundleDifferenceMetadataGroupKey] unsignedIntValue];
+	if ((info.st_uid != owner || info.st_gid != group) && lchown(fileSystemPath, owner, group) != 0) {
+		NSLog(@"Couldn't change the owner of %@ to %u:%u: %s", path, owner, group, strerror(errno));
+	}
+
+	mode_t mode = (mode_t)[metadata[SQRLBundleDifferenceMetadataModeKey] unsignedShortValue];
+	if (chmod(fileSystemPath, mode & ALLPERMS) != 0) return NO;
+
+	NSDictionary *encodedAttributes = metadata[SQRLBundleDifferenceMetadataExtendedAttributesKey];
+	NSDictionary *existingAttributes = SQRLBundleDifferenceExtendedAttributes(path);
+	if (existingAttributes == nil) return NO;
+
+	for (NSString *name in existingAttributes) {
+		if (encodedAttributes[name] != nil) continue;
+		if (removexattr(fileSystemPath, name.UTF8String, XATTR_NOFOLLOW) != 0 && errno != ENOATTR) return NO;
+	}
+
+	for (NSString *name in encodedAttributes) {
+		NSData *value = [[NSData alloc] initWithBase64EncodedString:encodedAttributes[name] options:0];
+		if (value == nil || [existingAttributes[name] isEqual:value]) continue;
+		if (setxattr(fileSystemPath, name.UTF8String, value.bytes, value.length, 0, XATTR_NOFOLLOW) != 0) return NO;
+	}
+
+	u_int32_t flags = (u_int32_t)[metadata[SQRLBundleDifferenceMetadataFlagsKey] unsignedIntValue] & SQRLBundleDifferenceComparedFlags;
+	return lchflags(fileSystemPath, otherFlags | flags) == 0;
+}
+
+// Orders attribute changes so that the deepest directories come first, and are
+// changed before their parents might become read-only.
+static NSArray *SQRLBundleDifferenceAttributeChangesDeepestFirst(NSArray *changes) {
+	NSPredicate *isAttributeChange = [NSPredicate predicateWithFormat:@"%K == %@", SQRLBundleDifferenceChangeKindKey, SQRLBundleDifferenceChangeKindAttributes];
+
+	return [[changes filteredArrayUsingPredicate:isAttributeChange] sortedArrayUsingComparator:^(NSDictionary *first, NSDictionary *second) {
+		NSUInteger firstDepth = [first[SQRLBundleDifferenceChangePathKey] pathComponents].count;
+		NSUInteger secondDepth = [second[SQRLBundleDifferenceChangePathKey] pathComponents].count;
+		return [@(secondDepth) compare:@(firstDepth)];
+	}];
+}
+
+@implementation SQRLBundleDifference
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithTargetURL:(NSURL *)targetURL sourceURL:(NSURL *)sourceURL {
+	NSParameterAssert(targetURL != nil);
+	NSParameterAssert(sourceURL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	// Standardized to match the URLs the walkers produce.
+	_targetURL = targetURL.URLByStandardizingPath;
+	_sourceURL = sourceURL.URLByStandardizingPath;
+
+	return self;
+}
+
+#pragma mark Comparison
+
+- (RACSignal *)changes {
+	return [[RACSignal
+		defer:^{
+			NSMutableArray *changes = [NSMutableArray array];
+			NSLock *changesLock = [[NSLock alloc] init];
+
+			NSString *sourcePath = self.sourceURL.path;
+			NSString *targetPath = self.targetURL.path;
+
+			SQRLFileTreeWalker *sourceWalker = [[SQRLFileTreeWalker alloc] initWithRootURL:self.sourceURL];
+			RACSignal *compareSource = [sourceWalker visitItemsWithBlock:^(NSURL *itemURL, NSError **error) {
+				// The roots are compared too, so that their metadata is
+				// updated.
+				NSString *path = (itemURL.path.length <= sourcePath.length ? @"" : [itemURL.path substringFromIndex:sourcePath.length + 1]);
+				id change = [self changeForSourceItemAtPath:path error:error];
+				if (change == nil) return NO;
+				if (change == NSNull.null) return YES;
+
+				[changesLock lock];
+				[changes addObject:change];
+				[changesLock unlock];
+
+				return YES;
+			}];
+
+			SQRLFileTreeWalker *targetWalker = [[SQRLFileTreeWalker alloc] initWithRootURL:self.targetURL];
+			RACSignal *findRemovals = [targetWalker visitItemsWithBlock:^(NSURL *itemURL, NSError **error) {
+				if (itemURL.path.length <= targetPath.length) return YES;
+
+				NSString *path = [itemURL.path substringFromIndex:targetPath.length + 1];
+				NSString *sourceItemPath = [sourcePath stringByAppendingPathComponent:path];
+
+				// Anything beneath a directory that's being removed or
+				// replaced goes along with it.
+				if (!SQRLBundleDifferenceIsDirectory(sourceItemPath.stringByDeletingLastPathComponent)) return YES;
+				if (SQRLBundleDifferenceItemExists(sourceItemPath)) return YES;
+
+				[changesLock lock];
+				[changes addObject:@{
+					SQRLBundleDifferenceChangePathKey: path,
+					SQRLBundleDifferenceChangeKindKey: SQRLBundleDifferenceChangeKindRemove,
+				}];
+				[changesLock unlock];
+
+				return YES;
+			}];
+
+			return [[RACSignal
+				merge:@[ compareSource, findRemovals ]]
+				then:^{
+					[changesLock lock];
+					NSArray *result = [changes copy];
+					[changesLock unlock];
+
+					return [RACSignal return:result];
+				}];
+		}]
+		setNameWithFormat:@"%@ -changes", self];
+}
+
+- (id)changeForSourceItemAtPath:(NSString *)path error:(NSError **)errorRef {
+	NSParameterAssert(path != nil);
+
+	NSString *sourceItemPath = [self.sourceURL.path stringByAppendingPathComponent:path];
+	NSString *targetItemPath = [self.targetURL.path stringByAppendingPathComponent:path];
+
+	// Anything beneath a directory that's being added or replaced goes along
+	// with it.
+	if (!SQRLBundleDifferenceIsDirectory(targetItemPath.stringByDeletingLastPathComponent)) return NSNull.null;
+
+	struct stat sourceInfo;
+	if (lstat(sourceItemPath.fileSystemRepresentation, &sourceInfo) != 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:sourceItemPath];
+		return nil;
+	}
+
+	struct stat targetInfo;
+	if (lstat(targetItemPath.fileSystemRepresentation, &targetInfo) != 0) {
+		if (errno != ENOENT) {
+			if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:targetItemPath];
+			return nil;
+		}
+
+		return @{
+			SQRLBundleDifferenceChangePathKey: path,
+			SQRLBundleDifferenceChangeKindKey: SQRLBundleDifferenceChangeKindAdd,
+		};
+	}
+
+	NSDictionary *replacement = @{
+		SQRLBundleDifferenceChangePathKey: path,
+		SQRLBundleDifferenceChangeKindKey: SQRLBundleDifferenceChangeKindReplace,
+		SQRLBundleDifferenceChangeTargetInodeKey: @(targetInfo.st_ino),
+	};
+
+	if ((sourceInfo.st_mode & S_IFMT) != (targetInfo.st_mode & S_IFMT)) return replacement;
+
+	BOOL sameMetadata = SQRLBundleDifferenceHasSameMetadata(sourceItemPath, &sourceInfo, targetItemPath, &targetInfo);
+
+	if (S_ISDIR(sourceInfo.st_mode)) {
+		if (sameMetadata) return NSNull.null;
+
+		NSDictionary *targetMetadata = SQRLBundleDifferenceDirectoryMetadata(targetItemPath);
+		if (targetMetadata == nil) {
+			if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:targetItemPath];
+			return nil;
+		}
+
+		return @{
+			SQRLBundleDifferenceChangePathKey: path,
+			SQRLBundleDifferenceChangeKindKey: SQRLBundleDifferenceChangeKindAttributes,
+			SQRLBundleDifferenceChangeTargetMetadataKey: targetMetadata,
+		};
+	}
+
+	if (!sameMetadata) return replacement;
+	if (S_ISLNK(sourceInfo.st_mode)) return [self isLinkAtPath:sourceItemPath equalToLinkAtPath:targetItemPath] ? NSNull.null : replacement;
+	if (!S_ISREG(sourceInfo.st_mode)) return replacement;
+
+	if (sourceInfo.st_size != targetInfo.st_size) return replacement;
+
+	NSError *error = nil;
+	if ([self isFileAtPath:sourceItemPath equalToFileAtPath:targetItemPath error:&error]) return NSNull.null;
+	if (error != nil) {
+		if (errorRef != NULL) *errorRef = error;
+		return nil;
+	}
+
+	return replacement;
+}
+
+- (BOOL)isFileAtPath:(NSString *)firstPath equalToFileAtPath:(NSString *)secondPath error:(NSError **)errorRef {
+	int firstFD = open(firstPath.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+	if (firstFD < 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:firstPath];
+		return NO;
+	}
+
+	@onExit {
+		close(firstFD);
+	};
+
+	int secondFD = open(secondPath.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+	if (secondFD < 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:secondPath];
+		return NO;
+	}
+
+	@onExit {
+		close(secondFD);
+	};
+
+	// Each file is only read once, so don't pollute the cache with it.
+	fcntl(firstFD, F_NOCACHE, 1);
+	fcntl(secondFD, F_NOCACHE, 1);
+
+	NSMutableData *firstBuffer = [NSMutableData dataWithLength:SQRLBundleDifferenceComparisonBufferSize];
+	NSMutableData *secondBuffer = [NSMutableData dataWithLength:SQRLBundleDifferenceComparisonBufferSize];
+
+	while (YES) {
+		ssize_t firstLength = read(firstFD, firstBuffer.mutableBytes, firstBuffer.length);
+		if (firstLength < 0) {
+			if (errno == EINTR) continue;
+			if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:firstPath];
+			return NO;
+		}
+
+		// Fill the same amount of the second buffer, so the two can be
+		// compared directly.
+		ssize_t secondLength = 0;
+		while (secondLength < firstLength) {
+			ssize_t length = read(secondFD, (char *)secondBuffer.mutableBytes + secondLength, (size_t)(firstLength - secondLength));
+			if (length < 0) {
+				if (errno == EINTR) continue;
+				if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno path:secondPath];
+				return NO;
+			}
+
+			if (length == 0) break;
+			secondLength += length;
+		}
+
+		if (secondLength != firstLength) return NO;
+		if (firstLength == 0) return YES;
+		if (memcmp(firstBuffer.bytes, secondBuffer.bytes, (size_t)firstLength) != 0) return NO;
+	}
+}
+
+- (BOOL)isLinkAtPath:(NSString *)firstPath equalToLinkAtPath:(NSString *)secondPath {
+	char firstDestination[PATH_MAX];
+	char secondDestination[PATH_MAX];
+
+	ssize_t firstLength = readlink(firstPath.fileSystemRepresentation, firstDestination, sizeof(firstDestination));
+	ssize_t secondLength = readlink(secondPath.fileSystemRepresentation, secondDestination, sizeof(secondDestination));
+	if (firstLength < 0 || secondLength < 0) return NO;
+
+	return firstLength == secondLength && memcmp(firstDestination, secondDestination, (size_t)firstLength) == 0;
+}
+
+#pragma mark Applying
+
+- (RACSignal *)applyChanges:(NSArray *)changes {
+	NSParameterAssert(changes != nil);
+
+	return [[RACSignal
+		defer:^{
+			for (NSDictionary *change in changes) {
+				NSString *path = change[SQRLBundleDifferenceChangePathKey];
+				NSString *kind = change[SQRLBundleDifferenceChangeKindKey];
+				NSString *sourceItemPath = [self.sourceURL.path stringByAppendingPathComponent:path];
+				NSString *targetItemPath = [self.targetURL.path stringByAppendingPathComponent:path];
+
+				int result = 0;
+				if ([kind isEqual:SQRLBundleDifferenceChangeKindReplace]) {
+					result = renamex_np(sourceItemPath.fileSystemRepresentation, targetItemPath.fileSystemRepresentation, RENAME_SWAP);
+				} else if ([kind isEqual:SQRLBundleDifferenceChangeKindAdd]) {
+					result = renamex_np(sourceItemPath.fileSystemRepresentation, targetItemPath.fileSystemRepresentation, RENAME_EXCL);
+				} else if ([kind isEqual:SQRLBundleDifferenceChangeKindRemove]) {
+					result = renamex_np(targetItemPath.fileSystemRepresentation, sourceItemPath.fileSystemRepresentation, RENAME_EXCL);
+				}
+
+				if (result != 0) return [RACSignal error:[self errorForPOSIXCode:errno path:targetItemPath]];
+			}
+
+			// Directories only take on their new metadata once nothing else
+			// needs to be moved into or out of them.
+			for (NSDictionary *change in SQRLBundleDifferenceAttributeChangesDeepestFirst(changes)) {
+				NSString *path = change[SQRLBundleDifferenceChangePathKey];
+				NSString *sourceItemPath = [self.sourceURL.path stringByAppendingPathComponent:path];
+				NSString *targetItemPath = [self.targetURL.path stringByAppendingPathComponent:path];
+
+				NSDictionary *sourceMetadata = SQRLBundleDifferenceDirectoryMetadata(sourceItemPath);
+				if (sourceMetadata == nil) return [RACSignal error:[self errorForPOSIXCode:errno path:sourceItemPath]];
+
+				if (!SQRLBundleDifferenceSetDirectoryMetadata(targetItemPath, sourceMetadata)) {
+					return [RACSignal error:[self errorForPOSIXCode:errno path:targetItemPath]];
+				}
+			}
+
+			NSLog(@"Applied %lu changes from %@ to %@", (unsigned long)changes.count, self.sourceURL, self.targetURL);
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"%@ -applyChanges: %lu", self, (unsigned long)changes.count];
+}
+
+- (RACSignal *)revertChanges:(NSArray *)changes {
+	NSParameterAssert(changes != nil);
+
+	return [[RACSignal
+		defer:^{
+			if (!SQRLBundleDifferenceItemExists(self.sourceURL.path)) {
+				// The install finished, and the replaced items were already
+				// deleted.
+				NSLog(@"Replaced items are no longer at %@, nothing to revert", self.sourceURL);
+				return [RACSignal empty];
+			}
+
+			// Setting the original metadata again is harmless if it was never
+			// changed, and makes directories writable again if they were
+			// originally.
+			for (NSDictionary *change in SQRLBundleDifferenceAttributeChangesDeepestFirst(changes).reverseObjectEnumerator) {
+				NSString *targetItemPath = [self.targetURL.path stringByAppendingPathComponent:change[SQRLBundleDifferenceChangePathKey]];
+				if (!SQRLBundleDifferenceSetDirectoryMetadata(targetItemPath, change[SQRLBundleDifferenceChangeTargetMetadataKey])) {
+					return [RACSignal error:[self errorForPOSIXCode:errno path:targetItemPath]];
+				}
+			}
+
+			for (NSDictionary *change in changes.reverseObjectEnumerator) {
+				NSString *path = change[SQRLBundleDifferenceChangePathKey];
+				NSString *kind = change[SQRLBundleDifferenceChangeKindKey];
+				NSString *sourceItemPath = [self.sourceURL.path stringByAppendingPathComponent:path];
+				NSString *targetItemPath = [self.targetURL.path stringByAppendingPathComponent:path];
+
+				struct stat targetInfo;
+				BOOL targetExists = lstat(targetItemPath.fileSystemRepresentation, &targetInfo) == 0;
+				BOOL sourceExists = SQRLBundleDifferenceItemExists(sourceItemPath);
+
+				int result = 0;
+				if ([kind isEqual:SQRLBundleDifferenceChangeKindReplace]) {
+					// If the original is still in place, this change was never
+					// applied.
+					ino_t targetInode = (ino_t)[change[SQRLBundleDifferenceChangeTargetInodeKey] unsignedLongLongValue];
+					if (targetExists && targetInfo.st_ino == targetInode) continue;
+
+					result = renamex_np(sourceItemPath.fileSystemRepresentation, targetItemPath.fileSystemRepresentation, RENAME_SWAP);
+				} else if ([kind isEqual:SQRLBundleDifferenceChangeKindAdd]) {
+					if (!targetExists || sourceExists) continue;
+
+					result = renamex_np(targetItemPath.fileSystemRepresentation, sourceItemPath.fileSystemRepresentation, RENAME_EXCL);
+				} else if ([kind isEqual:SQRLBundleDifferenceChangeKindRemove]) {
+					if (targetExists || !sourceExists) continue;
+
+					result = renamex_np(sourceItemPath.fileSystemRepresentation, targetItemPath.fileSystemRepresentation, RENAME_EXCL);
+				}
+
+				if (result != 0) return [RACSignal error:[self errorForPOSIXCode:errno path:targetItemPath]];
+			}
+
+			NSLog(@"Reverted %lu changes from %@ to %@", (unsigned long)changes.count, self.sourceURL, self.targetURL);
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"%@ -revertChanges: %lu", self, (unsigned long)changes.count];
+}
+
+#pragma mark Error Handling
+
+- (NSError *)errorForPOSIXCode:(int)code path:(NSString *)path {
+	NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+
+	const char *description = strerror(code);
+	if (description != NULL) userInfo[NSLocalizedDescriptionKey] = @(description);
+	if (path != nil) userInfo[NSFilePathErrorKey] = path;
+
+	return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo];
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ targetURL: %@, sourceURL: %@ }", self.class, self, self.targetURL, self.sourceURL];
+}
+
+@end
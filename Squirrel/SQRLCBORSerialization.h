@@ -0,0 +1,47 @@
+//
+//  SQRLCBORSerialization.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// The content type of CBOR documents.
+extern NSString * const SQRLCBORContentType;
+
+// Converts between CBOR (RFC 8949) and the same objects that
+// `NSJSONSerialization` uses, so that a compact binary document can stand in
+// for JSON anywhere it's read.
+//
+// Byte strings become `NSData`, which JSON has no equivalent of. Tags are
+// dropped, leaving the tagged value, and `undefined` becomes `NSNull`.
+//
+// Decoding reads directly from the given data, without copying it or building
+// any intermediate representation, so a document mapped from a file is decoded
+// straight from the mapping.
+@interface SQRLCBORSerialization : NSObject
+
+// Decodes a CBOR document.
+//
+// data  - The CBOR document, which must hold exactly one data item. This must
+//         not be nil.
+// error - If not NULL, set to any error that occurs.
+//
+// Returns the decoded object, or nil if the data isn't valid CBOR, has maps
+// with keys that aren't text strings, or nests containers and tags more
+// deeply than a JSON parser would allow containers.
++ (id)objectWithData:(NSData *)data error:(NSError **)error;
+
+// Encodes an object as CBOR, using the shortest encoding of each length and
+// integer.
+//
+// object - A dictionary with string keys, array, string, number, `NSData`, or
+//          `NSNull`, or any nesting of those. This must not be nil.
+// error  - If not NULL, set to any error that occurs.
+//
+// Returns the CBOR document, or nil if the object can't be encoded.
++ (NSData *)dataWithObject:(id)object error:(NSError **)error;
+
+@end
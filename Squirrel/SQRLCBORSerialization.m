@@ -0,0 +1,415 @@
+//
+//  SQRLCBORSerialization.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLCBORSerialization.h"
+
+NSString * const SQRLCBORContentType = @"application/cbor";
+
+// The major types of CBOR data items.
+enum {
+	SQRLCBORMajorTypeUnsignedInteger = 0,
+	SQRLCBORMajorTypeNegativeInteger = 1,
+	SQRLCBORMajorTypeByteString = 2,
+	SQRLCBORMajorTypeTextString = 3,
+	SQRLCBORMajorTypeArray = 4,
+	SQRLCBORMajorTypeMap = 5,
+	SQRLCBORMajorTypeTag = 6,
+	SQRLCBORMajorTypeSimple = 7,
+};
+
+// The additional information for an indefinite length.
+static const uint8_t SQRLCBORIndefiniteLength = 31;
+
+// The byte ending an item of indefinite length.
+static const uint8_t SQRLCBORBreak = 0xff;
+
+// How deeply arrays and maps may nest, matching NSJSONSerialization.
+static const NSUInteger SQRLCBORMaximumDepth = 512;
+
+// A position within the CBOR being decoded.
+typedef struct {
+	__unsafe_unretained NSData *data;
+	const uint8_t *bytes;
+	NSUInteger length;
+	NSUInteger offset;
+	NSUInteger depth;
+} SQRLCBORCursor;
+
+// Reads the head of a data item.
+//
+// majorType  - Set to the item's major type.
+// info       - Set to the item's additional information.
+// argument   - Set to the item's argument, or 0 for an indefinite length.
+//
+// Returns whether a valid head was read.
+static BOOL SQRLCBORReadHead(SQRLCBORCursor *cursor, uint8_t *majorType, uint8_t *info, uint64_t *argument) {
+	if (cursor->offset >= cursor->length) return NO;
+
+	uint8_t initialByte = cursor->bytes[cursor->offset++];
+	*majorType = initialByte >> 5;
+	*info = initialByte & 0x1f;
+	*argument = 0;
+
+	if (*info < 24) {
+		*argument = *info;
+		return YES;
+	}
+
+	if (*info == SQRLCBORIndefiniteLength) {
+		// Only strings, arrays, maps and the break itself can be indefinite.
+		return *majorType >= SQRLCBORMajorTypeByteString && *majorType != SQRLCBORMajorTypeTag;
+	}
+
+	if (*info > 27) return NO;
+
+	NSUInteger size = 1 << (*info - 24);
+	if (cursor->length - cursor->offset < size) return NO;
+
+	for (NSUInteger i = 0; i < size; i++) {
+		*argument = (*argument << 8) | cursor->bytes[cursor->offset++];
+	}
+
+	return YES;
+}
+
+// Returns whether the next byte is a break, consuming it if so.
+static BOOL SQRLCBORConsumeBreak(SQRLCBORCursor *cursor) {
+	if (cursor->offset >= cursor->length || cursor->bytes[cursor->offset] != SQRLCBORBreak) return NO;
+
+	cursor->offset++;
+	return YES;
+}
+
+// Converts an IEEE 754 half-precision float.
+static double SQRLCBORDecodeHalf(uint16_t half) {
+	int exponent = (half >> 10) & 0x1f;
+	int mantissa = half & 0x3ff;
+
+	double value;
+	if (exponent == 0) {
+		value = ldexp(mantissa, -24);
+	} else if (exponent != 31) {
+		value = ldexp(mantissa + 1024, exponent - 25);
+	} else {
+		value = (mantissa == 0 ? INFINITY : NAN);
+	}
+
+	return (half & 0x8000 ? -value : value);
+}
+
+static id SQRLCBORDecodeItem(SQRLCBORCursor *cursor);
+
+// Decodes the contents of a string whose head has already been read.
+//
+// Chunks of an indefinite-length string are concatenated.
+static id SQRLCBORDecodeString(SQRLCBORCursor *cursor, uint8_t majorType, uint8_t info, uint64_t length) {
+	NSData *contents;
+
+	if (info == SQRLCBORIndefiniteLength) {
+		NSMutableData *chunks = [NSMutableData data];
+		while (!SQRLCBORConsumeBreak(cursor)) {
+			uint8_t chunkMajorType, chunkInfo;
+			uint64_t chunkLength;
+			if (!SQRLCBORReadHead(cursor, &chunkMajorType, &chunkInfo, &chunkLength)) return nil;
+			if (chunkMajorType != majorType || chunkInfo == SQRLCBORIndefiniteLength) return nil;
+			if (chunkLength > cursor->length - cursor->offset) return nil;
+
+			[chunks appendBytes:cursor->bytes + cursor->offset length:(NSUInteger)chunkLength];
+			cursor->offset += (NSUInteger)chunkLength;
+		}
+
+		contents = chunks;
+	} else {
+		if (length > cursor->length - cursor->offset) return nil;
+
+		NSRange range = NSMakeRange(cursor->offset, (NSUInteger)length);
+		cursor->offset += range.length;
+
+		if (majorType == SQRLCBORMajorTypeTextString) {
+			return CFBridgingRelease(CFStringCreateWithBytes(kCFAllocatorDefault, cursor->bytes + range.location, (CFIndex)range.length, kCFStringEncodingUTF8, false));
+		}
+
+		contents = [cursor->data subdataWithRange:range];
+	}
+
+	if (majorType == SQRLCBORMajorTypeTextString) {
+		return [[NSString alloc] initWithData:contents encoding:NSUTF8StringEncoding];
+	}
+
+	return [contents copy];
+}
+
+// Decodes the contents of an array or map whose head has already been read.
+static id SQRLCBORDecodeContainer(SQRLCBORCursor *cursor, uint8_t majorType, uint8_t info, uint64_t count) {
+	BOOL indefinite = (info == SQRLCBORIndefiniteLength);
+
+	// Every item takes at least a byte, so a count larger than what's left
+	// can't be valid, and mustn't be used to size an allocation.
+	NSUInteger remaining = cursor->length - cursor->offset;
+	if (!indefinite && count > remaining) return nil;
+
+	if (++cursor->depth > SQRLCBORMaximumDepth) return nil;
+
+	id result = nil;
+	if (majorType == SQRLCBORMajorTypeArray) {
+		NSMutableArray *array = [NSMutableArray arrayWithCapacity:(indefinite ? 0 : (NSUInteger)count)];
+		for (uint64_t i = 0; indefinite || i < count; i++) {
+			if (indefinite && SQRLCBORConsumeBreak(cursor)) break;
+
+			id item = SQRLCBORDecodeItem(cursor);
+			if (item == nil) {
+				array = nil;
+				break;
+			}
+
+			[array addObject:item];
+		}
+
+		result = array;
+	} else {
+		NSMutableDictionary *map = [NSMutableDictionary dictionaryWithCapacity:(indefinite ? 0 : (NSUInteger)count)];
+		for (uint64_t i = 0; indefinite || i < count; i++) {
+			if (indefinite && SQRLCBORConsumeBreak(cursor)) break;
+
+			id key = SQRLCBORDecodeItem(cursor);
+			if (![key isKindOfClass:NSString.class]) {
+				map = nil;
+				break;
+			}
+
+			id value = SQRLCBORDecodeItem(cursor);
+			if (value == nil) {
+				map = nil;
+				break;
+			}
+
+			map[key] = value;
+		}
+
+		result = map;
+	}
+
+	cursor->depth--;
+	return result;
+}
+
+// Decodes the data item at the cursor.
+//
+// Returns the decoded object, or nil if the item is invalid.
+static id SQRLCBORDecodeItem(SQRLCBORCursor *cursor) {
+	uint8_t majorType, info;
+	uint64_t argument;
+	if (!SQRLCBORReadHead(cursor, &majorType, &info, &argument)) return nil;
+
+	switch (majorType) {
+		case SQRLCBORMajorTypeUnsignedInteger:
+			if (argument > LLONG_MAX) return @(argument);
+			return @((long long)argument);
+
+		case SQRLCBORMajorTypeNegativeInteger:
+			if (argument > LLONG_MAX) return nil;
+			return @(-1 - (long long)argument);
+
+		case SQRLCBORMajorTypeByteString:
+		case SQRLCBORMajorTypeTextString:
+			return SQRLCBORDecodeString(cursor, majorType, info, argument);
+
+		case SQRLCBORMajorTypeArray:
+		case SQRLCBORMajorTypeMap:
+			return SQRLCBORDecodeContainer(cursor, majorType, info, argument);
+
+		case SQRLCBORMajorTypeTag: {
+			// Tags are dropped, but each one nests the item after it, so it
+			// counts towards the maximum depth like a container does.
+			if (++cursor->depth > SQRLCBORMaximumDepth) return nil;
+
+			id item = SQRLCBORDecodeItem(cursor);
+			cursor->depth--;
+
+			return item;
+		}
+
+		case SQRLCBORMajorTypeSimple:
+			switch (info) {
+				case 20: return @NO;
+				case 21: return @YES;
+				case 22: return NSNull.null;
+				case 23: return NSNull.null;
+				case 25: return @(SQRLCBORDecodeHalf((uint16_t)argument));
+
+				case 26: {
+					uint32_t bits = (uint32_t)argument;
+					float value;
+					memcpy(&value, &bits, sizeof(value));
+					return @(value);
+				}
+
+				case 27: {
+					double value;
+					memcpy(&value, &argument, sizeof(value));
+					return @(value);
+				}
+			}
+	}
+
+	return nil;
+}
+
+// Appends the head of a data item, using the shortest encoding of its argument.
+static void SQRLCBORAppendHead(NSMutableData *data, uint8_t majorType, uint64_t argument) {
+	uint8_t head[9];
+	NSUInteger size;
+
+	if (argument < 24) {
+		head[0] = (uint8_t)(majorType << 5 | argument);
+		size = 1;
+	} else if (argument <= UINT8_MAX) {
+		head[0] = (uint8_t)(majorType << 5 | 24);
+		size = 2;
+	} else if (argument <= UINT16_MAX) {
+		head[0] = (uint8_t)(majorType << 5 | 25);
+		size = 3;
+	} else if (argument <= UINT32_MAX) {
+		head[0] = (uint8_t)(majorType << 5 | 26);
+		size = 5;
+	} else {
+		head[0] = (uint8_t)(majorType << 5 | 27);
+		size = 9;
+	}
+
+	for (NSUInteger i = size - 1; i > 0; i--) {
+		head[i] = (uint8_t)argument;
+		argument >>= 8;
+	}
+
+	[data appendBytes:head length:size];
+}
+
+// Appends the encoding of an object.
+//
+// Returns whether the object, and everything in it, could be encoded.
+static BOOL SQRLCBORAppendObject(NSMutableData *data, id object) {
+	if ([object isKindOfClass:NSString.class]) {
+		NSString *string = object;
+		NSUInteger length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+		SQRLCBORAppendHead(data, SQRLCBORMajorTypeTextString, length);
+		[data appendBytes:string.UTF8String length:length];
+		return YES;
+	}
+
+	if ([object isKindOfClass:NSNumber.class]) {
+		NSNumber *number = object;
+		if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+			uint8_t simple = (uint8_t)(SQRLCBORMajorTypeSimple << 5 | (number.boolValue ? 21 : 20));
+			[data appendBytes:&simple length:1];
+			return YES;
+		}
+
+		if (CFNumberIsFloatType((__bridge CFNumberRef)number)) {
+			double value = number.doubleValue;
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			uint8_t head[9] = { (uint8_t)(SQRLCBORMajorTypeSimple << 5 | 27) };
+			for (NSUInteger i = 8; i > 0; i--) {
+				head[i] = (uint8_t)bits;
+				bits >>= 8;
+			}
+
+			[data appendBytes:head length:sizeof(head)];
+			return YES;
+		}
+
+		// Unsigned values too large for a long long come back negative.
+		if (*number.objCType == 'Q' || number.longLongValue >= 0) {
+			SQRLCBORAppendHead(data, SQRLCBORMajorTypeUnsignedInteger, number.unsignedLongLongValue);
+		} else {
+			SQRLCBORAppendHead(data, SQRLCBORMajorTypeNegativeInteger, (uint64_t)(-1 - number.longLongValue));
+		}
+
+		return YES;
+	}
+
+	if ([object isKindOfClass:NSDictionary.class]) {
+		NSDictionary *dictionary = object;
+		SQRLCBORAppendHead(data, SQRLCBORMajorTypeMap, dictionary.count);
+
+		for (id key in dictionary) {
+			if (![key isKindOfClass:NSString.class]) return NO;
+			if (!SQRLCBORAppendObject(data, key)) return NO;
+			if (!SQRLCBORAppendObject(data, dictionary[key])) return NO;
+		}
+
+		return YES;
+	}
+
+	if ([object isKindOfClass:NSArray.class]) {
+		NSArray *array = object;
+		SQRLCBORAppendHead(data, SQRLCBORMajorTypeArray, array.count);
+
+		for (id item in array) {
+			if (!SQRLCBORAppendObject(data, item)) return NO;
+		}
+
+		return YES;
+	}
+
+	if ([object isKindOfClass:NSData.class]) {
+		SQRLCBORAppendHead(data, SQRLCBORMajorTypeByteString, [object length]);
+		[data appendData:object];
+		return YES;
+	}
+
+	if ([object isKindOfClass:NSNull.class]) {
+		uint8_t simple = (uint8_t)(SQRLCBORMajorTypeSimple << 5 | 22);
+		[data appendBytes:&simple length:1];
+		return YES;
+	}
+
+	return NO;
+}
+
+@implementation SQRLCBORSerialization
+
++ (id)objectWithData:(NSData *)data error:(NSError **)error {
+	NSParameterAssert(data != nil);
+
+	SQRLCBORCursor cursor = { .data = data, .bytes = data.bytes, .length = data.length, .offset = 0, .depth = 0 };
+
+	id object = SQRLCBORDecodeItem(&cursor);
+	if (object != nil && cursor.offset == cursor.length) return object;
+
+	if (error != NULL) {
+		NSDictionary *userInfo = @{
+			NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"The data is not a valid CBOR document around byte %lu.", (unsigned long)cursor.offset],
+		};
+
+		*error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListReadCorruptError userInfo:userInfo];
+	}
+
+	return nil;
+}
+
++ (NSData *)dataWithObject:(id)object error:(NSError **)error {
+	NSParameterAssert(object != nil);
+
+	NSMutableData *data = [NSMutableData data];
+	if (SQRLCBORAppendObject(data, object)) return data;
+
+	if (error != NULL) {
+		NSDictionary *userInfo = @{
+			NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"%@ contains an object that cannot be encoded as CBOR.", [object class]],
+		};
+
+		*error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListWriteInvalidError userInfo:userInfo];
+	}
+
+	return nil;
+}
+
+@end
@@ -0,0 +1,87 @@
+//
+//  SQRLCheckLease.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// The domain for errors originating within SQRLCheckLease.
+extern NSString * const SQRLCheckLeaseErrorDomain;
+
+// The leader held the lease past its expiration date.
+extern const NSInteger SQRLCheckLeaseErrorExpired;
+
+@class RACSignal;
+
+// Elects a single leader among the updaters, in this process or any other,
+// which check for updates using the same storage directory.
+//
+// The lease is an exclusive `flock()` on a lock file, so the system releases it
+// if the leader crashes. While it holds the lease, the leader records its
+// progress in the lock file for followers to read, and leaves the outcome of
+// its check there when it relinquishes the lease.
+//
+// Each instance represents a single attempt at the lease, and should not be
+// reused. This class is thread-safe.
+@interface SQRLCheckLease : NSObject
+
+// Initializes the receiver to use the given lock file.
+//
+// lockURL - The URL to the lock file, which is created if it doesn't exist.
+//           This must not be nil.
+- (instancetype)initWithURL:(NSURL *)lockURL;
+
+// How long the leader may go without recording progress before followers stop
+// waiting for it, in seconds. Defaults to 30 minutes.
+@property (atomic, assign) NSTimeInterval duration;
+
+// How often followers read the leader's progress, in seconds. Defaults to 0.5.
+@property (atomic, assign) NSTimeInterval pollInterval;
+
+// Whether the receiver holds the lease.
+@property (atomic, assign, readonly, getter = isLeader) BOOL leader;
+
+// The outcome left by the leader that `-waitForLeader` waited for, or nil if it
+// hasn't relinquished the lease yet or didn't leave one.
+//
+// Outcomes left before the receiver was initialized are ignored, since they
+// can't be from a leader that the receiver waited for.
+@property (atomic, copy, readonly) NSDictionary *outcome;
+
+// Tries to take the lease, without waiting if another updater holds it.
+//
+// Returns a signal which synchronously sends whether the receiver is now the
+// leader, as an `NSNumber`, then completes, or errors if the lock file could
+// not be opened.
+- (RACSignal *)acquire;
+
+// Records the leader's progress for followers to read, and extends the lease by
+// `duration`.
+//
+// This does nothing unless the receiver is the leader.
+//
+// progress - A property list dictionary describing the leader's progress. This
+//            must not be nil.
+- (void)recordProgress:(NSDictionary *)progress;
+
+// Leaves an outcome for followers to read, then releases the lease.
+//
+// This does nothing unless the receiver is the leader.
+//
+// outcome - A property list dictionary describing the outcome of the leader's
+//           check, or nil if followers should check for themselves.
+- (void)relinquishWithOutcome:(NSDictionary *)outcome;
+
+// Lazily waits for the leader to relinquish the lease.
+//
+// Returns a signal which sends the progress recorded by the leader each time it
+// changes, then completes once the lease has been relinquished, on a
+// background scheduler. `outcome` is set before the signal completes. If the
+// leader doesn't record any progress before the lease expires, the signal
+// errors with `SQRLCheckLeaseErrorExpired`.
+- (RACSignal *)waitForLeader;
+
+@end
@@ -0,0 +1,256 @@
+//
+//  SQRLCheckLease.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLCheckLease.h"
+
+#import <ReactiveObjC/EXTScope.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <sys/file.h>
+
+NSString * const SQRLCheckLeaseErrorDomain = @"SQRLCheckLeaseErrorDomain";
+
+const NSInteger SQRLCheckLeaseErrorExpired = 1;
+
+// Keys in the record saved to the lock file.
+//
+// While the lease is held, the record has the leader's process identifier, the
+// date at which the lease expires, and the progress it last recorded. Once the
+// lease has been relinquished, it has the date at which that happened and any
+// outcome that the leader left.
+static NSString * const SQRLCheckLeaseProcessIdentifierKey = @"processIdentifier";
+static NSString * const SQRLCheckLeaseExpirationDateKey = @"expirationDate";
+static NSString * const SQRLCheckLeaseProgressKey = @"progress";
+static NSString * const SQRLCheckLeaseRelinquishedDateKey = @"relinquishedDate";
+static NSString * const SQRLCheckLeaseOutcomeKey = @"outcome";
+
+@interface SQRLCheckLease () {
+	// The lock file, opened and locked while the receiver is the leader, or -1
+	// otherwise.
+	//
+	// This must only be used while synchronized on `self`.
+	int _fileDescriptor;
+}
+
+@property (nonatomic, copy, readonly) NSURL *lockURL;
+
+// When the receiver was initialized.
+@property (nonatomic, copy, readonly) NSDate *creationDate;
+
+@property (atomic, copy, readwrite) NSDictionary *outcome;
+
+// Replaces the record in the lock file, which must be open.
+//
+// This must only be invoked while synchronized on `self`.
+- (void)writeRecord:(NSDictionary *)record;
+
+// Reads the record from the lock file, if the leader has relinquished the
+// lease, updating `outcome` if it left one.
+//
+// Returns the record while the lease is held, an empty dictionary if it's held
+// but the record couldn't be read, or nil once it has been relinquished.
+- (NSDictionary *)pollLeader;
+
+@end
+
+@implementation SQRLCheckLease
+
+#pragma mark Properties
+
+- (BOOL)isLeader {
+	@synchronized (self) {
+		return _fileDescriptor >= 0;
+	}
+}
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithURL:(NSURL *)lockURL {
+	NSParameterAssert(lockURL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_lockURL = [lockURL copy];
+	_creationDate = [NSDate date];
+	_fileDescriptor = -1;
+	_duration = 30 * 60;
+	_pollInterval = 0.5;
+
+	return self;
+}
+
+- (void)dealloc {
+	[self relinquishWithOutcome:nil];
+}
+
+#pragma mark Leading
+
+- (RACSignal *)acquire {
+	return [[RACSignal
+		defer:^{
+			@synchronized (self) {
+				if (_fileDescriptor >= 0) return [RACSignal return:@YES];
+
+				int fd = open(self.lockURL.path.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+				if (fd < 0) {
+					int code = errno;
+
+					NSDictionary *userInfo = @{
+						NSLocalizedDescriptionKey: NSLocalizedString(@"Could not open update check lock file", nil),
+						NSURLErrorKey: self.lockURL
+					};
+
+					return [RACSignal error:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo]];
+				}
+
+				if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+					int code = errno;
+					close(fd);
+
+					if (code == EWOULDBLOCK) return [RACSignal return:@NO];
+
+					NSDictionary *userInfo = @{
+						NSLocalizedDescriptionKey: NSLocalizedString(@"Could not lock update check lock file", nil),
+						NSURLErrorKey: self.lockURL
+					};
+
+					return [RACSignal error:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo]];
+				}
+
+				_fileDescriptor = fd;
+			}
+
+			[self recordProgress:@{}];
+			return [RACSignal return:@YES];
+		}]
+		setNameWithFormat:@"%@ -acquire", self];
+}
+
+- (void)recordProgress:(NSDictionary *)progress {
+	NSParameterAssert(progress != nil);
+
+	@synchronized (self) {
+		if (_fileDescriptor < 0) return;
+
+		[self writeRecord:@{
+			SQRLCheckLeaseProcessIdentifierKey: @(NSProcessInfo.processInfo.processIdentifier),
+			SQRLCheckLeaseExpirationDateKey: [NSDate dateWithTimeIntervalSinceNow:self.duration],
+			SQRLCheckLeaseProgressKey: progress,
+		}];
+	}
+}
+
+- (void)relinquishWithOutcome:(NSDictionary *)outcome {
+	@synchronized (self) {
+		if (_fileDescriptor < 0) return;
+
+		NSMutableDictionary *record = [NSMutableDictionary dictionary];
+		record[SQRLCheckLeaseProcessIdentifierKey] = @(NSProcessInfo.processInfo.processIdentifier);
+		record[SQRLCheckLeaseRelinquishedDateKey] = [NSDate date];
+		record[SQRLCheckLeaseOutcomeKey] = outcome;
+		[self writeRecord:record];
+
+		flock(_fileDescriptor, LOCK_UN);
+		close(_fileDescriptor);
+		_fileDescriptor = -1;
+	}
+}
+
+- (void)writeRecord:(NSDictionary *)record {
+	NSParameterAssert(record != nil);
+
+	NSError *error = nil;
+	NSData *data = [NSPropertyListSerialization dataWithPropertyList:record format:NSPropertyListBinaryFormat_v1_0 options:0 error:&error];
+	if (data == nil) {
+		NSLog(@"Could not serialize update check lease record %@: %@", record, error);
+		return;
+	}
+
+	// Followers may read the file while it's being rewritten, but will just
+	// fail to parse it and try again later.
+	if (ftruncate(_fileDescriptor, 0) != 0 || pwrite(_fileDescriptor, data.bytes, data.length, 0) != (ssize_t)data.length) {
+		NSLog(@"Could not write update check lease record to %@: %s", self.lockURL, strerror(errno));
+	}
+}
+
+#pragma mark Following
+
+- (RACSignal *)waitForLeader {
+	RACScheduler *scheduler = [RACScheduler schedulerWithPriority:RACSchedulerPriorityLow];
+
+	return [[[[[[[[RACSignal
+		interval:self.pollInterval onScheduler:scheduler]
+		startWith:NSDate.date]
+		map:^(id _) {
+			return [self pollLeader];
+		}]
+		takeWhileBlock:^(NSDictionary *record) {
+			return (BOOL)(record != nil);
+		}]
+		flattenMap:^(NSDictionary *record) {
+			NSDate *expirationDate = record[SQRLCheckLeaseExpirationDateKey];
+			if ([expirationDate isKindOfClass:NSDate.class] && expirationDate.timeIntervalSinceNow < 0) {
+				NSDictionary *userInfo = @{
+					NSLocalizedDescriptionKey: NSLocalizedString(@"Another update check is taking too long", nil),
+					NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:NSLocalizedString(@"Process %@ has held the update check lease since it expired at %@.", nil), record[SQRLCheckLeaseProcessIdentifierKey], expirationDate],
+					NSURLErrorKey: self.lockURL
+				};
+
+				return [RACSignal error:[NSError errorWithDomain:SQRLCheckLeaseErrorDomain code:SQRLCheckLeaseErrorExpired userInfo:userInfo]];
+			}
+
+			NSDictionary *progress = record[SQRLCheckLeaseProgressKey];
+			if (![progress isKindOfClass:NSDictionary.class]) return [RACSignal empty];
+
+			return [RACSignal return:progress];
+		}]
+		distinctUntilChanged]
+		subscribeOn:scheduler]
+		setNameWithFormat:@"%@ -waitForLeader", self];
+}
+
+- (NSDictionary *)pollLeader {
+	int fd = open(self.lockURL.path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return nil;
+
+	@onExit {
+		close(fd);
+	};
+
+	// A shared lock can only be taken once the leader has let go of its
+	// exclusive one, and then the leader's record can't change while it's
+	// being read.
+	BOOL relinquished = (flock(fd, LOCK_SH | LOCK_NB) == 0);
+
+	NSFileHandle *handle = [[NSFileHandle alloc] initWithFileDescriptor:fd closeOnDealloc:NO];
+	NSData *data = [handle readDataToEndOfFile];
+
+	NSDictionary *record = nil;
+	if (data.length > 0) record = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:NULL];
+	if (![record isKindOfClass:NSDictionary.class]) record = @{};
+
+	if (!relinquished) return record;
+
+	flock(fd, LOCK_UN);
+
+	NSDate *relinquishedDate = record[SQRLCheckLeaseRelinquishedDateKey];
+	NSDictionary *outcome = record[SQRLCheckLeaseOutcomeKey];
+	if ([relinquishedDate isKindOfClass:NSDate.class] && [relinquishedDate compare:self.creationDate] != NSOrderedAscending && [outcome isKindOfClass:NSDictionary.class]) {
+		self.outcome = outcome;
+	}
+
+	return nil;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ lockURL: %@, leader: %i }", self.class, self, self.lockURL, (int)self.leader];
+}
+
+@end
@@ -0,0 +1,92 @@
+//
+//  SQRLCheckScheduler.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// Decides when to next check for updates.
+//
+// Every delay is randomly lengthened or shortened, so that clients which
+// started together drift apart instead of checking in lockstep. The server can
+// also ask clients to wait longer, with a `Retry-After` or `Cache-Control:
+// max-age` header, or a `nextCheckAfter` value in its JSON.
+//
+// This class is thread-safe.
+@interface SQRLCheckScheduler : NSObject
+
+// Reads a hint for when to check again from the headers of a response.
+//
+// `Retry-After` may be a number of seconds or an HTTP date. `Cache-Control:
+// max-age` is reduced by any `Age` header. If both are present, the longer
+// hint is used.
+//
+// response - The response to a check for updates. This may be nil.
+//
+// Returns the number of seconds to wait before checking again, or 0 if the
+// response doesn't say.
++ (NSTimeInterval)hintFromResponse:(NSURLResponse *)response;
+
+// Reads a hint for when to check again from a `nextCheckAfter` JSON value.
+//
+// nextCheckAfter - A number of seconds, or an ISO 8601 date string. This may
+//                  be nil.
+//
+// Returns the number of seconds to wait before checking again, or 0 if the
+// value isn't a hint.
++ (NSTimeInterval)hintFromNextCheckAfter:(id)nextCheckAfter;
+
+// Initializes the receiver to check about every `interval` seconds.
+//
+// interval - The interval between checks, before jitter. This must be greater
+//            than zero.
+- (instancetype)initWithInterval:(NSTimeInterval)interval;
+
+// The interval between checks, before jitter.
+@property (nonatomic, assign, readonly) NSTimeInterval interval;
+
+// The fraction of the interval, between 0 and 1, by which each delay is
+// randomly lengthened or shortened.
+//
+// Hints from the server are only ever lengthened by up to this fraction, since
+// every client is likely to have been sent the same one.
+//
+// This defaults to 0.2.
+@property (atomic, assign) double jitter;
+
+// How late, in seconds, a check may run so that the system can coalesce it
+// with other work and save energy.
+//
+// This defaults to a tenth of the interval, up to a minute.
+@property (atomic, assign) NSTimeInterval leeway;
+
+// The longest hint from the server that will be followed, so that a
+// misconfigured server can't stop clients from checking.
+//
+// This defaults to 1 day.
+@property (atomic, assign) NSTimeInterval maximumHint;
+
+// Returns how long to wait before the next check, including jitter.
+//
+// hint - The number of seconds the server asked clients to wait, or 0 if it
+//        didn't. Hints shorter than the interval have no effect.
+- (NSTimeInterval)delayWithHint:(NSTimeInterval)hint;
+
+// Waits until the next check is due, using a timer with the receiver's leeway.
+//
+// The timer counts wall clock time, so a check that fell due while the system
+// was asleep runs soon after it wakes.
+//
+// hint - The number of seconds the server asked clients to wait, or 0 if it
+//        didn't.
+//
+// Returns a signal which completes on a background queue once the next check
+// is due.
+- (RACSignal *)waitWithHint:(NSTimeInterval)hint;
+
+@end
@@ -0,0 +1,142 @@
+//
+//  SQRLCheckScheduler.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLCheckScheduler.h"
+
+#import <ReactiveObjC/RACDisposable.h>
+#import <ReactiveObjC/RACSignal+Operations.h>
+#import <ReactiveObjC/RACSubscriber.h>
+
+// Returns a random number from 0 to 1.
+static double SQRLCheckSchedulerRandomFraction(void) {
+	return arc4random_uniform(UINT32_MAX) / (double)UINT32_MAX;
+}
+
+@implementation SQRLCheckScheduler
+
+#pragma mark Server Hints
+
++ (NSTimeInterval)hintFromResponse:(NSURLResponse *)response {
+	if (![response isKindOfClass:NSHTTPURLResponse.class]) return 0;
+
+	NSDictionary *headers = ((NSHTTPURLResponse *)response).allHeaderFields;
+	NSTimeInterval hint = 0;
+
+	// Header names are case-insensitive, but allHeaderFields keeps the
+	// server's case.
+	NSString * (^header)(NSString *) = ^ NSString * (NSString *name) {
+		for (NSString *key in headers) {
+			if ([key caseInsensitiveCompare:name] == NSOrderedSame) return headers[key];
+		}
+
+		return nil;
+	};
+
+	NSString *retryAfter = [header(@"Retry-After") stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet];
+	if (retryAfter.length > 0) {
+		NSScanner *scanner = [NSScanner scannerWithString:retryAfter];
+		NSInteger seconds = 0;
+		if ([scanner scanInteger:&seconds] && scanner.isAtEnd) {
+			hint = MAX(hint, seconds);
+		} else {
+			NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+			formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+			formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+			formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+
+			NSDate *date = [formatter dateFromString:retryAfter];
+			if (date != nil) hint = MAX(hint, date.timeIntervalSinceNow);
+		}
+	}
+
+	NSString *cacheControl = header(@"Cache-Control");
+	for (NSString *directive in [cacheControl componentsSeparatedByString:@","]) {
+		NSString *trimmedDirective = [directive stringByTrimmingCharactersInSet:NSCharacterSet.whitespaceCharacterSet];
+		if (![trimmedDirective.lowercaseString hasPrefix:@"max-age="]) continue;
+
+		NSTimeInterval maxAge = [trimmedDirective substringFromIndex:@"max-age=".length].doubleValue;
+		NSTimeInterval age = [header(@"Age") doubleValue];
+		hint = MAX(hint, maxAge - age);
+	}
+
+	return MAX(hint, 0);
+}
+
++ (NSTimeInterval)hintFromNextCheckAfter:(id)nextCheckAfter {
+	if ([nextCheckAfter isKindOfClass:NSNumber.class]) return MAX([nextCheckAfter doubleValue], 0);
+
+	if ([nextCheckAfter isKindOfClass:NSString.class]) {
+		NSDate *date = [[[NSISO8601DateFormatter alloc] init] dateFromString:nextCheckAfter];
+		return MAX(date.timeIntervalSinceNow, 0);
+	}
+
+	return 0;
+}
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithInterval:(NSTimeInterval)interval {
+	NSParameterAssert(interval > 0);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_interval = interval;
+	_jitter = 0.2;
+	_leeway = MIN(interval / 10, 60);
+	_maximumHint = 24 * 60 * 60;
+
+	return self;
+}
+
+#pragma mark Scheduling
+
+- (NSTimeInterval)delayWithHint:(NSTimeInterval)hint {
+	double jitter = MIN(MAX(self.jitter, 0), 1);
+	NSTimeInterval delay = self.interval * (1 - jitter + 2 * jitter * SQRLCheckSchedulerRandomFraction());
+
+	if (hint > 0) {
+		// Every client was probably sent the same hint, so spread them out,
+		// but never check sooner than the server asked.
+		NSTimeInterval hintedDelay = MIN(hint, self.maximumHint) * (1 + jitter * SQRLCheckSchedulerRandomFraction());
+		delay = MAX(delay, hintedDelay);
+	}
+
+	return delay;
+}
+
+- (RACSignal *)waitWithHint:(NSTimeInterval)hint {
+	return [[RACSignal
+		createSignal:^(id<RACSubscriber> subscriber) {
+			NSTimeInterval delay = [self delayWithHint:hint];
+			NSTimeInterval leeway = MAX(self.leeway, 0);
+
+			dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+
+			dispatch_source_set_event_handler(timer, ^{
+				dispatch_source_cancel(timer);
+				[subscriber sendCompleted];
+			});
+
+			dispatch_source_set_timer(timer, dispatch_walltime(NULL, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, (uint64_t)(leeway * NSEC_PER_SEC));
+			dispatch_resume(timer);
+
+			return [RACDisposable disposableWithBlock:^{
+				dispatch_source_cancel(timer);
+			}];
+		}]
+		setNameWithFormat:@"%@ -waitWithHint: %f", self, hint];
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ interval: %f, jitter: %f, leeway: %f }", self.class, self, self.interval, self.jitter, self.leeway];
+}
+
+@end
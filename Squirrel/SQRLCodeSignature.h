@@ -52,6 +52,16 @@ extern const NSInteger SQRLCodeSignatureErrorCouldNotCreateStaticCode;
 // designated requirement of the bundle at `bundleURL`.
 + (instancetype)signatureWithBundle:(NSURL *)bundleURL error:(NSError **)error;
 
+// Recreates a code signature from the `requirementData` of another.
+//
+// requirementData - The serialized requirement, as returned from
+//                   `requirementData`. This must not be nil.
+// error           - If not NULL, set to any error that occurs.
+//
+// Returns a `SQRLCodeSignature`, or nil if `requirementData` could not be read
+// as a requirement.
++ (instancetype)signatureWithRequirementData:(NSData *)requirementData error:(NSError **)error;
+
 // Verifies the code signature of the specified bundle and verifies that the
 // bundle meets the receiver's requirement.
 //
@@ -90,6 +90,23 @@ const NSInteger SQRLCodeSignatureErrorCouldNotCreateStaticCode = -2;
 	return [[SQRLCodeSignature alloc] initWithRequirement:designatedRequirement];
 }
 
++ (instancetype)signatureWithRequirementData:(NSData *)requirementData error:(NSError **)errorRef {
+	NSParameterAssert(requirementData != nil);
+
+	SecRequirementRef requirement = NULL;
+	OSStatus error = SecRequirementCreateWithData((__bridge CFDataRef)requirementData, kSecCSDefaultFlags, &requirement);
+	if (error != noErr) {
+		if (errorRef != NULL) *errorRef = [NSError errorWithDomain:NSOSStatusErrorDomain code:error userInfo:nil];
+		return nil;
+	}
+
+	@onExit {
+		CFRelease(requirement);
+	};
+
+	return [[SQRLCodeSignature alloc] initWithRequirement:requirement];
+}
+
 - (id)initWithRequirement:(SecRequirementRef)requirement {
 	NSParameterAssert(requirement != NULL);
 
@@ -39,6 +39,24 @@
 // Returns a signal which synchronously sends a URL then completes, or errors.
 - (RACSignal *)shipItStateURL;
 
+// Determines where the validators (like the ETag) of the last release feed
+// response should be saved, for conditional requests.
+//
+// Returns a signal which synchronously sends a URL then completes, or errors.
+- (RACSignal *)releaseFeedValidatorsURL;
+
+// Determines where the lock file should be saved which coordinates update
+// checks between updaters using this directory.
+//
+// Returns a signal which synchronously sends a URL then completes, or errors.
+- (RACSignal *)updateCheckLeaseURL;
+
+// Determines where the update most recently prepared for installation should
+// be described, so that it isn't downloaded again.
+//
+// Returns a signal which synchronously sends a URL then completes, or errors.
+- (RACSignal *)stagedUpdateURL;
+
 // Determines where ShipIt's stdout log should be saved.
 //
 // Returns a signal which synchronously sends a URL then completes, or errors.
@@ -49,4 +67,14 @@
 // Returns a signal which synchronously sends a URL then completes, or errors.
 - (RACSignal *)shipItStderrURL;
 
+// Rotates ShipIt's stdout and stderr logs, so that the next ShipIt job starts
+// them afresh, keeping a few compressed, size-capped segments of each.
+//
+// This must be invoked before the job is submitted, and not while a previous
+// job may still be writing to the logs. See `SQRLLogRotator`.
+//
+// Returns a signal which synchronously completes, or errors if the storage
+// folder couldn't be found. Errors rotating each log are only logged.
+- (RACSignal *)rotateShipItLogs;
+
 @end
@@ -10,6 +10,12 @@
 
 #import <ReactiveObjC/RACSignal+Operations.h>
 
+#import "SQRLLogRotator.h"
+
+// The names of ShipIt's logs in the storage folder.
+static NSString * const SQRLDirectoryManagerShipItStdoutLogName = @"ShipIt_stdout.log";
+static NSString * const SQRLDirectoryManagerShipItStderrLogName = @"ShipIt_stderr.log";
+
 @implementation SQRLDirectoryManager
 
 #pragma mark Lifecycle
@@ -106,12 +112,47 @@
 	return [self URLForFileNamed:@"ShipItState.plist" withJobNamed:@"shipItStateURL" ensureWritable:false];
 }
 
+- (RACSignal *)releaseFeedValidatorsURL {
+	return [self URLForFileNamed:@"ReleaseFeedValidators.plist" withJobNamed:@"releaseFeedValidatorsURL" ensureWritable:false];
+}
+
+- (RACSignal *)updateCheckLeaseURL {
+	return [self URLForFileNamed:@"UpdateCheck.lock" withJobNamed:@"updateCheckLeaseURL" ensureWritable:false];
+}
+
+- (RACSignal *)stagedUpdateURL {
+	return [self URLForFileNamed:@"StagedUpdate.plist" withJobNamed:@"stagedUpdateURL" ensureWritable:false];
+}
+
 - (RACSignal *)shipItStdoutURL {
-	return [self URLForFileNamed:@"ShipIt_stdout.log" withJobNamed:@"shipItStdoutURL" ensureWritable:true];
+	return [self URLForFileNamed:SQRLDirectoryManagerShipItStdoutLogName withJobNamed:@"shipItStdoutURL" ensureWritable:true];
 }
 
 - (RACSignal *)shipItStderrURL {
-	return [self URLForFileNamed:@"ShipIt_stderr.log" withJobNamed:@"shipItStderrURL" ensureWritable:true];
+	return [self URLForFileNamed:SQRLDirectoryManagerShipItStderrLogName withJobNamed:@"shipItStderrURL" ensureWritable:true];
+}
+
+#pragma mark Logs
+
+- (RACSignal *)rotateShipItLogs {
+	return [[[self
+		storageURL]
+		flattenMap:^(NSURL *folderURL) {
+			NSArray *names = @[ SQRLDirectoryManagerShipItStdoutLogName, SQRLDirectoryManagerShipItStderrLogName ];
+			NSMutableArray *rotations = [NSMutableArray arrayWithCapacity:names.count];
+			for (NSString *name in names) {
+				SQRLLogRotator *rotator = [[SQRLLogRotator alloc] initWithLogURL:[folderURL URLByAppendingPathComponent:name]];
+
+				// One log failing to rotate shouldn't stop the other.
+				[rotations addObject:[[rotator rotate] catch:^(NSError *error) {
+					NSLog(@"Error rotating %@: %@", rotator.logURL, error);
+					return [RACSignal empty];
+				}]];
+			}
+
+			return [RACSignal concat:rotations];
+		}]
+		setNameWithFormat:@"%@ -rotateShipItLogs", self];
 }
 
 #pragma mark NSObject
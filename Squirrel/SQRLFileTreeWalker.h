@@ -0,0 +1,113 @@
+//
+//  SQRLFileTreeWalker.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// Walks a directory tree, spreading the per-item filesystem work across a
+// bounded pool of concurrent workers.
+//
+// Each worker keeps its own deque of pending items, and works through the tree
+// depth first. Workers that run out steal the oldest pending items from the
+// others, so a directory with many children (like `Contents/Frameworks`) is
+// fanned out across every worker rather than being processed by whichever
+// worker happened to list it.
+//
+// Symbolic links are visited but never followed.
+@interface SQRLFileTreeWalker : NSObject
+
+// Determines how many filesystem operations should be kept in flight for the
+// volume containing the given URL.
+//
+// Local APFS volumes handle many outstanding metadata operations well, so
+// they're given two workers per core (within limits), since each worker
+// spends much of its time waiting on the volume. Other local volumes may be
+// rotational, and network volumes pay a round trip per operation, so both are
+// kept to a small number of workers.
+//
+// URL - An item on the volume to inspect. This must not be nil.
++ (NSUInteger)maximumConcurrentOperationsForVolumeAtURL:(NSURL *)URL;
+
+// Initializes the receiver to walk the tree rooted at the given URL.
+//
+// rootURL - The item to start walking from. This may be a directory or any
+//           other kind of file. This must not be nil.
+- (instancetype)initWithRootURL:(NSURL *)rootURL;
+
+// The item that walks will start from.
+@property (nonatomic, copy, readonly) NSURL *rootURL;
+
+// The number of workers to use for each walk.
+//
+// Defaults to the result of +maximumConcurrentOperationsForVolumeAtURL: for
+// `rootURL`. Setting this to 1 makes walks serial.
+@property (atomic, assign) NSUInteger maximumConcurrentOperations;
+
+// The number of items visited by the most recently finished walk.
+@property (atomic, assign, readonly) unsigned long long visitedItemCount;
+
+// The total size, in bytes, of the files visited by the most recently finished
+// walk.
+@property (atomic, assign, readonly) unsigned long long visitedByteCount;
+
+// Lazily visits `rootURL` and every item beneath it.
+//
+// A directory is always visited before its children, but otherwise items are
+// visited in no particular order.
+//
+// block - Invoked concurrently from background threads with each item. The
+//         block should return YES to continue, or NO and set `error` to stop
+//         the walk. This must not be nil.
+//
+// Returns a signal which will complete or error on a background thread. The
+// walk stops early if the subscription is disposed.
+- (RACSignal *)visitItemsWithBlock:(BOOL (^)(NSURL *itemURL, NSError **error))block;
+
+// Like -visitItemsWithBlock:, but lets the caller decide what happens when a
+// directory's contents can't be listed.
+//
+// errorHandler - Invoked concurrently from background threads with the
+//                directory and the error listing it. The handler should return
+//                YES to skip the directory's contents and continue, or NO to
+//                stop the walk with that error. This may be nil, in which case
+//                the walk stops.
+- (RACSignal *)visitItemsWithBlock:(BOOL (^)(NSURL *itemURL, NSError **error))block errorHandler:(BOOL (^)(NSURL *URL, NSError *error))errorHandler;
+
+// Lazily removes `rootURL` and everything within it.
+//
+// Files are unlinked concurrently, then directories are removed from the
+// deepest level upwards. Like NSFileManager, items within the tree that are
+// immutable, or in read-only directories, are made removable first.
+//
+// Returns a signal which will complete or error on a background thread. If
+// `rootURL` does not exist, the signal errors with `NSFileNoSuchFileError` in
+// `NSCocoaErrorDomain`.
+- (RACSignal *)removeItems;
+
+// Lazily copies `rootURL` and everything within it to `destinationURL`, which
+// may be on another volume.
+//
+// Files are copied concurrently with large buffers, advising the kernel not to
+// cache them, which saves memory but doesn't make anything durable. Each file
+// is sent to the device with fsync(), and the copy only becomes durable when
+// the device's own cache is flushed with F_FULLFSYNC. That happens once per
+// batch of data, and once more at the end, rather than after every file. Files with several hard links within the tree
+// are copied once, and linked again in the copy. Directories are created
+// writable, then given their original permissions, ACLs, and attributes once
+// everything within them has been copied.
+//
+// destinationURL - Where to copy the tree to. Nothing may exist at this URL,
+//                  but its parent directory must. This must not be nil.
+//
+// Returns a signal which will complete or error on a background thread. If
+// the copy fails, whatever was copied is left at `destinationURL` for the
+// caller to remove.
+- (RACSignal *)copyItemsToURL:(NSURL *)destinationURL;
+
+@end
@@ -0,0 +1,855 @@
+//
+//  SQRLFileTreeWalker.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLFileTreeWalker.h"
+
+#import <ReactiveObjC/RACDisposable.h>
+#import <ReactiveObjC/RACSignal+Operations.h>
+#import <ReactiveObjC/RACSubscriber.h>
+#import <copyfile.h>
+#import <fcntl.h>
+#import <os/lock.h>
+#import <stdatomic.h>
+#import <sys/mount.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+// The most workers any walk will use, regardless of the volume.
+static const NSUInteger SQRLFileTreeWalkerMaximumWorkers = 16;
+
+// The number of workers to use for volumes that don't handle many outstanding
+// operations well.
+static const NSUInteger SQRLFileTreeWalkerConservativeWorkers = 4;
+
+// The largest buffer used to copy a single file.
+static const size_t SQRLFileTreeWalkerCopyBufferSize = 4 * 1024 * 1024;
+
+// How much data to copy between flushes of the destination device's cache.
+static const unsigned long long SQRLFileTreeWalkerCopySyncBatchSize = 64 * 1024 * 1024;
+
+// An item waiting to be visited.
+@interface SQRLFileTreeWalkerItem : NSObject
+
+@property (nonatomic, strong) NSURL *URL;
+@property (nonatomic, assign) BOOL directory;
+@property (nonatomic, assign) NSUInteger depth;
+@property (nonatomic, assign) unsigned long long size;
+
+@end
+
+@implementation SQRLFileTreeWalkerItem
+@end
+
+// The items waiting to be visited by one worker.
+//
+// The worker takes the items it added most recently, so it works through the
+// tree depth first. Idle workers steal the oldest items instead, which are the
+// closest to the root and so tend to have the most beneath them.
+@interface SQRLFileTreeWalkerDeque : NSObject
+
+// Adds items to the end.
+- (void)pushItems:(NSArray *)items;
+
+// Removes and returns the newest item, or nil if there are none.
+- (SQRLFileTreeWalkerItem *)popItem;
+
+// Removes and returns the oldest item, or nil if there are none.
+- (SQRLFileTreeWalkerItem *)stealItem;
+
+@end
+
+@implementation SQRLFileTreeWalkerDeque {
+	os_unfair_lock _lock;
+	NSMutableArray *_items;
+}
+
+- (instancetype)init {
+	self = [super init];
+	if (self == nil) return nil;
+
+	_lock = OS_UNFAIR_LOCK_INIT;
+	_items = [NSMutableArray array];
+
+	return self;
+}
+
+- (void)pushItems:(NSArray *)items {
+	os_unfair_lock_lock(&_lock);
+	[_items addObjectsFromArray:items];
+	os_unfair_lock_unlock(&_lock);
+}
+
+- (SQRLFileTreeWalkerItem *)popItem {
+	os_unfair_lock_lock(&_lock);
+	SQRLFileTreeWalkerItem *item = _items.lastObject;
+	if (item != nil) [_items removeLastObject];
+	os_unfair_lock_unlock(&_lock);
+
+	return item;
+}
+
+- (SQRLFileTreeWalkerItem *)stealItem {
+	os_unfair_lock_lock(&_lock);
+	SQRLFileTreeWalkerItem *item = _items.firstObject;
+	if (item != nil) [_items removeObjectAtIndex:0];
+	os_unfair_lock_unlock(&_lock);
+
+	return item;
+}
+
+@end
+
+// The copies of files with more than one hard link, so that later links to
+// the same file can link to its copy instead of copying it again.
+@interface SQRLFileTreeWalkerHardLinks : NSObject
+
+// Claims the file with the given device and inode number for copying.
+//
+// If another worker is already copying the file, this waits until it's done.
+//
+// Returns the path of an earlier copy of the file to link to, or nil if the
+// caller should copy it then invoke -finishCopyOfDevice:inode:path:.
+- (NSString *)claimDevice:(dev_t)device inode:(ino_t)inode;
+
+// Records the copy of a file claimed with -claimDevice:inode:.
+//
+// path - Where the file was copied to, or nil if it couldn't be copied, in
+//        which case the next worker to claim it will copy it instead.
+- (void)finishCopyOfDevice:(dev_t)device inode:(ino_t)inode path:(NSString *)path;
+
+@end
+
+@implementation SQRLFileTreeWalkerHardLinks {
+	NSCondition *_condition;
+
+	// The copied paths, keyed by device and inode number, or NSNull while
+	// the file is being copied.
+	NSMutableDictionary *_pathsByFile;
+}
+
+- (instancetype)init {
+	self = [super init];
+	if (self == nil) return nil;
+
+	_condition = [[NSCondition alloc] init];
+	_pathsByFile = [NSMutableDictionary dictionary];
+
+	return self;
+}
+
+- (NSString *)claimDevice:(dev_t)device inode:(ino_t)inode {
+	NSArray *key = @[ @(device), @(inode) ];
+
+	[_condition lock];
+	while (_pathsByFile[key] == NSNull.null) {
+		[_condition wait];
+	}
+
+	NSString *path = _pathsByFile[key];
+	if (path == nil) _pathsByFile[key] = NSNull.null;
+	[_condition unlock];
+
+	return path;
+}
+
+- (void)finishCopyOfDevice:(dev_t)device inode:(ino_t)inode path:(NSString *)path {
+	NSArray *key = @[ @(device), @(inode) ];
+
+	[_condition lock];
+	if (path != nil) {
+		_pathsByFile[key] = path;
+	} else {
+		[_pathsByFile removeObjectForKey:key];
+	}
+
+	[_condition broadcast];
+	[_condition unlock];
+}
+
+@end
+
+@interface SQRLFileTreeWalker ()
+
+@property (atomic, assign, readwrite) unsigned long long visitedItemCount;
+@property (atomic, assign, readwrite) unsigned long long visitedByteCount;
+
+@end
+
+@implementation SQRLFileTreeWalker
+
+#pragma mark Lifecycle
+
++ (NSUInteger)maximumConcurrentOperationsForVolumeAtURL:(NSURL *)URL {
+	NSParameterAssert(URL != nil);
+
+	struct statfs statfsInfo;
+	if (statfs(URL.path.fileSystemRepresentation, &statfsInfo) != 0) return SQRLFileTreeWalkerConservativeWorkers;
+
+	if ((statfsInfo.f_flags & MNT_LOCAL) == 0) return 2;
+	if (strcmp(statfsInfo.f_fstypename, "apfs") != 0) return SQRLFileTreeWalkerConservativeWorkers;
+
+	return MAX(MIN(NSProcessInfo.processInfo.activeProcessorCount * 2, SQRLFileTreeWalkerMaximumWorkers), 1);
+}
+
+- (instancetype)initWithRootURL:(NSURL *)rootURL {
+	NSParameterAssert(rootURL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_rootURL = rootURL.URLByStandardizingPath;
+	_maximumConcurrentOperations = [self.class maximumConcurrentOperationsForVolumeAtURL:_rootURL];
+
+	return self;
+}
+
+#pragma mark Walking
+
+// Synchronously walks the tree, invoking `block` with each item.
+//
+// Each worker has its own deque of pending items, and only takes the shared
+// lock when it runs out of work, so workers busy with their own part of the
+// tree don't contend with each other.
+//
+// block        - Invoked concurrently with each item and its depth below
+//                `rootURL`. This must not be nil.
+// errorHandler - Invoked with any error listing a directory. Returns YES to
+//                skip the directory's contents, or NO to stop the walk. This
+//                may be nil, in which case the walk stops.
+// cancelled    - Checked before visiting each item. The walk stops if it's set
+//                to YES. This must not be NULL.
+// errorRef     - If not NULL, set to the first error that occurred.
+//
+// Returns whether every item was visited successfully.
+- (BOOL)walkWithBlock:(BOOL (^)(SQRLFileTreeWalkerItem *item, NSError **error))block errorHandler:(BOOL (^)(NSURL *URL, NSError *error))errorHandler cancelled:(volatile BOOL *)cancelled error:(NSError **)errorRef {
+	NSParameterAssert(block != nil);
+	NSParameterAssert(cancelled != NULL);
+
+	struct stat rootInfo;
+	if (lstat(self.rootURL.path.fileSystemRepresentation, &rootInfo) != 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:self.rootURL];
+		return NO;
+	}
+
+	SQRLFileTreeWalkerItem *rootItem = [[SQRLFileTreeWalkerItem alloc] init];
+	rootItem.URL = self.rootURL;
+	rootItem.directory = S_ISDIR(rootInfo.st_mode);
+	rootItem.size = S_ISREG(rootInfo.st_mode) ? (unsigned long long)rootInfo.st_size : 0;
+
+	NSUInteger workerCount = MAX(self.maximumConcurrentOperations, 1);
+	NSMutableArray *deques = [NSMutableArray arrayWithCapacity:workerCount];
+	for (NSUInteger i = 0; i < workerCount; i++) {
+		[deques addObject:[[SQRLFileTreeWalkerDeque alloc] init]];
+	}
+
+	[deques[0] pushItems:@[ rootItem ]];
+
+	// The number of items that have been added to a deque but not yet
+	// visited. The walk is finished once this reaches zero.
+	_Atomic(unsigned long) pendingCount = 1;
+	_Atomic(unsigned long) *pendingCountRef = &pendingCount;
+
+	// The number of workers looking for something to steal.
+	_Atomic(unsigned long) idleWorkers = 0;
+	_Atomic(unsigned long) *idleWorkersRef = &idleWorkers;
+
+	_Atomic(unsigned long long) itemCount = 0;
+	_Atomic(unsigned long long) *itemCountRef = &itemCount;
+	_Atomic(unsigned long long) byteCount = 0;
+	_Atomic(unsigned long long) *byteCountRef = &byteCount;
+
+	// Idle workers wait on this until more work is added, the walk finishes,
+	// or it fails. `generation` is increased, with the lock held, whenever
+	// one of those happens.
+	NSCondition *condition = [[NSCondition alloc] init];
+	__block unsigned long generation = 0;
+	__block NSError *firstError = nil;
+
+	// Set once `firstError` is, so that busy workers can stop without taking
+	// the lock.
+	_Atomic(bool) failed = false;
+	_Atomic(bool) *failedRef = &failed;
+
+	void (^wakeIdleWorkers)(void) = ^{
+		[condition lock];
+		generation++;
+		[condition broadcast];
+		[condition unlock];
+	};
+
+	NSArray *keys = @[ NSURLIsDirectoryKey, NSURLIsSymbolicLinkKey, NSURLFileSizeKey ];
+
+	// Visits one item, returning any children that should be visited too.
+	NSArray * (^visit)(SQRLFileTreeWalkerItem *, NSError **) = ^ NSArray * (SQRLFileTreeWalkerItem *item, NSError **error) {
+		if (!block(item, error)) return nil;
+		if (!item.directory) return @[];
+
+		NSFileManager *manager = [[NSFileManager alloc] init];
+		NSError *listingError = nil;
+		NSArray *childURLs = [manager contentsOfDirectoryAtURL:item.URL includingPropertiesForKeys:keys options:0 error:&listingError];
+		if (childURLs == nil) {
+			if (errorHandler != nil && errorHandler(item.URL, listingError)) return @[];
+
+			if (error != NULL) *error = listingError;
+			return nil;
+		}
+
+		NSMutableArray *children = [NSMutableArray arrayWithCapacity:childURLs.count];
+		for (NSURL *childURL in childURLs) {
+			NSNumber *isDirectory = nil;
+			NSNumber *isSymbolicLink = nil;
+			NSNumber *size = nil;
+			[childURL getResourceValue:&isDirectory forKey:NSURLIsDirectoryKey error:NULL];
+			[childURL getResourceValue:&isSymbolicLink forKey:NSURLIsSymbolicLinkKey error:NULL];
+			[childURL getResourceValue:&size forKey:NSURLFileSizeKey error:NULL];
+
+			SQRLFileTreeWalkerItem *child = [[SQRLFileTreeWalkerItem alloc] init];
+			child.URL = childURL;
+			child.directory = isDirectory.boolValue && !isSymbolicLink.boolValue;
+			child.depth = item.depth + 1;
+			child.size = size.unsignedLongLongValue;
+			[children addObject:child];
+		}
+
+		return children;
+	};
+
+	dispatch_group_t group = dispatch_group_create();
+	dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+
+	for (NSUInteger i = 0; i < workerCount; i++) {
+		SQRLFileTreeWalkerDeque *ownDeque = deques[i];
+
+		// Steals from the other workers, starting with the next one along so
+		// that thieves spread out.
+		SQRLFileTreeWalkerItem * (^steal)(void) = ^ SQRLFileTreeWalkerItem * {
+			for (NSUInteger offset = 1; offset <= workerCount; offset++) {
+				SQRLFileTreeWalkerItem *item = [deques[(i + offset) % workerCount] stealItem];
+				if (item != nil) return item;
+			}
+
+			return nil;
+		};
+
+		dispatch_group_async(group, queue, ^{
+			while (YES) {
+				if (atomic_load(failedRef) || *cancelled) {
+					wakeIdleWorkers();
+					return;
+				}
+
+				SQRLFileTreeWalkerItem *item = [ownDeque popItem] ?: steal();
+
+				if (item == nil) {
+					[condition lock];
+					atomic_fetch_add(idleWorkersRef, 1);
+					unsigned long lastGeneration = generation;
+					[condition unlock];
+
+					// Anything added before this worker became idle will be
+					// found here. Anything added after will wake it up.
+					item = steal();
+
+					if (item == nil) {
+						[condition lock];
+						while (generation == lastGeneration && atomic_load(pendingCountRef) > 0 && firstError == nil && !*cancelled) {
+							[condition wait];
+						}
+
+						BOOL finished = (atomic_load(pendingCountRef) == 0);
+						[condition unlock];
+
+						atomic_fetch_sub(idleWorkersRef, 1);
+						if (finished) return;
+
+						continue;
+					}
+
+					atomic_fetch_sub(idleWorkersRef, 1);
+				}
+
+				NSError *error = nil;
+				NSArray *children = nil;
+				@autoreleasepool {
+					children = visit(item, &error);
+				}
+
+				if (children == nil) {
+					[condition lock];
+					if (firstError == nil) firstError = error ?: [self errorForPOSIXCode:EIO URL:item.URL];
+					atomic_store(failedRef, true);
+					generation++;
+					[condition broadcast];
+					[condition unlock];
+
+					return;
+				}
+
+				atomic_fetch_add(itemCountRef, 1);
+				atomic_fetch_add(byteCountRef, item.size);
+
+				if (children.count > 0) {
+					// Count the children before anyone can steal them, so that
+					// the walk can't look finished while they're pending.
+					atomic_fetch_add(pendingCountRef, children.count);
+					[ownDeque pushItems:children];
+
+					if (atomic_load(idleWorkersRef) > 0) wakeIdleWorkers();
+				}
+
+				if (atomic_fetch_sub(pendingCountRef, 1) == 1) wakeIdleWorkers();
+			}
+		});
+	}
+
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+	self.visitedItemCount = atomic_load(&itemCount);
+	self.visitedByteCount = atomic_load(&byteCount);
+
+	if (firstError != nil) {
+		if (errorRef != NULL) *errorRef = firstError;
+		return NO;
+	}
+
+	if (*cancelled) {
+		if (errorRef != NULL) *errorRef = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+		return NO;
+	}
+
+	return YES;
+}
+
+// Runs the given walk on a background queue for each subscription.
+- (RACSignal *)signalWithWalk:(BOOL (^)(volatile BOOL *cancelled, NSError **error))walk {
+	return [RACSignal createSignal:^(id<RACSubscriber> subscriber) {
+		__block volatile BOOL cancelled = NO;
+
+		dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+			NSError *error = nil;
+			if (walk(&cancelled, &error)) {
+				[subscriber sendCompleted];
+			} else {
+				[subscriber sendError:error];
+			}
+		});
+
+		return [RACDisposable disposableWithBlock:^{
+			cancelled = YES;
+		}];
+	}];
+}
+
+- (RACSignal *)visitItemsWithBlock:(BOOL (^)(NSURL *itemURL, NSError **error))block {
+	return [[self
+		visitItemsWithBlock:block errorHandler:nil]
+		setNameWithFormat:@"%@ -visitItemsWithBlock:", self];
+}
+
+- (RACSignal *)visitItemsWithBlock:(BOOL (^)(NSURL *itemURL, NSError **error))block errorHandler:(BOOL (^)(NSURL *URL, NSError *error))errorHandler {
+	NSParameterAssert(block != nil);
+
+	return [[self
+		signalWithWalk:^(volatile BOOL *cancelled, NSError **errorRef) {
+			return [self walkWithBlock:^(SQRLFileTreeWalkerItem *item, NSError **error) {
+				return block(item.URL, error);
+			} errorHandler:errorHandler cancelled:cancelled error:errorRef];
+		}]
+		setNameWithFormat:@"%@ -visitItemsWithBlock:errorHandler:", self];
+}
+
+// Clears the flags that stop an item from being removed or changed.
+static void SQRLFileTreeWalkerClearImmutableFlags(const char *path) {
+	struct stat info;
+	if (lstat(path, &info) != 0) return;
+
+	u_int32_t immutableFlags = UF_IMMUTABLE | UF_APPEND;
+	if ((info.st_flags & immutableFlags) != 0) lchflags(path, info.st_flags & ~immutableFlags);
+}
+
+// Removes a single item, like NSFileManager, making it and its parent
+// directory removable if they weren't already.
+//
+// itemURL       - The file or empty directory to remove. This must not be nil.
+// directory     - Whether the item is a directory.
+// changesParent - Whether the item's parent directory may be made writable.
+//                 This should only be YES for items within the tree being
+//                 removed.
+//
+// Returns whether the item was removed or didn't exist. If not, `errno` is
+// set to the reason.
+static BOOL SQRLFileTreeWalkerRemoveItem(NSURL *itemURL, BOOL directory, BOOL changesParent) {
+	const char *path = itemURL.path.fileSystemRepresentation;
+	int (*removeItem)(const char *) = (directory ? rmdir : unlink);
+
+	if (removeItem(path) == 0 || errno == ENOENT) return YES;
+	if (errno != EACCES && errno != EPERM) return NO;
+
+	SQRLFileTreeWalkerClearImmutableFlags(path);
+
+	if (changesParent) {
+		const char *parentPath = itemURL.URLByDeletingLastPathComponent.path.fileSystemRepresentation;
+		SQRLFileTreeWalkerClearImmutableFlags(parentPath);
+
+		struct stat parentInfo;
+		if (lstat(parentPath, &parentInfo) == 0 && (parentInfo.st_mode & S_IWUSR) == 0) {
+			chmod(parentPath, (parentInfo.st_mode & ALLPERMS) | S_IWUSR);
+		}
+	}
+
+	return removeItem(path) == 0 || errno == ENOENT;
+}
+
+- (RACSignal *)removeItems {
+	return [[self
+		signalWithWalk:^(volatile BOOL *cancelled, NSError **errorRef) {
+			NSMutableArray *directoriesByDepth = [NSMutableArray array];
+			NSLock *directoriesLock = [[NSLock alloc] init];
+
+			BOOL success = [self walkWithBlock:^(SQRLFileTreeWalkerItem *item, NSError **error) {
+				if (item.directory) {
+					[directoriesLock lock];
+					while (directoriesByDepth.count <= item.depth) {
+						[directoriesByDepth addObject:[NSMutableArray array]];
+					}
+
+					[directoriesByDepth[item.depth] addObject:item.URL];
+					[directoriesLock unlock];
+
+					return YES;
+				}
+
+				if (SQRLFileTreeWalkerRemoveItem(item.URL, NO, item.depth > 0)) return YES;
+
+				if (error != NULL) *error = [self errorForPOSIXCode:errno URL:item.URL];
+				return NO;
+			} errorHandler:nil cancelled:cancelled error:errorRef];
+
+			if (!success) return NO;
+
+			// Every file is gone, so each level of directories can be removed
+			// concurrently once the level below it has been.
+			__block NSError *directoryError = nil;
+			NSLock *errorLock = [[NSLock alloc] init];
+
+			for (NSUInteger depth = directoriesByDepth.count; depth-- > 0;) {
+				NSArray *directories = directoriesByDepth[depth];
+				dispatch_apply(directories.count, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(size_t index) {
+					NSURL *directoryURL = directories[index];
+					if (SQRLFileTreeWalkerRemoveItem(directoryURL, YES, depth > 0)) return;
+
+					NSError *error = [self errorForPOSIXCode:errno URL:directoryURL];
+					[errorLock lock];
+					if (directoryError == nil) directoryError = error;
+					[errorLock unlock];
+				});
+
+				if (directoryError != nil) {
+					if (errorRef != NULL) *errorRef = directoryError;
+					return NO;
+				}
+			}
+
+			return YES;
+		}]
+		setNameWithFormat:@"%@ -removeItems", self];
+}
+
+#pragma mark Copying
+
+- (RACSignal *)copyItemsToURL:(NSURL *)destinationURL {
+	NSParameterAssert(destinationURL != nil);
+
+	NSURL *standardizedDestinationURL = destinationURL.URLByStandardizingPath;
+
+	return [[self
+		signalWithWalk:^(volatile BOOL *cancelled, NSError **errorRef) {
+			NSString *rootPath = self.rootURL.path;
+			NSString *destinationPath = standardizedDestinationURL.path;
+
+			NSMutableArray *directoriesByDepth = [NSMutableArray array];
+			NSLock *directoriesLock = [[NSLock alloc] init];
+
+			__block unsigned long long unsyncedByteCount = 0;
+			NSLock *syncLock = [[NSLock alloc] init];
+
+			SQRLFileTreeWalkerHardLinks *hardLinks = [[SQRLFileTreeWalkerHardLinks alloc] init];
+
+			BOOL success = [self walkWithBlock:^(SQRLFileTreeWalkerItem *item, NSError **error) {
+				NSString *relativePath = [item.URL.path substringFromIndex:rootPath.length];
+				NSURL *destinationItemURL = [NSURL fileURLWithPath:[destinationPath stringByAppendingString:relativePath]];
+
+				if (item.directory) {
+					// Keep the directory writable until its children have been
+					// copied into it.
+					if (mkdir(destinationItemURL.path.fileSystemRepresentation, S_IRWXU) != 0) {
+						if (error != NULL) *error = [self errorForPOSIXCode:errno URL:destinationItemURL];
+						return NO;
+					}
+
+					[directoriesLock lock];
+					while (directoriesByDepth.count <= item.depth) {
+						[directoriesByDepth addObject:[NSMutableArray array]];
+					}
+
+					[directoriesByDepth[item.depth] addObject:@[ item.URL, destinationItemURL ]];
+					[directoriesLock unlock];
+
+					return YES;
+				}
+
+				int destinationFD = -1;
+				if (![self copyItemAtURL:item.URL toURL:destinationItemURL size:item.size hardLinks:hardLinks openedFileDescriptor:&destinationFD error:error]) return NO;
+				if (destinationFD < 0) return YES;
+
+				[syncLock lock];
+				unsyncedByteCount += item.size;
+				BOOL shouldFlushDevice = unsyncedByteCount >= SQRLFileTreeWalkerCopySyncBatchSize;
+				if (shouldFlushDevice) unsyncedByteCount = 0;
+				[syncLock unlock];
+
+				// Nothing is durable until the device flushes its own cache,
+				// which F_FULLFSYNC asks it to do for everything it has been
+				// sent so far, so one flush covers the whole batch.
+				if (shouldFlushDevice && fcntl(destinationFD, F_FULLFSYNC) != 0) fsync(destinationFD);
+
+				close(destinationFD);
+				return YES;
+			} errorHandler:nil cancelled:cancelled error:errorRef];
+
+			if (!success) return NO;
+
+			// Restore directories' permissions from the deepest level upwards,
+			// so that none becomes read-only before its children are done.
+			__block NSError *directoryError = nil;
+			NSLock *errorLock = [[NSLock alloc] init];
+
+			for (NSArray *directories in directoriesByDepth.reverseObjectEnumerator) {
+				dispatch_apply(directories.count, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(size_t index) {
+					NSURL *sourceURL = directories[index][0];
+					NSURL *directoryURL = directories[index][1];
+					if (copyfile(sourceURL.path.fileSystemRepresentation, directoryURL.path.fileSystemRepresentation, NULL, COPYFILE_STAT | COPYFILE_ACL | COPYFILE_XATTR | COPYFILE_NOFOLLOW) == 0) return;
+
+					NSError *error = [self errorForPOSIXCode:errno URL:directoryURL];
+					[errorLock lock];
+					if (directoryError == nil) directoryError = error;
+					[errorLock unlock];
+				});
+
+				if (directoryError != nil) {
+					if (errorRef != NULL) *errorRef = directoryError;
+					return NO;
+				}
+			}
+
+			// Flush whatever's left of the last batch.
+			int destinationFD = open(destinationPath.fileSystemRepresentation, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+			if (destinationFD >= 0) {
+				if (fcntl(destinationFD, F_FULLFSYNC) != 0) fsync(destinationFD);
+				close(destinationFD);
+			}
+
+			return YES;
+		}]
+		setNameWithFormat:@"%@ -copyItemsToURL: %@", self, destinationURL];
+}
+
+// Copies a single item that isn't a directory.
+//
+// sourceURL        - The file or symbolic link to copy. This must not be nil.
+// destinationURL   - Where to copy it to. This must not be nil.
+// size             - The size of the source item, in bytes.
+// hardLinks        - The files with several hard links copied so far. If the
+//                    source is one of them, it's linked to the earlier copy
+//                    instead of being copied again. This must not be nil.
+// destinationFDRef - Set to a descriptor for the copied file, which has been
+//                    sent to the device (but not necessarily made durable),
+//                    and must be closed by the caller, or -1 if the item
+//                    wasn't copied as a regular file. This must not be NULL.
+// errorRef         - If not NULL, set to any error that occurs.
+//
+// Returns whether the item was copied.
+- (BOOL)copyItemAtURL:(NSURL *)sourceURL toURL:(NSURL *)destinationURL size:(unsigned long long)size hardLinks:(SQRLFileTreeWalkerHardLinks *)hardLinks openedFileDescriptor:(int *)destinationFDRef error:(NSError **)errorRef {
+	NSParameterAssert(sourceURL != nil);
+	NSParameterAssert(destinationURL != nil);
+	NSParameterAssert(hardLinks != nil);
+	NSParameterAssert(destinationFDRef != NULL);
+
+	*destinationFDRef = -1;
+
+	struct stat sourceInfo;
+	if (lstat(sourceURL.path.fileSystemRepresentation, &sourceInfo) != 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:sourceURL];
+		return NO;
+	}
+
+	if (S_ISLNK(sourceInfo.st_mode)) {
+		char linkDestination[PATH_MAX];
+		ssize_t length = readlink(sourceURL.path.fileSystemRepresentation, linkDestination, sizeof(linkDestination) - 1);
+		if (length < 0) {
+			if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:sourceURL];
+			return NO;
+		}
+
+		linkDestination[length] = '\0';
+		if (symlink(linkDestination, destinationURL.path.fileSystemRepresentation) != 0) {
+			if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:destinationURL];
+			return NO;
+		}
+
+		return YES;
+	}
+
+	if (!S_ISREG(sourceInfo.st_mode)) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:ENOTSUP URL:sourceURL];
+		return NO;
+	}
+
+	BOOL linked = sourceInfo.st_nlink > 1;
+	if (linked) {
+		NSString *copiedPath = [hardLinks claimDevice:sourceInfo.st_dev inode:sourceInfo.st_ino];
+		if (copiedPath != nil) {
+			if (link(copiedPath.fileSystemRepresentation, destinationURL.path.fileSystemRepresentation) != 0) {
+				if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:destinationURL];
+				return NO;
+			}
+
+			return YES;
+		}
+	}
+
+	BOOL success = [self copyFileAtURL:sourceURL toURL:destinationURL size:size openedFileDescriptor:destinationFDRef error:errorRef];
+	if (linked) [hardLinks finishCopyOfDevice:sourceInfo.st_dev inode:sourceInfo.st_ino path:(success ? destinationURL.path : nil)];
+
+	return success;
+}
+
+// Copies the data and metadata of a regular file.
+//
+// The arguments and return value are the same as those of
+// -copyItemAtURL:toURL:size:hardLinks:openedFileDescriptor:error:.
+- (BOOL)copyFileAtURL:(NSURL *)sourceURL toURL:(NSURL *)destinationURL size:(unsigned long long)size openedFileDescriptor:(int *)destinationFDRef error:(NSError **)errorRef {
+	int sourceFD = open(sourceURL.path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+	if (sourceFD < 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:sourceURL];
+		return NO;
+	}
+
+	// The source is only read once, so don't pollute the cache with it.
+	fcntl(sourceFD, F_NOCACHE, 1);
+
+	int destinationFD = open(destinationURL.path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (destinationFD < 0) {
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:errno URL:destinationURL];
+		close(sourceFD);
+		return NO;
+	}
+
+	// The copy won't be read again soon, so don't pollute the cache with it
+	// either. This is only advice, and makes nothing durable.
+	fcntl(destinationFD, F_NOCACHE, 1);
+
+	size_t bufferSize = (size_t)MAX(MIN(size, SQRLFileTreeWalkerCopyBufferSize), 1);
+	char *buffer = malloc(bufferSize);
+
+	NSURL *failedURL = nil;
+	int failedCode = 0;
+
+	while (buffer != NULL) {
+		ssize_t readLength = read(sourceFD, buffer, bufferSize);
+		if (readLength < 0) {
+			if (errno == EINTR) continue;
+
+			failedURL = sourceURL;
+			failedCode = errno;
+			break;
+		}
+
+		if (readLength == 0) break;
+
+		ssize_t writtenLength = 0;
+		while (writtenLength < readLength) {
+			ssize_t length = write(destinationFD, buffer + writtenLength, (size_t)(readLength - writtenLength));
+			if (length < 0) {
+				if (errno == EINTR) continue;
+
+				failedURL = destinationURL;
+				failedCode = errno;
+				break;
+			}
+
+			writtenLength += length;
+		}
+
+		if (failedURL != nil) break;
+	}
+
+	if (buffer == NULL) {
+		failedURL = sourceURL;
+		failedCode = ENOMEM;
+	}
+
+	free(buffer);
+
+	// Permissions, ACLs, dates, and extended attributes (which hold the code
+	// signatures of files that aren't Mach-O) come across after the data.
+	if (failedURL == nil && fcopyfile(sourceFD, destinationFD, NULL, COPYFILE_STAT | COPYFILE_ACL | COPYFILE_XATTR) != 0) {
+		failedURL = destinationURL;
+		failedCode = errno;
+	}
+
+	close(sourceFD);
+
+	// Hand whatever the kernel still holds to the device, without waiting for
+	// the device to flush its own cache, so that the batch's F_FULLFSYNC
+	// covers this file too.
+	if (failedURL == nil && fsync(destinationFD) != 0) {
+		failedURL = destinationURL;
+		failedCode = errno;
+	}
+
+	if (failedURL != nil) {
+		close(destinationFD);
+		if (errorRef != NULL) *errorRef = [self errorForPOSIXCode:failedCode URL:failedURL];
+		return NO;
+	}
+
+	*destinationFDRef = destinationFD;
+	return YES;
+}
+
+#pragma mark Error Handling
+
+- (NSError *)errorForPOSIXCode:(int)code URL:(NSURL *)URL {
+	// Match NSFileManager, so callers can treat missing items the same way
+	// regardless of which API removed them.
+	if (code == ENOENT) {
+		return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileNoSuchFileError userInfo:@{ NSURLErrorKey: URL }];
+	}
+
+	NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+
+	const char *desc = strerror(code);
+	if (desc != NULL) {
+		userInfo[NSLocalizedDescriptionKey] = @(desc);
+	} else {
+		userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Unknown POSIX error", @"");
+	}
+
+	userInfo[NSURLErrorKey] = URL;
+
+	return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo];
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ rootURL: %@, maximumConcurrentOperations: %lu }", self.class, self, self.rootURL, (unsigned long)self.maximumConcurrentOperations];
+}
+
+@end
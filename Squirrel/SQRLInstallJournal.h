@@ -0,0 +1,60 @@
+//
+//  SQRLInstallJournal.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// The domain for errors originating within SQRLInstallJournal.
+extern NSString * const SQRLInstallJournalErrorDomain;
+
+// A record could not be serialized or written to the journal.
+extern const NSInteger SQRLInstallJournalErrorWritingRecord;
+
+// An append-only log of the steps an installation has completed, which
+// survives ShipIt being terminated at any point.
+//
+// Each record is a JSON object on its own line, and is flushed to permanent
+// storage before -appendRecord:error: returns, so a record that has been
+// appended is never lost. A record that was only partly written when the
+// process died is discarded, along with anything after it.
+//
+// This class is thread-safe, but a journal file must only be used by one
+// process at a time.
+@interface SQRLInstallJournal : NSObject
+
+// Initializes the receiver to use the journal file at the given URL.
+//
+// URL - The location of the journal file, which need not exist yet. This must
+//       not be nil.
+- (instancetype)initWithURL:(NSURL *)URL;
+
+// The location of the journal file.
+@property (nonatomic, copy, readonly) NSURL *URL;
+
+// Reads every complete record in the journal, in the order they were
+// appended.
+//
+// Returns the records, which will be empty if the journal doesn't exist or
+// can't be read.
+- (NSArray *)records;
+
+// Durably appends a record to the journal, creating it if necessary.
+//
+// record - A JSON-compatible dictionary. This must not be nil.
+// error  - If not NULL, set to any error that occurs.
+//
+// Returns whether the record was written to permanent storage.
+- (BOOL)appendRecord:(NSDictionary *)record error:(NSError **)error;
+
+// Removes the journal, discarding every record.
+//
+// error - If not NULL, set to any error that occurs.
+//
+// Returns whether the journal was removed, or didn't exist.
+- (BOOL)removeJournal:(NSError **)error;
+
+@end
@@ -0,0 +1,223 @@
+//
+//  SQRLInstallJournal.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLInstallJournal.h"
+
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import <ReactiveObjC/EXTScope.h>
+
+NSString * const SQRLInstallJournalErrorDomain = @"SQRLInstallJournalErrorDomain";
+
+const NSInteger SQRLInstallJournalErrorWritingRecord = -1;
+
+@interface SQRLInstallJournal ()
+
+// Guards reading and writing the journal file.
+@property (nonatomic, strong, readonly) NSLock *lock;
+
+// Whether any torn record at the end of the journal has been truncated since
+// the receiver was initialized.
+//
+// This must only be accessed while holding `lock`.
+@property (nonatomic, assign) BOOL truncated;
+
+// Reads the complete records in the journal.
+//
+// validLength - If not NULL, set to the length of the journal up to the end of
+//               the last complete record.
+//
+// This must only be invoked while holding `lock`.
+- (NSArray *)readRecordsWithValidLength:(off_t *)validLength;
+
+// Creates an error for a failed system call, with the given errno.
+- (NSError *)errorWithDescription:(NSString *)description code:(int)code;
+
+@end
+
+@implementation SQRLInstallJournal
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithURL:(NSURL *)URL {
+	NSParameterAssert(URL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_URL = [URL copy];
+	_lock = [[NSLock alloc] init];
+
+	return self;
+}
+
+#pragma mark Reading
+
+- (NSArray *)records {
+	[self.lock lock];
+	NSArray *records = [self readRecordsWithValidLength:NULL];
+	[self.lock unlock];
+
+	return records;
+}
+
+- (NSArray *)readRecordsWithValidLength:(off_t *)validLength {
+	NSMutableArray *records = [NSMutableArray array];
+	if (validLength != NULL) *validLength = 0;
+
+	NSData *data = [NSData dataWithContentsOfURL:self.URL options:NSDataReadingUncached error:NULL];
+	if (data == nil) return records;
+
+	const char *bytes = data.bytes;
+	NSUInteger start = 0;
+
+	while (start < data.length) {
+		const char *newline = memchr(bytes + start, '\n', data.length - start);
+
+		// A record without its newline was torn by a crash mid-write.
+		if (newline == NULL) break;
+
+		NSUInteger end = (NSUInteger)(newline - bytes);
+		NSData *line = [data subdataWithRange:NSMakeRange(start, end - start)];
+		NSDictionary *record = [NSJSONSerialization JSONObjectWithData:line options:0 error:NULL];
+		if (![record isKindOfClass:NSDictionary.class]) break;
+
+		[records addObject:record];
+		start = end + 1;
+	}
+
+	if (validLength != NULL) *validLength = (off_t)start;
+	return records;
+}
+
+#pragma mark Writing
+
+- (BOOL)appendRecord:(NSDictionary *)record error:(NSError **)errorRef {
+	NSParameterAssert(record != nil);
+
+	// NSJSONSerialization throws, rather than erroring, for invalid objects.
+	NSError *error = nil;
+	NSMutableData *data = nil;
+	if ([NSJSONSerialization isValidJSONObject:record]) {
+		data = [[NSJSONSerialization dataWithJSONObject:record options:0 error:&error] mutableCopy];
+	}
+
+	if (data == nil) {
+		if (errorRef != NULL) {
+			NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+			userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Could not serialize install journal record", nil);
+			if (error != nil) userInfo[NSUnderlyingErrorKey] = error;
+
+			*errorRef = [NSError errorWithDomain:SQRLInstallJournalErrorDomain code:SQRLInstallJournalErrorWritingRecord userInfo:userInfo];
+		}
+
+		return NO;
+	}
+
+	[data appendBytes:"\n" length:1];
+
+	[self.lock lock];
+	@onExit {
+		[self.lock unlock];
+	};
+
+	const char *path = self.URL.path.fileSystemRepresentation;
+	BOOL created = access(path, F_OK) != 0;
+
+	// Appending after a torn record would leave the new record unreadable, so
+	// cut it off first.
+	if (!self.truncated && !created) {
+		off_t validLength = 0;
+		[self readRecordsWithValidLength:&validLength];
+
+		if (truncate(path, validLength) != 0) {
+			if (errorRef != NULL) *errorRef = [self errorWithDescription:NSLocalizedString(@"Could not truncate install journal", nil) code:errno];
+			return NO;
+		}
+	}
+
+	int fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		if (errorRef != NULL) *errorRef = [self errorWithDescription:NSLocalizedString(@"Could not open install journal", nil) code:errno];
+		return NO;
+	}
+
+	@onExit {
+		close(fd);
+	};
+
+	const char *bytes = data.bytes;
+	size_t remaining = data.length;
+	while (remaining > 0) {
+		ssize_t written = write(fd, bytes, remaining);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+
+			if (errorRef != NULL) *errorRef = [self errorWithDescription:NSLocalizedString(@"Could not write install journal record", nil) code:errno];
+			return NO;
+		}
+
+		bytes += written;
+		remaining -= (size_t)written;
+	}
+
+	// fsync() only reaches the drive's cache, which may be lost on power
+	// failure.
+	if (fcntl(fd, F_FULLFSYNC) != 0 && fsync(fd) != 0) {
+		if (errorRef != NULL) *errorRef = [self errorWithDescription:NSLocalizedString(@"Could not flush install journal", nil) code:errno];
+		return NO;
+	}
+
+	// Make sure the new file's directory entry is durable too.
+	if (created) {
+		int directoryFD = open(self.URL.URLByDeletingLastPathComponent.path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+		if (directoryFD >= 0) {
+			fsync(directoryFD);
+			close(directoryFD);
+		}
+	}
+
+	self.truncated = YES;
+	return YES;
+}
+
+- (BOOL)removeJournal:(NSError **)errorRef {
+	[self.lock lock];
+	@onExit {
+		[self.lock unlock];
+	};
+
+	if (unlink(self.URL.path.fileSystemRepresentation) != 0 && errno != ENOENT) {
+		if (errorRef != NULL) *errorRef = [self errorWithDescription:NSLocalizedString(@"Could not remove install journal", nil) code:errno];
+		return NO;
+	}
+
+	self.truncated = YES;
+	return YES;
+}
+
+#pragma mark Error Handling
+
+- (NSError *)errorWithDescription:(NSString *)description code:(int)code {
+	NSDictionary *userInfo = @{
+		NSLocalizedDescriptionKey: description,
+		NSLocalizedFailureReasonErrorKey: @(strerror(code)),
+		NSURLErrorKey: self.URL,
+	};
+
+	return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo];
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ URL: %@ }", self.class, self, self.URL];
+}
+
+@end
@@ -0,0 +1,77 @@
+//
+//  SQRLInstallMetrics.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+@class SQRLFileTreeWalker;
+@class SQRLShipItRequest;
+
+// The prefix of the file names that install records are written to.
+extern NSString * const SQRLInstallMetricsRecordFilePrefix;
+
+// Records how long each phase of an installation took, and how much it
+// processed, so that slow updates can be diagnosed across many machines.
+//
+// Phases may overlap (the update is prepared while waiting for the application
+// to terminate, for instance), and the same phase may be recorded more than
+// once. Timings are taken from a monotonic clock, so changes to the wall clock
+// don't affect them.
+//
+// This class is thread-safe.
+@interface SQRLInstallMetrics : NSObject
+
+// Initializes the receiver, starting the clock for the whole installation.
+- (instancetype)init;
+
+// Records which request is being installed, and on which attempt.
+//
+// request - The request being installed. This must not be nil.
+// attempt - The number of times ShipIt has tried to install this request,
+//           including the current attempt.
+- (void)recordRequest:(SQRLShipItRequest *)request attempt:(NSUInteger)attempt;
+
+// Measures a phase of installation around the given signal.
+//
+// name   - The name of the phase. This must not be nil.
+// signal - The work making up the phase. This must not be nil.
+//
+// Returns a signal which forwards the events of `signal`, starting the phase
+// when subscribed to, and ending it when `signal` completes or errors.
+- (RACSignal *)measurePhase:(NSString *)name ofSignal:(RACSignal *)signal;
+
+// Like -measurePhase:ofSignal:, but also records how many items and bytes
+// `walker` visited during the phase.
+//
+// walker - The walker performing the phase's work. If nil, no counts are
+//          recorded.
+- (RACSignal *)measurePhase:(NSString *)name ofSignal:(RACSignal *)signal countingItemsOfWalker:(SQRLFileTreeWalker *)walker;
+
+// Synchronously measures a phase of installation around the given block.
+//
+// name  - The name of the phase. This must not be nil.
+// block - The work making up the phase. This must not be nil.
+- (void)measurePhase:(NSString *)name usingBlock:(void (^)(void))block;
+
+// Creates a JSON-compatible record of everything measured so far.
+//
+// error - The error that ended the installation, or nil if it succeeded.
+- (NSDictionary *)recordWithError:(NSError *)error;
+
+// Writes a record of everything measured so far as a new JSON file in the
+// given directory, removing the oldest records if there are too many.
+//
+// directoryURL - The directory to write the record into. This must not be nil.
+// installError - The error that ended the installation, or nil if it
+//                succeeded.
+// errorRef     - If not NULL, set to any error that occurs.
+//
+// Returns whether the record was written.
+- (BOOL)writeRecordToDirectoryURL:(NSURL *)directoryURL installError:(NSError *)installError error:(NSError **)errorRef;
+
+@end
@@ -0,0 +1,231 @@
+//
+//  SQRLInstallMetrics.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLInstallMetrics.h"
+
+#import <ReactiveObjC/RACSignal+Operations.h>
+#import <time.h>
+
+#import "SQRLFileTreeWalker.h"
+#import "SQRLShipItRequest.h"
+
+NSString * const SQRLInstallMetricsRecordFilePrefix = @"ShipIt_install_";
+
+// The version of the record format, bumped on incompatible changes.
+static const NSInteger SQRLInstallMetricsRecordVersion = 1;
+
+// The number of records to keep in a directory.
+static const NSUInteger SQRLInstallMetricsMaximumRecords = 10;
+
+// Returns the current time of a monotonic clock which keeps counting while the
+// machine sleeps, in nanoseconds.
+static uint64_t SQRLInstallMetricsNow(void) {
+	return clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+}
+
+@interface SQRLInstallMetrics ()
+
+// Guards `phases` and `information`.
+@property (nonatomic, strong, readonly) NSLock *lock;
+
+// The monotonic time at which the receiver was initialized.
+@property (nonatomic, assign, readonly) uint64_t startTime;
+
+// The wall clock time at which the receiver was initialized.
+@property (nonatomic, copy, readonly) NSDate *startDate;
+
+// An `NSMutableDictionary` for each phase, in the order they started.
+@property (nonatomic, strong, readonly) NSMutableArray *phases;
+
+// Top level fields to include in the record.
+@property (nonatomic, strong, readonly) NSMutableDictionary *information;
+
+// Adds a phase which started at the current time.
+//
+// Returns the dictionary describing the phase, which must only be accessed
+// while holding `lock`.
+- (NSMutableDictionary *)beginPhase:(NSString *)name;
+
+// Ends a phase returned from -beginPhase:.
+- (void)endPhase:(NSMutableDictionary *)phase succeeded:(BOOL)succeeded;
+
+@end
+
+@implementation SQRLInstallMetrics
+
+#pragma mark Lifecycle
+
+- (instancetype)init {
+	self = [super init];
+	if (self == nil) return nil;
+
+	_lock = [[NSLock alloc] init];
+	_startTime = SQRLInstallMetricsNow();
+	_startDate = [NSDate date];
+	_phases = [NSMutableArray array];
+	_information = [NSMutableDictionary dictionary];
+
+	return self;
+}
+
+#pragma mark Measurement
+
+- (void)recordRequest:(SQRLShipItRequest *)request attempt:(NSUInteger)attempt {
+	NSParameterAssert(request != nil);
+
+	[self.lock lock];
+	if (request.bundleIdentifier != nil) self.information[@"bundleIdentifier"] = request.bundleIdentifier;
+	if (request.targetBundleURL.path != nil) self.information[@"targetBundlePath"] = request.targetBundleURL.path;
+	self.information[@"launchAfterInstallation"] = @(request.launchAfterInstallation);
+	self.information[@"attempt"] = @(attempt);
+	[self.lock unlock];
+}
+
+- (NSMutableDictionary *)beginPhase:(NSString *)name {
+	NSParameterAssert(name != nil);
+
+	NSMutableDictionary *phase = [@{
+		@"name": name,
+		@"start": @((SQRLInstallMetricsNow() - self.startTime) / (double)NSEC_PER_SEC),
+	} mutableCopy];
+
+	[self.lock lock];
+	[self.phases addObject:phase];
+	[self.lock unlock];
+
+	return phase;
+}
+
+- (void)endPhase:(NSMutableDictionary *)phase succeeded:(BOOL)succeeded {
+	NSParameterAssert(phase != nil);
+
+	double end = (SQRLInstallMetricsNow() - self.startTime) / (double)NSEC_PER_SEC;
+
+	[self.lock lock];
+	phase[@"duration"] = @(end - [phase[@"start"] doubleValue]);
+	phase[@"succeeded"] = @(succeeded);
+	[self.lock unlock];
+}
+
+- (RACSignal *)measurePhase:(NSString *)name ofSignal:(RACSignal *)signal {
+	return [self measurePhase:name ofSignal:signal countingItemsOfWalker:nil];
+}
+
+- (RACSignal *)measurePhase:(NSString *)name ofSignal:(RACSignal *)signal countingItemsOfWalker:(SQRLFileTreeWalker *)walker {
+	NSParameterAssert(name != nil);
+	NSParameterAssert(signal != nil);
+
+	return [[RACSignal
+		defer:^{
+			NSMutableDictionary *phase = [self beginPhase:name];
+
+			void (^recordCounts)(void) = ^{
+				if (walker == nil) return;
+
+				[self.lock lock];
+				phase[@"items"] = @(walker.visitedItemCount);
+				phase[@"bytes"] = @(walker.visitedByteCount);
+				[self.lock unlock];
+			};
+
+			return [[signal
+				doError:^(NSError *error) {
+					[self endPhase:phase succeeded:NO];
+				}]
+				doCompleted:^{
+					recordCounts();
+					[self endPhase:phase succeeded:YES];
+				}];
+		}]
+		setNameWithFormat:@"%@ -measurePhase: %@ ofSignal: %@", self, name, signal];
+}
+
+- (void)measurePhase:(NSString *)name usingBlock:(void (^)(void))block {
+	NSParameterAssert(block != nil);
+
+	NSMutableDictionary *phase = [self beginPhase:name];
+	block();
+	[self endPhase:phase succeeded:YES];
+}
+
+#pragma mark Records
+
+- (NSDictionary *)recordWithError:(NSError *)error {
+	NSMutableDictionary *record = [NSMutableDictionary dictionary];
+
+	[self.lock lock];
+	{
+		[record addEntriesFromDictionary:self.information];
+
+		NSMutableArray *phases = [NSMutableArray arrayWithCapacity:self.phases.count];
+		for (NSDictionary *phase in self.phases) {
+			[phases addObject:[phase copy]];
+		}
+
+		record[@"phases"] = phases;
+	}
+	[self.lock unlock];
+
+	NSISO8601DateFormatter *formatter = [[NSISO8601DateFormatter alloc] init];
+	record[@"version"] = @(SQRLInstallMetricsRecordVersion);
+	record[@"startDate"] = [formatter stringFromDate:self.startDate];
+	record[@"duration"] = @((SQRLInstallMetricsNow() - self.startTime) / (double)NSEC_PER_SEC);
+	record[@"succeeded"] = @(error == nil);
+
+	if (error != nil) {
+		record[@"error"] = @{
+			@"domain": error.domain,
+			@"code": @(error.code),
+			@"description": error.localizedDescription ?: @"",
+		};
+	}
+
+	return record;
+}
+
+- (BOOL)writeRecordToDirectoryURL:(NSURL *)directoryURL installError:(NSError *)installError error:(NSError **)errorRef {
+	NSParameterAssert(directoryURL != nil);
+
+	NSData *data = [NSJSONSerialization dataWithJSONObject:[self recordWithError:installError] options:NSJSONWritingPrettyPrinted error:errorRef];
+	if (data == nil) return NO;
+
+	// Sortable by name, so the oldest records can be found without reading
+	// them.
+	NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+	formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+	formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+	formatter.dateFormat = @"yyyyMMdd'T'HHmmss'Z'";
+
+	NSString *fileName = [NSString stringWithFormat:@"%@%@_%d.json", SQRLInstallMetricsRecordFilePrefix, [formatter stringFromDate:self.startDate], (int)getpid()];
+	if (![data writeToURL:[directoryURL URLByAppendingPathComponent:fileName] options:NSDataWritingAtomic error:errorRef]) return NO;
+
+	NSArray *contents = [NSFileManager.defaultManager contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:nil options:NSDirectoryEnumerationSkipsHiddenFiles error:NULL];
+	NSArray *recordURLs = [[contents
+		filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^(NSURL *URL, NSDictionary *bindings) {
+			return [URL.lastPathComponent hasPrefix:SQRLInstallMetricsRecordFilePrefix];
+		}]]
+		sortedArrayUsingComparator:^(NSURL *first, NSURL *second) {
+			return [first.lastPathComponent compare:second.lastPathComponent];
+		}];
+
+	if (recordURLs.count > SQRLInstallMetricsMaximumRecords) {
+		for (NSURL *URL in [recordURLs subarrayWithRange:NSMakeRange(0, recordURLs.count - SQRLInstallMetricsMaximumRecords)]) {
+			[NSFileManager.defaultManager removeItemAtURL:URL error:NULL];
+		}
+	}
+
+	return YES;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ startDate: %@ }", self.class, self, self.startDate];
+}
+
+@end
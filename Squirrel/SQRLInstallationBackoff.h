@@ -0,0 +1,96 @@
+//
+//  SQRLInstallationBackoff.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// Whether an installation error is worth retrying.
+//
+// SQRLInstallationErrorRetryable - The error may clear up by itself, like a full
+//                                  disk or a locked file, so installation
+//                                  should be tried again later.
+// SQRLInstallationErrorFatal     - Trying again can't help, like when the
+//                                  update fails code signing, so the update
+//                                  should be aborted.
+typedef enum : NSInteger {
+	SQRLInstallationErrorRetryable,
+	SQRLInstallationErrorFatal,
+} SQRLInstallationErrorClass;
+
+// Spaces out attempts to install an update with exponential backoff, so that a
+// transient problem doesn't use up every attempt within seconds.
+//
+// When the next attempt is due is saved to user defaults, so it survives ShipIt
+// being relaunched by launchd.
+//
+// This class is thread-safe.
+@interface SQRLInstallationBackoff : NSObject
+
+// Classifies an error from installation, including any underlying errors.
+//
+// error - The error that installation failed with. This must not be nil.
+//
+// Returns `SQRLInstallationErrorFatal` if the error, or any error underlying
+// it, is known to be permanent, or `SQRLInstallationErrorRetryable` otherwise.
++ (SQRLInstallationErrorClass)classifyError:(NSError *)error;
+
+// Initializes the receiver using the given application identifier, which is
+// used to scope the state stored to user defaults.
+//
+// applicationIdentifier - The defaults domain in which to store when the next
+//                         attempt is due. This must not be nil.
+- (instancetype)initWithApplicationIdentifier:(NSString *)applicationIdentifier;
+
+// The delay after the first failed attempt, before jitter.
+//
+// This defaults to 5 seconds, and doubles with each failed attempt.
+@property (atomic, assign) NSTimeInterval initialDelay;
+
+// The longest delay between attempts, before jitter.
+//
+// This defaults to 2 minutes.
+@property (atomic, assign) NSTimeInterval maximumDelay;
+
+// The fraction of each delay, between 0 and 1, by which it is randomly
+// lengthened or shortened.
+//
+// This defaults to 0.25.
+@property (atomic, assign) double jitter;
+
+// Returns how long to wait after the given failed attempt, including jitter.
+//
+// attempt - The number of the attempt that failed, starting at 1.
+- (NSTimeInterval)delayAfterAttempt:(NSUInteger)attempt;
+
+// When the next attempt is due, or nil if none is scheduled.
+@property (nonatomic, copy, readonly) NSDate *nextAttemptDate;
+
+// Saves that the next attempt is due after the delay for the given failed
+// attempt.
+//
+// attempt - The number of the attempt that failed, starting at 1.
+//
+// Returns whether the schedule was saved.
+- (BOOL)scheduleRetryAfterAttempt:(NSUInteger)attempt;
+
+// Waits until the next attempt is due.
+//
+// If the wall clock has moved backwards since the attempt was scheduled, the
+// wait is cut down to the longest delay that could have been scheduled.
+//
+// Returns a signal which completes once the next attempt is due, or
+// immediately if none is scheduled.
+- (RACSignal *)waitForNextAttempt;
+
+// Clears any scheduled attempt.
+//
+// Returns whether the change was saved.
+- (BOOL)reset;
+
+@end
@@ -0,0 +1,124 @@
+//
+//  SQRLInstallationBackoff.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLInstallationBackoff.h"
+
+#import <ReactiveObjC/RACSignal+Operations.h>
+
+#import "SQRLCodeSignature.h"
+#import "SQRLInstaller.h"
+#import "SQRLShipItRequest.h"
+
+// The user defaults key for the date that the next attempt is due.
+static NSString * const SQRLInstallationBackoffNextAttemptDateKey = @"SQRLShipItNextInstallationAttemptDate";
+
+@interface SQRLInstallationBackoff ()
+
+@property (nonatomic, copy, readonly) NSString *applicationIdentifier;
+
+// Saves `value` for `SQRLInstallationBackoffNextAttemptDateKey`.
+//
+// Returns whether the value was saved.
+- (BOOL)setNextAttemptDateValue:(NSDate *)value;
+
+@end
+
+@implementation SQRLInstallationBackoff
+
+#pragma mark Error Classification
+
++ (SQRLInstallationErrorClass)classifyError:(NSError *)error {
+	NSParameterAssert(error != nil);
+
+	NSSet *fatalInstallerCodes = [NSSet setWithObjects:
+		@(SQRLInstallerErrorCouldNotOpenTarget),
+		@(SQRLInstallerErrorInvalidBundleVersion),
+		@(SQRLInstallerErrorMissingInstallationData),
+		@(SQRLInstallerErrorInvalidState),
+		nil];
+
+	for (NSError *currentError = error; currentError != nil; currentError = currentError.userInfo[NSUnderlyingErrorKey]) {
+		// The update's code signature, and the request describing it, won't
+		// change between attempts.
+		if ([currentError.domain isEqual:SQRLCodeSignatureErrorDomain]) return SQRLInstallationErrorFatal;
+		if ([currentError.domain isEqual:SQRLShipItRequestErrorDomain]) return SQRLInstallationErrorFatal;
+
+		if ([currentError.domain isEqual:SQRLInstallerErrorDomain] && [fatalInstallerCodes containsObject:@(currentError.code)]) return SQRLInstallationErrorFatal;
+	}
+
+	return SQRLInstallationErrorRetryable;
+}
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithApplicationIdentifier:(NSString *)applicationIdentifier {
+	NSParameterAssert(applicationIdentifier != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_applicationIdentifier = [applicationIdentifier copy];
+	_initialDelay = 5;
+	_maximumDelay = 120;
+	_jitter = 0.25;
+
+	return self;
+}
+
+#pragma mark Scheduling
+
+- (NSTimeInterval)delayAfterAttempt:(NSUInteger)attempt {
+	NSParameterAssert(attempt > 0);
+
+	// Cap the exponent too, so the delay can't overflow.
+	NSTimeInterval delay = MIN(self.initialDelay * exp2(MIN(attempt - 1, 32)), self.maximumDelay);
+
+	double jitter = MIN(MAX(self.jitter, 0), 1);
+	double randomFraction = arc4random_uniform(UINT32_MAX) / (double)UINT32_MAX;
+	return delay * (1 - jitter + 2 * jitter * randomFraction);
+}
+
+- (NSDate *)nextAttemptDate {
+	id value = CFBridgingRelease(CFPreferencesCopyValue((__bridge CFStringRef)SQRLInstallationBackoffNextAttemptDateKey, (__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost));
+	if (![value isKindOfClass:NSDate.class]) return nil;
+
+	return value;
+}
+
+- (BOOL)scheduleRetryAfterAttempt:(NSUInteger)attempt {
+	return [self setNextAttemptDateValue:[NSDate dateWithTimeIntervalSinceNow:[self delayAfterAttempt:attempt]]];
+}
+
+- (RACSignal *)waitForNextAttempt {
+	return [[RACSignal
+		defer:^{
+			NSTimeInterval longestDelay = self.maximumDelay * (1 + MIN(MAX(self.jitter, 0), 1));
+			NSTimeInterval delay = MIN(self.nextAttemptDate.timeIntervalSinceNow, longestDelay);
+			if (delay <= 0) return [RACSignal empty];
+
+			return [[[RACSignal return:nil] delay:delay] ignoreValues];
+		}]
+		setNameWithFormat:@"%@ -waitForNextAttempt", self];
+}
+
+- (BOOL)reset {
+	return [self setNextAttemptDateValue:nil];
+}
+
+- (BOOL)setNextAttemptDateValue:(NSDate *)value {
+	CFPreferencesSetValue((__bridge CFStringRef)SQRLInstallationBackoffNextAttemptDateKey, (__bridge CFPropertyListRef)value, (__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+	return CFPreferencesSynchronize((__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ applicationIdentifier: %@, nextAttemptDate: %@ }", self.class, self, self.applicationIdentifier, self.nextAttemptDate];
+}
+
+@end
@@ -8,10 +8,33 @@
 
 #import "SQRLInstaller.h"
 
-// The defaults key to store a `SQRLInstallerOwnedBundle` so that a moved bundle
-// can be restored.
+// The defaults key that earlier versions stored a `SQRLInstallerOwnedBundle`
+// under. It's moved into the install journal when an installer is created.
 extern NSString * const SQRLInstallerOwnedBundleKey;
 
 // The defaults key to store the number of installation attempts that have been
 // made.
 extern NSString * const SQRLShipItInstallationAttemptsKey;
+
+@class SQRLInstallJournal;
+@class SQRLInstallMetrics;
+
+@interface SQRLInstaller ()
+
+// Where to record how long each phase of installation takes.
+//
+// If nil, phases aren't measured.
+@property (atomic, strong) SQRLInstallMetrics *metrics;
+
+// Whether processes still running from inside the target bundle, like
+// helpers, should be terminated once the application has exited.
+//
+// This is opt-in, by setting the `SquirrelMacTerminateBundleProcesses` user
+// default, since the processes may be doing work the user cares about.
+@property (nonatomic, assign, readonly) BOOL terminatesBundleProcesses;
+
+// The journal of completed installation steps, which an interrupted
+// installation is resumed from.
+@property (nonatomic, strong, readonly) SQRLInstallJournal *journal;
+
+@end
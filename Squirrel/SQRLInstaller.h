@@ -41,12 +41,13 @@ extern const NSInteger SQRLInstallerErrorChangingPermissions;
 extern const NSInteger SQRLInstallerErrorAppStillRunning;
 
 @class RACCommand;
+@class RACSignal;
 
 // Performs the installation of an update, saving its intermediate state to user
 // defaults.
 //
-// This class is meant to be used only after the app that will be updated has
-// terminated.
+// Apart from `prepareUpdateCommand`, this class is meant to be used only after
+// the app that will be updated has terminated.
 @interface SQRLInstaller : NSObject
 
 // Initializes an installer using the given application identifier, which is
@@ -63,6 +64,21 @@ extern const NSInteger SQRLInstallerErrorAppStillRunning;
 // installation has completed or failed.
 @property (nonatomic, strong, readonly) RACCommand *installUpdateCommand;
 
+// When executed with a `SQRLShipItRequest`, copies, clears the quarantine of,
+// takes ownership of, and verifies the update ahead of installation.
+//
+// This can be executed while the application being updated is still running,
+// so that once it terminates, `installUpdateCommand` only has to check that the
+// prepared update is still intact and move it into place. If the request has
+// changed by then, or the prepared update has been tampered with,
+// `installUpdateCommand` prepares the update again itself.
+//
+// This must not be executed while `installUpdateCommand` is executing.
+//
+// Each execution will complete or error on an unspecified scheduler once the
+// update has been prepared.
+@property (nonatomic, strong, readonly) RACCommand *prepareUpdateCommand;
+
 // When executed with a `SQRLShipItRequest`, aborts an installation, and
 // attempts to restore the old version of the application if necessary.
 //
@@ -72,4 +88,30 @@ extern const NSInteger SQRLInstallerErrorAppStillRunning;
 // aborting/recovery has finished.
 @property (nonatomic, strong, readonly) RACCommand *abortInstallationCommand;
 
+// Deletes the bundles left over from the last installation, like the version
+// of the application that was replaced and the update it was replaced with.
+//
+// `installUpdateCommand` leaves these in place, so that the updated
+// application can be relaunched without waiting for them to be deleted. They're
+// tracked in resumable state until this finishes, so they're never forgotten
+// if it's interrupted.
+//
+// Returns a signal which completes on an unspecified scheduler. Failures to
+// delete individual bundles are logged rather than sent.
+- (RACSignal *)removeLeftoverBundles;
+
+// Removes the temporary directories that earlier installations created for
+// copies of bundles, but failed to clean up, including the staging directories
+// of copies across volumes that were interrupted.
+//
+// Directories still referenced by resumable state are kept, as are any
+// directories created after this signal is subscribed to.
+//
+// timeout - How long to spend removing directories. Any that haven't been
+//           removed in time are left for the next collection.
+//
+// Returns a signal which sends the number of bytes reclaimed as an `NSNumber`,
+// then completes on an unspecified scheduler.
+- (RACSignal *)removeLeakedTemporaryDirectoriesWithTimeout:(NSTimeInterval)timeout;
+
 @end
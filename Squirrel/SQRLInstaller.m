@@ -7,24 +7,33 @@
 //
 
 #import "SQRLInstaller.h"
+#import "SQRLInstaller+Private.h"
 
+#import <fcntl.h>
 #import <libkern/OSAtomic.h>
 #import <mach-o/dyld.h>
+#import <stdio.h>
 #import <sys/param.h>
+#import <sys/stat.h>
 #import <unistd.h>
 #import <ReactiveObjC/EXTScope.h>
-#import <ReactiveObjC/NSEnumerator+RACSequenceAdditions.h>
+#import <ReactiveObjC/NSArray+RACSequenceAdditions.h>
 #import <ReactiveObjC/NSObject+RACPropertySubscribing.h>
 #import <ReactiveObjC/RACCommand.h>
+#import <ReactiveObjC/RACScheduler.h>
 #import <ReactiveObjC/RACSequence.h>
 #import <ReactiveObjC/RACSignal+Operations.h>
-#import <ReactiveObjC/RACSubscriber.h>
+#import <ReactiveObjC/RACTuple.h>
 #import <sys/xattr.h>
 
 #import "NSBundle+SQRLVersionExtensions.h"
 #import "NSError+SQRLVerbosityExtensions.h"
 #import "RACSignal+SQRLTransactionExtensions.h"
+#import "SQRLBundleDifference.h"
 #import "SQRLCodeSignature.h"
+#import "SQRLFileTreeWalker.h"
+#import "SQRLInstallJournal.h"
+#import "SQRLInstallMetrics.h"
 #import "SQRLShipItRequest.h"
 #import "SQRLTerminationListener.h"
 #import "SQRLInstallerOwnedBundle.h"
@@ -44,6 +53,37 @@ const NSInteger SQRLInstallerErrorAppStillRunning = -9;
 NSString * const SQRLShipItInstallationAttemptsKey = @"SQRLShipItInstallationAttempts";
 NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 
+// The number of leaked temporary directories to remove at once, each of which
+// is itself removed by a pool of workers.
+static const NSInteger SQRLInstallerMaximumConcurrentCollections = 2;
+
+// The length of the random suffix, with its leading dot, that
+// -moveItemAcrossVolumesToURL:fromURL:walker: appends to the name of a target
+// to name its staging directory.
+static const NSUInteger SQRLInstallerStagingSuffixLength = 9;
+
+// The name that -replaceItemAtURL:withItemAtURL: moves a target aside to,
+// beside the item replacing it, when the volume can't exchange them.
+static NSString * const SQRLInstallerAsideName = @"Replaced";
+
+// The steps recorded in the install journal.
+//
+// An update has been prepared and verified, ready to be installed.
+static NSString * const SQRLInstallerJournalStepPrepared = @"prepared";
+// `ownedBundle` has been set.
+static NSString * const SQRLInstallerJournalStepOwned = @"owned";
+// `ownedBundle` has been cleared.
+static NSString * const SQRLInstallerJournalStepReleased = @"released";
+// The target has been replaced, and only the leftover bundles remain to be
+// deleted.
+static NSString * const SQRLInstallerJournalStepSwapped = @"swapped";
+// A hidden directory has been created beside a target on another volume, to
+// copy an update into.
+static NSString * const SQRLInstallerJournalStepStaging = @"staging";
+// A target is about to be moved aside, to be replaced by hand on a volume that
+// can't exchange items.
+static NSString * const SQRLInstallerJournalStepAside = @"aside";
+
 @interface SQRLInstaller ()
 
 // The defaults domain to store all resumable state in.
@@ -51,10 +91,68 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 
 // The bundle currently owned by this installer.
 //
-// Stores the bundle moved aside by an install request so that the original
-// bundle can be restored to its original location if needed.
+// Stores the bundle moved aside (or exchanged) by an install request so that
+// the original bundle can be restored to its original location if needed.
+// Every change is recorded in `journal` before the setter returns.
 @property (atomic, strong) SQRLInstallerOwnedBundle *ownedBundle;
 
+// The request most recently prepared by `prepareUpdateCommand`, or nil if
+// nothing has been prepared ahead of installation.
+@property (atomic, strong) SQRLShipItRequest *stagedRequest;
+
+// The prepared update for `stagedRequest`.
+@property (atomic, copy) NSURL *stagedUpdateBundleURL;
+
+// The inode number of `stagedUpdateBundleURL` when it was verified.
+@property (atomic, copy) NSNumber *stagedUpdateBundleInode;
+
+// The request whose target has been replaced, but whose leftover bundles
+// haven't been deleted yet, or nil if no installation is that far along.
+@property (atomic, strong) SQRLShipItRequest *swappedRequest;
+
+// The bundles left over from installing `swappedRequest`.
+@property (atomic, copy) NSArray *swappedLeftoverURLs;
+
+// The staging directories journaled by earlier installers, which are left
+// behind if they were interrupted while copying across volumes.
+@property (atomic, copy) NSArray *journaledStagingURLs;
+
+// The defaults that installer options are read from.
+//
+// Options are normally set by the application being updated, so when running
+// under ShipIt this includes the parent application's domain as well as our
+// own.
+@property (nonatomic, strong, readonly) NSUserDefaults *installerDefaults;
+
+// Restores the state recorded in `journal` by an earlier installer, and moves
+// any owned bundle saved by an earlier version into the journal.
+- (void)restoreJournaledState;
+
+// Moves a target back into place if an earlier installer was interrupted
+// after moving it aside, but before replacing it.
+//
+// targetURL - The target that was moved aside. This must not be nil.
+// asideURL  - Where the target was moved to. This must not be nil.
+- (void)restoreTargetAtURL:(NSURL *)targetURL fromAsideURL:(NSURL *)asideURL;
+
+// Reads the `SQRLInstallerOwnedBundle` that earlier versions archived into the
+// preferences.
+//
+// Returns the owned bundle, or nil if there isn't one.
+- (SQRLInstallerOwnedBundle *)legacyOwnedBundle;
+
+// Durably records that a step of installation has completed.
+//
+// Failures are logged, since the installation can continue regardless; it just
+// can't be resumed from this step.
+//
+// step    - The step that completed. This must not be nil.
+// payload - The state to restore when resuming from `step`. This may be nil.
+- (void)recordJournalStep:(NSString *)step payload:(NSDictionary *)payload;
+
+// Discards every step recorded in `journal`, and the state restored from it.
+- (void)resetJournal;
+
 // Reads the given key from `request`, failing if it's not set.
 //
 // key     - The property key to read from `request`. This must not be nil, and
@@ -65,6 +163,75 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 // completes, or errors.
 - (RACSignal *)getRequiredKey:(NSString *)key fromRequest:(SQRLShipItRequest *)request;
 
+// Measures `signal` as the given phase of installation, if `metrics` is set.
+//
+// name   - The name of the phase. This must not be nil.
+// signal - The work making up the phase. This must not be nil.
+// walker - The walker performing the phase's work, whose item and byte counts
+//          should be recorded. This may be nil.
+//
+// Returns a signal which forwards the events of `signal`.
+- (RACSignal *)measurePhase:(NSString *)name ofSignal:(RACSignal *)signal countingItemsOfWalker:(SQRLFileTreeWalker *)walker;
+
+// Checks that the target of `request` is a canonical path, and when running
+// privileged, that it's the application containing this installer.
+//
+// request - The request to validate. This must not be nil.
+//
+// Returns a signal which synchronously sends a copy of `request` with the
+// canonical target URL then completes, or errors.
+- (RACSignal *)canonicalRequestForRequest:(SQRLShipItRequest *)request;
+
+// Prepares and validates the update of `request`, and remembers the result so
+// that -installRequest: can skip doing so again.
+//
+// If the same update was already prepared, by this installer or one before it
+// that recorded it in `journal`, and it's still intact, nothing is done.
+//
+// request - The request whose update should be prepared. This must not be nil.
+//
+// Returns a signal which completes, or errors.
+- (RACSignal *)prepareRequest:(SQRLShipItRequest *)request;
+
+// Finds the prepared update for the given canonical request.
+//
+// If -prepareRequest: already prepared this request, and the prepared update is
+// still intact, that's used as-is. Otherwise the update is prepared now.
+//
+// request - The canonical request to install. This must not be nil.
+//
+// Returns a signal which sends the owned & validated bundle URL then completes,
+// or errors.
+- (RACSignal *)preparedUpdateBundleURLForRequest:(SQRLShipItRequest *)request;
+
+// Checks whether the update already prepared by -prepareRequest: can be used to
+// install the given canonical request.
+//
+// If it can't, because it was prepared for another request or has changed
+// since it was verified, it's deleted and forgotten.
+//
+// request - The canonical request to install. This must not be nil.
+//
+// Returns a signal which sends the prepared update's URL then completes if it
+// can be used, or just completes otherwise.
+- (RACSignal *)reusableStagedUpdateBundleURLForRequest:(SQRLShipItRequest *)request;
+
+// Checks that an update prepared by -prepareRequest: is still the item that
+// was verified, and still can't be modified by anyone else.
+//
+// Prepared updates live in a directory from -ownedTemporaryDirectoryURL, which
+// only we can write to, and -takeOwnershipOfDirectory: removes write access for
+// anyone but us from the bundle. Confirming that both still hold, and that the
+// bundle is the same item, lets us trust the earlier verification without
+// reading the whole bundle again.
+//
+// bundleURL - The prepared update. This must not be nil.
+// inode     - The inode number of the update when it was verified. This must
+//             not be nil.
+//
+// Returns whether the prepared update can still be installed.
+- (BOOL)isStagedUpdateIntactAtURL:(NSURL *)bundleURL inode:(NSNumber *)inode;
+
 // Moves the updateBundleURL to an owned directory to prevent symlink attack,
 // takes user:group ownership of the bundle, then verifies that it meets the
 // designated requirement of the targetBundleURL.
@@ -76,7 +243,7 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 - (RACSignal *)prepareAndValidateUpdateBundleURLForRequest:(SQRLShipItRequest *)request;
 
 // Saves a `SQRLInstallerOwnedBundle` for the targetBundleURL to the
-// preferences, then moves the targetBundleURL to an owned directory.
+// install journal, then moves the targetBundleURL to an owned directory.
 //
 // request - The request whose target should be removed in preparation of an
 //           update being installed.
@@ -84,32 +251,169 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 // Returns a signal which completes, or errors.
 - (RACSignal *)acquireTargetBundleURLForRequest:(SQRLShipItRequest *)request;
 
+// Replaces the target of `request` with the prepared update.
+//
+// If `SquirrelMacEnableDifferentialContentsWrite` is set along with
+// `SquirrelMacEnableDirectContentsWrite`, only the items that changed are
+// exchanged into the target. If `SquirrelMacEnableAtomicBundleExchange` is set,
+// the target and the update are exchanged in a single rename, so the target
+// location never stops existing. Otherwise, or if the volume can't exchange
+// items, the target is moved aside with -acquireTargetBundleURLForRequest: and
+// the update is moved into its place.
+//
+// request         - The request whose target should be replaced. This must
+//                   not be nil.
+// updateBundleURL - The prepared and validated update, as sent from
+//                   -prepareAndValidateUpdateBundleURLForRequest:. This must
+//                   not be nil.
+//
+// Returns a signal which synchronously sends the URL of the bundle now holding
+// the replaced target, then completes, or errors.
+- (RACSignal *)replaceTargetBundleForRequest:(SQRLShipItRequest *)request withUpdateBundleURL:(NSURL *)updateBundleURL;
+
+// Saves a `SQRLInstallerOwnedBundle` describing the exchange to the
+// install journal, then exchanges the target of `request` with `updateBundleURL`.
+//
+// request         - The request whose target should be exchanged. This must
+//                   not be nil.
+// updateBundleURL - The prepared and validated update. This must not be nil.
+//
+// Returns a signal which synchronously completes, or errors. If the exchange
+// itself fails, the error is in `NSPOSIXErrorDomain` and nothing is left owned.
+- (RACSignal *)exchangeTargetBundleForRequest:(SQRLShipItRequest *)request withUpdateBundleURL:(NSURL *)updateBundleURL;
+
+// Saves a `SQRLInstallerOwnedBundle` listing the items that differ between the
+// `Contents` of the target of `request` and of `updateBundleURL` to the
+// install journal, then exchanges only those items.
+//
+// request         - The request whose target should be updated in place. This
+//                   must not be nil.
+// updateBundleURL - The prepared and validated update. This must not be nil.
+//
+// Returns a signal which completes, or errors. If applying the changes fails,
+// any that were applied are reverted, and nothing is left owned.
+- (RACSignal *)applyDifferentialUpdateForRequest:(SQRLShipItRequest *)request withUpdateBundleURL:(NSURL *)updateBundleURL;
+
+// Whether installs should update the `Contents` of the target in place, only
+// replacing the items that changed, rather than moving the whole directory.
+//
+// targetURL - The bundle being replaced. This must not be nil.
+// sourceURL - The bundle replacing it. This must not be nil.
+- (BOOL)shouldApplyDifferentiallyWithTargetURL:(NSURL *)targetURL sourceURL:(NSURL *)sourceURL;
+
+// Undoes an exchange saved by
+// -exchangeTargetBundleForRequest:withUpdateBundleURL:.
+//
+// The exchange is a single rename, so the original item is always in exactly
+// one of the two locations. It's found by inode number and exchanged back if
+// needed.
+//
+// ownedBundle - The exchanged bundle to restore. This must not be nil.
+//
+// Returns a signal which synchronously completes, or errors.
+- (RACSignal *)restoreExchangedBundle:(SQRLInstallerOwnedBundle *)ownedBundle;
+
+// Records that the target of `request` has been replaced, so that an
+// interrupted installation only needs to delete the leftover bundles.
+//
+// request      - The request that was installed. This must not be nil.
+// leftoverURLs - The bundles to delete. This must not be nil.
+- (void)recordSwappedRequest:(SQRLShipItRequest *)request leftoverURLs:(NSArray *)leftoverURLs;
+
+// Finds the directories created by -ownedTemporaryDirectoryURL that are no
+// longer referenced by `ownedBundle`, the prepared update, or the leftovers of
+// a swapped installation, along with any staging directories left behind by
+// an interrupted -moveItemAcrossVolumesToURL:fromURL:walker:. A staging
+// directory is kept while it holds the only copy of its target.
+//
+// Returns the URLs of the unreferenced directories.
+- (NSArray *)leakedTemporaryDirectoryURLs;
+
 // Deletes a bundle that was moved into place using -moveAndTakeOwnershipOfBundleAtURL:.
 //
 // bundleURL - The URL to the backup bundle, as sent from -moveAndTakeOwnershipOfBundleAtURL:.
 //             This must not be nil.
 //
-// Returns a signal which will synchronously complete or error.
+// Returns a signal which will complete or error on a background thread.
 - (RACSignal *)deleteOwnedBundleAtURL:(NSURL *)bundleURL;
 
 // Moves `sourceURL` to `targetURL`.
 //
 // If the two URLs lie on the same volume, the installation will be performed
-// atomically. Otherwise, the target item will be deleted, the source item will
-// be copied to the target, then the source item will be deleted.
+// atomically. Otherwise, the source item is moved with
+// -moveItemAcrossVolumesToURL:fromURL:walker:.
 //
 // targetURL - The URL to overwrite with the install. This must not be nil.
 // sourceURL - The URL to move from. This must not be nil.
 //
-// Retruns a signal which will synchronously complete or error.
+// Retruns a signal which will complete or error, synchronously if the URLs are
+// on the same volume.
 - (RACSignal *)installItemToURL:(NSURL *)targetURL fromURL:(NSURL *)sourceURL;
 
+// Like -installItemToURL:fromURL:, but also measures the move as a phase of
+// installation.
+//
+// phaseName - The name of the phase, which also records the items and bytes
+//             copied. Those are 0 unless the move crosses volumes. If nil,
+//             the move isn't measured.
+- (RACSignal *)installItemToURL:(NSURL *)targetURL fromURL:(NSURL *)sourceURL measuringPhase:(NSString *)phaseName;
+
+// Moves `sourceURL` to `targetURL` on another volume.
+//
+// The source item is copied concurrently into a hidden directory beside
+// `targetURL`, made durable, then renamed over the target, so the target is
+// never left partially written. The source item is deleted afterwards.
+//
+// The hidden directory is journaled before anything is copied into it, so that
+// -removeLeakedTemporaryDirectoriesWithTimeout: can remove it if the copy is
+// interrupted.
+//
+// targetURL - The URL to overwrite with the install. This must not be nil.
+// sourceURL - The URL to move from. This must not be nil.
+// walker    - A walker rooted at `sourceURL` to copy it with, so that the caller
+//             can count what was copied. This must not be nil.
+//
+// Returns a signal which will complete or error on a background thread.
+- (RACSignal *)moveItemAcrossVolumesToURL:(NSURL *)targetURL fromURL:(NSURL *)sourceURL walker:(SQRLFileTreeWalker *)walker;
+
+// Atomically replaces `targetURL` with `sourceURL` on the same volume, leaving
+// the replaced item at `sourceURL`.
+//
+// If the volume can't exchange items, the target is moved aside beside
+// `sourceURL` instead, and that move is journaled first so that an interrupted
+// installer puts the target back when it's relaunched.
+//
+// targetURL - The URL to replace, which need not exist. This must not be nil.
+// sourceURL - The item to move into place. This must not be nil.
+//
+// Returns a signal which will synchronously complete, or error in
+// `NSPOSIXErrorDomain`.
+- (RACSignal *)replaceItemAtURL:(NSURL *)targetURL withItemAtURL:(NSURL *)sourceURL;
+
+// Atomically swaps the items at the two URLs, which must be on the same volume.
+//
+// firstURL  - The item to move to `secondURL`. This must not be nil.
+// secondURL - The item to move to `firstURL`. This must not be nil.
+//
+// Returns a signal which will synchronously complete, or error in
+// `NSPOSIXErrorDomain`.
+- (RACSignal *)exchangeItemAtURL:(NSURL *)firstURL withItemAtURL:(NSURL *)secondURL;
+
+// Whether installs should move the `Contents` directories of the given bundles
+// rather than the bundles themselves.
+//
+// targetURL - The bundle being replaced. This must not be nil.
+// sourceURL - The bundle replacing it. This must not be nil.
+- (BOOL)shouldRenameContentsDirectlyWithTargetURL:(NSURL *)targetURL sourceURL:(NSURL *)sourceURL;
+
 // Recursively clears the quarantine extended attribute from the given
 // directory.
 //
 // This ensures users don't see a warning that the application was downloaded
 // from the Internet.
 //
+// Items which can't be cleared, or listed, are logged and skipped.
+//
 // directory - The directory to recursively clear the quarantine bit upon. This
 //             must not be nil.
 //
@@ -122,13 +426,15 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 // directoryURL - The URL to the folder to take ownership of. This must not be
 //                nil.
 //
-// Returns a signal which will synchronously complete or error.
+// Returns a signal which will complete or error on a background thread.
 - (RACSignal *)takeOwnershipOfDirectory:(NSURL *)directoryURL;
 
 @end
 
 @implementation SQRLInstaller
 
+@synthesize ownedBundle = _ownedBundle;
+
 #pragma mark Lifecycle
 
 - (id)initWithApplicationIdentifier:(NSString *)applicationIdentifier {
@@ -139,6 +445,22 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 
 	_applicationIdentifier = [applicationIdentifier copy];
 
+	_installerDefaults = [[NSUserDefaults alloc] init];
+	[_installerDefaults addSuiteNamed:_applicationIdentifier];
+	// In cases where this code is being executed under the ShipIt executable it's running
+	// under an application identifier equal to {parent_identifier}.ShipIt
+	// In this case we need to use the true parent identifier too as that is 99% of the time
+	// where the key will be set.
+	if ([_applicationIdentifier hasSuffix:@".ShipIt"]) {
+		[_installerDefaults addSuiteNamed:[_applicationIdentifier substringToIndex:[_applicationIdentifier length] - 7]];
+	}
+
+	// Kept alongside the owned directories from -ownedTemporaryDirectoryURL
+	// that it refers to.
+	NSString *journalPath = [[NSTemporaryDirectory() stringByResolvingSymlinksInPath] stringByAppendingPathComponent:[_applicationIdentifier stringByAppendingPathExtension:@"ShipItJournal"]];
+	_journal = [[SQRLInstallJournal alloc] initWithURL:[NSURL fileURLWithPath:journalPath isDirectory:NO]];
+	[self restoreJournaledState];
+
 	@weakify(self);
 
 	RACSignal *aborting = [[[[RACObserve(self, abortInstallationCommand)
@@ -153,6 +475,25 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		@strongify(self);
 		NSParameterAssert(request != nil);
 
+		// If an earlier attempt already replaced the target, the update is
+		// installed, and only the leftover bundles need deleting, which is
+		// left to -removeLeftoverBundles as usual.
+		SQRLShipItRequest *swappedRequest = self.swappedRequest;
+		if (swappedRequest != nil) {
+			if ([swappedRequest.updateBundleURL isEqual:request.updateBundleURL]) {
+				NSLog(@"Finishing installation of %@, which was interrupted after replacing the target", swappedRequest.targetBundleURL);
+
+				SQRLShipItRequest *installedRequest = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:swappedRequest.updateBundleURL targetBundleURL:swappedRequest.targetBundleURL bundleIdentifier:swappedRequest.bundleIdentifier launchAfterInstallation:request.launchAfterInstallation useUpdateBundleName:swappedRequest.useUpdateBundleName];
+				return [RACSignal return:installedRequest];
+			}
+
+			return [[self
+				removeLeftoverBundles]
+				then:^{
+					return [self installRequest:request];
+				}];
+		}
+
 		// Request can be changed between launches, the installer may have
 		// already have an owned bundle, for a previous targetURL.
 		//
@@ -170,6 +511,13 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 			}];
 	}];
 
+	_prepareUpdateCommand = [[RACCommand alloc] initWithEnabled:[self.installUpdateCommand.executing not] signalBlock:^(SQRLShipItRequest *request) {
+		@strongify(self);
+		NSParameterAssert(request != nil);
+
+		return [self prepareRequest:request];
+	}];
+
 	_abortInstallationCommand = [[RACCommand alloc] initWithEnabled:[self.installUpdateCommand.executing not] signalBlock:^(SQRLShipItRequest *request) {
 		@strongify(self);
 
@@ -179,9 +527,130 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 	return self;
 }
 
-#pragma mark Preferences
+#pragma mark Journal
 
 - (SQRLInstallerOwnedBundle *)ownedBundle {
+	@synchronized (self) {
+		return _ownedBundle;
+	}
+}
+
+- (void)setOwnedBundle:(SQRLInstallerOwnedBundle *)ownedBundle {
+	@synchronized (self) {
+		_ownedBundle = ownedBundle;
+
+		if (ownedBundle == nil) {
+			[self recordJournalStep:SQRLInstallerJournalStepReleased payload:nil];
+			return;
+		}
+
+		NSError *error = nil;
+		NSDictionary *JSONDictionary = [MTLJSONAdapter JSONDictionaryFromModel:ownedBundle error:&error];
+		if (JSONDictionary == nil) {
+			NSLog(@"Couldn't serialize ownedBundle - %@", error.localizedDescription);
+			return;
+		}
+
+		[self recordJournalStep:SQRLInstallerJournalStepOwned payload:@{ @"ownedBundle": JSONDictionary }];
+	}
+}
+
+- (void)restoreJournaledState {
+	NSMutableArray *asideRecords = [NSMutableArray array];
+
+	for (NSDictionary *record in self.journal.records) {
+		NSString *step = record[@"step"];
+		NSDictionary *payload = record[@"payload"];
+
+		if ([step isEqual:SQRLInstallerJournalStepPrepared]) {
+			SQRLShipItRequest *request = [MTLJSONAdapter modelOfClass:SQRLShipItRequest.class fromJSONDictionary:payload[@"request"] error:NULL];
+			NSString *updateBundlePath = payload[@"updateBundlePath"];
+			NSNumber *inode = payload[@"inode"];
+			if (request == nil || ![updateBundlePath isKindOfClass:NSString.class] || ![inode isKindOfClass:NSNumber.class]) continue;
+
+			self.stagedUpdateBundleURL = [NSURL fileURLWithPath:updateBundlePath isDirectory:YES];
+			self.stagedUpdateBundleInode = inode;
+			self.stagedRequest = request;
+		} else if ([step isEqual:SQRLInstallerJournalStepOwned]) {
+			NSError *error = nil;
+			SQRLInstallerOwnedBundle *ownedBundle = [MTLJSONAdapter modelOfClass:SQRLInstallerOwnedBundle.class fromJSONDictionary:payload[@"ownedBundle"] error:&error];
+			if (ownedBundle == nil) {
+				NSLog(@"Couldn't read ownedBundle from install journal - %@", error.localizedDescription);
+				continue;
+			}
+
+			@synchronized (self) {
+				_ownedBundle = ownedBundle;
+			}
+		} else if ([step isEqual:SQRLInstallerJournalStepReleased]) {
+			@synchronized (self) {
+				_ownedBundle = nil;
+			}
+		} else if ([step isEqual:SQRLInstallerJournalStepSwapped]) {
+			SQRLShipItRequest *request = [MTLJSONAdapter modelOfClass:SQRLShipItRequest.class fromJSONDictionary:payload[@"request"] error:NULL];
+			NSArray *leftoverPaths = payload[@"leftoverPaths"];
+			if (request == nil || ![leftoverPaths isKindOfClass:NSArray.class]) continue;
+
+			NSMutableArray *leftoverURLs = [NSMutableArray arrayWithCapacity:leftoverPaths.count];
+			for (NSString *path in leftoverPaths) {
+				if (![path isKindOfClass:NSString.class]) continue;
+				[leftoverURLs addObject:[NSURL fileURLWithPath:path isDirectory:YES]];
+			}
+
+			self.swappedLeftoverURLs = leftoverURLs;
+			self.swappedRequest = request;
+		} else if ([step isEqual:SQRLInstallerJournalStepStaging]) {
+			NSString *stagingPath = payload[@"path"];
+			if (![stagingPath isKindOfClass:NSString.class]) continue;
+
+			self.journaledStagingURLs = [(self.journaledStagingURLs ?: @[]) arrayByAddingObject:[NSURL fileURLWithPath:stagingPath isDirectory:YES]];
+		} else if ([step isEqual:SQRLInstallerJournalStepAside]) {
+			if (![payload[@"targetPath"] isKindOfClass:NSString.class] || ![payload[@"asidePath"] isKindOfClass:NSString.class]) continue;
+
+			[asideRecords addObject:payload];
+		}
+	}
+
+	// Put targets back before anything, like collection, can touch the
+	// staging directories they were moved into.
+	for (NSDictionary *payload in asideRecords) {
+		[self restoreTargetAtURL:[NSURL fileURLWithPath:payload[@"targetPath"]] fromAsideURL:[NSURL fileURLWithPath:payload[@"asidePath"]]];
+	}
+
+	// Earlier versions archived the owned bundle into the preferences, which
+	// is only read once here so that an interrupted update from one of them
+	// can still be restored.
+	SQRLInstallerOwnedBundle *legacyOwnedBundle = [self legacyOwnedBundle];
+	if (legacyOwnedBundle == nil) return;
+
+	self.ownedBundle = legacyOwnedBundle;
+
+	CFPreferencesSetValue((__bridge CFStringRef)SQRLInstallerOwnedBundleKey, NULL, (__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+	CFPreferencesSynchronize((__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+}
+
+- (void)restoreTargetAtURL:(NSURL *)targetURL fromAsideURL:(NSURL *)asideURL {
+	NSParameterAssert(targetURL != nil);
+	NSParameterAssert(asideURL != nil);
+
+	const char *targetPath = targetURL.path.fileSystemRepresentation;
+	const char *asidePath = asideURL.path.fileSystemRepresentation;
+
+	// If the target is in place, it was either never moved or already
+	// replaced, and whatever is aside is a leftover.
+	struct stat info;
+	if (lstat(targetPath, &info) == 0 || errno != ENOENT) return;
+	if (lstat(asidePath, &info) != 0) return;
+
+	if (renamex_np(asidePath, targetPath, RENAME_EXCL) != 0) {
+		NSLog(@"Couldn't move %@ back to %@ after an interrupted install, error %@", asideURL, targetURL, [self errorForPOSIXCode:errno URL:targetURL].sqrl_verboseDescription);
+		return;
+	}
+
+	NSLog(@"Moved %@ back to %@ after an interrupted install", asideURL, targetURL);
+}
+
+- (SQRLInstallerOwnedBundle *)legacyOwnedBundle {
 	id archiveData = CFBridgingRelease(CFPreferencesCopyValue((__bridge CFStringRef)SQRLInstallerOwnedBundleKey, (__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost));
 	if (![archiveData isKindOfClass:NSData.class]) return nil;
 
@@ -207,20 +676,34 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 	return ownedBundle;
 }
 
-- (void)setOwnedBundle:(SQRLInstallerOwnedBundle *)ownedBundle {
-	NSData *archiveData = nil;
-	if (ownedBundle != nil) {
-		NSError *error;
-		archiveData = [NSKeyedArchiver archivedDataWithRootObject:ownedBundle
-													requiringSecureCoding:NO
-																					error:&error];
-
-		if (error)
-			NSLog(@"Couldn't archive ownedBundle - %@", error.localizedDescription);
+- (void)recordJournalStep:(NSString *)step payload:(NSDictionary *)payload {
+	NSParameterAssert(step != nil);
+
+	NSMutableDictionary *record = [NSMutableDictionary dictionaryWithObject:step forKey:@"step"];
+	if (payload != nil) record[@"payload"] = payload;
+
+	NSError *error = nil;
+	if (![self.journal appendRecord:record error:&error]) {
+		NSLog(@"Couldn't record install step \"%@\" in %@, error %@", step, self.journal.URL, error.sqrl_verboseDescription);
 	}
+}
 
-	CFPreferencesSetValue((__bridge CFStringRef)SQRLInstallerOwnedBundleKey, (__bridge CFPropertyListRef)archiveData, (__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
-	CFPreferencesSynchronize((__bridge CFStringRef)self.applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+- (void)resetJournal {
+	@synchronized (self) {
+		_ownedBundle = nil;
+	}
+
+	self.stagedRequest = nil;
+	self.stagedUpdateBundleURL = nil;
+	self.stagedUpdateBundleInode = nil;
+	self.swappedRequest = nil;
+	self.swappedLeftoverURLs = nil;
+	self.journaledStagingURLs = nil;
+
+	NSError *error = nil;
+	if (![self.journal removeJournal:&error]) {
+		NSLog(@"Couldn't remove install journal %@, error %@", self.journal.URL, error.sqrl_verboseDescription);
+	}
 }
 
 #pragma mark Properties
@@ -242,6 +725,22 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		setNameWithFormat:@"%@ -getRequiredKey: %@ fromRequest: %@", self, key, request];
 }
 
+- (BOOL)terminatesBundleProcesses {
+	return [self.installerDefaults boolForKey:@"SquirrelMacTerminateBundleProcesses"];
+}
+
+#pragma mark Metrics
+
+- (RACSignal *)measurePhase:(NSString *)name ofSignal:(RACSignal *)signal countingItemsOfWalker:(SQRLFileTreeWalker *)walker {
+	NSParameterAssert(name != nil);
+	NSParameterAssert(signal != nil);
+
+	SQRLInstallMetrics *metrics = self.metrics;
+	if (metrics == nil) return signal;
+
+	return [metrics measurePhase:name ofSignal:signal countingItemsOfWalker:walker];
+}
+
 #pragma mark Installer States
 
 - (RACSignal *)prepareAndValidateUpdateBundleURLForRequest:(SQRLShipItRequest *)request {
@@ -307,7 +806,7 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		}];
 }
 
-- (RACSignal *)installRequest:(SQRLShipItRequest *)request {
+- (RACSignal *)canonicalRequestForRequest:(SQRLShipItRequest *)request {
 	NSParameterAssert(request != nil);
 
 	// Resolve the target bundle path exactly once and use the canonical URL for
@@ -322,7 +821,7 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		};
 		return [RACSignal error:[NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorInvalidState userInfo:errorInfo]];
 	}
-	request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:request.updateBundleURL targetBundleURL:resolvedTargetURL bundleIdentifier:request.bundleIdentifier launchAfterInstallation:request.launchAfterInstallation useUpdateBundleName:request.useUpdateBundleName];
+	SQRLShipItRequest *canonicalRequest = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:request.updateBundleURL targetBundleURL:resolvedTargetURL bundleIdentifier:request.bundleIdentifier launchAfterInstallation:request.launchAfterInstallation useUpdateBundleName:request.useUpdateBundleName];
 
 	// When running privileged, the target must be the app bundle that contains
 	// this installer. This pins the install to a location whose ancestors the
@@ -352,10 +851,134 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		}
 	}
 
+	return [RACSignal return:canonicalRequest];
+}
+
+- (RACSignal *)prepareRequest:(SQRLShipItRequest *)request {
+	NSParameterAssert(request != nil);
+
 	return [[[[self
-		prepareAndValidateUpdateBundleURLForRequest:request]
-		flattenMap:^(NSURL *updateBundleURL) {
+		canonicalRequestForRequest:request]
+		flattenMap:^(SQRLShipItRequest *request) {
+			RACSignal *prepare = [[self
+				prepareAndValidateUpdateBundleURLForRequest:request]
+				doNext:^(NSURL *updateBundleURL) {
+					struct stat info;
+					if (lstat(updateBundleURL.path.fileSystemRepresentation, &info) != 0) return;
+
+					self.stagedUpdateBundleURL = updateBundleURL;
+					self.stagedUpdateBundleInode = @(info.st_ino);
+					self.stagedRequest = request;
+
+					NSDictionary *requestDictionary = [MTLJSONAdapter JSONDictionaryFromModel:(id)request error:NULL];
+					if (requestDictionary != nil) {
+						[self recordJournalStep:SQRLInstallerJournalStepPrepared payload:@{
+							@"request": requestDictionary,
+							@"updateBundlePath": updateBundleURL.path,
+							@"inode": @(info.st_ino),
+						}];
+					}
+
+					NSLog(@"Prepared update %@ ahead of installation", updateBundleURL);
+				}];
+
 			return [[[[self
+				reusableStagedUpdateBundleURLForRequest:request]
+				doNext:^(NSURL *updateBundleURL) {
+					NSLog(@"Update %@ was already prepared ahead of installation", updateBundleURL);
+				}]
+				concat:prepare]
+				take:1];
+		}]
+		ignoreValues]
+		setNameWithFormat:@"%@ -prepareRequest: %@", self, request];
+}
+
+- (RACSignal *)preparedUpdateBundleURLForRequest:(SQRLShipItRequest *)request {
+	NSParameterAssert(request != nil);
+
+	return [[[[[self
+		reusableStagedUpdateBundleURLForRequest:request]
+		doNext:^(NSURL *updateBundleURL) {
+			NSLog(@"Using update %@ prepared ahead of installation", updateBundleURL);
+
+			// Don't install the same prepared update twice.
+			self.stagedRequest = nil;
+		}]
+		concat:[self prepareAndValidateUpdateBundleURLForRequest:request]]
+		take:1]
+		setNameWithFormat:@"%@ -preparedUpdateBundleURLForRequest: %@", self, request];
+}
+
+- (RACSignal *)reusableStagedUpdateBundleURLForRequest:(SQRLShipItRequest *)request {
+	NSParameterAssert(request != nil);
+
+	return [[RACSignal
+		defer:^{
+			SQRLShipItRequest *stagedRequest = self.stagedRequest;
+			NSURL *stagedUpdateBundleURL = self.stagedUpdateBundleURL;
+			NSNumber *stagedUpdateBundleInode = self.stagedUpdateBundleInode;
+
+			if (stagedUpdateBundleURL == nil) return [RACSignal empty];
+
+			// The request is rewritten to relaunch after installation, so only
+			// compare the bundles involved.
+			BOOL sameBundles = [stagedRequest.updateBundleURL isEqual:request.updateBundleURL] && [stagedRequest.targetBundleURL isEqual:request.targetBundleURL];
+			if (sameBundles && stagedUpdateBundleInode != nil && [self isStagedUpdateIntactAtURL:stagedUpdateBundleURL inode:stagedUpdateBundleInode]) {
+				return [RACSignal return:stagedUpdateBundleURL];
+			}
+
+			NSLog(@"Update prepared ahead of installation at %@ can't be used, removing it", stagedUpdateBundleURL);
+
+			self.stagedRequest = nil;
+			self.stagedUpdateBundleURL = nil;
+			self.stagedUpdateBundleInode = nil;
+
+			return [[[self
+				deleteOwnedBundleAtURL:stagedUpdateBundleURL]
+				doError:^(NSError *error) {
+					NSLog(@"Couldn't remove prepared update at location %@, error %@", stagedUpdateBundleURL, error.sqrl_verboseDescription);
+				}]
+				catchTo:[RACSignal empty]];
+		}]
+		setNameWithFormat:@"%@ -reusableStagedUpdateBundleURLForRequest: %@", self, request];
+}
+
+- (BOOL)isStagedUpdateIntactAtURL:(NSURL *)bundleURL inode:(NSNumber *)inode {
+	NSParameterAssert(bundleURL != nil);
+	NSParameterAssert(inode != nil);
+
+	BOOL (^isOwnedDirectory)(NSURL *, struct stat *) = ^(NSURL *URL, struct stat *info) {
+		if (lstat(URL.path.fileSystemRepresentation, info) != 0) return NO;
+		if (!S_ISDIR(info->st_mode)) return NO;
+		if (info->st_uid != geteuid()) return NO;
+
+		return (BOOL)((info->st_mode & (S_IWGRP | S_IWOTH)) == 0);
+	};
+
+	struct stat directoryInfo;
+	if (!isOwnedDirectory(bundleURL.URLByDeletingLastPathComponent, &directoryInfo)) return NO;
+
+	struct stat bundleInfo;
+	if (!isOwnedDirectory(bundleURL, &bundleInfo)) return NO;
+
+	return bundleInfo.st_ino == (ino_t)inode.unsignedLongLongValue;
+}
+
+- (RACSignal *)installRequest:(SQRLShipItRequest *)request {
+	NSParameterAssert(request != nil);
+
+	return [[[[[[self
+		canonicalRequestForRequest:request]
+		flattenMap:^(SQRLShipItRequest *request) {
+			return [[self
+				preparedUpdateBundleURLForRequest:request]
+				map:^(NSURL *updateBundleURL) {
+					return RACTuplePack(request, updateBundleURL);
+				}];
+		}]
+		reduceEach:^(SQRLShipItRequest *request, NSURL *updateBundleURL) {
+			return [[[self
 				renameIfNeeded:request updateBundleURL:updateBundleURL]
 				flattenMap:^(SQRLShipItRequest *request) {
 					// Final validation that the application is not running again;
@@ -374,34 +997,161 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 						return [RACSignal error:[NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorAppStillRunning userInfo:errorInfo]];
 					}
 
-					return [[self acquireTargetBundleURLForRequest:request] concat:[RACSignal return:request]];
+					return [RACSignal return:request];
 				}]
 				flattenMap:^(SQRLShipItRequest *request) {
-					return [[[[[[self
-						installItemToURL:request.targetBundleURL fromURL:updateBundleURL]
-						concat:[RACSignal return:request.updateBundleURL]]
-						concat:[RACSignal return:updateBundleURL]]
-						concat:[RACSignal defer:^{
-							return [RACSignal return:self.ownedBundle.temporaryURL];
-						}]]
-						flattenMap:^(NSURL *location) {
-							return [[[self
-								deleteOwnedBundleAtURL:location]
-								doError:^(NSError *error) {
-									NSLog(@"Couldn't remove owned bundle at location %@, error %@", location, error.sqrl_verboseDescription);
-								}]
-								catchTo:[RACSignal empty]];
-						}]
-						concat:[RACSignal return:request]];
-				}]
-				doCompleted:^{
-					self.ownedBundle = nil;
+					return [[[self
+						replaceTargetBundleForRequest:request withUpdateBundleURL:updateBundleURL]
+						map:^(NSURL *replacedBundleURL) {
+							// An exchange leaves the replaced bundle where the
+							// update was staged, so don't delete it twice.
+							//
+							// Deleting them is left to -removeLeftoverBundles,
+							// so the application can be relaunched first.
+							NSOrderedSet *locations = [NSOrderedSet orderedSetWithArray:@[ request.updateBundleURL, updateBundleURL, replacedBundleURL ]];
+							[self recordSwappedRequest:request leftoverURLs:locations.array];
+
+							return request;
+						}];
 				}];
 		}]
+		flatten]
 		sqrl_addTransactionWithName:NSLocalizedString(@"Updating", nil) description:NSLocalizedString(@"%@ is being updated, and interrupting the process could corrupt the application", nil), request.targetBundleURL.path]
 		setNameWithFormat:@"%@ -installRequest: %@", self, request];
 }
 
+- (RACSignal *)replaceTargetBundleForRequest:(SQRLShipItRequest *)request withUpdateBundleURL:(NSURL *)updateBundleURL {
+	NSParameterAssert(request != nil);
+	NSParameterAssert(updateBundleURL != nil);
+
+	RACSignal *moveAside = [RACSignal defer:^{
+		return [[[self
+			measurePhase:@"acquire" ofSignal:[self acquireTargetBundleURLForRequest:request] countingItemsOfWalker:nil]
+			concat:[self installItemToURL:request.targetBundleURL fromURL:updateBundleURL measuringPhase:@"swap"]]
+			concat:[RACSignal defer:^{
+				return [RACSignal return:self.ownedBundle.temporaryURL];
+			}]];
+	}];
+
+	// Like SquirrelMacEnableDirectContentsWrite, these are behind user
+	// defaults while they're tested at scale.
+	RACSignal *exchange = nil;
+	if ([self shouldApplyDifferentiallyWithTargetURL:request.targetBundleURL sourceURL:updateBundleURL]) {
+		exchange = [self applyDifferentialUpdateForRequest:request withUpdateBundleURL:updateBundleURL];
+	} else if ([self.installerDefaults boolForKey:@"SquirrelMacEnableAtomicBundleExchange"]) {
+		exchange = [self exchangeTargetBundleForRequest:request withUpdateBundleURL:updateBundleURL];
+	} else {
+		return [moveAside setNameWithFormat:@"%@ -replaceTargetBundleForRequest: %@ withUpdateBundleURL: %@", self, request, updateBundleURL];
+	}
+
+	// Either way, the replaced items end up where the update was staged.
+	return [[[exchange
+		concat:[RACSignal return:updateBundleURL]]
+		catch:^(NSError *error) {
+			// Not every volume supports exchanging, but those that don't can
+			// still be updated by moving the target aside.
+			if (![error.domain isEqual:NSPOSIXErrorDomain]) return [RACSignal error:error];
+			if (error.code != ENOTSUP && error.code != EINVAL && error.code != EXDEV) return [RACSignal error:error];
+
+			NSLog(@"Couldn't exchange %@ with %@, moving it aside instead: %@", request.targetBundleURL, updateBundleURL, error.sqrl_verboseDescription);
+			return moveAside;
+		}]
+		setNameWithFormat:@"%@ -replaceTargetBundleForRequest: %@ withUpdateBundleURL: %@", self, request, updateBundleURL];
+}
+
+- (RACSignal *)exchangeTargetBundleForRequest:(SQRLShipItRequest *)request withUpdateBundleURL:(NSURL *)updateBundleURL {
+	NSParameterAssert(request != nil);
+	NSParameterAssert(updateBundleURL != nil);
+
+	return [[[self
+		codeSignatureForBundleAtURL:request.targetBundleURL]
+		flattenMap:^(SQRLCodeSignature *codeSignature) {
+			BOOL exchangeContents = [self shouldRenameContentsDirectlyWithTargetURL:request.targetBundleURL sourceURL:updateBundleURL];
+			NSURL *targetURL = exchangeContents ? [request.targetBundleURL URLByAppendingPathComponent:@"Contents"] : request.targetBundleURL;
+			NSURL *sourceURL = exchangeContents ? [updateBundleURL URLByAppendingPathComponent:@"Contents"] : updateBundleURL;
+
+			struct stat targetInfo;
+			if (lstat(targetURL.path.fileSystemRepresentation, &targetInfo) != 0) {
+				return [RACSignal error:[self errorForPOSIXCode:errno URL:targetURL]];
+			}
+
+			self.ownedBundle = [[SQRLInstallerOwnedBundle alloc] initWithOriginalURL:targetURL temporaryURL:sourceURL codeSignature:codeSignature originalInode:@(targetInfo.st_ino)];
+
+			return [[self
+				measurePhase:@"swap" ofSignal:[self exchangeItemAtURL:targetURL withItemAtURL:sourceURL] countingItemsOfWalker:nil]
+				doError:^(NSError *error) {
+					self.ownedBundle = nil;
+				}];
+		}]
+		setNameWithFormat:@"%@ -exchangeTargetBundleForRequest: %@ withUpdateBundleURL: %@", self, request, updateBundleURL];
+}
+
+- (RACSignal *)applyDifferentialUpdateForRequest:(SQRLShipItRequest *)request withUpdateBundleURL:(NSURL *)updateBundleURL {
+	NSParameterAssert(request != nil);
+	NSParameterAssert(updateBundleURL != nil);
+
+	NSURL *targetURL = [request.targetBundleURL URLByAppendingPathComponent:@"Contents"];
+	NSURL *sourceURL = [updateBundleURL URLByAppendingPathComponent:@"Contents"];
+	SQRLBundleDifference *difference = [[SQRLBundleDifference alloc] initWithTargetURL:targetURL sourceURL:sourceURL];
+
+	return [[[[RACSignal
+		zip:@[
+			[self codeSignatureForBundleAtURL:request.targetBundleURL],
+			[self measurePhase:@"diff" ofSignal:[difference changes] countingItemsOfWalker:nil],
+		]]
+		reduceEach:^(SQRLCodeSignature *codeSignature, NSArray *changes) {
+			NSLog(@"Updating %@ in place with %lu changed items", targetURL, (unsigned long)changes.count);
+
+			self.ownedBundle = [[SQRLInstallerOwnedBundle alloc] initWithOriginalURL:targetURL temporaryURL:sourceURL codeSignature:codeSignature differentialChanges:changes];
+
+			return [[self
+				measurePhase:@"swap" ofSignal:[difference applyChanges:changes] countingItemsOfWalker:nil]
+				catch:^(NSError *error) {
+					// Put back whatever was changed before the failure, so
+					// the target is left as it was.
+					return [[[difference
+						revertChanges:changes]
+						doCompleted:^{
+							self.ownedBundle = nil;
+						}]
+						concat:[RACSignal error:error]];
+				}];
+		}]
+		flatten]
+		setNameWithFormat:@"%@ -applyDifferentialUpdateForRequest: %@ withUpdateBundleURL: %@", self, request, updateBundleURL];
+}
+
+- (RACSignal *)restoreExchangedBundle:(SQRLInstallerOwnedBundle *)ownedBundle {
+	NSParameterAssert(ownedBundle != nil);
+
+	return [[RACSignal
+		defer:^{
+			ino_t originalInode = (ino_t)ownedBundle.originalInode.unsignedLongLongValue;
+
+			struct stat originalInfo;
+			BOOL originalExists = lstat(ownedBundle.originalURL.path.fileSystemRepresentation, &originalInfo) == 0;
+			if (originalExists && originalInfo.st_ino == originalInode) {
+				NSLog(@"%@ was never exchanged, nothing to restore", ownedBundle.originalURL);
+				return [RACSignal empty];
+			}
+
+			struct stat temporaryInfo;
+			if (lstat(ownedBundle.temporaryURL.path.fileSystemRepresentation, &temporaryInfo) != 0 || temporaryInfo.st_ino != originalInode) {
+				// The install finished, and the original was already deleted.
+				NSLog(@"Original of %@ is no longer at %@, nothing to restore", ownedBundle.originalURL, ownedBundle.temporaryURL);
+				return [RACSignal empty];
+			}
+
+			if (!originalExists) {
+				if (rename(ownedBundle.temporaryURL.path.fileSystemRepresentation, ownedBundle.originalURL.path.fileSystemRepresentation) == 0) return [RACSignal empty];
+				return [RACSignal error:[self errorForPOSIXCode:errno URL:ownedBundle.originalURL]];
+			}
+
+			return [self exchangeItemAtURL:ownedBundle.originalURL withItemAtURL:ownedBundle.temporaryURL];
+		}]
+		setNameWithFormat:@"%@ -restoreExchangedBundle: %@", self, ownedBundle];
+}
+
 - (RACSignal *)abortInstall {
 	// The request may have been tampered with to select a new targetURL to
 	// which the moved bundles should be restored.
@@ -412,15 +1162,76 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 	SQRLInstallerOwnedBundle *ownedBundle = self.ownedBundle;
 	if (ownedBundle == nil) return [RACSignal empty];
 
-	return [[[[self
-		installItemToURL:ownedBundle.originalURL fromURL:ownedBundle.temporaryURL]
+	RACSignal *restore = nil;
+	if (ownedBundle.differential) {
+		SQRLBundleDifference *difference = [[SQRLBundleDifference alloc] initWithTargetURL:ownedBundle.originalURL sourceURL:ownedBundle.temporaryURL];
+		restore = [difference revertChanges:ownedBundle.differentialChanges];
+	} else if (ownedBundle.exchanged) {
+		restore = [self restoreExchangedBundle:ownedBundle];
+	} else {
+		restore = [self installItemToURL:ownedBundle.originalURL fromURL:ownedBundle.temporaryURL];
+	}
+
+	return [[[restore
 		doCompleted:^{
-			self.ownedBundle = nil;
+			// Rolling back an install that had replaced its target leaves
+			// nothing in the journal worth resuming.
+			if (self.swappedRequest != nil) {
+				[self resetJournal];
+			} else {
+				self.ownedBundle = nil;
+			}
 		}]
 		sqrl_addTransactionWithName:NSLocalizedString(@"Aborting update", nil) description:NSLocalizedString(@"An update to %@ is being rolled back, and interrupting the process could corrupt the application", nil), ownedBundle.originalURL.path]
 		setNameWithFormat:@"%@ -abortInstall", self];
 }
 
+- (void)recordSwappedRequest:(SQRLShipItRequest *)request leftoverURLs:(NSArray *)leftoverURLs {
+	NSParameterAssert(request != nil);
+	NSParameterAssert(leftoverURLs != nil);
+
+	self.swappedLeftoverURLs = leftoverURLs;
+	self.swappedRequest = request;
+
+	NSError *error = nil;
+	NSDictionary *requestDictionary = [MTLJSONAdapter JSONDictionaryFromModel:(id)request error:&error];
+	if (requestDictionary == nil) {
+		NSLog(@"Couldn't serialize installed request - %@", error.localizedDescription);
+		return;
+	}
+
+	[self recordJournalStep:SQRLInstallerJournalStepSwapped payload:@{
+		@"request": requestDictionary,
+		@"leftoverPaths": [leftoverURLs valueForKey:@"path"],
+	}];
+}
+
+- (RACSignal *)removeLeftoverBundles {
+	return [[RACSignal
+		defer:^{
+			// Otherwise, resetting the journal could lose an owned bundle that
+			// an abort failed to restore.
+			if (self.swappedRequest == nil) return [RACSignal empty];
+
+			NSArray *leftoverURLs = self.swappedLeftoverURLs ?: @[];
+			return [[[[leftoverURLs.rac_sequence
+				signalWithScheduler:RACScheduler.immediateScheduler]
+				flattenMap:^(NSURL *location) {
+					return [[[self
+						deleteOwnedBundleAtURL:location]
+						doError:^(NSError *error) {
+							NSLog(@"Couldn't remove owned bundle at location %@, error %@", location, error.sqrl_verboseDescription);
+						}]
+						catchTo:[RACSignal empty]];
+				}]
+				ignoreValues]
+				doCompleted:^{
+					[self resetJournal];
+				}];
+		}]
+		setNameWithFormat:@"%@ -removeLeftoverBundles", self];
+}
+
 #pragma mark Bundle Ownership
 
 - (RACSignal *)ownedTemporaryDirectoryURL {
@@ -454,14 +1265,14 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 
 	NSURL *newBundleURL = [directoryURL URLByAppendingPathComponent:bundleURL.lastPathComponent];
 
-	return [[[RACSignal
-		defer:^{
-			NSError *error;
-			BOOL copy = [NSFileManager.defaultManager copyItemAtURL:bundleURL toURL:newBundleURL error:&error];
-			if (!copy) return [RACSignal error:error];
+	// Writes are the bottleneck, so don't run more workers than the
+	// destination volume can keep busy.
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:bundleURL];
+	walker.maximumConcurrentOperations = MIN(walker.maximumConcurrentOperations, [SQRLFileTreeWalker maximumConcurrentOperationsForVolumeAtURL:directoryURL]);
 
-			return [RACSignal return:newBundleURL];
-		}]
+	return [[[[self
+		measurePhase:@"copy" ofSignal:[walker copyItemsToURL:newBundleURL] countingItemsOfWalker:walker]
+		concat:[RACSignal return:newBundleURL]]
 		catch:^(NSError *error) {
 			NSString *description = [NSString stringWithFormat:NSLocalizedString(@"Failed to copy bundle %@ to directory %@", nil), bundleURL, newBundleURL];
 			return [RACSignal error:[self errorByAddingDescription:description code:SQRLInstallerErrorBackupFailed toError:error]];
@@ -472,12 +1283,12 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 - (RACSignal *)deleteOwnedBundleAtURL:(NSURL *)bundleURL {
 	NSParameterAssert(bundleURL != nil);
 
-	return [[[RACSignal
-		defer:^{
-			NSError *error;
-			if ([NSFileManager.defaultManager removeItemAtURL:bundleURL error:&error]) {
-				return [RACSignal empty];
-			} else if ([error.domain isEqualToString:NSCocoaErrorDomain] && error.code == NSFileNoSuchFileError) {
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:bundleURL];
+
+	return [[[[self
+		measurePhase:@"delete" ofSignal:[walker removeItems] countingItemsOfWalker:walker]
+		catch:^(NSError *error) {
+			if ([error.domain isEqualToString:NSCocoaErrorDomain] && error.code == NSFileNoSuchFileError) {
 				// The bundle was already moved into place by installItemToURL:;
 				// proceed so the parent mkdtemp directory still gets removed.
 				return [RACSignal empty];
@@ -513,6 +1324,105 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		setNameWithFormat:@"%@ -deleteOwnedBundleAtURL: %@", self, bundleURL];
 }
 
+- (NSArray *)leakedTemporaryDirectoryURLs {
+	NSString *tmpPath = [NSTemporaryDirectory() stringByResolvingSymlinksInPath];
+	NSString *prefix = [self.applicationIdentifier stringByAppendingString:@"."];
+
+	NSMutableArray *referencedPaths = [NSMutableArray array];
+	SQRLInstallerOwnedBundle *ownedBundle = self.ownedBundle;
+	if (ownedBundle.temporaryURL.path != nil) [referencedPaths addObject:ownedBundle.temporaryURL.path];
+	if (self.stagedUpdateBundleURL.path != nil) [referencedPaths addObject:self.stagedUpdateBundleURL.path];
+	for (NSURL *URL in self.swappedLeftoverURLs) {
+		[referencedPaths addObject:URL.path];
+	}
+
+	NSCharacterSet *invalidCharacters = NSCharacterSet.alphanumericCharacterSet.invertedSet;
+	NSMutableArray *directoryURLs = [NSMutableArray array];
+
+	for (NSString *name in [NSFileManager.defaultManager contentsOfDirectoryAtPath:tmpPath error:NULL]) {
+		// Match the template from -ownedTemporaryDirectoryURL exactly, so
+		// that the journal, and other identifiers sharing our prefix, are
+		// left alone.
+		if (![name hasPrefix:prefix]) continue;
+
+		NSString *suffix = [name substringFromIndex:prefix.length];
+		if (suffix.length != 8 || [suffix rangeOfCharacterFromSet:invalidCharacters].location != NSNotFound) continue;
+
+		// mkdtemp() creates directories that only we can access.
+		NSString *path = [tmpPath stringByAppendingPathComponent:name];
+		struct stat info;
+		if (lstat(path.fileSystemRepresentation, &info) != 0) continue;
+		if (!S_ISDIR(info.st_mode) || info.st_uid != geteuid() || (info.st_mode & (S_IRWXG | S_IRWXO)) != 0) continue;
+
+		NSString *directoryPrefix = [path stringByAppendingString:@"/"];
+		BOOL referenced = NO;
+		for (NSString *referencedPath in referencedPaths) {
+			if ([referencedPath isEqual:path] || [referencedPath hasPrefix:directoryPrefix]) {
+				referenced = YES;
+				break;
+			}
+		}
+
+		if (referenced) continue;
+
+		[directoryURLs addObject:[NSURL fileURLWithPath:path isDirectory:YES]];
+	}
+
+	// Staging directories are only journaled by earlier installers, so none
+	// of them can still be in use.
+	for (NSURL *stagingURL in self.journaledStagingURLs) {
+		NSString *stagingName = stagingURL.lastPathComponent;
+		if (![stagingName hasPrefix:@"."] || stagingName.length <= SQRLInstallerStagingSuffixLength + 1) continue;
+
+		struct stat info;
+		if (lstat(stagingURL.path.fileSystemRepresentation, &info) != 0) continue;
+		if (!S_ISDIR(info.st_mode) || info.st_uid != geteuid()) continue;
+
+		// If the target was moved aside by -replaceItemAtURL:withItemAtURL:
+		// and never replaced, the staging directory holds the only copy of
+		// it.
+		NSString *asidePath = [stagingURL.path stringByAppendingPathComponent:SQRLInstallerAsideName];
+		NSString *targetName = [stagingName substringWithRange:NSMakeRange(1, stagingName.length - SQRLInstallerStagingSuffixLength - 1)];
+		NSString *targetPath = [stagingURL.path.stringByDeletingLastPathComponent stringByAppendingPathComponent:targetName];
+		if (lstat(asidePath.fileSystemRepresentation, &info) == 0 && lstat(targetPath.fileSystemRepresentation, &info) != 0) {
+			NSLog(@"Keeping staging directory %@, which holds %@ moved aside from %@", stagingURL, asidePath, targetPath);
+			continue;
+		}
+
+		[directoryURLs addObject:stagingURL];
+	}
+
+	return directoryURLs;
+}
+
+- (RACSignal *)removeLeakedTemporaryDirectoriesWithTimeout:(NSTimeInterval)timeout {
+	return [[[[[[RACSignal
+		defer:^{
+			NSArray *directoryURLs = [self leakedTemporaryDirectoryURLs];
+			return [directoryURLs.rac_sequence signalWithScheduler:RACScheduler.immediateScheduler];
+		}]
+		map:^(NSURL *directoryURL) {
+			SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:directoryURL];
+
+			return [[[[walker
+				removeItems]
+				concat:[RACSignal defer:^{
+					NSLog(@"Removed leaked temporary directory %@", directoryURL);
+					return [RACSignal return:@(walker.visitedByteCount)];
+				}]]
+				doError:^(NSError *error) {
+					NSLog(@"Couldn't remove leaked temporary directory %@, error %@", directoryURL, error.sqrl_verboseDescription);
+				}]
+				catchTo:[RACSignal empty]];
+		}]
+		flatten:SQRLInstallerMaximumConcurrentCollections]
+		takeUntil:[[RACSignal return:nil] delay:timeout]]
+		aggregateWithStart:@0 reduce:^(NSNumber *total, NSNumber *byteCount) {
+			return @(total.unsignedLongLongValue + byteCount.unsignedLongLongValue);
+		}]
+		setNameWithFormat:@"%@ -removeLeakedTemporaryDirectoriesWithTimeout: %f", self, timeout];
+}
+
 #pragma mark Verification
 
 - (RACSignal *)codeSignatureForBundleAtURL:(NSURL *)URL {
@@ -533,7 +1443,7 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 	return [[[self
 		takeOwnershipOfDirectory:bundleURL]
 		then:^{
-			return [signature verifyBundleAtURL:bundleURL];
+			return [self measurePhase:@"verify" ofSignal:[signature verifyBundleAtURL:bundleURL] countingItemsOfWalker:nil];
 		}]
 		setNameWithFormat:@"%@ -verifyBundleAtURL: %@ usingSignature: %@", self, bundleURL, signature];
 }
@@ -571,50 +1481,23 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 }
 
 - (RACSignal *)installItemToURL:(NSURL *)targetURL fromURL:(NSURL *)sourceURL {
+	return [self installItemToURL:targetURL fromURL:sourceURL measuringPhase:nil];
+}
+
+- (RACSignal *)installItemToURL:(NSURL *)targetURL fromURL:(NSURL *)sourceURL measuringPhase:(NSString *)phaseName {
 	NSParameterAssert(targetURL != nil);
 	NSParameterAssert(sourceURL != nil);
 
 	NSLog(@"Moving bundle from %@ to %@", sourceURL, targetURL);
 
-	// If both the sourceURL and the targetURL exist we can try to skip a permissions check
-	// by moving Thing.app/Contents directly.  This allows us to update applications without
-	// permission to write files into the parent directory of Thing.app
-	//
-	// There is no known case where these directories don't exist but in order to handle
-	// edge cases / race conditions we'll handle it anyway.
-	//
-	// This exists check is non-atomic with the rename call below but that's OK
-	BOOL canRenameContentsDirectly = FALSE;
-	// For now while this is tested at scale this new option is behind a user default, this
-	// can be set by applications wishing to test this feature at runtime.  If it causes issues
-	// it can be opted out by individual users by setting this key to false explicitly.
-	// Once this has bene tested at scale it will become the default for all Squirrel.Mac
-	// users.
-	NSUserDefaults *defaults = [[NSUserDefaults alloc] init];
-	[defaults addSuiteNamed:_applicationIdentifier];
-	// In cases where this code is being executed under the ShipIt executable it's running
-	// under an application identifier equal to {parent_identifier}.ShipIt
-	// In this case we need to use the true parent identifier too as that is 99% of the time
-	// where the key will be set.
-	if ([_applicationIdentifier hasSuffix:@".ShipIt"]) {
-		[defaults addSuiteNamed:[_applicationIdentifier substringToIndex:[_applicationIdentifier length] - 7]];
-	}
-
-	if ([defaults boolForKey:@"SquirrelMacEnableDirectContentsWrite"]) {
-		canRenameContentsDirectly = [NSFileManager.defaultManager fileExistsAtPath:targetURL.path] && [NSFileManager.defaultManager fileExistsAtPath:sourceURL.path];
-
-		if (canRenameContentsDirectly) {
-			NSLog(@"Moving bundles via 'Contents' folder rename");
-		} else {
-			NSLog(@"Moving bundles directly as one of source / target does not exist.  This is unexpected.");
-		}
-	} else {
-		NSLog(@"Moving bundles directly as SquirrelMacEnableDirectContentsWrite is disabled for app: %@", _applicationIdentifier);
-	}
+	BOOL canRenameContentsDirectly = [self shouldRenameContentsDirectlyWithTargetURL:targetURL sourceURL:sourceURL];
 	NSURL *targetContentsURL = canRenameContentsDirectly ? [targetURL URLByAppendingPathComponent:@"Contents"] : targetURL;
 	NSURL *sourceContentsURL = canRenameContentsDirectly ? [sourceURL URLByAppendingPathComponent:@"Contents"] : sourceURL;
 
-	return [[[[RACSignal
+	// Only visits anything if the move has to copy across volumes.
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:sourceContentsURL];
+
+	RACSignal *install = [[[RACSignal
 		defer:^{
 			// rename() is atomic, NSFileManager sucks.
 			if (rename(sourceContentsURL.path.fileSystemRepresentation, targetContentsURL.path.fileSystemRepresentation) == 0) {
@@ -635,132 +1518,255 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 		catch:^(NSError *error) {
 			if (![error.domain isEqual:NSPOSIXErrorDomain] || error.code != EXDEV) return [RACSignal error:error];
 
-			// If the locations lie on two different volumes, remove the
-			// destination by hand, then perform a move.
-			[NSFileManager.defaultManager removeItemAtURL:targetContentsURL error:NULL];
+			return [[self
+				moveItemAcrossVolumesToURL:targetContentsURL fromURL:sourceContentsURL walker:walker]
+				catch:^(NSError *error) {
+					NSString *description = [NSString stringWithFormat:NSLocalizedString(@"Couldn't move bundle contents %@ across volumes to %@", nil), sourceContentsURL, targetContentsURL];
+					return [RACSignal error:[self errorByAddingDescription:description code:SQRLInstallerErrorMovingAcrossVolumes toError:error]];
+				}];
+		}];
 
-			if ([NSFileManager.defaultManager moveItemAtURL:sourceContentsURL toURL:targetContentsURL error:&error]) {
-				NSLog(@"Moved bundle contents across volumes from %@ to %@", sourceContentsURL, targetContentsURL);
-				return [RACSignal empty];
-			} else {
-				NSString *description = [NSString stringWithFormat:NSLocalizedString(@"Couldn't move bundle contents %@ across volumes to %@", nil), sourceContentsURL, targetContentsURL];
-				return [RACSignal error:[self errorByAddingDescription:description code:SQRLInstallerErrorMovingAcrossVolumes toError:error]];
-			}
-		}]
-		setNameWithFormat:@"%@ -installItemAtURL: %@ fromURL: %@", self, targetContentsURL, sourceContentsURL];
-}
+	if (phaseName != nil) install = [self measurePhase:phaseName ofSignal:install countingItemsOfWalker:walker];
 
-#pragma mark Quarantine Bit Removal
+	return [install setNameWithFormat:@"%@ -installItemAtURL: %@ fromURL: %@", self, targetContentsURL, sourceContentsURL];
+}
 
-- (RACSignal *)clearQuarantineForDirectory:(NSURL *)directory {
-	NSParameterAssert(directory != nil);
+- (RACSignal *)moveItemAcrossVolumesToURL:(NSURL *)targetURL fromURL:(NSURL *)sourceURL walker:(SQRLFileTreeWalker *)walker {
+	NSParameterAssert(targetURL != nil);
+	NSParameterAssert(sourceURL != nil);
+	NSParameterAssert([walker.rootURL isEqual:sourceURL]);
 
-	return [[[RACSignal
+	return [[RACSignal
 		defer:^{
-			NSFileManager *manager = [[NSFileManager alloc] init];
-			NSDirectoryEnumerator *enumerator = [manager enumeratorAtURL:directory includingPropertiesForKeys:nil options:0 errorHandler:^(NSURL *URL, NSError *error) {
-				NSLog(@"Error enumerating item %@ within directory %@: %@", URL, directory, error);
-				return YES;
-			}];
+			// Copy beside the target, so the copy can be renamed into place
+			// once it's complete.
+			NSURL *parentURL = targetURL.URLByDeletingLastPathComponent;
+			NSString *template = [parentURL.path stringByAppendingPathComponent:[NSString stringWithFormat:@".%@.XXXXXXXX", targetURL.lastPathComponent]];
 
-			return enumerator.rac_sequence.signal;
-		}]
-		flattenMap:^(NSURL *URL) {
-			const char *path = URL.path.fileSystemRepresentation;
-			if (removexattr(path, "com.apple.quarantine", XATTR_NOFOLLOW) != 0) {
-				int code = errno;
+			char *stagingPath = strdup(template.fileSystemRepresentation);
+			@onExit {
+				free(stagingPath);
+			};
 
-				// This code just means the extended attribute was never set on the
-				// file to begin with.
-				if (code != ENOATTR) {
-					NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+			if (mkdtemp(stagingPath) == NULL) return [RACSignal error:[self errorForPOSIXCode:errno URL:parentURL]];
 
-					const char *desc = strerror(code);
-					if (desc != NULL) {
-						userInfo[NSLocalizedDescriptionKey] = @(desc);
-					} else {
-						userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Unknown POSIX error", @"");
-					}
+			NSURL *stagingURL = [NSURL fileURLWithPath:[NSFileManager.defaultManager stringWithFileSystemRepresentation:stagingPath length:strlen(stagingPath)] isDirectory:YES];
+			[self recordJournalStep:SQRLInstallerJournalStepStaging payload:@{ @"path": stagingURL.path }];
 
-					userInfo[NSLocalizedFailureReasonErrorKey] = [NSString stringWithFormat:NSLocalizedString(@"Couldn't remove quarantine attribute from \"%@\". This most likely means the file is read-only.", @""), URL.path];
-					userInfo[NSURLErrorKey] = URL;
+			NSURL *copyURL = [stagingURL URLByAppendingPathComponent:targetURL.lastPathComponent];
 
-					return [RACSignal error:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo]];
-				}
-			}
+			// Writes are the bottleneck, so don't run more workers than the
+			// destination volume can keep busy.
+			walker.maximumConcurrentOperations = MIN(walker.maximumConcurrentOperations, [SQRLFileTreeWalker maximumConcurrentOperationsForVolumeAtURL:parentURL]);
 
-			return [RACSignal empty];
+			RACSignal *removeStaging = [[[[SQRLFileTreeWalker alloc]
+				initWithRootURL:stagingURL]
+				removeItems]
+				catch:^(NSError *error) {
+					NSLog(@"Couldn't remove staging directory %@: %@", stagingURL, error.sqrl_verboseDescription);
+					return [RACSignal empty];
+				}];
+
+			// A walker of its own, so that `walker` is left counting the copy.
+			RACSignal *removeSource = [[[[SQRLFileTreeWalker alloc]
+				initWithRootURL:sourceURL]
+				removeItems]
+				catch:^(NSError *error) {
+					NSLog(@"Couldn't remove %@ after moving it across volumes: %@", sourceURL, error.sqrl_verboseDescription);
+					return [RACSignal empty];
+				}];
+
+			NSDate *startDate = [NSDate date];
+
+			return [[[[[walker
+				copyItemsToURL:copyURL]
+				doCompleted:^{
+					NSTimeInterval duration = -startDate.timeIntervalSinceNow;
+					NSLog(@"Copied %llu items (%llu bytes) from %@ to %@ in %.3fs", walker.visitedItemCount, walker.visitedByteCount, sourceURL, copyURL, duration);
+				}]
+				concat:[self replaceItemAtURL:targetURL withItemAtURL:copyURL]]
+				catch:^(NSError *error) {
+					return [removeStaging concat:[RACSignal error:error]];
+				}]
+				concat:[[removeSource
+					concat:removeStaging]
+					doCompleted:^{
+						NSLog(@"Moved bundle contents across volumes from %@ to %@", sourceURL, targetURL);
+					}]];
 		}]
-		setNameWithFormat:@"%@ -clearQuarantineForDirectory: %@", self, directory];
+		setNameWithFormat:@"%@ -moveItemAcrossVolumesToURL: %@ fromURL: %@ walker: %@", self, targetURL, sourceURL, walker];
 }
 
-#pragma mark File Security
-
-- (RACSignal *)readFileSecurityOfURL:(NSURL *)location {
-	NSParameterAssert(location != nil);
+- (RACSignal *)replaceItemAtURL:(NSURL *)targetURL withItemAtURL:(NSURL *)sourceURL {
+	NSParameterAssert(targetURL != nil);
+	NSParameterAssert(sourceURL != nil);
 
 	return [[RACSignal
 		defer:^{
-			NSError *error;
-			NSFileSecurity *fileSecurity;
-			if (![location getResourceValue:&fileSecurity forKey:NSURLFileSecurityKey error:&error]) {
-				return [RACSignal error:error];
+			const char *targetPath = targetURL.path.fileSystemRepresentation;
+			const char *sourcePath = sourceURL.path.fileSystemRepresentation;
+
+			if (renamex_np(sourcePath, targetPath, RENAME_SWAP) != 0) {
+				int code = errno;
+
+				if (code == ENOENT) {
+					// Nothing to replace.
+					if (renamex_np(sourcePath, targetPath, RENAME_EXCL) != 0) return [RACSignal error:[self errorForPOSIXCode:errno URL:targetURL]];
+				} else if (code == ENOTSUP || code == EINVAL) {
+					// The volume can't exchange items, so swap them by hand,
+					// with a brief window where neither is in place.
+					// Journal it first, so that a relaunched installer can
+					// put the target back.
+					NSURL *asideURL = [sourceURL.URLByDeletingLastPathComponent URLByAppendingPathComponent:SQRLInstallerAsideName];
+					[self recordJournalStep:SQRLInstallerJournalStepAside payload:@{ @"targetPath": targetURL.path, @"asidePath": asideURL.path }];
+
+					if (rename(targetPath, asideURL.path.fileSystemRepresentation) != 0) return [RACSignal error:[self errorForPOSIXCode:errno URL:targetURL]];
+
+					if (rename(sourcePath, targetPath) != 0) {
+						code = errno;
+
+						if (rename(asideURL.path.fileSystemRepresentation, targetPath) != 0) {
+							// The journal still records the move, so it'll be
+							// retried when the installer is next launched.
+							NSLog(@"Couldn't move %@ back to %@, error %@", asideURL, targetURL, [self errorForPOSIXCode:errno URL:targetURL].sqrl_verboseDescription);
+						}
+
+						return [RACSignal error:[self errorForPOSIXCode:code URL:targetURL]];
+					}
+				} else {
+					return [RACSignal error:[self errorForPOSIXCode:code URL:targetURL]];
+				}
 			}
 
-			return [RACSignal return:fileSecurity];
+			// Make the rename itself durable before anything that depends on
+			// it, like deleting the source.
+			int parentFD = open(targetURL.URLByDeletingLastPathComponent.path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+			if (parentFD >= 0) {
+				if (fcntl(parentFD, F_FULLFSYNC) != 0) fsync(parentFD);
+				close(parentFD);
+			}
+
+			NSLog(@"Replaced %@ with %@", targetURL, sourceURL);
+			return [RACSignal empty];
 		}]
-		setNameWithFormat:@"%@ -readFileSecurity: %@", self, location];
+		setNameWithFormat:@"%@ -replaceItemAtURL: %@ withItemAtURL: %@", self, targetURL, sourceURL];
 }
 
-- (RACSignal *)writeFileSecurity:(NSFileSecurity *)fileSecurity toURL:(NSURL *)location {
-	NSParameterAssert(location != nil);
+- (RACSignal *)exchangeItemAtURL:(NSURL *)firstURL withItemAtURL:(NSURL *)secondURL {
+	NSParameterAssert(firstURL != nil);
+	NSParameterAssert(secondURL != nil);
 
 	return [[RACSignal
 		defer:^{
-			NSError *error;
-			if (![location setResourceValue:fileSecurity forKey:NSURLFileSecurityKey error:&error]) {
-				return [RACSignal error:error];
+			if (renamex_np(firstURL.path.fileSystemRepresentation, secondURL.path.fileSystemRepresentation, RENAME_SWAP) == 0) {
+				NSLog(@"Exchanged %@ with %@", firstURL, secondURL);
+				return [RACSignal empty];
+			} else {
+				return [RACSignal error:[self errorForPOSIXCode:errno URL:firstURL]];
 			}
-
-			return [RACSignal empty];
 		}]
-		setNameWithFormat:@"%@ -writeFileSecurity: %@", self, location];
+		setNameWithFormat:@"%@ -exchangeItemAtURL: %@ withItemAtURL: %@", self, firstURL, secondURL];
+}
+
+- (BOOL)shouldRenameContentsDirectlyWithTargetURL:(NSURL *)targetURL sourceURL:(NSURL *)sourceURL {
+	NSParameterAssert(targetURL != nil);
+	NSParameterAssert(sourceURL != nil);
+
+	// If both the sourceURL and the targetURL exist we can try to skip a permissions check
+	// by moving Thing.app/Contents directly.  This allows us to update applications without
+	// permission to write files into the parent directory of Thing.app
+	//
+	// There is no known case where these directories don't exist but in order to handle
+	// edge cases / race conditions we'll handle it anyway.
+	//
+	// This exists check is non-atomic with the rename call below but that's OK
+	//
+	// For now while this is tested at scale this new option is behind a user default, this
+	// can be set by applications wishing to test this feature at runtime.  If it causes issues
+	// it can be opted out by individual users by setting this key to false explicitly.
+	// Once this has bene tested at scale it will become the default for all Squirrel.Mac
+	// users.
+	if (![self.installerDefaults boolForKey:@"SquirrelMacEnableDirectContentsWrite"]) {
+		NSLog(@"Moving bundles directly as SquirrelMacEnableDirectContentsWrite is disabled for app: %@", _applicationIdentifier);
+		return NO;
+	}
+
+	BOOL canRenameContentsDirectly = [NSFileManager.defaultManager fileExistsAtPath:targetURL.path] && [NSFileManager.defaultManager fileExistsAtPath:sourceURL.path];
+	if (canRenameContentsDirectly) {
+		NSLog(@"Moving bundles via 'Contents' folder rename");
+	} else {
+		NSLog(@"Moving bundles directly as one of source / target does not exist.  This is unexpected.");
+	}
+
+	return canRenameContentsDirectly;
+}
+
+- (BOOL)shouldApplyDifferentiallyWithTargetURL:(NSURL *)targetURL sourceURL:(NSURL *)sourceURL {
+	NSParameterAssert(targetURL != nil);
+	NSParameterAssert(sourceURL != nil);
+
+	// Most files are the same from one version to the next, so leaving them
+	// in place saves rewriting the whole bundle on every update.
+	if (![self.installerDefaults boolForKey:@"SquirrelMacEnableDifferentialContentsWrite"]) return NO;
+	if (![self shouldRenameContentsDirectlyWithTargetURL:targetURL sourceURL:sourceURL]) return NO;
+
+	NSLog(@"Updating bundle 'Contents' in place as SquirrelMacEnableDifferentialContentsWrite is enabled");
+	return YES;
+}
+
+#pragma mark Quarantine Bit Removal
+
+- (RACSignal *)clearQuarantineForDirectory:(NSURL *)directory {
+	NSParameterAssert(directory != nil);
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:directory];
+	RACSignal *clear = [walker visitItemsWithBlock:^(NSURL *URL, NSError **error) {
+		const char *path = URL.path.fileSystemRepresentation;
+
+		// ENOATTR just means the extended attribute was never set on the file
+		// to begin with. Anything else is logged, but doesn't stop the rest of
+		// the bundle from being cleared.
+		if (removexattr(path, "com.apple.quarantine", XATTR_NOFOLLOW) != 0 && errno != ENOATTR) {
+			NSLog(@"Couldn't remove quarantine attribute from %@: %s", URL.path, strerror(errno));
+		}
+
+		return YES;
+	} errorHandler:^(NSURL *URL, NSError *error) {
+		NSLog(@"Error enumerating item %@ within directory %@: %@", URL, directory, error);
+		return YES;
+	}];
+
+	return [[self
+		measurePhase:@"quarantine" ofSignal:clear countingItemsOfWalker:walker]
+		setNameWithFormat:@"%@ -clearQuarantineForDirectory: %@", self, directory];
 }
 
+#pragma mark File Security
+
 - (RACSignal *)takeOwnershipOfDirectory:(NSURL *)directoryURL {
 	NSParameterAssert(directoryURL != nil);
 
-	return [[[RACSignal
-		createSignal:^(id<RACSubscriber> subscriber) {
-			NSDirectoryEnumerator *enumerator = [NSFileManager.defaultManager enumeratorAtURL:directoryURL includingPropertiesForKeys:@[ NSURLFileSecurityKey ] options:0 errorHandler:^ BOOL (NSURL *url, NSError *error) {
-				[subscriber sendError:error];
-				return NO;
-			}];
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:directoryURL];
+	RACSignal *takeOwnership = [walker visitItemsWithBlock:^(NSURL *itemURL, NSError **error) {
+		NSFileSecurity *fileSecurity = nil;
+		if (![itemURL getResourceValue:&fileSecurity forKey:NSURLFileSecurityKey error:error]) return NO;
 
-			return [[enumerator.rac_sequence.signal
-				startWith:directoryURL]
-				subscribe:subscriber];
-		}]
-		flattenMap:^(NSURL *itemURL) {
-			return [[[self
-				readFileSecurityOfURL:itemURL]
-				flattenMap:^(NSFileSecurity *fileSecurity) {
-					if (![self takeOwnershipOfFileSecurity:fileSecurity]) {
-						NSDictionary *errorInfo = @{
-							NSLocalizedDescriptionKey: NSLocalizedString(@"Permissions Error", nil),
-							NSLocalizedRecoverySuggestionErrorKey: [NSString stringWithFormat:NSLocalizedString(@"Couldn’t update permissions of %@", nil), itemURL.path],
-							NSURLErrorKey: itemURL
-						};
+		if (![self takeOwnershipOfFileSecurity:fileSecurity]) {
+			NSDictionary *errorInfo = @{
+				NSLocalizedDescriptionKey: NSLocalizedString(@"Permissions Error", nil),
+				NSLocalizedRecoverySuggestionErrorKey: [NSString stringWithFormat:NSLocalizedString(@"Couldn’t update permissions of %@", nil), itemURL.path],
+				NSURLErrorKey: itemURL
+			};
 
-						return [RACSignal error:[NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorChangingPermissions userInfo:errorInfo]];
-					}
+			if (error != NULL) *error = [NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorChangingPermissions userInfo:errorInfo];
+			return NO;
+		}
 
-					return [RACSignal return:fileSecurity];
-				}]
-				flattenMap:^(NSFileSecurity *fileSecurity) {
-					return [self writeFileSecurity:fileSecurity toURL:itemURL];
-				}];
-		}]
+		return [itemURL setResourceValue:fileSecurity forKey:NSURLFileSecurityKey error:error];
+	}];
+
+	return [[self
+		measurePhase:@"ownership" ofSignal:takeOwnership countingItemsOfWalker:walker]
 		setNameWithFormat:@"%@ -takeOwnershipOfDirectory: %@", self, directoryURL];
 }
 
@@ -769,8 +1775,8 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 
 	// If ShipIt is running as root, this will change the owner to
 	// root:wheel.
-	if (!CFFileSecuritySetOwner(actualFileSecurity, getuid())) return NO;
-	if (!CFFileSecuritySetGroup(actualFileSecurity, getgid())) return NO;
+	if (!CFFileSecuritySetOwner(actualFileSecurity, geteuid())) return NO;
+	if (!CFFileSecuritySetGroup(actualFileSecurity, getegid())) return NO;
 
 	mode_t fileMode = 0;
 	if (!CFFileSecurityGetMode(actualFileSecurity, &fileMode)) return NO;
@@ -798,6 +1804,21 @@ NSString * const SQRLInstallerOwnedBundleKey = @"SQRLInstallerOwnedBundle";
 	return [NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorMissingInstallationData userInfo:userInfo];
 }
 
+- (NSError *)errorForPOSIXCode:(int)code URL:(NSURL *)URL {
+	NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+
+	const char *desc = strerror(code);
+	if (desc != NULL) {
+		userInfo[NSLocalizedDescriptionKey] = @(desc);
+	} else {
+		userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Unknown POSIX error", @"");
+	}
+
+	if (URL != nil) userInfo[NSURLErrorKey] = URL;
+
+	return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo];
+}
+
 - (NSError *)errorByAddingDescription:(NSString *)description code:(NSInteger)code toError:(NSError *)error {
 	NSMutableDictionary *userInfo = [error.userInfo mutableCopy] ?: [NSMutableDictionary dictionary];
 
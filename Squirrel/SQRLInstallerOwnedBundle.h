@@ -15,7 +15,10 @@
 //
 // Can be used to ensure new targetURL requests meet the original bundle at that
 // location's code signature, even though it's been moved aside.
-@interface SQRLInstallerOwnedBundle : MTLModel
+//
+// Owned bundles are serialized to JSON with `MTLJSONAdapter` so they can be
+// written to the install journal.
+@interface SQRLInstallerOwnedBundle : MTLModel <MTLJSONSerializing>
 
 // Designated initialiser.
 //
@@ -30,8 +33,50 @@
 // Returns an initialised owned bundle for serializing.
 - (instancetype)initWithOriginalURL:(NSURL *)originalURL temporaryURL:(NSURL *)temporaryURL codeSignature:(SQRLCodeSignature *)codeSignature;
 
+// Initialises an owned bundle for an item that will be exchanged with
+// `temporaryURL` in a single rename, instead of being moved aside.
+//
+// originalURL   - The item being replaced, which will end up at temporaryURL.
+// temporaryURL  - The item replacing it, which will end up at originalURL.
+// codeSignature - The code signature of the original bundle.
+// originalInode - The inode number of the item at originalURL before the
+//                 exchange, so that recovery can tell which side of the
+//                 exchange the original item is on.
+//
+// Returns an initialised owned bundle for serializing.
+- (instancetype)initWithOriginalURL:(NSURL *)originalURL temporaryURL:(NSURL *)temporaryURL codeSignature:(SQRLCodeSignature *)codeSignature originalInode:(NSNumber *)originalInode;
+
+// Initialises an owned bundle for an item that will be updated in place to
+// match `temporaryURL`, by exchanging only the items that differ.
+//
+// originalURL         - The item being updated in place.
+// temporaryURL        - The item it's being updated from, which will end up
+//                       holding the replaced items.
+// codeSignature       - The code signature of the original bundle.
+// differentialChanges - The changes from `SQRLBundleDifference` that will be
+//                       applied, so that recovery can revert them.
+//
+// Returns an initialised owned bundle for serializing.
+- (instancetype)initWithOriginalURL:(NSURL *)originalURL temporaryURL:(NSURL *)temporaryURL codeSignature:(SQRLCodeSignature *)codeSignature differentialChanges:(NSArray *)differentialChanges;
+
 @property (readonly, copy, nonatomic) NSURL *originalURL;
 @property (readonly, copy, nonatomic) NSURL *temporaryURL;
 @property (readonly, copy, nonatomic) SQRLCodeSignature *codeSignature;
 
+// The inode number of the original item before it was exchanged, or nil if
+// the original item was moved aside instead.
+@property (readonly, copy, nonatomic) NSNumber *originalInode;
+
+// Whether the original item is being exchanged in place, rather than moved
+// aside.
+@property (readonly, nonatomic, getter = isExchanged) BOOL exchanged;
+
+// The changes being applied to the original item in place, or nil if the
+// original item was moved aside or exchanged instead.
+@property (readonly, copy, nonatomic) NSArray *differentialChanges;
+
+// Whether the original item is being updated in place, rather than moved
+// aside.
+@property (readonly, nonatomic, getter = isDifferential) BOOL differential;
+
 @end
@@ -10,6 +10,8 @@
 
 #import <ReactiveObjC/EXTKeyPathCoding.h>
 
+#import "SQRLCodeSignature.h"
+
 @implementation SQRLInstallerOwnedBundle
 
 - (instancetype)initWithOriginalURL:(NSURL *)originalURL temporaryURL:(NSURL *)temporaryURL codeSignature:(SQRLCodeSignature *)codeSignature {
@@ -20,4 +22,79 @@
 	} error:NULL];
 }
 
+- (instancetype)initWithOriginalURL:(NSURL *)originalURL temporaryURL:(NSURL *)temporaryURL codeSignature:(SQRLCodeSignature *)codeSignature originalInode:(NSNumber *)originalInode {
+	NSParameterAssert(originalInode != nil);
+
+	return [self initWithDictionary:@{
+		@keypath(self.originalURL): originalURL,
+		@keypath(self.temporaryURL): temporaryURL,
+		@keypath(self.codeSignature): codeSignature,
+		@keypath(self.originalInode): originalInode,
+	} error:NULL];
+}
+
+- (instancetype)initWithOriginalURL:(NSURL *)originalURL temporaryURL:(NSURL *)temporaryURL codeSignature:(SQRLCodeSignature *)codeSignature differentialChanges:(NSArray *)differentialChanges {
+	NSParameterAssert(differentialChanges != nil);
+
+	return [self initWithDictionary:@{
+		@keypath(self.originalURL): originalURL,
+		@keypath(self.temporaryURL): temporaryURL,
+		@keypath(self.codeSignature): codeSignature,
+		@keypath(self.differentialChanges): differentialChanges,
+	} error:NULL];
+}
+
+#pragma mark Properties
+
+- (BOOL)isExchanged {
+	return self.originalInode != nil;
+}
+
+- (BOOL)isDifferential {
+	return self.differentialChanges != nil;
+}
+
+#pragma mark Serialization
+
++ (NSDictionary *)JSONKeyPathsByPropertyKey {
+	return @{
+		@keypath(SQRLInstallerOwnedBundle.new, originalURL): @keypath(SQRLInstallerOwnedBundle.new, originalURL),
+		@keypath(SQRLInstallerOwnedBundle.new, temporaryURL): @keypath(SQRLInstallerOwnedBundle.new, temporaryURL),
+		@keypath(SQRLInstallerOwnedBundle.new, codeSignature): @keypath(SQRLInstallerOwnedBundle.new, codeSignature),
+		@keypath(SQRLInstallerOwnedBundle.new, originalInode): @keypath(SQRLInstallerOwnedBundle.new, originalInode),
+		@keypath(SQRLInstallerOwnedBundle.new, differentialChanges): @keypath(SQRLInstallerOwnedBundle.new, differentialChanges),
+	};
+}
+
++ (NSValueTransformer *)originalURLJSONTransformer {
+	return [NSValueTransformer valueTransformerForName:MTLURLValueTransformerName];
+}
+
++ (NSValueTransformer *)temporaryURLJSONTransformer {
+	return [NSValueTransformer valueTransformerForName:MTLURLValueTransformerName];
+}
+
++ (NSValueTransformer *)codeSignatureJSONTransformer {
+	// Only the requirement is needed to verify bundles against the signature,
+	// so that's all that is serialized.
+	return [MTLValueTransformer
+		transformerUsingForwardBlock:^ id (NSString *string, BOOL *success, NSError **error) {
+			if (string == nil) return nil;
+
+			NSData *requirementData = [[NSData alloc] initWithBase64EncodedString:string options:0];
+			if (requirementData == nil) {
+				*success = NO;
+				return nil;
+			}
+
+			SQRLCodeSignature *codeSignature = [SQRLCodeSignature signatureWithRequirementData:requirementData error:error];
+			if (codeSignature == nil) *success = NO;
+
+			return codeSignature;
+		}
+		reverseBlock:^ id (SQRLCodeSignature *codeSignature, BOOL *success, NSError **error) {
+			return [codeSignature.requirementData base64EncodedStringWithOptions:0];
+		}];
+}
+
 @end
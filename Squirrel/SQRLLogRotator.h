@@ -0,0 +1,52 @@
+//
+//  SQRLLogRotator.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// Rotates a log which launchd appends to, so that each job starts a fresh
+// segment, and older segments are kept compressed and bounded.
+//
+// Rotated segments are named after the log, numbered from the newest, like
+// `ShipIt_stdout.log.1.gz`. Uncompressed logs with a number instead, like
+// `ShipIt_stdout.log.1`, were written when the log itself wasn't writable, and
+// are rotated along with the log.
+@interface SQRLLogRotator : NSObject
+
+// Initializes the receiver to rotate the given log.
+//
+// logURL - The log that launchd writes to. This must not be nil.
+- (instancetype)initWithLogURL:(NSURL *)logURL;
+
+// The log that launchd writes to.
+@property (nonatomic, copy, readonly) NSURL *logURL;
+
+// The most bytes of each segment to keep, from its end. Defaults to 1 MB.
+@property (atomic, assign) unsigned long long maximumSegmentSize;
+
+// The most rotated segments to keep. Defaults to 5.
+@property (atomic, assign) NSUInteger maximumGenerations;
+
+// Returns where the given rotated segment is saved.
+//
+// generation - The number of the segment, starting from 1 for the newest.
+- (NSURL *)URLForGeneration:(NSUInteger)generation;
+
+// Lazily compresses the log into the newest rotated segment, if it isn't
+// empty, then removes it, so that launchd starts it afresh.
+//
+// Older segments are renumbered, and removed beyond `maximumGenerations`.
+//
+// This must not be invoked while launchd may be writing to the log.
+//
+// Returns a signal which completes or errors. Even if it errors, the log will
+// have been removed if at all possible.
+- (RACSignal *)rotate;
+
+@end
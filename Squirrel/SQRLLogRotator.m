@@ -0,0 +1,235 @@
+//
+//  SQRLLogRotator.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLLogRotator.h"
+
+#import <ReactiveObjC/EXTScope.h>
+#import <ReactiveObjC/RACSignal+Operations.h>
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import <zlib.h>
+
+// The extension given to rotated segments.
+static NSString * const SQRLLogRotatorCompressedExtension = @"gz";
+
+// How much of a segment to compress at a time.
+static const size_t SQRLLogRotatorBufferSize = 64 * 1024;
+
+@interface SQRLLogRotator ()
+
+// Compresses the end of a segment into a rotated segment.
+//
+// segmentURL     - The uncompressed segment. This must not be nil.
+// destinationURL - Where to save the compressed segment, replacing anything
+//                  already there. This must not be nil.
+// errorRef       - If not NULL, set to any error that occurs.
+//
+// Returns whether the segment was compressed.
+- (BOOL)compressSegmentAtURL:(NSURL *)segmentURL toURL:(NSURL *)destinationURL error:(NSError **)errorRef;
+
+@end
+
+@implementation SQRLLogRotator
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithLogURL:(NSURL *)logURL {
+	NSParameterAssert(logURL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_logURL = [logURL copy];
+	_maximumSegmentSize = 1024 * 1024;
+	_maximumGenerations = 5;
+
+	return self;
+}
+
+#pragma mark Rotation
+
+- (NSURL *)URLForGeneration:(NSUInteger)generation {
+	NSParameterAssert(generation > 0);
+
+	NSString *name = [NSString stringWithFormat:@"%@.%lu.%@", self.logURL.lastPathComponent, (unsigned long)generation, SQRLLogRotatorCompressedExtension];
+	return [self.logURL.URLByDeletingLastPathComponent URLByAppendingPathComponent:name];
+}
+
+// Returns the number that `string` consists of, or 0 if it isn't a positive
+// number.
+static NSUInteger SQRLLogRotatorGenerationFromString(NSString *string) {
+	if (string.length == 0) return 0;
+	if ([string rangeOfCharacterFromSet:NSCharacterSet.decimalDigitCharacterSet.invertedSet].location != NSNotFound) return 0;
+
+	return (NSUInteger)MAX(string.integerValue, 0);
+}
+
+- (RACSignal *)rotate {
+	return [[RACSignal
+		defer:^{
+			NSFileManager *manager = [[NSFileManager alloc] init];
+			NSURL *directoryURL = self.logURL.URLByDeletingLastPathComponent;
+			NSString *logName = self.logURL.lastPathComponent;
+			NSString *prefix = [logName stringByAppendingString:@"."];
+			NSString *compressedSuffix = [@"." stringByAppendingString:SQRLLogRotatorCompressedExtension];
+
+			NSError *error = nil;
+			NSArray *keys = @[ NSURLFileSizeKey, NSURLContentModificationDateKey ];
+			NSArray *itemURLs = [manager contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:keys options:0 error:&error];
+			if (itemURLs == nil) return [RACSignal error:error];
+
+			NSMutableArray *segmentURLs = [NSMutableArray array];
+			NSMutableDictionary *generationURLs = [NSMutableDictionary dictionary];
+
+			for (NSURL *itemURL in itemURLs) {
+				NSString *name = itemURL.lastPathComponent;
+
+				NSNumber *size = nil;
+				[itemURL getResourceValue:&size forKey:NSURLFileSizeKey error:NULL];
+
+				if ([name isEqualToString:logName]) {
+					// An empty log is already fresh.
+					if (size.unsignedLongLongValue > 0) [segmentURLs addObject:itemURL];
+					continue;
+				}
+
+				if (![name hasPrefix:prefix]) continue;
+
+				NSString *suffix = [name substringFromIndex:prefix.length];
+				if ([suffix hasSuffix:compressedSuffix]) {
+					NSUInteger generation = SQRLLogRotatorGenerationFromString([suffix substringToIndex:suffix.length - compressedSuffix.length]);
+					if (generation > 0) generationURLs[@(generation)] = itemURL;
+				} else if (SQRLLogRotatorGenerationFromString(suffix) > 0) {
+					if (size.unsignedLongLongValue > 0) {
+						[segmentURLs addObject:itemURL];
+					} else {
+						[manager removeItemAtURL:itemURL error:NULL];
+					}
+				}
+			}
+
+			if (segmentURLs.count == 0) return [RACSignal empty];
+
+			[segmentURLs sortUsingComparator:^(NSURL *URL, NSURL *otherURL) {
+				NSDate *date = nil;
+				NSDate *otherDate = nil;
+				[URL getResourceValue:&date forKey:NSURLContentModificationDateKey error:NULL];
+				[otherURL getResourceValue:&otherDate forKey:NSURLContentModificationDateKey error:NULL];
+
+				// Newest first.
+				return [otherDate ?: NSDate.distantPast compare:date ?: NSDate.distantPast];
+			}];
+
+			NSUInteger maximumGenerations = self.maximumGenerations;
+
+			// Make room for the new segments, starting from the oldest so that
+			// nothing is renamed over a segment which hasn't moved yet.
+			NSArray *generations = [generationURLs.allKeys sortedArrayUsingSelector:@selector(compare:)];
+			for (NSNumber *generation in generations.reverseObjectEnumerator) {
+				NSURL *generationURL = generationURLs[generation];
+				NSUInteger newGeneration = generation.unsignedIntegerValue + segmentURLs.count;
+
+				if (newGeneration > maximumGenerations) {
+					[manager removeItemAtURL:generationURL error:NULL];
+				} else if (rename(generationURL.path.fileSystemRepresentation, [self URLForGeneration:newGeneration].path.fileSystemRepresentation) != 0) {
+					NSLog(@"Could not rename %@ to generation %lu: %s", generationURL, (unsigned long)newGeneration, strerror(errno));
+				}
+			}
+
+			NSError *firstError = nil;
+			for (NSUInteger i = 0; i < segmentURLs.count; i++) {
+				NSURL *segmentURL = segmentURLs[i];
+
+				NSError *segmentError = nil;
+				if (i < maximumGenerations && ![self compressSegmentAtURL:segmentURL toURL:[self URLForGeneration:i + 1] error:&segmentError]) {
+					firstError = firstError ?: segmentError;
+				}
+
+				// The segment is removed even if it couldn't be compressed, so
+				// that the log still starts afresh.
+				if (![manager removeItemAtURL:segmentURL error:&segmentError]) {
+					firstError = firstError ?: segmentError;
+				}
+			}
+
+			if (firstError != nil) return [RACSignal error:firstError];
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"%@ -rotate", self];
+}
+
+- (BOOL)compressSegmentAtURL:(NSURL *)segmentURL toURL:(NSURL *)destinationURL error:(NSError **)errorRef {
+	NSParameterAssert(segmentURL != nil);
+	NSParameterAssert(destinationURL != nil);
+
+	// Compress into a temporary file first, so that a partially written
+	// segment never takes the place of a whole one.
+	NSString *temporaryPath = [destinationURL.path stringByAppendingString:@".partial"];
+
+	BOOL (^failWithCode)(int, NSURL *) = ^(int code, NSURL *URL) {
+		unlink(temporaryPath.fileSystemRepresentation);
+
+		if (errorRef != NULL) {
+			NSDictionary *userInfo = @{
+				NSLocalizedDescriptionKey: NSLocalizedString(@"Could not rotate log", nil),
+				NSURLErrorKey: URL
+			};
+
+			*errorRef = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo];
+		}
+
+		return NO;
+	};
+
+	int fd = open(segmentURL.path.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return failWithCode(errno, segmentURL);
+
+	@onExit {
+		close(fd);
+	};
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) return failWithCode(errno, segmentURL);
+
+	// Keep the end of the segment, which is what's most useful when
+	// something has gone wrong.
+	unsigned long long size = (unsigned long long)info.st_size;
+	unsigned long long discardedSize = (size > self.maximumSegmentSize ? size - self.maximumSegmentSize : 0);
+	if (lseek(fd, (off_t)discardedSize, SEEK_SET) < 0) return failWithCode(errno, segmentURL);
+
+	gzFile file = gzopen(temporaryPath.fileSystemRepresentation, "wb");
+	if (file == NULL) return failWithCode(errno ?: ENOMEM, destinationURL);
+
+	BOOL success = YES;
+	if (discardedSize > 0) {
+		success = gzprintf(file, "[%llu earlier bytes of this log were discarded]\n", discardedSize) > 0;
+	}
+
+	char buffer[SQRLLogRotatorBufferSize];
+	while (success) {
+		ssize_t count = read(fd, buffer, sizeof(buffer));
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) {
+			success = (count == 0);
+			break;
+		}
+
+		success = gzwrite(file, buffer, (unsigned)count) == count;
+	}
+
+	int code = errno ?: EIO;
+	if (gzclose(file) != Z_OK) success = NO;
+	if (!success) return failWithCode(code, destinationURL);
+
+	if (rename(temporaryPath.fileSystemRepresentation, destinationURL.path.fileSystemRepresentation) != 0) return failWithCode(errno, destinationURL);
+
+	return YES;
+}
+
+@end
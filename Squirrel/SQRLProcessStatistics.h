@@ -0,0 +1,31 @@
+//
+//  SQRLProcessStatistics.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// Measures the startup cost of the current process, so that ShipIt's
+// executables can be compared.
+//
+// This only depends on Foundation, so it can be built into executables that
+// don't link anything else.
+
+// Returns how long ago, in seconds, the kernel created the current process.
+//
+// This includes the time spent by dyld and the Objective-C runtime before
+// `main` was called. Returns a negative number if it couldn't be determined.
+NSTimeInterval SQRLProcessTimeSinceLaunch(void);
+
+// Returns the resident memory size of the current process, in bytes, or 0 if
+// it couldn't be determined.
+uint64_t SQRLProcessResidentSize(void);
+
+// Logs SQRLProcessTimeSinceLaunch() and SQRLProcessResidentSize(). This should
+// be called right before the process starts its first real work.
+//
+// processName - Identifies the process in the log. This must not be nil.
+void SQRLProcessLogStartupStatistics(NSString *processName);
@@ -0,0 +1,41 @@
+//
+//  SQRLProcessStatistics.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLProcessStatistics.h"
+
+#import <mach/mach.h>
+#import <sys/sysctl.h>
+#import <sys/time.h>
+#import <unistd.h>
+
+NSTimeInterval SQRLProcessTimeSinceLaunch(void) {
+	struct kinfo_proc info;
+	size_t size = sizeof(info);
+	int name[] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid() };
+	if (sysctl(name, sizeof(name) / sizeof(*name), &info, &size, NULL, 0) != 0) return -1;
+
+	struct timeval now;
+	if (gettimeofday(&now, NULL) != 0) return -1;
+
+	struct timeval start = info.kp_proc.p_starttime;
+	return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / (NSTimeInterval)USEC_PER_SEC;
+}
+
+uint64_t SQRLProcessResidentSize(void) {
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+
+	return info.resident_size;
+}
+
+void SQRLProcessLogStartupStatistics(NSString *processName) {
+	NSCParameterAssert(processName != nil);
+
+	NSLog(@"%@ started work %.1fms after launch, with %llu KB resident", processName, SQRLProcessTimeSinceLaunch() * 1000, SQRLProcessResidentSize() / 1024);
+}
@@ -0,0 +1,73 @@
+//
+//  SQRLReleaseFeedScanner.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// Reads the current release, and the update to it, out of a JSON release feed
+// without parsing the rest of the feed.
+//
+// The feed is scanned in place, once, and scanning stops as soon as the wanted
+// values have been found. Values that aren't wanted are skipped over without
+// being decoded, so nothing is allocated for them, and they are only checked
+// for well-formedness as far as finding where they end requires.
+//
+// This class is not thread-safe.
+@interface SQRLReleaseFeedScanner : NSObject
+
+// Initializes the receiver to scan the given feed.
+//
+// data - The JSON release feed, which should be an object with a
+//        `currentRelease` version string and an array of `releases`. UTF-8
+//        feeds, with or without a byte order mark, are scanned in place.
+//        Feeds in UTF-16 or UTF-32 are converted to UTF-8 first. This must not
+//        be nil.
+- (instancetype)initWithData:(NSData *)data;
+
+// Scans the feed for its `currentRelease`.
+//
+// If the feed lists its releases before its current release, the releases are
+// skipped, but where they start is remembered for
+// -scanUpdateData:forReleaseVersion:error:.
+//
+// currentRelease - If not NULL, set to the current release, or nil if the feed
+//                  doesn't have a current release string.
+// error          - If not NULL, set to any error that occurs.
+//
+// Returns whether the feed could be scanned.
+- (BOOL)scanCurrentRelease:(NSString **)currentRelease error:(NSError **)error;
+
+// Scans the feed for its `nextCheckAfter`, the server's hint for when to check
+// for updates again.
+//
+// Unless the hint has already been passed, this scans the rest of the feed's
+// top-level object, skipping its releases. Call it before
+// -scanUpdateData:forReleaseVersion:error:, which may stop scanning the feed
+// before reaching the hint.
+//
+// nextCheckAfter - If not NULL, set to the decoded JSON value of the hint, or
+//                  nil if the feed doesn't have one.
+// error          - If not NULL, set to any error that occurs.
+//
+// Returns whether the feed could be scanned.
+- (BOOL)scanNextCheckAfter:(id *)nextCheckAfter error:(NSError **)error;
+
+// Scans the feed's `releases` for the first release with the given version,
+// stopping as soon as its `updateTo` object has been found.
+//
+// Call -scanCurrentRelease:error: first, if the current release is needed too,
+// since this may stop scanning the feed before reaching it.
+//
+// updateData - If not NULL, set to the JSON data of the release's `updateTo`,
+//              or nil if the feed doesn't list the release.
+// version    - The version of the release to find. This must not be nil.
+// error      - If not NULL, set to any error that occurs.
+//
+// Returns whether the feed could be scanned.
+- (BOOL)scanUpdateData:(NSData **)updateData forReleaseVersion:(NSString *)version error:(NSError **)error;
+
+@end
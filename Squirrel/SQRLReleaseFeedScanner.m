@@ -0,0 +1,444 @@
+//
+//  SQRLReleaseFeedScanner.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLReleaseFeedScanner.h"
+
+// A position within the JSON being scanned.
+typedef struct {
+	const uint8_t *bytes;
+	NSUInteger length;
+	NSUInteger offset;
+} SQRLFeedCursor;
+
+static void SQRLFeedSkipWhitespace(SQRLFeedCursor *cursor) {
+	while (cursor->offset < cursor->length) {
+		uint8_t byte = cursor->bytes[cursor->offset];
+		if (byte != ' ' && byte != '\t' && byte != '\n' && byte != '\r') return;
+
+		cursor->offset++;
+	}
+}
+
+// Skips whitespace, then returns the next byte without consuming it, or 0 at the
+// end of the data.
+static uint8_t SQRLFeedPeek(SQRLFeedCursor *cursor) {
+	SQRLFeedSkipWhitespace(cursor);
+	return (cursor->offset < cursor->length ? cursor->bytes[cursor->offset] : 0);
+}
+
+// Skips whitespace, then consumes the next byte if it is `expected`.
+//
+// Returns whether the byte was consumed.
+static BOOL SQRLFeedConsume(SQRLFeedCursor *cursor, uint8_t expected) {
+	if (SQRLFeedPeek(cursor) != expected) return NO;
+
+	cursor->offset++;
+	return YES;
+}
+
+// Scans a string, without decoding it.
+//
+// contents - Set to the range of the string's contents, between its quotes.
+// escaped  - If not NULL, set to whether the contents contain escapes.
+//
+// Returns whether a string was scanned.
+static BOOL SQRLFeedScanString(SQRLFeedCursor *cursor, NSRange *contents, BOOL *escaped) {
+	if (!SQRLFeedConsume(cursor, '"')) return NO;
+
+	NSUInteger start = cursor->offset;
+	BOOL containsEscapes = NO;
+
+	while (cursor->offset < cursor->length) {
+		uint8_t byte = cursor->bytes[cursor->offset];
+		if (byte == '"') {
+			*contents = NSMakeRange(start, cursor->offset - start);
+			if (escaped != NULL) *escaped = containsEscapes;
+
+			cursor->offset++;
+			return YES;
+		}
+
+		if (byte < 0x20) return NO;
+
+		if (byte == '\\') {
+			containsEscapes = YES;
+			cursor->offset++;
+		}
+
+		cursor->offset++;
+	}
+
+	return NO;
+}
+
+// Skips over a value of any type.
+//
+// Returns whether the value could be skipped.
+static BOOL SQRLFeedSkipValue(SQRLFeedCursor *cursor) {
+	uint8_t byte = SQRLFeedPeek(cursor);
+	NSRange contents;
+
+	if (byte == '"') return SQRLFeedScanString(cursor, &contents, NULL);
+
+	if (byte == '{' || byte == '[') {
+		NSUInteger depth = 0;
+		while (cursor->offset < cursor->length) {
+			byte = cursor->bytes[cursor->offset];
+			if (byte == '"') {
+				if (!SQRLFeedScanString(cursor, &contents, NULL)) return NO;
+				continue;
+			}
+
+			cursor->offset++;
+
+			if (byte == '{' || byte == '[') {
+				depth++;
+			} else if (byte == '}' || byte == ']') {
+				if (--depth == 0) return YES;
+			}
+		}
+
+		return NO;
+	}
+
+	// A number, or `true`, `false` or `null`.
+	NSUInteger start = cursor->offset;
+	while (cursor->offset < cursor->length) {
+		byte = cursor->bytes[cursor->offset];
+		if (byte == ',' || byte == '}' || byte == ']' || byte == ' ' || byte == '\t' || byte == '\n' || byte == '\r') break;
+
+		cursor->offset++;
+	}
+
+	return cursor->offset > start;
+}
+
+// Decodes a string scanned by SQRLFeedScanString().
+static NSString *SQRLFeedDecodeString(const SQRLFeedCursor *cursor, NSRange contents, BOOL escaped) {
+	if (!escaped) return [[NSString alloc] initWithBytes:cursor->bytes + contents.location length:contents.length encoding:NSUTF8StringEncoding];
+
+	// Escapes are rare enough in versions and keys to leave to Foundation.
+	NSData *quotedString = [NSData dataWithBytes:cursor->bytes + contents.location - 1 length:contents.length + 2];
+	NSString *string = [NSJSONSerialization JSONObjectWithData:quotedString options:NSJSONReadingAllowFragments error:NULL];
+	return ([string isKindOfClass:NSString.class] ? string : nil);
+}
+
+// Returns whether a string scanned by SQRLFeedScanString() is equal to the
+// given UTF-8 string.
+static BOOL SQRLFeedStringEquals(const SQRLFeedCursor *cursor, NSRange contents, BOOL escaped, const char *string, size_t length) {
+	if (!escaped) return contents.length == length && memcmp(cursor->bytes + contents.location, string, length) == 0;
+
+	return [SQRLFeedDecodeString(cursor, contents, escaped) isEqualToString:@(string)];
+}
+
+// Scans an object, calling `member` for each key.
+//
+// member - Called with the range of each key and whether it contains escapes,
+//          when the cursor is at the key's value. It must consume the value,
+//          and return whether it could.
+//
+// Returns whether the object could be scanned.
+static BOOL SQRLFeedScanObject(SQRLFeedCursor *cursor, BOOL (^member)(NSRange key, BOOL escaped)) {
+	if (!SQRLFeedConsume(cursor, '{')) return NO;
+	if (SQRLFeedConsume(cursor, '}')) return YES;
+
+	do {
+		NSRange key;
+		BOOL escaped;
+		if (!SQRLFeedScanString(cursor, &key, &escaped)) return NO;
+		if (!SQRLFeedConsume(cursor, ':')) return NO;
+		if (!member(key, escaped)) return NO;
+	} while (SQRLFeedConsume(cursor, ','));
+
+	return SQRLFeedConsume(cursor, '}');
+}
+
+// Returns an error describing where scanning failed.
+static NSError *SQRLFeedError(const SQRLFeedCursor *cursor) {
+	NSDictionary *userInfo = @{
+		NSDebugDescriptionErrorKey: [NSString stringWithFormat:@"The release feed is not valid JSON around character %lu.", (unsigned long)cursor->offset],
+	};
+
+	return [NSError errorWithDomain:NSCocoaErrorDomain code:NSPropertyListReadCorruptError userInfo:userInfo];
+}
+
+// The byte order mark that some servers put at the start of UTF-8 files.
+static const uint8_t SQRLFeedUTF8ByteOrderMark[] = { 0xEF, 0xBB, 0xBF };
+
+// Returns the feed as UTF-8, which is all that the scanner can read.
+//
+// JSON may also be UTF-16 or UTF-32, which always has a zero byte or a byte
+// order mark in its first two bytes. Such feeds are parsed with
+// NSJSONSerialization, which detects the encoding, and serialized again as
+// UTF-8. Other feeds, and any that can't be parsed, are returned as they are.
+static NSData *SQRLFeedUTF8Data(NSData *data) {
+	if (data.length < 2) return data;
+
+	const uint8_t *bytes = data.bytes;
+	BOOL wideByteOrderMark = (bytes[0] == 0xFE && bytes[1] == 0xFF) || (bytes[0] == 0xFF && bytes[1] == 0xFE);
+	if (bytes[0] != 0 && bytes[1] != 0 && !wideByteOrderMark) return data;
+
+	id feed = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+	if (feed == nil) return data;
+
+	return [NSJSONSerialization dataWithJSONObject:feed options:0 error:NULL] ?: data;
+}
+
+// The members of the feed's top-level object that are looked for.
+//
+// SQRLFeedMemberCurrentRelease - The version string of the current release.
+// SQRLFeedMemberReleases       - The array of releases.
+// SQRLFeedMemberNextCheckAfter - The server's hint for when to check again.
+typedef enum : NSUInteger {
+	SQRLFeedMemberCurrentRelease,
+	SQRLFeedMemberReleases,
+	SQRLFeedMemberNextCheckAfter,
+} SQRLFeedMember;
+
+@interface SQRLReleaseFeedScanner () {
+	// Where scanning of the feed's top-level object has reached.
+	SQRLFeedCursor _cursor;
+
+	// The number of the top-level object's members that have been scanned.
+	NSUInteger _memberCount;
+
+	// Whether the top-level object has been scanned to its end, or left
+	// partway through once there was no more need for it.
+	BOOL _finishedObject;
+
+	// Whether the `currentRelease` member has been scanned.
+	BOOL _scannedCurrentRelease;
+
+	// Whether the `nextCheckAfter` member has been scanned.
+	BOOL _scannedNextCheckAfter;
+
+	// Where the `releases` value starts, or NSNotFound if it hasn't been
+	// reached.
+	NSUInteger _releasesOffset;
+}
+
+// The feed being scanned.
+@property (nonatomic, copy, readonly) NSData *data;
+
+// The value of the feed's `currentRelease`, if it is a string and has been
+// scanned.
+@property (nonatomic, copy) NSString *currentRelease;
+
+// The value of the feed's `nextCheckAfter`, if it has been scanned.
+@property (nonatomic, strong) id nextCheckAfter;
+
+// Scans members of the top-level object, until the wanted member has been
+// found or the object ends.
+//
+// Members before the one wanted are skipped, but any other member looked for
+// is still remembered if it's passed.
+//
+// member - The member to stop at.
+// error  - If not NULL, set to any error that occurs.
+//
+// Returns whether the feed could be scanned.
+- (BOOL)scanMembersFinding:(SQRLFeedMember)member error:(NSError **)error;
+
+// Scans the next member of the top-level object, or its end.
+//
+// member - The member wanted.
+// found  - Set to YES if the member scanned was the one wanted. This must not
+//          be NULL.
+//
+// Returns whether the member could be scanned.
+- (BOOL)scanNextMemberFinding:(SQRLFeedMember)member found:(BOOL *)found;
+
+@end
+
+@implementation SQRLReleaseFeedScanner
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithData:(NSData *)data {
+	NSParameterAssert(data != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_data = [SQRLFeedUTF8Data(data) copy];
+	_cursor = (SQRLFeedCursor){ .bytes = _data.bytes, .length = _data.length, .offset = 0 };
+	_releasesOffset = NSNotFound;
+
+	if (_data.length >= sizeof(SQRLFeedUTF8ByteOrderMark) && memcmp(_data.bytes, SQRLFeedUTF8ByteOrderMark, sizeof(SQRLFeedUTF8ByteOrderMark)) == 0) {
+		_cursor.offset = sizeof(SQRLFeedUTF8ByteOrderMark);
+	}
+
+	if (!SQRLFeedConsume(&_cursor, '{')) {
+		// Leave the cursor where it is, so scanning reports an error.
+		_cursor.length = 0;
+	}
+
+	return self;
+}
+
+#pragma mark Scanning
+
+- (BOOL)scanCurrentRelease:(NSString **)currentRelease error:(NSError **)error {
+	if (!_scannedCurrentRelease && ![self scanMembersFinding:SQRLFeedMemberCurrentRelease error:error]) return NO;
+
+	if (currentRelease != NULL) *currentRelease = self.currentRelease;
+	return YES;
+}
+
+- (BOOL)scanNextCheckAfter:(id *)nextCheckAfter error:(NSError **)error {
+	if (!_scannedNextCheckAfter && ![self scanMembersFinding:SQRLFeedMemberNextCheckAfter error:error]) return NO;
+
+	if (nextCheckAfter != NULL) *nextCheckAfter = self.nextCheckAfter;
+	return YES;
+}
+
+- (BOOL)scanUpdateData:(NSData **)updateData forReleaseVersion:(NSString *)version error:(NSError **)error {
+	NSParameterAssert(version != nil);
+
+	if (updateData != NULL) *updateData = nil;
+
+	if (_releasesOffset == NSNotFound && ![self scanMembersFinding:SQRLFeedMemberReleases error:error]) return NO;
+	if (_releasesOffset == NSNotFound) return YES;
+
+	SQRLFeedCursor cursor = _cursor;
+	cursor.offset = _releasesOffset;
+
+	// Anything other than an array doesn't list any releases.
+	if (!SQRLFeedConsume(&cursor, '[')) return YES;
+	if (SQRLFeedConsume(&cursor, ']')) return YES;
+
+	const char *wantedVersion = version.UTF8String;
+	size_t wantedVersionLength = strlen(wantedVersion);
+
+	do {
+		if (SQRLFeedPeek(&cursor) != '{') {
+			if (!SQRLFeedSkipValue(&cursor)) break;
+			continue;
+		}
+
+		__block BOOL matches = NO;
+		__block NSRange updateRange = NSMakeRange(NSNotFound, 0);
+
+		SQRLFeedCursor *releaseCursor = &cursor;
+		BOOL scanned = SQRLFeedScanObject(releaseCursor, ^(NSRange key, BOOL escaped) {
+			if (SQRLFeedStringEquals(releaseCursor, key, escaped, "version", 7) && SQRLFeedPeek(releaseCursor) == '"') {
+				NSRange value;
+				BOOL valueEscaped;
+				if (!SQRLFeedScanString(releaseCursor, &value, &valueEscaped)) return NO;
+
+				matches = SQRLFeedStringEquals(releaseCursor, value, valueEscaped, wantedVersion, wantedVersionLength);
+				return YES;
+			}
+
+			if (SQRLFeedStringEquals(releaseCursor, key, escaped, "updateTo", 8)) {
+				NSUInteger start = (SQRLFeedSkipWhitespace(releaseCursor), releaseCursor->offset);
+				if (!SQRLFeedSkipValue(releaseCursor)) return NO;
+
+				updateRange = NSMakeRange(start, releaseCursor->offset - start);
+				return YES;
+			}
+
+			return SQRLFeedSkipValue(releaseCursor);
+		});
+
+		if (!scanned) break;
+
+		// Only the first listing of a version counts.
+		if (matches) {
+			if (updateData != NULL && updateRange.location != NSNotFound) *updateData = [self.data subdataWithRange:updateRange];
+			return YES;
+		}
+	} while (SQRLFeedConsume(&cursor, ','));
+
+	if (SQRLFeedConsume(&cursor, ']')) return YES;
+
+	if (error != NULL) *error = SQRLFeedError(&cursor);
+	return NO;
+}
+
+- (BOOL)scanMembersFinding:(SQRLFeedMember)member error:(NSError **)error {
+	BOOL found = NO;
+	while (!_finishedObject && !found) {
+		if (![self scanNextMemberFinding:member found:&found]) {
+			if (error != NULL) *error = SQRLFeedError(&_cursor);
+			return NO;
+		}
+	}
+
+	return YES;
+}
+
+- (BOOL)scanNextMemberFinding:(SQRLFeedMember)member found:(BOOL *)found {
+	SQRLFeedCursor *cursor = &_cursor;
+
+	if (SQRLFeedConsume(cursor, '}')) {
+		_finishedObject = YES;
+		return YES;
+	}
+
+	if (_memberCount > 0 && !SQRLFeedConsume(cursor, ',')) return NO;
+
+	NSRange key;
+	BOOL escaped;
+	if (!SQRLFeedScanString(cursor, &key, &escaped)) return NO;
+	if (!SQRLFeedConsume(cursor, ':')) return NO;
+
+	_memberCount++;
+
+	if (SQRLFeedStringEquals(cursor, key, escaped, "currentRelease", 14)) {
+		if (SQRLFeedPeek(cursor) == '"') {
+			NSRange value;
+			BOOL valueEscaped;
+			if (!SQRLFeedScanString(cursor, &value, &valueEscaped)) return NO;
+
+			self.currentRelease = SQRLFeedDecodeString(cursor, value, valueEscaped);
+		} else if (!SQRLFeedSkipValue(cursor)) {
+			return NO;
+		}
+
+		_scannedCurrentRelease = YES;
+		*found = (member == SQRLFeedMemberCurrentRelease);
+		return YES;
+	}
+
+	if (SQRLFeedStringEquals(cursor, key, escaped, "releases", 8)) {
+		SQRLFeedSkipWhitespace(cursor);
+		_releasesOffset = cursor->offset;
+
+		// The releases are scanned from their start, and nothing after them
+		// is needed.
+		if (member == SQRLFeedMemberReleases) {
+			_finishedObject = YES;
+			*found = YES;
+			return YES;
+		}
+	}
+
+	if (SQRLFeedStringEquals(cursor, key, escaped, "nextCheckAfter", 14)) {
+		NSUInteger start = (SQRLFeedSkipWhitespace(cursor), cursor->offset);
+		if (!SQRLFeedSkipValue(cursor)) return NO;
+
+		// The hint is small, so leave decoding it to Foundation.
+		NSData *valueData = [self.data subdataWithRange:NSMakeRange(start, cursor->offset - start)];
+		self.nextCheckAfter = [NSJSONSerialization JSONObjectWithData:valueData options:NSJSONReadingAllowFragments error:NULL];
+
+		_scannedNextCheckAfter = YES;
+		*found = (member == SQRLFeedMemberNextCheckAfter);
+		return YES;
+	}
+
+	return SQRLFeedSkipValue(cursor);
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ length: %lu, currentRelease: %@ }", self.class, self, (unsigned long)self.data.length, self.currentRelease];
+}
+
+@end
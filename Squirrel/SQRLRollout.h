@@ -0,0 +1,44 @@
+//
+//  SQRLRollout.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// Decides whether this install is part of a staged rollout.
+//
+// Each install is given a random identifier the first time it's needed, which
+// is saved to user defaults. Hashing the identifier with a release's version
+// places the install in a bucket from 0 to 100, which is stable for that
+// release but unrelated to its bucket for any other release, so the same
+// installs aren't always the first to get updates.
+//
+// This class is thread-safe.
+@interface SQRLRollout : NSObject
+
+// Initializes the receiver to save its identifier to the given defaults.
+//
+// userDefaults - The defaults in which to save the install's identifier. This
+//                must not be nil.
+- (instancetype)initWithUserDefaults:(NSUserDefaults *)userDefaults;
+
+// The install's identifier, which is created and saved if it doesn't exist yet.
+@property (nonatomic, copy, readonly) NSString *installIdentifier;
+
+// Returns the install's bucket for the given release, from 0 up to, but not
+// including, 100.
+//
+// version - The version of the release. This must not be nil.
+- (double)bucketForVersion:(NSString *)version;
+
+// Returns whether the install is part of a release's rollout.
+//
+// version    - The version of the release. This must not be nil.
+// percentage - The percentage of installs, from 0 to 100, that the release is
+//              rolled out to.
+- (BOOL)includesVersion:(NSString *)version rolloutPercentage:(double)percentage;
+
+@end
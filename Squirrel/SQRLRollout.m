@@ -0,0 +1,83 @@
+//
+//  SQRLRollout.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLRollout.h"
+
+#import <CommonCrypto/CommonDigest.h>
+
+// The user defaults key for the install's identifier.
+static NSString * const SQRLRolloutInstallIdentifierKey = @"SQRLRolloutInstallIdentifier";
+
+// The number of distinct buckets, so that percentages can have two decimal
+// places.
+static const uint64_t SQRLRolloutBucketCount = 10000;
+
+@interface SQRLRollout ()
+
+@property (nonatomic, strong, readonly) NSUserDefaults *userDefaults;
+
+@end
+
+@implementation SQRLRollout
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithUserDefaults:(NSUserDefaults *)userDefaults {
+	NSParameterAssert(userDefaults != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_userDefaults = userDefaults;
+
+	return self;
+}
+
+#pragma mark Bucketing
+
+- (NSString *)installIdentifier {
+	@synchronized (self) {
+		NSString *identifier = [self.userDefaults stringForKey:SQRLRolloutInstallIdentifierKey];
+		if (identifier.length > 0) return identifier;
+
+		identifier = NSUUID.UUID.UUIDString;
+		[self.userDefaults setObject:identifier forKey:SQRLRolloutInstallIdentifierKey];
+		return identifier;
+	}
+}
+
+- (double)bucketForVersion:(NSString *)version {
+	NSParameterAssert(version != nil);
+
+	NSData *key = [[NSString stringWithFormat:@"%@:%@", self.installIdentifier, version] dataUsingEncoding:NSUTF8StringEncoding];
+
+	uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+	CC_SHA256(key.bytes, (CC_LONG)key.length, digest);
+
+	uint64_t value = 0;
+	for (NSUInteger i = 0; i < sizeof(value); i++) {
+		value = (value << 8) | digest[i];
+	}
+
+	return (value % SQRLRolloutBucketCount) * 100.0 / SQRLRolloutBucketCount;
+}
+
+- (BOOL)includesVersion:(NSString *)version rolloutPercentage:(double)percentage {
+	if (percentage >= 100) return YES;
+	if (!(percentage > 0)) return NO;
+
+	return [self bucketForVersion:version] < percentage;
+}
+
+#pragma mark NSObject
+
+- (NSString *)description {
+	return [NSString stringWithFormat:@"<%@: %p>{ installIdentifier: %@ }", self.class, self, self.installIdentifier];
+}
+
+@end
@@ -0,0 +1,96 @@
+//
+//  SQRLSemanticVersion.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// The longest version string, in UTF-8 bytes, that can be parsed from an
+// `NSString`. Longer strings are treated as invalid, so that they can be
+// copied onto the stack.
+#define SQRLSemanticVersionMaximumStringLength 255
+
+// Options for parsing versions.
+typedef NS_OPTIONS(NSUInteger, SQRLSemanticVersionOptions) {
+	// Only accepts versions which follow Semantic Versioning 2.0 exactly.
+	SQRLSemanticVersionOptionsStrict = 0,
+
+	// Also accepts leading zeroes in numbers, like `1.02.0`.
+	SQRLSemanticVersionOptionsLeadingZeroes = 1 << 1,
+
+	// Also accepts the forms that release feeds and bundle versions often use
+	// instead: a leading `v`, one or two version core numbers instead of three
+	// (with the missing ones taken to be 0), and leading zeroes in numbers.
+	SQRLSemanticVersionOptionsLenient = 1 << 0 | SQRLSemanticVersionOptionsLeadingZeroes,
+};
+
+// A version parsed by `SQRLSemanticVersionParse()`.
+//
+// The prerelease and build metadata aren't copied, but point into the string
+// that was parsed, so the version is only valid for as long as that string is.
+typedef struct {
+	uint64_t major;
+	uint64_t minor;
+	uint64_t patch;
+
+	// The dot-separated prerelease identifiers, after the `-`. The length is
+	// zero if this isn't a prerelease.
+	const char *prerelease;
+	size_t prereleaseLength;
+
+	// The dot-separated build metadata identifiers, after the `+`. The length
+	// is zero if there's no build metadata.
+	const char *build;
+	size_t buildLength;
+} SQRLSemanticVersion;
+
+// Parses a version, without allocating any memory.
+//
+// string  - The UTF-8 string to parse, which doesn't need to be
+//           NUL-terminated. This must not be NULL unless `length` is 0.
+// length  - The number of bytes in `string`.
+// options - Which forms of version to accept.
+// version - If not NULL, and the string is a valid version, this is set to the
+//           parsed version.
+//
+// Returns whether the string is a valid version.
+BOOL SQRLSemanticVersionParse(const char *string, size_t length, SQRLSemanticVersionOptions options, SQRLSemanticVersion *version);
+
+// Compares two parsed versions by their precedence.
+//
+// Version core numbers are compared numerically, then a prerelease is older
+// than the release itself. Prereleases are compared identifier by identifier,
+// numerically if both are numbers, with numbers older than other identifiers,
+// and otherwise in ASCII order, until one runs out of identifiers and is older.
+// Build metadata is ignored.
+//
+// Neither version may be NULL.
+NSComparisonResult SQRLSemanticVersionCompare(const SQRLSemanticVersion *version, const SQRLSemanticVersion *otherVersion);
+
+// Parses a version string, without allocating any memory.
+//
+// The prerelease and build metadata point into `buffer` if the string had to be
+// copied into it.
+//
+// string  - The version string. This must not be nil.
+// options - Which forms of version to accept.
+// version - If not NULL, and the string is a valid version, this is set to the
+//           parsed version.
+// buffer  - Storage for the string's UTF-8 bytes, if they can't be read from
+//           the string directly. This must not be NULL.
+//
+// Returns whether the string is a valid version.
+BOOL SQRLSemanticVersionParseString(NSString *string, SQRLSemanticVersionOptions options, SQRLSemanticVersion *version, char buffer[SQRLSemanticVersionMaximumStringLength]);
+
+// Compares two version strings by their precedence, without allocating any
+// memory unless one of them isn't a version.
+//
+// The strings are parsed leniently. Strings which aren't versions even then
+// are older than all those which are, and are compared to each other with
+// `NSNumericSearch`, so that sorting mixed lists is still consistent.
+//
+// Neither string may be nil.
+NSComparisonResult SQRLSemanticVersionCompareStrings(NSString *version, NSString *otherVersion);
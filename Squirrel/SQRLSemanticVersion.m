@@ -0,0 +1,242 @@
+//
+//  SQRLSemanticVersion.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLSemanticVersion.h"
+
+static inline BOOL SQRLVersionIsDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static inline BOOL SQRLVersionIsIdentifierCharacter(char c) {
+	return SQRLVersionIsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-';
+}
+
+// Parses a version core number, advancing `position` past it.
+//
+// Returns whether there was a number which fits in 64 bits, and which doesn't
+// have a leading zero unless `leadingZeroes` is set.
+static BOOL SQRLVersionScanNumber(const char *string, size_t length, size_t *position, BOOL leadingZeroes, uint64_t *number) {
+	size_t start = *position;
+	uint64_t value = 0;
+
+	while (*position < length && SQRLVersionIsDigit(string[*position])) {
+		uint64_t digit = (uint64_t)(string[*position] - '0');
+		if (value > (UINT64_MAX - digit) / 10) return NO;
+
+		value = value * 10 + digit;
+		(*position)++;
+	}
+
+	size_t digitCount = *position - start;
+	if (digitCount == 0) return NO;
+	if (!leadingZeroes && digitCount > 1 && string[start] == '0') return NO;
+
+	*number = value;
+	return YES;
+}
+
+// Validates dot-separated identifiers, advancing `position` to the end of the
+// string, or to the `+` which ends a prerelease.
+//
+// Returns whether every identifier was valid. Numeric prerelease identifiers
+// can't have leading zeroes unless `leadingZeroes` is set.
+static BOOL SQRLVersionScanIdentifiers(const char *string, size_t length, size_t *position, BOOL prerelease, BOOL leadingZeroes) {
+	size_t identifierStart = *position;
+	BOOL numeric = YES;
+
+	for (;; (*position)++) {
+		BOOL atEnd = (*position == length || (prerelease && string[*position] == '+'));
+		if (atEnd || string[*position] == '.') {
+			size_t identifierLength = *position - identifierStart;
+			if (identifierLength == 0) return NO;
+			if (prerelease && !leadingZeroes && numeric && identifierLength > 1 && string[identifierStart] == '0') return NO;
+			if (atEnd) return YES;
+
+			identifierStart = *position + 1;
+			numeric = YES;
+			continue;
+		}
+
+		char c = string[*position];
+		if (!SQRLVersionIsIdentifierCharacter(c)) return NO;
+		if (!SQRLVersionIsDigit(c)) numeric = NO;
+	}
+}
+
+BOOL SQRLSemanticVersionParse(const char *string, size_t length, SQRLSemanticVersionOptions options, SQRLSemanticVersion *version) {
+	NSCParameterAssert(string != NULL || length == 0);
+
+	BOOL lenient = (options & SQRLSemanticVersionOptionsLenient) == SQRLSemanticVersionOptionsLenient;
+	BOOL leadingZeroes = (options & SQRLSemanticVersionOptionsLeadingZeroes) != 0;
+	SQRLSemanticVersion parsed = { 0 };
+	size_t position = 0;
+
+	if (lenient && length > 0 && (string[0] == 'v' || string[0] == 'V')) position++;
+
+	uint64_t *numbers[] = { &parsed.major, &parsed.minor, &parsed.patch };
+	for (size_t i = 0; i < sizeof(numbers) / sizeof(*numbers); i++) {
+		if (i > 0) {
+			if (position < length && string[position] == '.') {
+				position++;
+			} else if (lenient) {
+				break;
+			} else {
+				return NO;
+			}
+		}
+
+		if (!SQRLVersionScanNumber(string, length, &position, leadingZeroes, numbers[i])) return NO;
+	}
+
+	if (position < length && string[position] == '-') {
+		size_t start = ++position;
+		if (!SQRLVersionScanIdentifiers(string, length, &position, YES, leadingZeroes)) return NO;
+
+		parsed.prerelease = string + start;
+		parsed.prereleaseLength = position - start;
+	}
+
+	if (position < length && string[position] == '+') {
+		size_t start = ++position;
+		if (!SQRLVersionScanIdentifiers(string, length, &position, NO, leadingZeroes)) return NO;
+
+		parsed.build = string + start;
+		parsed.buildLength = position - start;
+	}
+
+	if (position != length) return NO;
+
+	if (version != NULL) *version = parsed;
+	return YES;
+}
+
+static inline NSComparisonResult SQRLVersionCompareNumbers(uint64_t number, uint64_t otherNumber) {
+	if (number == otherNumber) return NSOrderedSame;
+	return (number < otherNumber ? NSOrderedAscending : NSOrderedDescending);
+}
+
+static BOOL SQRLVersionIdentifierIsNumeric(const char *identifier, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		if (!SQRLVersionIsDigit(identifier[i])) return NO;
+	}
+
+	return YES;
+}
+
+// Compares two prerelease identifiers.
+static NSComparisonResult SQRLVersionCompareIdentifiers(const char *identifier, size_t length, const char *otherIdentifier, size_t otherLength) {
+	BOOL numeric = SQRLVersionIdentifierIsNumeric(identifier, length);
+	BOOL otherNumeric = SQRLVersionIdentifierIsNumeric(otherIdentifier, otherLength);
+
+	if (numeric && otherNumeric) {
+		// Numbers may be longer than 64 bits, so compare their digits instead.
+		// Leading zeroes, which lenient parsing allows, don't count.
+		while (length > 1 && *identifier == '0') {
+			identifier++;
+			length--;
+		}
+
+		while (otherLength > 1 && *otherIdentifier == '0') {
+			otherIdentifier++;
+			otherLength--;
+		}
+
+		if (length != otherLength) return (length < otherLength ? NSOrderedAscending : NSOrderedDescending);
+	} else if (numeric != otherNumeric) {
+		return (numeric ? NSOrderedAscending : NSOrderedDescending);
+	}
+
+	int result = memcmp(identifier, otherIdentifier, MIN(length, otherLength));
+	if (result != 0) return (result < 0 ? NSOrderedAscending : NSOrderedDescending);
+
+	return SQRLVersionCompareNumbers(length, otherLength);
+}
+
+NSComparisonResult SQRLSemanticVersionCompare(const SQRLSemanticVersion *version, const SQRLSemanticVersion *otherVersion) {
+	NSCParameterAssert(version != NULL);
+	NSCParameterAssert(otherVersion != NULL);
+
+	NSComparisonResult result = SQRLVersionCompareNumbers(version->major, otherVersion->major);
+	if (result != NSOrderedSame) return result;
+
+	result = SQRLVersionCompareNumbers(version->minor, otherVersion->minor);
+	if (result != NSOrderedSame) return result;
+
+	result = SQRLVersionCompareNumbers(version->patch, otherVersion->patch);
+	if (result != NSOrderedSame) return result;
+
+	// A prerelease comes before the release itself.
+	size_t length = version->prereleaseLength;
+	size_t otherLength = otherVersion->prereleaseLength;
+	if (length == 0 || otherLength == 0) return SQRLVersionCompareNumbers(otherLength, length);
+
+	size_t position = 0;
+	size_t otherPosition = 0;
+	while (position < length && otherPosition < otherLength) {
+		const char *identifier = version->prerelease + position;
+		const char *otherIdentifier = otherVersion->prerelease + otherPosition;
+
+		size_t end = position;
+		while (end < length && version->prerelease[end] != '.') end++;
+
+		size_t otherEnd = otherPosition;
+		while (otherEnd < otherLength && otherVersion->prerelease[otherEnd] != '.') otherEnd++;
+
+		result = SQRLVersionCompareIdentifiers(identifier, end - position, otherIdentifier, otherEnd - otherPosition);
+		if (result != NSOrderedSame) return result;
+
+		position = end + 1;
+		otherPosition = otherEnd + 1;
+	}
+
+	// If one has identifiers left over, it comes after the other.
+	BOOL remaining = position < length;
+	BOOL otherRemaining = otherPosition < otherLength;
+	if (remaining == otherRemaining) return NSOrderedSame;
+
+	return (remaining ? NSOrderedDescending : NSOrderedAscending);
+}
+
+BOOL SQRLSemanticVersionParseString(NSString *string, SQRLSemanticVersionOptions options, SQRLSemanticVersion *version, char buffer[SQRLSemanticVersionMaximumStringLength]) {
+	NSCParameterAssert(string != nil);
+	NSCParameterAssert(buffer != NULL);
+
+	CFStringRef cfString = (__bridge CFStringRef)string;
+
+	const char *bytes = CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8);
+	if (bytes != NULL) return SQRLSemanticVersionParse(bytes, strlen(bytes), options, version);
+
+	// Every character takes at least one byte, so this rules out strings
+	// which can't fit before converting them.
+	CFIndex length = CFStringGetLength(cfString);
+	if (length > SQRLSemanticVersionMaximumStringLength) return NO;
+
+	CFIndex byteCount = 0;
+	CFIndex convertedLength = CFStringGetBytes(cfString, CFRangeMake(0, length), kCFStringEncodingUTF8, 0, false, (UInt8 *)buffer, SQRLSemanticVersionMaximumStringLength, &byteCount);
+	if (convertedLength != length) return NO;
+
+	return SQRLSemanticVersionParse(buffer, (size_t)byteCount, options, version);
+}
+
+NSComparisonResult SQRLSemanticVersionCompareStrings(NSString *version, NSString *otherVersion) {
+	NSCParameterAssert(version != nil);
+	NSCParameterAssert(otherVersion != nil);
+
+	char buffer[SQRLSemanticVersionMaximumStringLength];
+	char otherBuffer[SQRLSemanticVersionMaximumStringLength];
+
+	SQRLSemanticVersion parsed;
+	SQRLSemanticVersion otherParsed;
+	BOOL valid = SQRLSemanticVersionParseString(version, SQRLSemanticVersionOptionsLenient, &parsed, buffer);
+	BOOL otherValid = SQRLSemanticVersionParseString(otherVersion, SQRLSemanticVersionOptionsLenient, &otherParsed, otherBuffer);
+
+	if (valid && otherValid) return SQRLSemanticVersionCompare(&parsed, &otherParsed);
+	if (valid != otherValid) return (valid ? NSOrderedDescending : NSOrderedAscending);
+
+	return [version compare:otherVersion options:NSNumericSearch];
+}
@@ -24,6 +24,9 @@ extern const NSInteger SQRLShipItLauncherErrorCouldNotStartService;
 
 // Attempts to launch ShipIt.
 //
+// Any previous ShipIt job is removed, then ShipIt's logs are rotated, so that
+// the new job starts them afresh.
+//
 // privileged - Determines which launchd domain to launch the job in.
 //              If YES, ShipIt is launched in the root domain, otherwise it is
 //              launched in the current user’s domain.
@@ -131,18 +131,28 @@ const NSInteger SQRLShipItLauncherErrorCouldNotStartService = 1;
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 
-+ (RACSignal *)launchPrivileged:(BOOL)privileged {
++ (RACSignal *)rotateShipItLogs {
+	NSString *jobLabel = self.shipItJobLabel;
+
 	return [[[RACSignal
-		zip:@[
-			self.shipItJobDictionary,
-			(privileged ? self.shipItAuthorization : [RACSignal return:nil])
-		] reduce:^(NSDictionary *jobDictionary, SQRLAuthorization *authorizationValue) {
-			CFStringRef domain = (privileged ? kSMDomainSystemLaunchd : kSMDomainUserLaunchd);
+		defer:^{
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:jobLabel];
+			return [directoryManager rotateShipItLogs];
+		}]
+		catch:^(NSError *error) {
+			NSLog(@"Could not rotate ShipIt logs: %@", error);
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"+rotateShipItLogs"];
+}
 
-			AuthorizationRef authorization = authorizationValue.authorization;
++ (RACSignal *)launchPrivileged:(BOOL)privileged {
+	return [[[[(privileged ? self.shipItAuthorization : [RACSignal return:nil])
+		flattenMap:^(SQRLAuthorization *authorizationValue) {
+			CFStringRef domain = (privileged ? kSMDomainSystemLaunchd : kSMDomainUserLaunchd);
 
 			CFErrorRef cfError;
-			if (!SMJobRemove(domain, (__bridge CFStringRef)self.shipItJobLabel, authorization, true, &cfError)) {
+			if (!SMJobRemove(domain, (__bridge CFStringRef)self.shipItJobLabel, authorizationValue.authorization, true, &cfError)) {
 				NSError *error = CFBridgingRelease(cfError);
 				cfError = NULL;
 
@@ -151,7 +161,22 @@ const NSInteger SQRLShipItLauncherErrorCouldNotStartService = 1;
 				}
 			}
 
-			if (!SMJobSubmit(domain, (__bridge CFDictionaryRef)jobDictionary, authorization, &cfError)) {
+			// Now that the previous job can't write to the logs any more, start
+			// them afresh before the new job opens them.
+			return [[[self
+				rotateShipItLogs]
+				then:^{
+					return self.shipItJobDictionary;
+				}]
+				map:^(NSDictionary *jobDictionary) {
+					return RACTuplePack(jobDictionary, authorizationValue);
+				}];
+		}]
+		reduceEach:^(NSDictionary *jobDictionary, SQRLAuthorization *authorizationValue) {
+			CFStringRef domain = (privileged ? kSMDomainSystemLaunchd : kSMDomainUserLaunchd);
+
+			CFErrorRef cfError;
+			if (!SMJobSubmit(domain, (__bridge CFDictionaryRef)jobDictionary, authorizationValue.authorization, &cfError)) {
 				return [RACSignal error:CFBridgingRelease(cfError)];
 			}
 
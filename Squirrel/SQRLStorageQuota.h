@@ -0,0 +1,79 @@
+//
+//  SQRLStorageQuota.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// The kinds of item kept in the storage directory.
+typedef NS_ENUM(NSInteger, SQRLStorageArtifactClass) {
+	// An `update.XXXXXXX` directory that an update was (or is being) downloaded
+	// and unarchived into, or the trash that they're moved into to be deleted.
+	SQRLStorageArtifactClassUpdate,
+
+	// A ShipIt log that has been rotated.
+	SQRLStorageArtifactClassLog,
+
+	// Anything else, like ShipIt's state and the logs it's writing to. These
+	// items are small, or in use, so they're never evicted.
+	SQRLStorageArtifactClassOther,
+};
+
+// Keeps the size of the storage directory under a maximum by evicting the
+// update directories and rotated logs which were least recently used.
+//
+// Only the items directly within the storage directory are evicted, and each is
+// evicted as a whole. An item was last used when any file within it was last
+// read, or anything within it modified.
+@interface SQRLStorageQuota : NSObject
+
+// Determines the kind of an item in the storage directory from its name.
+//
+// name - The last path component of the item. This must not be nil.
++ (SQRLStorageArtifactClass)artifactClassForItemNamed:(NSString *)name;
+
+// Initializes the receiver to manage the given directory.
+//
+// storageURL  - The storage directory. This must not be nil.
+// maximumSize - The most bytes that the files in the directory should take up,
+//               or 0 if there is no maximum.
+- (instancetype)initWithStorageURL:(NSURL *)storageURL maximumSize:(unsigned long long)maximumSize;
+
+// The storage directory.
+@property (nonatomic, copy, readonly) NSURL *storageURL;
+
+// The most bytes that the files in the storage directory should take up, or 0
+// if there is no maximum.
+@property (nonatomic, assign, readonly) unsigned long long maximumSize;
+
+// Lazily measures how many bytes each kind of item takes up.
+//
+// Returns a signal which sends an `NSDictionary` from each
+// `SQRLStorageArtifactClass` (as an `NSNumber`) to the number of bytes in items
+// of that kind (also as an `NSNumber`), then completes, on a background thread.
+- (RACSignal *)usage;
+
+// Lazily evicts update directories and rotated logs, least recently used first,
+// until the storage directory is no larger than `maximumSize`.
+//
+// Items which can't be evicted are counted towards the maximum, so the
+// directory may still be larger afterwards.
+//
+// protectedURLs - A signal which sends an array of items which must not be
+//                 evicted, even if they're the least recently used. The item in
+//                 the storage directory containing each of these URLs is
+//                 protected. This is only subscribed to once the storage
+//                 directory has been measured, if anything needs evicting, so
+//                 it can protect items created during the measurement. This
+//                 must not be nil.
+//
+// Returns a signal which sends the URL of each evicted item, then completes,
+// on a background thread.
+- (RACSignal *)evictProtectingURLs:(RACSignal *)protectedURLs;
+
+@end
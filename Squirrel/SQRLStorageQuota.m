@@ -0,0 +1,268 @@
+//
+//  SQRLStorageQuota.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLStorageQuota.h"
+
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <fts.h>
+#import <sys/stat.h>
+
+#import "NSError+SQRLVerbosityExtensions.h"
+#import "SQRLFileTreeWalker.h"
+#import "SQRLTrash.h"
+
+// The prefix of the directories that SQRLUpdater downloads updates into.
+static NSString * const SQRLStorageQuotaUpdateDirectoryPrefix = @"update.";
+
+// The prefixes of ShipIt's rotated logs, which are followed by a generation
+// number.
+static NSString * const SQRLStorageQuotaStdoutLogPrefix = @"ShipIt_stdout.log.";
+static NSString * const SQRLStorageQuotaStderrLogPrefix = @"ShipIt_stderr.log.";
+
+// The extension of ShipIt's rotated logs.
+static NSString * const SQRLStorageQuotaRotatedLogExtension = @"gz";
+
+// An item directly within the storage directory.
+@interface SQRLStorageQuotaItem : NSObject
+
+@property (nonatomic, strong) NSURL *URL;
+@property (nonatomic, assign) SQRLStorageArtifactClass artifactClass;
+
+// The total size of the files in the item, in bytes.
+@property (nonatomic, assign) unsigned long long size;
+
+// When any file within the item was last read, or anything within it
+// modified, in seconds since 1970.
+@property (nonatomic, assign) NSTimeInterval lastUsedTime;
+
+@end
+
+@implementation SQRLStorageQuotaItem
+@end
+
+@interface SQRLStorageQuota ()
+
+// Synchronously measures each item in the storage directory.
+//
+// errorRef - If not NULL, set to any error that occurs.
+//
+// Returns an array of `SQRLStorageQuotaItem`s, or nil if the storage directory
+// couldn't be read.
+- (NSArray *)measureItems:(NSError **)errorRef;
+
+@end
+
+@implementation SQRLStorageQuota
+
+#pragma mark Lifecycle
+
++ (SQRLStorageArtifactClass)artifactClassForItemNamed:(NSString *)name {
+	NSParameterAssert(name != nil);
+
+	if ([name hasPrefix:SQRLStorageQuotaUpdateDirectoryPrefix] || [name isEqualToString:SQRLTrashDirectoryName]) return SQRLStorageArtifactClassUpdate;
+
+	// The logs ShipIt writes to have no extension, or just a number if the
+	// usual ones weren't writable, and mustn't be deleted out from under it.
+	BOOL isLog = [name hasPrefix:SQRLStorageQuotaStdoutLogPrefix] || [name hasPrefix:SQRLStorageQuotaStderrLogPrefix];
+	if (isLog && [name.pathExtension isEqualToString:SQRLStorageQuotaRotatedLogExtension]) return SQRLStorageArtifactClassLog;
+
+	return SQRLStorageArtifactClassOther;
+}
+
+- (instancetype)initWithStorageURL:(NSURL *)storageURL maximumSize:(unsigned long long)maximumSize {
+	NSParameterAssert(storageURL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_storageURL = [storageURL copy];
+	_maximumSize = maximumSize;
+
+	return self;
+}
+
+#pragma mark Measuring
+
+// Walks everything within the item at `path`, without following symbolic
+// links.
+//
+// size         - Set to the total size of the regular files within the item.
+// lastUsedTime - Set to when any file within the item was last read, or
+//                anything within it modified, in seconds since 1970.
+//
+// Returns whether the item itself could be measured. Items within it which
+// disappear or can't be read during the walk are skipped.
+static BOOL SQRLStorageQuotaMeasureItem(const char *path, unsigned long long *size, NSTimeInterval *lastUsedTime) {
+	char *paths[] = { (char *)path, NULL };
+	FTS *fts = fts_open(paths, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, NULL);
+	if (fts == NULL) return NO;
+
+	BOOL measured = NO;
+	*size = 0;
+	*lastUsedTime = 0;
+
+	FTSENT *entry;
+	while ((entry = fts_read(fts)) != NULL) {
+		switch (entry->fts_info) {
+		// Directories are visited again after their contents.
+		case FTS_DP:
+			continue;
+
+		case FTS_DNR:
+		case FTS_ERR:
+		case FTS_NS:
+			NSLog(@"Could not measure %s: %s", entry->fts_path, strerror(entry->fts_errno));
+			continue;
+		}
+
+		const struct stat *info = entry->fts_statp;
+		if (S_ISREG(info->st_mode)) *size += (unsigned long long)info->st_size;
+
+		NSTimeInterval modificationTime = info->st_mtimespec.tv_sec + info->st_mtimespec.tv_nsec / (double)NSEC_PER_SEC;
+		*lastUsedTime = MAX(*lastUsedTime, modificationTime);
+
+		// Listing a directory, like this walk does, updates its access time, so
+		// only the access times of files are meaningful.
+		if (S_ISREG(info->st_mode)) {
+			NSTimeInterval accessTime = info->st_atimespec.tv_sec + info->st_atimespec.tv_nsec / (double)NSEC_PER_SEC;
+			*lastUsedTime = MAX(*lastUsedTime, accessTime);
+		}
+
+		if (entry->fts_level == FTS_ROOTLEVEL) measured = YES;
+	}
+
+	fts_close(fts);
+	return measured;
+}
+
+- (NSArray *)measureItems:(NSError **)errorRef {
+	NSFileManager *manager = [[NSFileManager alloc] init];
+	NSArray *itemURLs = [manager contentsOfDirectoryAtURL:self.storageURL includingPropertiesForKeys:nil options:0 error:errorRef];
+	if (itemURLs == nil) return nil;
+
+	NSMutableArray *items = [NSMutableArray arrayWithCapacity:itemURLs.count];
+	for (NSURL *itemURL in itemURLs) {
+		unsigned long long size = 0;
+		NSTimeInterval lastUsedTime = 0;
+		if (!SQRLStorageQuotaMeasureItem(itemURL.path.fileSystemRepresentation, &size, &lastUsedTime)) continue;
+
+		SQRLStorageQuotaItem *item = [[SQRLStorageQuotaItem alloc] init];
+		item.URL = itemURL;
+		item.artifactClass = [self.class artifactClassForItemNamed:itemURL.lastPathComponent];
+		item.size = size;
+		item.lastUsedTime = lastUsedTime;
+		[items addObject:item];
+	}
+
+	return items;
+}
+
+- (RACSignal *)usage {
+	return [[[RACSignal
+		defer:^{
+			NSError *error = nil;
+			NSArray *items = [self measureItems:&error];
+			if (items == nil) return [RACSignal error:error];
+
+			unsigned long long sizes[] = {
+				[SQRLStorageArtifactClassUpdate] = 0,
+				[SQRLStorageArtifactClassLog] = 0,
+				[SQRLStorageArtifactClassOther] = 0,
+			};
+
+			for (SQRLStorageQuotaItem *item in items) {
+				sizes[item.artifactClass] += item.size;
+			}
+
+			return [RACSignal return:@{
+				@(SQRLStorageArtifactClassUpdate): @(sizes[SQRLStorageArtifactClassUpdate]),
+				@(SQRLStorageArtifactClassLog): @(sizes[SQRLStorageArtifactClassLog]),
+				@(SQRLStorageArtifactClassOther): @(sizes[SQRLStorageArtifactClassOther]),
+			}];
+		}]
+		subscribeOn:[RACScheduler schedulerWithPriority:RACSchedulerPriorityBackground]]
+		setNameWithFormat:@"%@ -usage", self];
+}
+
+#pragma mark Evicting
+
+- (RACSignal *)evictProtectingURLs:(RACSignal *)protectedURLs {
+	NSParameterAssert(protectedURLs != nil);
+
+	return [[[RACSignal
+		defer:^{
+			if (self.maximumSize == 0) return [RACSignal empty];
+
+			NSError *error = nil;
+			NSArray *items = [self measureItems:&error];
+			if (items == nil) return [RACSignal error:error];
+
+			unsigned long long totalSize = 0;
+			for (SQRLStorageQuotaItem *item in items) {
+				totalSize += item.size;
+			}
+
+			if (totalSize <= self.maximumSize) return [RACSignal empty];
+
+			// Only find out what's protected now, so that anything which was
+			// protected while being measured still is.
+			return [[protectedURLs
+				take:1]
+				flattenMap:^(NSArray *URLs) {
+					NSMutableArray *protectedPaths = [NSMutableArray arrayWithCapacity:URLs.count];
+					for (NSURL *URL in URLs) {
+						[protectedPaths addObject:URL.URLByStandardizingPath.path];
+					}
+
+					BOOL (^isProtected)(SQRLStorageQuotaItem *) = ^(SQRLStorageQuotaItem *item) {
+						NSString *itemPath = item.URL.URLByStandardizingPath.path;
+						NSString *itemPrefix = [itemPath stringByAppendingString:@"/"];
+
+						for (NSString *protectedPath in protectedPaths) {
+							if ([protectedPath isEqualToString:itemPath] || [protectedPath hasPrefix:itemPrefix]) return YES;
+						}
+
+						return NO;
+					};
+
+					NSArray *candidates = [[items
+						filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^(SQRLStorageQuotaItem *item, NSDictionary *bindings) {
+							return (BOOL)(item.artifactClass != SQRLStorageArtifactClassOther && !isProtected(item));
+						}]]
+						sortedArrayUsingComparator:^(SQRLStorageQuotaItem *item, SQRLStorageQuotaItem *otherItem) {
+							return [@(item.lastUsedTime) compare:@(otherItem.lastUsedTime)];
+						}];
+
+					unsigned long long remainingSize = totalSize;
+					NSMutableArray *evictedItems = [NSMutableArray array];
+					for (SQRLStorageQuotaItem *item in candidates) {
+						if (remainingSize <= self.maximumSize) break;
+
+						[evictedItems addObject:item];
+						remainingSize -= item.size;
+					}
+
+					return [[evictedItems.rac_sequence.signal
+						map:^(SQRLStorageQuotaItem *item) {
+							return [[[[[SQRLFileTreeWalker alloc]
+								initWithRootURL:item.URL]
+								removeItems]
+								concat:[RACSignal return:item.URL]]
+								catch:^(NSError *error) {
+									NSLog(@"Error evicting %@ from storage: %@", item.URL, error.sqrl_verboseDescription);
+									return [RACSignal empty];
+								}];
+						}]
+						concat];
+				}];
+		}]
+		subscribeOn:[RACScheduler schedulerWithPriority:RACSchedulerPriorityBackground]]
+		setNameWithFormat:@"%@ -evictProtectingURLs: %@", self, protectedURLs];
+}
+
+@end
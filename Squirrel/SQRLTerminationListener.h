@@ -8,6 +8,31 @@
 
 #import <Cocoa/Cocoa.h>
 
+// The domain for errors originating within SQRLTerminationListener.
+extern NSString * const SQRLTerminationListenerErrorDomain;
+
+// Processes were still running when the deadline passed.
+extern const NSInteger SQRLTerminationListenerErrorTimedOut;
+
+// Associated with an `NSArray` of the process identifiers, as `NSNumber`s, that
+// were still running when the deadline passed.
+extern NSString * const SQRLTerminationListenerRunningProcessIdentifiersErrorKey;
+
+// Associated with the identifier of a process that exited, as an `NSNumber`.
+extern NSString * const SQRLTerminationListenerProcessIdentifierKey;
+
+// Associated with the path of the executable for a process that exited, as an
+// `NSString`.
+extern NSString * const SQRLTerminationListenerExecutablePathKey;
+
+// Associated with the number of seconds, as an `NSNumber`, between the start of
+// waiting and the process exiting.
+extern NSString * const SQRLTerminationListenerDurationKey;
+
+// Associated with the last signal sent to the process before it exited, as an
+// `NSNumber`. This is 0 if the process exited by itself.
+extern NSString * const SQRLTerminationListenerSignalKey;
+
 @class RACSignal;
 
 // Waits for the termination of a GUI application.
@@ -29,4 +54,26 @@
 // completes on a background scheduler.
 - (RACSignal *)waitForTermination;
 
+// Lazily waits for termination of every process running an executable from
+// inside the bundle, including helpers that aren't applications themselves.
+//
+// Only processes owned by the same user as the instances found by
+// -waitForTermination are waited for, or by the current user if none were
+// found, so processes from other users' sessions are never signaled.
+//
+// All of the processes are watched with a single kqueue.
+//
+// timeout         - How long to let the processes exit by themselves. This must
+//                   be greater than zero.
+// escalationDelay - If greater than zero, processes still running once
+//                   `timeout` has passed are sent SIGTERM, then SIGKILL if they
+//                   are still running this many seconds later. If zero, no
+//                   signals are sent.
+//
+// Returns a signal which sends a dictionary for each process as it exits,
+// described by the keys above, then completes on a background queue. If any
+// process is still running after the timeout and any escalation, the signal
+// errors with `SQRLTerminationListenerErrorTimedOut`.
+- (RACSignal *)waitForTerminationOfBundleProcessesWithTimeout:(NSTimeInterval)timeout escalationDelay:(NSTimeInterval)escalationDelay;
+
 @end
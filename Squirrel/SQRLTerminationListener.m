@@ -15,17 +15,70 @@
 #import <ReactiveObjC/RACSequence.h>
 #import <ReactiveObjC/RACSignal+Operations.h>
 #import <ReactiveObjC/RACSubscriber.h>
+#import <libproc.h>
+#import <sys/event.h>
+
+NSString * const SQRLTerminationListenerErrorDomain = @"SQRLTerminationListenerErrorDomain";
+const NSInteger SQRLTerminationListenerErrorTimedOut = 1;
+
+NSString * const SQRLTerminationListenerRunningProcessIdentifiersErrorKey = @"SQRLTerminationListenerRunningProcessIdentifiers";
+
+NSString * const SQRLTerminationListenerProcessIdentifierKey = @"processIdentifier";
+NSString * const SQRLTerminationListenerExecutablePathKey = @"executablePath";
+NSString * const SQRLTerminationListenerDurationKey = @"duration";
+NSString * const SQRLTerminationListenerSignalKey = @"signal";
+
+// Returns a monotonic timestamp in nanoseconds.
+static uint64_t SQRLTerminationListenerNow(void) {
+	return clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+}
+
+// Finds the user that owns a process.
+//
+// processIdentifier - The process to look up.
+// userIdentifier    - Set to the owner of the process. This must not be NULL.
+//
+// Returns whether the owner could be found.
+static BOOL SQRLTerminationListenerGetProcessOwner(pid_t processIdentifier, uid_t *userIdentifier) {
+	struct proc_bsdinfo info;
+	if (proc_pidinfo(processIdentifier, PROC_PIDTBSDINFO, 0, &info, PROC_PIDTBSDINFO_SIZE) != PROC_PIDTBSDINFO_SIZE) return NO;
+
+	*userIdentifier = info.pbi_uid;
+	return YES;
+}
 
 @interface SQRLTerminationListener ()
 
 @property (nonatomic, copy, readonly) NSURL *bundleURL;
 @property (nonatomic, copy, readonly) NSString *bundleIdentifier;
 
-// Waits for the process identified by the given PID to terminate.
+// The users that owned the instances of the application found by
+// -waitForTermination, or nil if it hasn't found any.
+@property (atomic, copy) NSSet *applicationUserIdentifiers;
+
+// Finds the processes, other than the current one, running an executable from
+// inside `bundleURL`.
+//
+// Only processes owned by the same users as the application are included, so
+// that escalation never signals another user's processes. If no instances of
+// the application were found, processes owned by the current user are.
 //
-// Returns a signal which sends `processIdentifier` as soon as the process is
-// being monitored, then completes once it exits, all on a background thread. 
-- (RACSignal *)waitForTerminationOfProcessIdentifier:(pid_t)processIdentifier;
+// Returns a dictionary of executable paths keyed by process identifier.
+- (NSDictionary *)bundleProcesses;
+
+// Waits for the given processes to terminate, using a single kqueue.
+//
+// processes       - The processes to wait for, as a dictionary of executable
+//                   paths (or `NSNull`) keyed by process identifier. This must
+//                   not be nil.
+// timeout         - How long to wait before escalating, or `INFINITY` to wait
+//                   forever.
+// escalationDelay - How long to wait after each of SIGTERM and SIGKILL, or zero
+//                   to not send any signals.
+//
+// Returns a signal which sends a dictionary describing each process as it
+// exits, then completes once none are left running.
+- (RACSignal *)waitForTerminationOfProcesses:(NSDictionary *)processes timeout:(NSTimeInterval)timeout escalationDelay:(NSTimeInterval)escalationDelay;
 
 @end
 
@@ -49,41 +102,220 @@
 #pragma mark Termination Listening
 
 - (RACSignal *)waitForTermination {
-	return [[[[RACSignal
+	return [[RACSignal
 		defer:^{
-			NSArray *apps = [NSRunningApplication runningApplicationsWithBundleIdentifier:self.bundleIdentifier];
-			return [apps.rac_sequence signalWithScheduler:RACScheduler.immediateScheduler];
-		}]
-		filter:^(NSRunningApplication *application) {
-			return [application.bundleURL.URLByStandardizingPath isEqual:self.bundleURL];
-		}]
-		flattenMap:^(NSRunningApplication *application) {
-			return [[self
-				waitForTerminationOfProcessIdentifier:application.processIdentifier]
-				mapReplace:application];
+			NSArray *apps = [[NSRunningApplication runningApplicationsWithBundleIdentifier:self.bundleIdentifier] filteredArrayUsingPredicate:[NSPredicate predicateWithBlock:^ BOOL (NSRunningApplication *application, NSDictionary *bindings) {
+				return [application.bundleURL.URLByStandardizingPath isEqual:self.bundleURL];
+			}]];
+
+			NSMutableDictionary *processes = [NSMutableDictionary dictionary];
+			NSMutableSet *userIdentifiers = [NSMutableSet set];
+			for (NSRunningApplication *application in apps) {
+				processes[@(application.processIdentifier)] = application.executableURL.path ?: NSNull.null;
+
+				uid_t userIdentifier;
+				if (SQRLTerminationListenerGetProcessOwner(application.processIdentifier, &userIdentifier)) [userIdentifiers addObject:@(userIdentifier)];
+			}
+
+			if (userIdentifiers.count > 0) self.applicationUserIdentifiers = userIdentifiers;
+
+			return [[apps.rac_sequence
+				signalWithScheduler:RACScheduler.immediateScheduler]
+				concat:[[self waitForTerminationOfProcesses:processes timeout:INFINITY escalationDelay:0] ignoreValues]];
 		}]
 		setNameWithFormat:@"%@ -waitForTermination", self];
 }
 
-- (RACSignal *)waitForTerminationOfProcessIdentifier:(pid_t)processIdentifier {
+- (RACSignal *)waitForTerminationOfBundleProcessesWithTimeout:(NSTimeInterval)timeout escalationDelay:(NSTimeInterval)escalationDelay {
+	NSParameterAssert(timeout > 0);
+	NSParameterAssert(escalationDelay >= 0);
+
 	return [[RACSignal
-		createSignal:^(id<RACSubscriber> subscriber) {
-			dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_PROC, processIdentifier, DISPATCH_PROC_EXIT, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+		defer:^{
+			return [self waitForTerminationOfProcesses:self.bundleProcesses timeout:timeout escalationDelay:escalationDelay];
+		}]
+		setNameWithFormat:@"%@ -waitForTerminationOfBundleProcessesWithTimeout: %f escalationDelay: %f", self, timeout, escalationDelay];
+}
 
-			dispatch_source_set_registration_handler(source, ^{
-				[subscriber sendNext:@(processIdentifier)];
-			});
+- (NSDictionary *)bundleProcesses {
+	char bundlePath[PATH_MAX];
+	if (realpath(self.bundleURL.path.fileSystemRepresentation, bundlePath) == NULL) {
+		strlcpy(bundlePath, self.bundleURL.path.fileSystemRepresentation, sizeof(bundlePath));
+	}
+
+	strlcat(bundlePath, "/", sizeof(bundlePath));
+	size_t bundlePathLength = strlen(bundlePath);
+
+	NSSet *userIdentifiers = self.applicationUserIdentifiers ?: [NSSet setWithObject:@(getuid())];
+
+	int count = proc_listallpids(NULL, 0);
+	if (count <= 0) return @{};
+
+	// Leave room for processes that start before the second call.
+	NSMutableData *processIdentifiers = [NSMutableData dataWithLength:(NSUInteger)(count + 64) * sizeof(pid_t)];
+	count = proc_listallpids(processIdentifiers.mutableBytes, (int)processIdentifiers.length);
+
+	NSMutableDictionary *processes = [NSMutableDictionary dictionary];
+	const pid_t *pids = processIdentifiers.bytes;
+	for (int i = 0; i < count; i++) {
+		if (pids[i] == getpid()) continue;
+
+		char path[PROC_PIDPATHINFO_MAXSIZE];
+		if (proc_pidpath(pids[i], path, sizeof(path)) <= 0) continue;
+		if (strncmp(path, bundlePath, bundlePathLength) != 0) continue;
+
+		uid_t userIdentifier;
+		if (!SQRLTerminationListenerGetProcessOwner(pids[i], &userIdentifier) || ![userIdentifiers containsObject:@(userIdentifier)]) continue;
+
+		processes[@(pids[i])] = [NSFileManager.defaultManager stringWithFileSystemRepresentation:path length:strlen(path)];
+	}
 
-			dispatch_source_set_event_handler(source, ^{
+	return processes;
+}
+
+- (RACSignal *)waitForTerminationOfProcesses:(NSDictionary *)processes timeout:(NSTimeInterval)timeout escalationDelay:(NSTimeInterval)escalationDelay {
+	NSParameterAssert(processes != nil);
+
+	return [[RACSignal
+		createSignal:^ id (id<RACSubscriber> subscriber) {
+			uint64_t startTime = SQRLTerminationListenerNow();
+			NSMutableDictionary *runningProcesses = [processes mutableCopy];
+
+			// The last signal sent to the remaining processes.
+			__block int lastSignal = 0;
+
+			void (^processExited)(NSNumber *) = ^(NSNumber *processIdentifier) {
+				id path = runningProcesses[processIdentifier];
+				if (path == nil) return;
+
+				[runningProcesses removeObjectForKey:processIdentifier];
+
+				NSMutableDictionary *exit = [@{
+					SQRLTerminationListenerProcessIdentifierKey: processIdentifier,
+					SQRLTerminationListenerDurationKey: @((SQRLTerminationListenerNow() - startTime) / (double)NSEC_PER_SEC),
+					SQRLTerminationListenerSignalKey: @(lastSignal),
+				} mutableCopy];
+
+				if (path != NSNull.null) exit[SQRLTerminationListenerExecutablePathKey] = path;
+				[subscriber sendNext:exit];
+			};
+
+			int kq = kqueue();
+			if (kq == -1) {
+				[subscriber sendError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil]];
+				return nil;
+			}
+
+			// Register every process in one call. With EV_RECEIPT, each change
+			// is reported back with its own result, so a process that has
+			// already exited doesn't stop the others from being registered.
+			NSArray *processIdentifiers = runningProcesses.allKeys;
+			int changeCount = (int)processIdentifiers.count;
+			NSMutableData *changes = [NSMutableData dataWithLength:(NSUInteger)changeCount * sizeof(struct kevent)];
+			NSMutableData *receipts = [NSMutableData dataWithLength:(NSUInteger)changeCount * sizeof(struct kevent)];
+
+			struct kevent *change = changes.mutableBytes;
+			for (NSNumber *processIdentifier in processIdentifiers) {
+				EV_SET(change++, processIdentifier.intValue, EVFILT_PROC, EV_ADD | EV_ONESHOT | EV_RECEIPT, NOTE_EXIT, 0, NULL);
+			}
+
+			int receiptCount = kevent(kq, changes.bytes, changeCount, receipts.mutableBytes, changeCount, NULL);
+			if (receiptCount == -1) {
+				int code = errno;
+				close(kq);
+				[subscriber sendError:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil]];
+				return nil;
+			}
+
+			const struct kevent *receipt = receipts.bytes;
+			for (int i = 0; i < receiptCount; i++, receipt++) {
+				if ((receipt->flags & EV_ERROR) == 0 || receipt->data == 0) continue;
+
+				if (receipt->data == ESRCH) {
+					processExited(@((pid_t)receipt->ident));
+				} else {
+					close(kq);
+					[subscriber sendError:[NSError errorWithDomain:NSPOSIXErrorDomain code:(NSInteger)receipt->data userInfo:nil]];
+					return nil;
+				}
+			}
+
+			if (runningProcesses.count == 0) {
+				close(kq);
 				[subscriber sendCompleted];
+				return nil;
+			}
+
+			dispatch_queue_t queue = dispatch_queue_create("com.github.Squirrel.SQRLTerminationListener", DISPATCH_QUEUE_SERIAL);
+			dispatch_set_target_queue(queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0));
+
+			// The kqueue becomes readable whenever a watched process exits.
+			dispatch_source_t exitSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)kq, 0, queue);
+			dispatch_source_t deadlineSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+
+			void (^cancel)(void) = ^{
+				dispatch_source_cancel(exitSource);
+				dispatch_source_cancel(deadlineSource);
+			};
+
+			dispatch_source_set_event_handler(exitSource, ^{
+				struct kevent events[16];
+				struct timespec noWait = { 0, 0 };
+
+				int eventCount;
+				while ((eventCount = kevent(kq, NULL, 0, events, 16, &noWait)) > 0) {
+					for (int i = 0; i < eventCount; i++) {
+						processExited(@((pid_t)events[i].ident));
+					}
+				}
+
+				if (runningProcesses.count > 0) return;
+
+				cancel();
+				[subscriber sendCompleted];
+			});
+
+			dispatch_source_set_cancel_handler(exitSource, ^{
+				close(kq);
 			});
 
-			dispatch_resume(source);
-			return [RACDisposable disposableWithBlock:^{
-				dispatch_source_cancel(source);
-			}];
+			dispatch_source_set_event_handler(deadlineSource, ^{
+				if (escalationDelay <= 0 || lastSignal == SIGKILL) {
+					cancel();
+
+					NSDictionary *userInfo = @{
+						NSLocalizedDescriptionKey: NSLocalizedString(@"Processes did not terminate", nil),
+						NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:NSLocalizedString(@"%lu processes were still running after the deadline passed.", nil), (unsigned long)runningProcesses.count],
+						SQRLTerminationListenerRunningProcessIdentifiersErrorKey: runningProcesses.allKeys,
+					};
+
+					[subscriber sendError:[NSError errorWithDomain:SQRLTerminationListenerErrorDomain code:SQRLTerminationListenerErrorTimedOut userInfo:userInfo]];
+					return;
+				}
+
+				lastSignal = (lastSignal == 0 ? SIGTERM : SIGKILL);
+				for (NSNumber *processIdentifier in runningProcesses) {
+					NSLog(@"Sending %s to process %@ (%@)", strsignal(lastSignal), processIdentifier, runningProcesses[processIdentifier]);
+
+					if (kill(processIdentifier.intValue, lastSignal) != 0 && errno != ESRCH) {
+						NSLog(@"Could not signal process %@: %s", processIdentifier, strerror(errno));
+					}
+				}
+
+				dispatch_source_set_timer(deadlineSource, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(escalationDelay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, 100 * NSEC_PER_MSEC);
+			});
+
+			// Without a start time, the timer never fires.
+			if (isfinite(timeout)) {
+				dispatch_source_set_timer(deadlineSource, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, 100 * NSEC_PER_MSEC);
+			}
+
+			dispatch_resume(exitSource);
+			dispatch_resume(deadlineSource);
+
+			return [RACDisposable disposableWithBlock:cancel];
 		}]
-		setNameWithFormat:@"%@ -waitForTerminationOfProcessIdentifier: %i", self, (int)processIdentifier];
+		setNameWithFormat:@"%@ -waitForTerminationOfProcesses: %@ timeout: %f escalationDelay: %f", self, processes, timeout, escalationDelay];
 }
 
 #pragma mark NSObject
@@ -0,0 +1,53 @@
+//
+//  SQRLTrash.h
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RACSignal;
+
+// The name of the trash directory within a storage directory.
+extern NSString * const SQRLTrashDirectoryName;
+
+// Defers deleting items in a storage directory.
+//
+// Items are renamed into a trash directory, which takes the same short time no
+// matter how large they are, and deleted later in the background.
+@interface SQRLTrash : NSObject
+
+// Initializes the receiver to keep its trash in the given storage directory.
+//
+// storageURL - The directory which contains the items that will be trashed.
+//              This must not be nil.
+- (instancetype)initWithStorageURL:(NSURL *)storageURL;
+
+// The trash directory, which is created when something is first trashed.
+@property (nonatomic, copy, readonly) NSURL *trashURL;
+
+// Moves an item into the trash.
+//
+// itemURL - The item to trash, which must be on the same volume as the trash.
+//           This must not be nil.
+//
+// Returns a signal which synchronously sends the item's URL in the trash then
+// completes, or errors if it couldn't be moved.
+- (RACSignal *)trashItemAtURL:(NSURL *)itemURL;
+
+// Lazily deletes the items in the trash, stopping early if that takes longer
+// than `timeBudget`.
+//
+// Deletions are kept to a few workers at a low priority, so that they don't
+// compete with more important work. Whatever is left will be deleted the next
+// time.
+//
+// timeBudget - The most time to spend deleting, in seconds.
+//
+// Returns a signal which sends whether the trash is now empty, as an
+// `NSNumber`, then completes, on a background thread.
+- (RACSignal *)emptyWithTimeBudget:(NSTimeInterval)timeBudget;
+
+@end
@@ -0,0 +1,102 @@
+//
+//  SQRLTrash.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import "SQRLTrash.h"
+
+#import <ReactiveObjC/ReactiveObjC.h>
+
+#import "NSError+SQRLVerbosityExtensions.h"
+#import "SQRLFileTreeWalker.h"
+
+NSString * const SQRLTrashDirectoryName = @"Trash";
+
+// The number of workers used to delete each item.
+static const NSUInteger SQRLTrashMaximumConcurrentOperations = 2;
+
+@implementation SQRLTrash
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithStorageURL:(NSURL *)storageURL {
+	NSParameterAssert(storageURL != nil);
+
+	self = [super init];
+	if (self == nil) return nil;
+
+	_trashURL = [storageURL URLByAppendingPathComponent:SQRLTrashDirectoryName isDirectory:YES];
+
+	return self;
+}
+
+#pragma mark Trashing
+
+- (RACSignal *)trashItemAtURL:(NSURL *)itemURL {
+	NSParameterAssert(itemURL != nil);
+
+	return [[RACSignal
+		defer:^{
+			NSError *error = nil;
+			if (![NSFileManager.defaultManager createDirectoryAtURL:self.trashURL withIntermediateDirectories:YES attributes:nil error:&error]) {
+				return [RACSignal error:error];
+			}
+
+			// Items with the same name may be trashed more than once before the
+			// trash is emptied.
+			NSString *name = [NSString stringWithFormat:@"%@.%@", itemURL.lastPathComponent, NSUUID.UUID.UUIDString];
+			NSURL *trashedURL = [self.trashURL URLByAppendingPathComponent:name];
+
+			if (rename(itemURL.path.fileSystemRepresentation, trashedURL.path.fileSystemRepresentation) != 0) {
+				int code = errno;
+
+				NSDictionary *userInfo = @{
+					NSLocalizedDescriptionKey: NSLocalizedString(@"Could not move item to the trash", nil),
+					NSURLErrorKey: itemURL
+				};
+
+				return [RACSignal error:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo]];
+			}
+
+			return [RACSignal return:trashedURL];
+		}]
+		setNameWithFormat:@"%@ -trashItemAtURL: %@", self, itemURL];
+}
+
+- (RACSignal *)emptyWithTimeBudget:(NSTimeInterval)timeBudget {
+	RACScheduler *scheduler = [RACScheduler schedulerWithPriority:RACSchedulerPriorityBackground];
+
+	NSArray * (^contents)(void) = ^{
+		NSArray *itemURLs = [NSFileManager.defaultManager contentsOfDirectoryAtURL:self.trashURL includingPropertiesForKeys:nil options:0 error:NULL];
+		return itemURLs ?: @[];
+	};
+
+	return [[[[[[[RACSignal
+		defer:^{
+			return contents().rac_sequence.signal;
+		}]
+		map:^(NSURL *itemURL) {
+			SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:itemURL];
+			walker.maximumConcurrentOperations = MIN(walker.maximumConcurrentOperations, SQRLTrashMaximumConcurrentOperations);
+
+			return [[walker
+				removeItems]
+				catch:^(NSError *error) {
+					NSLog(@"Error deleting %@ from the trash: %@", itemURL, error.sqrl_verboseDescription);
+					return [RACSignal empty];
+				}];
+		}]
+		concat]
+		// Disposing of the deletion in progress stops it where it is.
+		takeUntil:[[RACSignal return:nil] delay:timeBudget]]
+		then:^{
+			return [RACSignal return:@(contents().count == 0)];
+		}]
+		subscribeOn:scheduler]
+		setNameWithFormat:@"%@ -emptyWithTimeBudget: %f", self, timeBudget];
+}
+
+@end
@@ -28,4 +28,10 @@
 // The URL to the update package that should be downloaded for installation.
 @property (readonly, copy, nonatomic) NSURL *updateURL;
 
+// The version of the update, if the server sent one.
+@property (readonly, copy, nonatomic) NSString *releaseVersion;
+
+// The hex-encoded SHA-256 digest of the update package, if the server sent one.
+@property (readonly, copy, nonatomic) NSString *updateSHA256;
+
 @end
@@ -65,6 +65,8 @@ NSString * const SQRLUpdateJSONPublicationDateKey = @"pub_date";
 		@keypath(SQRLUpdate.new, releaseName): @"name",
 		@keypath(SQRLUpdate.new, releaseDate): @"pub_date",
 		@keypath(SQRLUpdate.new, updateURL): @"url",
+		@keypath(SQRLUpdate.new, releaseVersion): @"version",
+		@keypath(SQRLUpdate.new, updateSHA256): @"sha256",
 	};
 }
 
@@ -122,6 +124,22 @@ NSString * const SQRLUpdateJSONPublicationDateKey = @"pub_date";
 	return YES;
 }
 
+- (BOOL)validateReleaseVersion:(NSString **)stringPtr error:(NSError **)error {
+	if (![self validateString:*stringPtr forKey:@keypath(self.releaseVersion) error:error]) {
+		*stringPtr = nil;
+	}
+
+	return YES;
+}
+
+- (BOOL)validateUpdateSHA256:(NSString **)stringPtr error:(NSError **)error {
+	if (![self validateString:*stringPtr forKey:@keypath(self.updateSHA256) error:error]) {
+		*stringPtr = nil;
+	}
+
+	return YES;
+}
+
 - (BOOL)validateUpdateURL:(NSURL **)updateURLPtr error:(NSError **)error {
 	NSURL *updateURL = *updateURLPtr;
 	if (![updateURL isKindOfClass:NSURL.class]) {
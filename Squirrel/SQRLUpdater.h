@@ -55,6 +55,10 @@ extern const NSInteger SQRLUpdaterErrorInvalidServerBody;
 // Includes `SQRLUpdaterJSONObjectErrorKey` in the error's `userInfo`.
 extern const NSInteger SQRLUpdaterErrorInvalidJSON;
 
+// The downloaded update archive doesn't match the SHA-256 digest the server
+// sent for it.
+extern const NSInteger SQRLUpdaterErrorUpdateDigestMismatch;
+
 // Associated with the `NSData` received from the server when an error with code
 // `SQRLUpdaterErrorInvalidServerResponse` is generated.
 extern NSString * const SQRLUpdaterServerDataErrorKey;
@@ -63,6 +67,23 @@ extern NSString * const SQRLUpdaterServerDataErrorKey;
 // error with code `SQRLUpdaterErrorInvalidJSON` is generated.
 extern NSString * const SQRLUpdaterJSONObjectErrorKey;
 
+// Keys in the dictionaries sent by -storageUsage, each associated with a number
+// of bytes as an `NSNumber`.
+//
+// SQRLUpdaterStorageUpdatesKey - Downloaded updates, including the one
+//                                prepared for installation.
+// SQRLUpdaterStorageLogsKey    - ShipIt's rotated logs.
+// SQRLUpdaterStorageOtherKey   - Everything else, like ShipIt's state and the
+//                                logs it's writing to.
+// SQRLUpdaterStorageTotalKey   - All of the above.
+extern NSString * const SQRLUpdaterStorageUpdatesKey;
+extern NSString * const SQRLUpdaterStorageLogsKey;
+extern NSString * const SQRLUpdaterStorageOtherKey;
+extern NSString * const SQRLUpdaterStorageTotalKey;
+
+// The default value of `maximumStorageSize`, in bytes.
+extern const unsigned long long SQRLUpdaterDefaultMaximumStorageSize;
+
 @class RACCommand;
 @class RACDisposable;
 @class RACSignal;
@@ -78,7 +99,19 @@ typedef enum {
 
 // Kicks off a check for updates.
 //
-// If an update is available, it will be sent on `updates` once downloaded.
+// If an update is available, it will be sent on `updates` once downloaded. If
+// the server sends a `version` or `sha256` matching the update that's already
+// been prepared for installation, that update is sent again without being
+// downloaded.
+//
+// If the update has a `rolloutPercentage` from 0 to 100, it is only downloaded
+// by that percentage of installs. Each install is placed in a random bucket
+// for each release version, which it keeps as the percentage is raised.
+//
+// Only one updater for the application checks at a time, even across
+// processes. If another updater is already checking, this one mirrors its
+// `state` and finishes with the same update or error instead of downloading
+// the update again.
 @property (nonatomic, strong, readonly) RACCommand *checkForUpdatesCommand;
 
 // The current state of the manager.
@@ -117,12 +150,27 @@ typedef enum {
 // documentation for more information.
 @property (atomic, strong) Class updateClass;
 
+// The most bytes that Squirrel should keep on disk for downloaded updates and
+// ShipIt's logs, or 0 for no limit.
+//
+// Once each check for updates has started, and old downloads have been deleted
+// in the background, the least recently used downloads and logs are removed
+// until everything fits. The update prepared for installation is never
+// removed.
+//
+// The default value is `SQRLUpdaterDefaultMaximumStorageSize`.
+@property (atomic, assign) unsigned long long maximumStorageSize;
+
 // Publicly exposed for testing purposes, compares two version strings to see if it's
 // allowed.  This assumes that the ElectronSquirrelPreventDowngrades flag is enabled.
 + (bool) isVersionAllowedForUpdate:(NSString*)targetVersion from:(NSString*)currentVersion;
 
 // Initializes an updater that will send the given request to check for updates.
 //
+// The request asks for the update as either CBOR or JSON, so a release server
+// can send the more compact CBOR (with a `Content-Type` of `application/cbor`)
+// to clients that support it.
+//
 // This is the designated initializer for this class.
 //
 // updateRequest - A request to send to check for updates. This request can be
@@ -136,6 +184,11 @@ typedef enum {
 // Initializes an updater that will send the given request to check for updates
 // on a CDN reading a release file in json format.
 //
+// Once the release file shows that `version` is up to date, its `ETag` and
+// `Last-Modified` headers are saved, and later checks ask the server to only
+// send the file if it has changed. A 304 (Not Modified) response means there is
+// no update.
+//
 // updateRequest - A request to send to check for updates. This request can be
 //                 customized as desired, like by including an `Authorization`
 //                 header to authenticate with a private update server, or
@@ -172,11 +225,22 @@ typedef enum {
 // Returns the initialized `SQRLUpdater`.
 - (id)initWithUpdateRequest:(NSURLRequest *)updateRequest requestForDownload:(SQRLRequestForDownload)requestForDownload forVersion:(NSString*) version useMode:(SQRLUpdaterMode) mode;
 
-// Executes `checkForUpdatesCommand` (if enabled) every `interval` seconds.
+// Executes `checkForUpdatesCommand` (if enabled) about every `interval`
+// seconds.
+//
+// Each delay is randomly lengthened or shortened by up to a fifth, so that
+// clients launched together don't check in lockstep, and the timer is given
+// leeway so the system can coalesce it with other work. The next delay starts
+// once a check has finished.
 //
-// The first check will not occur until `interval` seconds have passed.
+// If the server sends a `Retry-After` or `Cache-Control: max-age` header, or a
+// `nextCheckAfter` number of seconds or ISO 8601 date in its JSON, the next
+// check waits at least that long, up to a day.
 //
-// interval - The interval, in seconds, between each check.
+// The first check will not occur until about `interval` seconds have passed.
+//
+// interval - The interval, in seconds, between each check. This must be
+//            greater than zero.
 //
 // Returns a disposable which can be used to cancel the automatic update
 // checking.
@@ -197,6 +261,12 @@ typedef enum {
 // wrong before termination. The signal will never complete.
 - (RACSignal *)relaunchToInstallUpdate;
 
+// Measures how much disk space Squirrel is using for this application.
+//
+// Returns a signal which sends an `NSDictionary` with the
+// `SQRLUpdaterStorage…Key` keys, then completes, or errors, on the main thread.
+- (RACSignal *)storageUsage;
+
 - (BOOL)isRunningOnReadOnlyVolume;
 - (RACSignal *)updateFromJSONData:(NSData *)data;
 
@@ -11,20 +11,36 @@
 #import "NSError+SQRLVerbosityExtensions.h"
 #import "NSProcessInfo+SQRLVersionExtensions.h"
 #import "RACSignal+SQRLTransactionExtensions.h"
+#import "SQRLCBORSerialization.h"
+#import "SQRLCheckLease.h"
+#import "SQRLCheckScheduler.h"
 #import "SQRLCodeSignature.h"
 #import "SQRLDirectoryManager.h"
 #import "SQRLDownloadedUpdate.h"
+#import "SQRLFileTreeWalker.h"
+#import "SQRLReleaseFeedScanner.h"
+#import "SQRLRollout.h"
+#import "SQRLSemanticVersion.h"
 #import "SQRLShipItLauncher.h"
+#import "SQRLStorageQuota.h"
+#import "SQRLTrash.h"
 #import "SQRLUpdate.h"
 #import "SQRLZipArchiver.h"
 #import "SQRLShipItRequest.h"
 #import <ReactiveObjC/EXTScope.h>
 #import <ReactiveObjC/ReactiveObjC.h>
+#import <CommonCrypto/CommonDigest.h>
 #import <sys/mount.h>
 
 NSString * const SQRLUpdaterErrorDomain = @"SQRLUpdaterErrorDomain";
 NSString * const SQRLUpdaterServerDataErrorKey = @"SQRLUpdaterServerDataErrorKey";
 NSString * const SQRLUpdaterJSONObjectErrorKey = @"SQRLUpdaterJSONObjectErrorKey";
+NSString * const SQRLUpdaterStorageUpdatesKey = @"SQRLUpdaterStorageUpdatesKey";
+NSString * const SQRLUpdaterStorageLogsKey = @"SQRLUpdaterStorageLogsKey";
+NSString * const SQRLUpdaterStorageOtherKey = @"SQRLUpdaterStorageOtherKey";
+NSString * const SQRLUpdaterStorageTotalKey = @"SQRLUpdaterStorageTotalKey";
+
+const unsigned long long SQRLUpdaterDefaultMaximumStorageSize = 1024 * 1024 * 1024;
 
 const NSInteger SQRLUpdaterErrorMissingUpdateBundle = 2;
 const NSInteger SQRLUpdaterErrorPreparingUpdateJob = 3;
@@ -32,6 +48,7 @@ const NSInteger SQRLUpdaterErrorRetrievingCodeSigningRequirement = 4;
 const NSInteger SQRLUpdaterErrorInvalidServerResponse = 5;
 const NSInteger SQRLUpdaterErrorInvalidJSON = 6;
 const NSInteger SQRLUpdaterErrorInvalidServerBody = 7;
+const NSInteger SQRLUpdaterErrorUpdateDigestMismatch = 9;
 
 /// The application's being run on a read-only volume.
 const NSInteger SQRLUpdaterErrorReadOnlyVolume = 8;
@@ -42,16 +59,68 @@ const NSTimeInterval SQURLUpdaterZipDownloadTimeoutSeconds = 20 * 60;
 // followed by a random string of characters.
 static NSString * const SQRLUpdaterUniqueTemporaryDirectoryPrefix = @"update.";
 
-BOOL isVersionStandard(NSString* version) {
-	NSCharacterSet *alphaNums = [NSCharacterSet decimalDigitCharacterSet];
+// Returns the lowercase hex-encoded SHA-256 digest of the given data.
+static NSString *SQRLUpdaterSHA256HexDigest(NSData *data) {
+	uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+	CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
 
-	NSArray* versionParts = [version componentsSeparatedByString:@"."];
-	BOOL versionBad = [versionParts count] != 3;
-	for (NSString* part in versionParts) {
-		versionBad = versionBad || part.length == 0 || ![alphaNums isSupersetOfSet:[NSCharacterSet characterSetWithCharactersInString:part]];
+	NSMutableString *hexDigest = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+	for (NSUInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+		[hexDigest appendFormat:@"%02x", digest[i]];
 	}
 
-	return !versionBad;
+	return hexDigest;
+}
+
+// The most time to spend deleting old update directories each time, in
+// seconds. Whatever's left is deleted after a later check.
+static const NSTimeInterval SQRLUpdaterCleanUpTimeBudget = 10;
+
+// Keys in the saved release feed validators, associated with the URL of the
+// feed and the version that was up to date, as `NSString`s.
+static NSString * const SQRLUpdaterReleaseFeedURLKey = @"URL";
+static NSString * const SQRLUpdaterReleaseFeedVersionKey = @"version";
+
+// Keys in the saved release feed validators, associated with the values of the
+// response headers with the same names.
+static NSString * const SQRLUpdaterReleaseFeedETagKey = @"ETag";
+static NSString * const SQRLUpdaterReleaseFeedLastModifiedKey = @"Last-Modified";
+
+// A key in the progress recorded by the leader of an update check, associated
+// with its `SQRLUpdaterState` as an `NSNumber`.
+static NSString * const SQRLUpdaterCheckStateKey = @"state";
+
+// A key in the outcome left by the leader of an update check, associated with
+// one of the results below.
+static NSString * const SQRLUpdaterCheckResultKey = @"result";
+
+// Results of an update check. A downloaded update is associated with
+// `SQRLUpdaterCheckDownloadedUpdateKey`, and a failure with the keys for its
+// error.
+static NSString * const SQRLUpdaterCheckResultNoUpdate = @"noUpdate";
+static NSString * const SQRLUpdaterCheckResultDownloaded = @"downloaded";
+static NSString * const SQRLUpdaterCheckResultFailed = @"failed";
+
+// Keys in the outcome left by the leader of an update check, associated with
+// the archived `SQRLDownloadedUpdate`, and with the domain, code, description
+// and recovery suggestion of the error the check failed with.
+static NSString * const SQRLUpdaterCheckDownloadedUpdateKey = @"downloadedUpdate";
+static NSString * const SQRLUpdaterCheckErrorDomainKey = @"errorDomain";
+static NSString * const SQRLUpdaterCheckErrorCodeKey = @"errorCode";
+static NSString * const SQRLUpdaterCheckErrorDescriptionKey = @"errorDescription";
+static NSString * const SQRLUpdaterCheckErrorRecoverySuggestionKey = @"errorRecoverySuggestion";
+
+BOOL isVersionStandard(NSString* version) {
+	if (version == nil) return NO;
+
+	// Only plain Major.Minor.Patch versions, without any prerelease or build
+	// metadata. Leading zeroes are fine, but the lenient forms with a leading
+	// `v` or fewer than three numbers aren't.
+	char buffer[SQRLSemanticVersionMaximumStringLength];
+	SQRLSemanticVersion parsed;
+	if (!SQRLSemanticVersionParseString(version, SQRLSemanticVersionOptionsLeadingZeroes, &parsed, buffer)) return NO;
+
+	return parsed.prereleaseLength == 0 && parsed.buildLength == 0;
 }
 
 @interface SQRLUpdater ()
@@ -62,6 +131,81 @@ BOOL isVersionStandard(NSString* version) {
 /// downloaded.
 @property (atomic, copy) NSString *etag;
 
+// Decides whether this install is part of an update's staged rollout.
+@property (nonatomic, strong, readonly) SQRLRollout *rollout;
+
+// Whether this install is part of the rollout of the given update.
+//
+// An update with a `rolloutPercentage` number is only offered to that
+// percentage of installs, bucketed by its `version`, or its `name` or `url`
+// if it doesn't have one. Updates without a percentage are offered to every
+// install.
+//
+// JSON - The decoded update manifest. This must not be nil.
+- (BOOL)isUpdateIncludedInRollout:(NSDictionary *)JSON;
+
+// How long the server asked clients to wait before checking again, in
+// seconds, or 0 if it didn't say during the last check.
+@property (atomic, assign) NSTimeInterval nextCheckHint;
+
+// Whether old update directories are being deleted in the background.
+//
+// This must only be used while synchronized on `self`.
+@property (nonatomic, assign, getter = isCleaningUp) BOOL cleaningUp;
+
+// The `update.XXXXXXX` directories that updates are being downloaded into and
+// prepared in, which the storage quota mustn't evict.
+//
+// This must only be used while synchronized on `self`.
+@property (nonatomic, strong, readonly) NSMutableSet *downloadDirectoryURLs;
+
+// Reads the `nextCheckAfter` hint from a release feed, and remembers it if it's
+// longer than any hint already read during this check.
+//
+// scanner - The scanner for the feed, which must not have scanned its update
+//           data yet. This must not be nil.
+- (void)recordNextCheckHintFromScanner:(SQRLReleaseFeedScanner *)scanner;
+
+// Checks for updates as the leader of the updaters, in this process or any
+// other, which use the same storage directory, or else follows the check that
+// the current leader is performing.
+//
+// check - The signal which checks for an update, then downloads and prepares
+//         it. This must not be nil.
+//
+// Returns a signal which sends any `SQRLDownloadedUpdate` then completes, or
+// errors.
+- (RACSignal *)coalesceCheck:(RACSignal *)check;
+
+// Performs the given check while holding the lease, recording the receiver's
+// state for followers and leaving the outcome of the check for them. The lease
+// is renewed whenever the state changes, and every third of its duration until
+// the check finishes.
+//
+// check - The signal which checks for an update, then downloads and prepares
+//         it. This must not be nil.
+// lease - The lease, which the receiver must be the leader of. This must not be
+//         nil.
+//
+// Returns a signal which sends any `SQRLDownloadedUpdate` then completes, or
+// errors.
+- (RACSignal *)leadCheck:(RACSignal *)check withLease:(SQRLCheckLease *)lease;
+
+// Mirrors the state of the leader's check, then finishes with its outcome.
+//
+// If the leader didn't leave a usable outcome, the receiver tries to lead a
+// check of its own. If the lease expires, the receiver performs `check` without
+// it.
+//
+// check - The signal which checks for an update, then downloads and prepares
+//         it. This must not be nil.
+// lease - The lease, which another updater was the leader of. This must not be
+//         nil.
+//
+// Returns a signal which sends any `SQRLDownloadedUpdate` then completes, or
+// errors.
+- (RACSignal *)followCheck:(RACSignal *)check withLease:(SQRLCheckLease *)lease;
+
 // The code signature for the running application, used to check updates before
 // sending them to ShipIt.
 @property (nonatomic, strong, readonly) SQRLCodeSignature *signature;
@@ -81,6 +225,70 @@ BOOL isVersionStandard(NSString* version) {
 // errors.
 - (RACSignal *)updateFromJSONData:(NSData *)data;
 
+// Parses an update model from downloaded CBOR data.
+//
+// data - CBOR data representing an update manifest. This must not be nil.
+//
+// Returns a signal which synchronously sends a `SQRLUpdate` then completes, or
+// errors.
+- (RACSignal *)updateFromCBORData:(NSData *)data;
+
+// Creates an update model from a decoded update manifest.
+//
+// JSON - The decoded manifest, which should be a dictionary. This must not be
+//        nil.
+//
+// Returns a signal which synchronously sends a `SQRLUpdate` then completes, or
+// errors.
+- (RACSignal *)updateFromJSONObject:(id)JSON;
+
+// Adds conditional headers to a request for the release feed, using the
+// validators saved when the feed last showed that `version` was up to date.
+//
+// request - The request for the release feed. This must not be nil.
+// version - The running version. This must not be nil.
+//
+// Returns a signal which synchronously sends an `NSURLRequest` then completes.
+// If there are no matching validators, `request` is sent unchanged.
+- (RACSignal *)conditionalReleaseFeedRequest:(NSURLRequest *)request forVersion:(NSString *)version;
+
+// Saves the validators from a response to the release feed which showed that
+// `version` is up to date, so that the next check can skip the feed if it
+// hasn't changed.
+//
+// request  - The request for the release feed, without conditional headers.
+//            This must not be nil.
+// response - The response containing validators, or nil to forget any saved
+//            validators.
+// version  - The running version. This must not be nil.
+//
+// Returns a signal which synchronously completes, even if the validators could
+// not be saved.
+- (RACSignal *)saveReleaseFeedValidatorsForRequest:(NSURLRequest *)request response:(NSURLResponse *)response version:(NSString *)version;
+
+// Finds the update that's already been prepared for installation, if it's the
+// same release as the given update.
+//
+// Releases are only the same if the server sent a `releaseVersion` or
+// `updateSHA256` for the update, and each one it sent matches the prepared
+// update's. The prepared update must also still be the one that ShipIt will
+// install.
+//
+// update - The update sent by the server. This must not be nil.
+//
+// Returns a signal which synchronously sends the prepared `SQRLDownloadedUpdate`,
+// or nil if there's no matching update, then completes.
+- (RACSignal *)stagedUpdateMatchingUpdate:(SQRLUpdate *)update;
+
+// Saves the update which has just been prepared for installation, so that a
+// later check for the same release can skip downloading it.
+//
+// update - The update which was prepared. This must not be nil.
+//
+// Returns a signal which synchronously completes, even if the update could not
+// be saved.
+- (RACSignal *)saveStagedUpdate:(SQRLDownloadedUpdate *)update;
+
 // Downloads an update bundle and prepares it for installation.
 //
 // Upon success, the update will be automatically installed after the
@@ -94,17 +302,24 @@ BOOL isVersionStandard(NSString* version) {
 
 // Downloads the archived bundle associated with the given update.
 //
+// If the update has an `updateSHA256`, the downloaded archive must match it.
+//
 // update            - Describes the update to install. This must not be nil.
 // downloadDirectory - A directory in which to create a temporary directory for this
 //                     download. This must not be nil.
 //
-// Returns a signal which sends an unarchived `NSBundle` then completes, or
-// errors, on a background thread.
+// Returns a signal which sends a `RACTuple` of the unarchived `NSBundle` and the
+// hex-encoded SHA-256 digest of the archive then completes, or errors, on a
+// background thread. If the server said the archive hasn't changed since the
+// last download, nil is sent instead.
 - (RACSignal *)downloadBundleForUpdate:(SQRLUpdate *)update intoDirectory:(NSURL *)downloadDirectory;
 
 // Creates a unique directory in which to save the update bundle, for later use
 // by ShipIt.
 //
+// The directory is added to `downloadDirectoryURLs` as it's created, and must
+// be removed once the update has been prepared in it, or has failed.
+//
 // Returns a signal which sends an `NSURL` then completes, or errors, on an
 // unspecified thread.
 - (RACSignal *)uniqueTemporaryDirectoryForUpdate;
@@ -198,6 +413,9 @@ BOOL isVersionStandard(NSString* version) {
 	}
 	_updateRequest = mutableUpdateRequest;
 	_updateClass = SQRLUpdate.class;
+	_maximumStorageSize = SQRLUpdaterDefaultMaximumStorageSize;
+	_rollout = [[SQRLRollout alloc] initWithUserDefaults:NSUserDefaults.standardUserDefaults];
+	_downloadDirectoryURLs = [NSMutableSet set];
 	NSError *error = nil;
 	_signature = [SQRLCodeSignature currentApplicationSignature:&error];
 	if (_signature == nil) {
@@ -219,18 +437,28 @@ BOOL isVersionStandard(NSString* version) {
 
 		// TODO: Maybe allow this to be an argument to the command?
 		NSMutableURLRequest *request = [self.updateRequest mutableCopy];
-		[request setValue:@"application/json" forHTTPHeaderField:@"Accept"];
+		// Release servers may send the update as CBOR instead, but release
+		// feeds are always scanned as JSON.
+		NSString *accept = (mode == RELEASESERVER ? [NSString stringWithFormat:@"%@, application/json;q=0.9", SQRLCBORContentType] : @"application/json");
+		[request setValue:accept forHTTPHeaderField:@"Accept"];
 
-		return [[[[[[[[self
+		RACSignal *check = [[[[[[[self
 			performHousekeeping]
 
 			//! get file from server
 			then:^{
 				self.state = SQRLUpdaterStateCheckingForUpdate;
+				self.nextCheckHint = 0;
 
-				return [NSURLConnection rac_sendAsynchronousRequest:request];
+				if (mode != JSONFILE) return [RACSignal return:request];
+				return [self conditionalReleaseFeedRequest:request forVersion:version];
+			}]
+			flattenMap:^(NSURLRequest *feedRequest) {
+				return [NSURLConnection rac_sendAsynchronousRequest:feedRequest];
 			}]
 			reduceEach:^(NSURLResponse *response, NSData *bodyData) {
+				self.nextCheckHint = [SQRLCheckScheduler hintFromResponse:response];
+
 				BOOL readOnlyVolume = [self isRunningOnReadOnlyVolume];
 				if (readOnlyVolume) {
 					NSDictionary *errorInfo = @{
@@ -260,10 +488,18 @@ BOOL isVersionStandard(NSString* version) {
 				}
 
 				if (mode == JSONFILE) {
-					NSError *error = nil;
-					NSDictionary *dict = [NSJSONSerialization JSONObjectWithData:bodyData options:0 error:&error];
+					if ([response isKindOfClass:NSHTTPURLResponse.class] && ((NSHTTPURLResponse *)response).statusCode == 304 /* Not Modified */) {
+						NSLog(@"The release feed is unchanged since the running client was last up to date.");
+						return [RACSignal empty];
+					}
 
-					if (dict == nil) {
+					// Only the current release and its update are needed, so
+					// scan for those instead of parsing the whole feed.
+					SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:bodyData];
+
+					NSError *error = nil;
+					NSString *currentRelease = nil;
+					if (![scanner scanCurrentRelease:&currentRelease error:&error]) {
 						NSMutableDictionary *userInfo = [error.userInfo mutableCopy] ?: [NSMutableDictionary dictionary];
 						userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Update check failed", nil);
 						userInfo[NSLocalizedRecoverySuggestionErrorKey] = NSLocalizedString(@"The server sent an invalid response. Try again later.", nil);
@@ -273,30 +509,28 @@ BOOL isVersionStandard(NSString* version) {
 						return [RACSignal error:[NSError errorWithDomain:SQRLUpdaterErrorDomain code:SQRLUpdaterErrorInvalidServerBody userInfo:userInfo]];
 					}
 
-					NSString *currentRelease = dict[@"currentRelease"];
 					if(currentRelease) {
 						//! if CDN points to the currently running version as the latest version, bail out
 						if([currentRelease isEqualToString:version]) {
 							NSLog(@"The running client is already the latest version.");
-							return [RACSignal empty];
+							[self recordNextCheckHintFromScanner:scanner];
+							return [self saveReleaseFeedValidatorsForRequest:request response:response version:version];
 						}
 
-						if ([version compare:currentRelease options:NSNumericSearch] == NSOrderedDescending) {
+						if (SQRLSemanticVersionCompareStrings(version, currentRelease) == NSOrderedDescending) {
 							// currentRelease is lower than version.
 							// Might be a new version for testing that is not deployed yet
 							// no roll back
 							NSLog(@"The running client is newer than the latest deployed release. Not downgrading.");
-							return [RACSignal empty];
+							[self recordNextCheckHintFromScanner:scanner];
+							return [self saveReleaseFeedValidatorsForRequest:request response:response version:version];
 						}
 
-						//! @todo find latest
-						NSArray *releases = dict[@"releases"];
-						for(NSDictionary* release in releases) {
-							if([currentRelease isEqualToString:release[@"version"]]) {
-								bodyData = [NSJSONSerialization dataWithJSONObject:release[@"updateTo"]
-																			options:0 error:&error];
-								break;
-							}
+						// The release's `updateTo` bytes are passed along as they
+						// are, rather than being parsed and serialized again.
+						NSData *updateData = nil;
+						if ([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error] && updateData != nil) {
+							bodyData = updateData;
 						}
 					}
 				}
@@ -309,23 +543,45 @@ BOOL isVersionStandard(NSString* version) {
 
 					return [RACSignal error:[NSError errorWithDomain:SQRLUpdaterErrorDomain code:SQRLUpdaterErrorInvalidServerBody userInfo:userInfo]];
 				}
-				return [RACSignal return:bodyData];
+
+				// The feed has something new, so it mustn't be skipped next
+				// time just because it's unchanged.
+				if (mode == JSONFILE) {
+					return [[self
+						saveReleaseFeedValidatorsForRequest:request response:nil version:version]
+						concat:[RACSignal return:RACTuplePack(bodyData, nil)]];
+				}
+
+				return [RACSignal return:RACTuplePack(bodyData, response.MIMEType)];
 			}]
 			flatten]
-			flattenMap:^(NSData *data) {
+			flattenMap:^(RACTuple *updateResponse) {
+				RACTupleUnpack(NSData *data, NSString *MIMEType) = updateResponse;
+				if ([MIMEType isEqualToString:SQRLCBORContentType]) return [self updateFromCBORData:data];
+
 				return [self updateFromJSONData:data];
 			}]
 			flattenMap:^(SQRLUpdate *update) {
-				return [[RACSignal
-					defer:^{
-						self.state = SQRLUpdaterStateDownloadingUpdate;
+				return [[[self
+					stagedUpdateMatchingUpdate:update]
+					flattenMap:^(SQRLDownloadedUpdate *stagedUpdate) {
+						if (stagedUpdate != nil) {
+							NSLog(@"Update %@ has already been prepared for installation, not downloading it again.", update.releaseVersion ?: update.updateSHA256);
+
+							// ShipIt only has to be waiting for it.
+							return [self.shipItLauncher concat:[RACSignal return:stagedUpdate]];
+						}
 
+						self.state = SQRLUpdaterStateDownloadingUpdate;
 						return [self downloadAndPrepareUpdate:update];
 					}]
 					doCompleted:^{
 						self.state = SQRLUpdaterStateAwaitingRelaunch;
 					}];
-			}]
+			}];
+
+		return [[[self
+			coalesceCheck:check]
 			finally:^{
 				if (self.state == SQRLUpdaterStateAwaitingRelaunch) return;
 				self.state = SQRLUpdaterStateIdle;
@@ -375,26 +631,186 @@ BOOL isVersionStandard(NSString* version) {
 #pragma mark Checking for Updates
 
 - (RACDisposable *)startAutomaticChecksWithInterval:(NSTimeInterval)interval {
+	SQRLCheckScheduler *scheduler = [[SQRLCheckScheduler alloc] initWithInterval:interval];
+
 	@weakify(self);
 
-	return [[[[[RACSignal
-		interval:interval onScheduler:[RACScheduler schedulerWithPriority:RACSchedulerPriorityBackground]]
-		flattenMap:^(id _) {
+	// Each wait starts once the previous check has finished, so that the
+	// server's hint from that check can be followed.
+	return [[[[[[RACSignal
+		defer:^{
 			@strongify(self);
-			return [[self.checkForUpdatesCommand
+			return [scheduler waitWithHint:self.nextCheckHint];
+		}]
+		then:^{
+			@strongify(self);
+			return [[[self.checkForUpdatesCommand
 				execute:RACUnit.defaultUnit]
+				ignoreValues]
 				catch:^(NSError *error) {
 					NSLog(@"Error checking for updates: %@", error);
 					return [RACSignal empty];
 				}];
 		}]
+		repeat]
 		takeUntil:self.rac_willDeallocSignal]
 		publish]
 		connect];
 }
 
+- (RACSignal *)coalesceCheck:(RACSignal *)check {
+	NSParameterAssert(check != nil);
+
+	return [[[[self.updateCheckLeaseURL
+		flattenMap:^(NSURL *leaseURL) {
+			SQRLCheckLease *lease = [[SQRLCheckLease alloc] initWithURL:leaseURL];
+			return [[lease acquire] mapReplace:lease];
+		}]
+		catch:^(NSError *error) {
+			NSLog(@"Could not coordinate with other updaters, checking for updates anyway: %@", error.sqrl_verboseDescription);
+			return [RACSignal return:nil];
+		}]
+		flattenMap:^(SQRLCheckLease *lease) {
+			if (lease == nil) return check;
+			if (lease.leader) return [self leadCheck:check withLease:lease];
+
+			return [self followCheck:check withLease:lease];
+		}]
+		setNameWithFormat:@"%@ -coalesceCheck:", self];
+}
+
+- (RACSignal *)leadCheck:(RACSignal *)check withLease:(SQRLCheckLease *)lease {
+	NSParameterAssert(check != nil);
+	NSParameterAssert(lease != nil);
+
+	return [[RACSignal
+		createSignal:^(id<RACSubscriber> subscriber) {
+			RACCompoundDisposable *disposable = [RACCompoundDisposable compoundDisposable];
+
+			// The state doesn't change while an update downloads, however long
+			// that takes, so the lease is also renewed periodically, well
+			// before it would expire.
+			RACSignal *renewals = [[RACSignal
+				interval:lease.duration / 3 onScheduler:[RACScheduler schedulerWithPriority:RACSchedulerPriorityBackground]]
+				startWith:nil];
+
+			[disposable addDisposable:[[RACSignal
+				combineLatest:@[ RACObserve(self, state), renewals ]
+				reduce:^(NSNumber *state, id _) {
+					return state;
+				}]
+				subscribeNext:^(NSNumber *state) {
+					[lease recordProgress:@{ SQRLUpdaterCheckStateKey: state }];
+				}]];
+
+			// If the check is cancelled, followers will have to check for
+			// themselves.
+			[disposable addDisposable:[RACDisposable disposableWithBlock:^{
+				[lease relinquishWithOutcome:nil];
+			}]];
+
+			__block SQRLDownloadedUpdate *downloadedUpdate = nil;
+
+			RACDisposable *checkDisposable = [[[[check
+				doNext:^(SQRLDownloadedUpdate *update) {
+					downloadedUpdate = update;
+				}]
+				doError:^(NSError *error) {
+					NSMutableDictionary *outcome = [NSMutableDictionary dictionary];
+					outcome[SQRLUpdaterCheckResultKey] = SQRLUpdaterCheckResultFailed;
+					outcome[SQRLUpdaterCheckErrorDomainKey] = error.domain;
+					outcome[SQRLUpdaterCheckErrorCodeKey] = @(error.code);
+					outcome[SQRLUpdaterCheckErrorDescriptionKey] = error.userInfo[NSLocalizedDescriptionKey];
+					outcome[SQRLUpdaterCheckErrorRecoverySuggestionKey] = error.userInfo[NSLocalizedRecoverySuggestionErrorKey];
+
+					[lease relinquishWithOutcome:outcome];
+				}]
+				doCompleted:^{
+					if (downloadedUpdate == nil) {
+						[lease relinquishWithOutcome:@{ SQRLUpdaterCheckResultKey: SQRLUpdaterCheckResultNoUpdate }];
+						return;
+					}
+
+					[lease relinquishWithOutcome:@{
+						SQRLUpdaterCheckResultKey: SQRLUpdaterCheckResultDownloaded,
+						SQRLUpdaterCheckDownloadedUpdateKey: [NSKeyedArchiver archivedDataWithRootObject:downloadedUpdate],
+					}];
+				}]
+				subscribe:subscriber];
+
+			[disposable addDisposable:checkDisposable];
+			return disposable;
+		}]
+		setNameWithFormat:@"%@ -leadCheck:withLease: %@", self, lease];
+}
+
+- (RACSignal *)followCheck:(RACSignal *)check withLease:(SQRLCheckLease *)lease {
+	NSParameterAssert(check != nil);
+	NSParameterAssert(lease != nil);
+
+	return [[[[[lease
+		waitForLeader]
+		doNext:^(NSDictionary *progress) {
+			NSNumber *state = progress[SQRLUpdaterCheckStateKey];
+			if (![state isKindOfClass:NSNumber.class]) return;
+
+			SQRLUpdaterState leaderState = state.integerValue;
+			if (leaderState == SQRLUpdaterStateCheckingForUpdate || leaderState == SQRLUpdaterStateDownloadingUpdate) {
+				self.state = leaderState;
+			}
+		}]
+		then:^{
+			NSDictionary *outcome = lease.outcome;
+			NSString *result = outcome[SQRLUpdaterCheckResultKey];
+
+			if ([result isEqual:SQRLUpdaterCheckResultNoUpdate]) return [RACSignal empty];
+
+			if ([result isEqual:SQRLUpdaterCheckResultDownloaded]) {
+				// The leader has already handed the update to ShipIt, so it
+				// just needs to be sent.
+				NSData *data = outcome[SQRLUpdaterCheckDownloadedUpdateKey];
+				SQRLDownloadedUpdate *downloadedUpdate = nil;
+				if ([data isKindOfClass:NSData.class]) downloadedUpdate = [NSKeyedUnarchiver unarchiveTopLevelObjectWithData:data error:NULL];
+
+				if ([downloadedUpdate isKindOfClass:SQRLDownloadedUpdate.class] && downloadedUpdate.bundle != nil) {
+					self.state = SQRLUpdaterStateAwaitingRelaunch;
+					return [RACSignal return:downloadedUpdate];
+				}
+			}
+
+			if ([result isEqual:SQRLUpdaterCheckResultFailed] && [outcome[SQRLUpdaterCheckErrorDomainKey] isKindOfClass:NSString.class]) {
+				NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+				userInfo[NSLocalizedDescriptionKey] = outcome[SQRLUpdaterCheckErrorDescriptionKey];
+				userInfo[NSLocalizedRecoverySuggestionErrorKey] = outcome[SQRLUpdaterCheckErrorRecoverySuggestionKey];
+
+				NSInteger code = [outcome[SQRLUpdaterCheckErrorCodeKey] integerValue];
+				return [RACSignal error:[NSError errorWithDomain:outcome[SQRLUpdaterCheckErrorDomainKey] code:code userInfo:userInfo]];
+			}
+
+			// The leader stopped without an outcome that can be used, so
+			// another check is needed.
+			return [self coalesceCheck:check];
+		}]
+		catch:^(NSError *error) {
+			if (![error.domain isEqual:SQRLCheckLeaseErrorDomain] || error.code != SQRLCheckLeaseErrorExpired) return [RACSignal error:error];
+
+			NSLog(@"Checking for updates without waiting any longer for another updater: %@", error.sqrl_verboseDescription);
+			return check;
+		}]
+		setNameWithFormat:@"%@ -followCheck:withLease: %@", self, lease];
+}
+
+- (void)recordNextCheckHintFromScanner:(SQRLReleaseFeedScanner *)scanner {
+	NSParameterAssert(scanner != nil);
+
+	id nextCheckAfter = nil;
+	if (![scanner scanNextCheckAfter:&nextCheckAfter error:NULL]) return;
+
+	self.nextCheckHint = MAX(self.nextCheckHint, [SQRLCheckScheduler hintFromNextCheckAfter:nextCheckAfter]);
+}
+
 + (bool) isVersionAllowedForUpdate:(NSString*)targetVersion from:(NSString*)currentVersion {
-	return [currentVersion compare:targetVersion options:NSNumericSearch] != NSOrderedDescending;
+	return SQRLSemanticVersionCompareStrings(currentVersion, targetVersion) != NSOrderedDescending;
 }
 
 - (RACSignal *)updateFromJSONData:(NSData *)data {
@@ -414,12 +830,53 @@ BOOL isVersionStandard(NSString* version) {
 				return [RACSignal error:[NSError errorWithDomain:SQRLUpdaterErrorDomain code:SQRLUpdaterErrorInvalidServerBody userInfo:userInfo]];
 			}
 
+			return [self updateFromJSONObject:JSON];
+		}]
+		setNameWithFormat:@"%@ -updateFromJSONData:", self];
+}
+
+- (RACSignal *)updateFromCBORData:(NSData *)data {
+	NSParameterAssert(data != nil);
+
+	return [[RACSignal
+		defer:^{
+			NSError *error = nil;
+			id JSON = [SQRLCBORSerialization objectWithData:data error:&error];
+			if (JSON == nil) {
+				NSMutableDictionary *userInfo = [error.userInfo mutableCopy] ?: [NSMutableDictionary dictionary];
+				userInfo[NSLocalizedDescriptionKey] = NSLocalizedString(@"Update check failed", nil);
+				userInfo[NSLocalizedRecoverySuggestionErrorKey] = NSLocalizedString(@"The server sent an invalid response. Try again later.", nil);
+				userInfo[SQRLUpdaterServerDataErrorKey] = data;
+				if (error != nil) userInfo[NSUnderlyingErrorKey] = error;
+
+				return [RACSignal error:[NSError errorWithDomain:SQRLUpdaterErrorDomain code:SQRLUpdaterErrorInvalidServerBody userInfo:userInfo]];
+			}
+
+			return [self updateFromJSONObject:JSON];
+		}]
+		setNameWithFormat:@"%@ -updateFromCBORData:", self];
+}
+
+- (RACSignal *)updateFromJSONObject:(id)JSON {
+	NSParameterAssert(JSON != nil);
+
+	return [[RACSignal
+		defer:^{
 			Class updateClass = self.updateClass;
 			NSAssert([updateClass isSubclassOfClass:SQRLUpdate.class], @"%@ is not a subclass of SQRLUpdate", updateClass);
 
 			SQRLUpdate *update = nil;
-			error = nil;
-			if ([JSON isKindOfClass:NSDictionary.class]) update = [MTLJSONAdapter modelOfClass:updateClass fromJSONDictionary:JSON error:&error];
+			NSError *error = nil;
+			if ([JSON isKindOfClass:NSDictionary.class]) {
+				self.nextCheckHint = MAX(self.nextCheckHint, [SQRLCheckScheduler hintFromNextCheckAfter:JSON[@"nextCheckAfter"]]);
+
+				if (![self isUpdateIncludedInRollout:JSON]) {
+					NSLog(@"This install is not yet part of the update's staged rollout.");
+					return [RACSignal empty];
+				}
+
+				update = [MTLJSONAdapter modelOfClass:updateClass fromJSONDictionary:JSON error:&error];
+			}
 
 			if (update == nil) {
 				NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
@@ -433,7 +890,144 @@ BOOL isVersionStandard(NSString* version) {
 
 			return [RACSignal return:update];
 		}]
-		setNameWithFormat:@"%@ -updateFromJSONData:", self];
+		setNameWithFormat:@"%@ -updateFromJSONObject:", self];
+}
+
+- (BOOL)isUpdateIncludedInRollout:(NSDictionary *)JSON {
+	NSParameterAssert(JSON != nil);
+
+	NSNumber *percentage = JSON[@"rolloutPercentage"];
+	if (![percentage isKindOfClass:NSNumber.class]) return YES;
+
+	for (NSString *key in @[ @"version", @"name", @"url" ]) {
+		NSString *version = JSON[key];
+		if ([version isKindOfClass:NSString.class] && version.length > 0) {
+			return [self.rollout includesVersion:version rolloutPercentage:percentage.doubleValue];
+		}
+	}
+
+	return YES;
+}
+
+- (RACSignal *)conditionalReleaseFeedRequest:(NSURLRequest *)request forVersion:(NSString *)version {
+	NSParameterAssert(request != nil);
+	NSParameterAssert(version != nil);
+
+	return [[[self.releaseFeedValidatorsURL
+		map:^(NSURL *validatorsURL) {
+			NSDictionary *validators = [NSDictionary dictionaryWithContentsOfURL:validatorsURL];
+
+			// The validators only show that the feed has nothing newer than
+			// the version that was running when they were saved.
+			if (![validators[SQRLUpdaterReleaseFeedURLKey] isEqual:request.URL.absoluteString]) return request;
+			if (![validators[SQRLUpdaterReleaseFeedVersionKey] isEqual:version]) return request;
+
+			NSMutableURLRequest *conditionalRequest = [request mutableCopy];
+
+			NSString *ETag = validators[SQRLUpdaterReleaseFeedETagKey];
+			if ([ETag isKindOfClass:NSString.class]) [conditionalRequest setValue:ETag forHTTPHeaderField:@"If-None-Match"];
+
+			NSString *lastModified = validators[SQRLUpdaterReleaseFeedLastModifiedKey];
+			if ([lastModified isKindOfClass:NSString.class]) [conditionalRequest setValue:lastModified forHTTPHeaderField:@"If-Modified-Since"];
+
+			return conditionalRequest;
+		}]
+		catchTo:[RACSignal return:request]]
+		setNameWithFormat:@"%@ -conditionalReleaseFeedRequest: %@ forVersion: %@", self, request, version];
+}
+
+- (RACSignal *)saveReleaseFeedValidatorsForRequest:(NSURLRequest *)request response:(NSURLResponse *)response version:(NSString *)version {
+	NSParameterAssert(request != nil);
+	NSParameterAssert(version != nil);
+
+	return [[[self.releaseFeedValidatorsURL
+		flattenMap:^(NSURL *validatorsURL) {
+			NSMutableDictionary *validators = [NSMutableDictionary dictionary];
+			if ([response isKindOfClass:NSHTTPURLResponse.class]) {
+				NSDictionary *headers = ((NSHTTPURLResponse *)response).allHeaderFields;
+				validators[SQRLUpdaterReleaseFeedETagKey] = headers[@"ETag"];
+				validators[SQRLUpdaterReleaseFeedLastModifiedKey] = headers[@"Last-Modified"];
+			}
+
+			NSError *error = nil;
+			if (validators.count == 0) {
+				if (![NSFileManager.defaultManager removeItemAtURL:validatorsURL error:&error] && !([error.domain isEqual:NSCocoaErrorDomain] && error.code == NSFileNoSuchFileError)) {
+					return [RACSignal error:error];
+				}
+
+				return [RACSignal empty];
+			}
+
+			validators[SQRLUpdaterReleaseFeedURLKey] = request.URL.absoluteString;
+			validators[SQRLUpdaterReleaseFeedVersionKey] = version;
+
+			NSData *data = [NSPropertyListSerialization dataWithPropertyList:validators format:NSPropertyListBinaryFormat_v1_0 options:0 error:&error];
+			if (data == nil || ![data writeToURL:validatorsURL options:NSDataWritingAtomic error:&error]) {
+				return [RACSignal error:error];
+			}
+
+			return [RACSignal empty];
+		}]
+		catch:^(NSError *error) {
+			NSLog(@"Error saving release feed validators: %@", error.sqrl_verboseDescription);
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"%@ -saveReleaseFeedValidatorsForRequest: %@ response: %@ version: %@", self, request, response, version];
+}
+
+- (RACSignal *)stagedUpdateMatchingUpdate:(SQRLUpdate *)update {
+	NSParameterAssert(update != nil);
+
+	return [[[[SQRLShipItRequest
+		readUsingURL:self.shipItStateURL]
+		flattenMap:^(SQRLShipItRequest *request) {
+			return [self.stagedUpdateURL map:^ id (NSURL *stagedUpdateURL) {
+				if (update.releaseVersion == nil && update.updateSHA256 == nil) return nil;
+
+				NSData *data = [NSData dataWithContentsOfURL:stagedUpdateURL];
+				if (data == nil) return nil;
+
+				SQRLDownloadedUpdate *stagedUpdate = [NSKeyedUnarchiver unarchiveTopLevelObjectWithData:data error:NULL];
+				if (![stagedUpdate isKindOfClass:SQRLDownloadedUpdate.class]) return nil;
+
+				// The bundle must still exist, and be what ShipIt will install.
+				NSURL *bundleURL = stagedUpdate.bundle.bundleURL;
+				if (bundleURL == nil) return nil;
+				if (![bundleURL.URLByResolvingSymlinksInPath.path isEqual:request.updateBundleURL.URLByResolvingSymlinksInPath.path]) return nil;
+
+				SQRLUpdate *staged = stagedUpdate.update;
+				if (update.releaseVersion != nil && ![update.releaseVersion isEqual:staged.releaseVersion]) return nil;
+				if (update.updateSHA256 != nil && [update.updateSHA256 caseInsensitiveCompare:staged.updateSHA256 ?: @""] != NSOrderedSame) return nil;
+
+				return stagedUpdate;
+			}];
+		}]
+		catch:^(NSError *error) {
+			// Nothing has been prepared, or it can't be read.
+			return [RACSignal return:nil];
+		}]
+		setNameWithFormat:@"%@ -stagedUpdateMatchingUpdate: %@", self, update];
+}
+
+- (RACSignal *)saveStagedUpdate:(SQRLDownloadedUpdate *)update {
+	NSParameterAssert(update != nil);
+
+	return [[[self.stagedUpdateURL
+		flattenMap:^(NSURL *stagedUpdateURL) {
+			NSData *data = [NSKeyedArchiver archivedDataWithRootObject:update];
+
+			NSError *error = nil;
+			if (![data writeToURL:stagedUpdateURL options:NSDataWritingAtomic error:&error]) {
+				return [RACSignal error:error];
+			}
+
+			return [RACSignal empty];
+		}]
+		catch:^(NSError *error) {
+			NSLog(@"Error saving staged update: %@", error.sqrl_verboseDescription);
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"%@ -saveStagedUpdate: %@", self, update];
 }
 
 - (RACSignal *)downloadAndPrepareUpdate:(SQRLUpdate *)update {
@@ -449,20 +1043,37 @@ BOOL isVersionStandard(NSString* version) {
 				}
 			};
 
-			return [[[self
+			return [[[[self
 				downloadBundleForUpdate:update intoDirectory:downloadDirectory]
-				flattenMap:^(NSBundle *updateBundle) {
-					// If the bundle is nil it means our conditional GET told us
-					// we already downloaded the update. So just clean up.
-					if (updateBundle == nil) {
+				flattenMap:^(RACTuple *download) {
+					// If there's no download it means our conditional GET told
+					// us we already downloaded the update. So just clean up.
+					if (download == nil) {
 						cleanUp();
 						return [RACSignal empty];
 					}
 
-					return [self verifyAndPrepareUpdate:update fromBundle:updateBundle];
+					RACTupleUnpack(NSBundle *updateBundle, NSString *digest) = download;
+
+					// Remember what was downloaded, so that the prepared update
+					// can be matched against later checks by its digest.
+					SQRLUpdate *downloadedUpdate = update;
+					if (update.updateSHA256 == nil) {
+						downloadedUpdate = [update copy];
+						[downloadedUpdate setValue:digest forKey:@keypath(downloadedUpdate.updateSHA256)];
+					}
+
+					return [self verifyAndPrepareUpdate:downloadedUpdate fromBundle:updateBundle];
 				}]
 				doError:^(id _) {
 					cleanUp();
+				}]
+				finally:^{
+					// By now, a prepared update is protected by ShipItState.plist
+					// instead.
+					@synchronized (self) {
+						[self.downloadDirectoryURLs removeObject:downloadDirectory];
+					}
 				}];
 		}]
 		setNameWithFormat:@"%@ -downloadAndPrepareUpdate: %@", self, update];
@@ -536,10 +1147,29 @@ BOOL isVersionStandard(NSString* version) {
 							return [RACSignal error:error];
 						}
 
-						self.etag = httpResponse.allHeaderFields[@"ETag"];
 					}
 
-					return [self unarchiveAndPrepareData:bodyData withName:zipDownloadURL.lastPathComponent intoDirectory:downloadDirectory];
+					NSString *digest = SQRLUpdaterSHA256HexDigest(bodyData);
+					if (update.updateSHA256 != nil && [update.updateSHA256 caseInsensitiveCompare:digest] != NSOrderedSame) {
+						NSDictionary *errorInfo = @{
+							NSLocalizedDescriptionKey: NSLocalizedString(@"Update download failed", nil),
+							NSLocalizedRecoverySuggestionErrorKey: NSLocalizedString(@"The downloaded update was damaged or has been tampered with. Try again later.", nil),
+						};
+						NSError *error = [NSError errorWithDomain:SQRLUpdaterErrorDomain code:SQRLUpdaterErrorUpdateDigestMismatch userInfo:errorInfo];
+						return [RACSignal error:error];
+					}
+
+					// Only skip downloading this archive again once it's known
+					// to be the right one.
+					if ([response isKindOfClass:NSHTTPURLResponse.class]) {
+						self.etag = ((NSHTTPURLResponse *)response).allHeaderFields[@"ETag"];
+					}
+
+					return [[self
+						unarchiveAndPrepareData:bodyData withName:zipDownloadURL.lastPathComponent intoDirectory:downloadDirectory]
+						map:^(NSBundle *updateBundle) {
+							return RACTuplePack(updateBundle, digest);
+						}];
 				}]
 				flatten];
 		}]
@@ -569,19 +1199,26 @@ BOOL isVersionStandard(NSString* version) {
 				free(updateDirectoryCString);
 			};
 			
-			if (mkdtemp(updateDirectoryCString) == NULL) {
-				int code = errno;
+			// Create and record the directory at once, so the storage quota
+			// can't find it before it's protected.
+			@synchronized (self) {
+				if (mkdtemp(updateDirectoryCString) == NULL) {
+					int code = errno;
+
+					NSDictionary *userInfo = @{
+						NSLocalizedDescriptionKey: NSLocalizedString(@"Could not create temporary directory", nil),
+						NSURLErrorKey: updateDirectoryTemplate
+					};
 
-				NSDictionary *userInfo = @{
-					NSLocalizedDescriptionKey: NSLocalizedString(@"Could not create temporary directory", nil),
-					NSURLErrorKey: updateDirectoryTemplate
-				};
+					return [RACSignal error:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo]];
+				}
 
-				return [RACSignal error:[NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:userInfo]];
-			}
+				NSString *updateDirectoryPath = [NSFileManager.defaultManager stringWithFileSystemRepresentation:updateDirectoryCString length:strlen(updateDirectoryCString)];
+				NSURL *updateDirectoryURL = [NSURL fileURLWithPath:updateDirectoryPath isDirectory:YES];
+				[self.downloadDirectoryURLs addObject:updateDirectoryURL];
 
-			NSString *updateDirectoryPath = [NSFileManager.defaultManager stringWithFileSystemRepresentation:updateDirectoryCString length:strlen(updateDirectoryCString)];
-			return [RACSignal return:[NSURL fileURLWithPath:updateDirectoryPath isDirectory:YES]];
+				return [RACSignal return:updateDirectoryURL];
+			}
 		}]
 		setNameWithFormat:@"%@ -uniqueTemporaryDirectoryForUpdate", self];
 }
@@ -641,6 +1278,33 @@ BOOL isVersionStandard(NSString* version) {
 		setNameWithFormat:@"%@ -shipItStateURL", self];
 }
 
+- (RACSignal *)releaseFeedValidatorsURL {
+	return [[RACSignal
+		defer:^{
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+			return directoryManager.releaseFeedValidatorsURL;
+		}]
+		setNameWithFormat:@"%@ -releaseFeedValidatorsURL", self];
+}
+
+- (RACSignal *)updateCheckLeaseURL {
+	return [[RACSignal
+		defer:^{
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+			return directoryManager.updateCheckLeaseURL;
+		}]
+		setNameWithFormat:@"%@ -updateCheckLeaseURL", self];
+}
+
+- (RACSignal *)stagedUpdateURL {
+	return [[RACSignal
+		defer:^{
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+			return directoryManager.stagedUpdateURL;
+		}]
+		setNameWithFormat:@"%@ -stagedUpdateURL", self];
+}
+
 /// Is the host app running on a read-only volume?
 - (BOOL)isRunningOnReadOnlyVolume {
 	struct statfs statfsInfo;
@@ -655,16 +1319,66 @@ BOOL isVersionStandard(NSString* version) {
 }
 
 - (RACSignal *)performHousekeeping {
-	return [[self
+	return [[[self
 		pruneUpdateDirectories]
 		catch:^(NSError *error) {
 			NSLog(@"Error doing housekeeping: %@", error);
 			return [RACSignal empty];
+		}]
+		doCompleted:^{
+			[self cleanUpInBackground];
+		}];
+}
+
+/// Starts deleting trashed update directories, then enforcing the storage
+/// quota, at a low priority, unless that's already in progress.
+///
+/// Neither has to finish before checking for updates, so this doesn't wait
+/// for them.
+- (void)cleanUpInBackground {
+	@synchronized (self) {
+		if (self.cleaningUp) return;
+		self.cleaningUp = YES;
+	}
+
+	[[[[[self
+		trash]
+		flattenMap:^(SQRLTrash *trash) {
+			return [trash emptyWithTimeBudget:SQRLUpdaterCleanUpTimeBudget];
+		}]
+		flattenMap:^(NSNumber *emptied) {
+			// Until the trash is empty, the quota would only count (and
+			// delete) what's already going to be deleted.
+			if (!emptied.boolValue) return [RACSignal empty];
+
+			return [self enforceStorageQuota];
+		}]
+		finally:^{
+			@synchronized (self) {
+				self.cleaningUp = NO;
+			}
+		}]
+		subscribeError:^(NSError *error) {
+			NSLog(@"Error cleaning up: %@", error);
 		}];
 }
 
-/// Lazily removes outdated temporary directories (used for previous updates)
-/// upon subscription.
+/// Returns a signal which sends the trash in Squirrel's storage directory, then
+/// completes.
+- (RACSignal *)trash {
+	return [[[RACSignal
+		defer:^{
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+			return [directoryManager storageURL];
+		}]
+		map:^(NSURL *storageURL) {
+			return [[SQRLTrash alloc] initWithStorageURL:storageURL];
+		}]
+		setNameWithFormat:@"%@ -trash", self];
+}
+
+/// Lazily moves outdated temporary directories (used for previous updates)
+/// into the trash upon subscription.
 ///
 /// Pruning directories while an update is pending or in progress will result in
 /// undefined behavior.
@@ -686,15 +1400,15 @@ BOOL isVersionStandard(NSString* version) {
 		setNameWithFormat:@"%@ -prunedUpdateDirectories", self];
 }
 
-/// Lazily removes orphaned temporary directories upon subscription, always
-/// preserving the directory currently referenced by ShipItState.plist so that
-/// quitAndInstall remains safe to call mid-check.
+/// Lazily moves orphaned temporary directories into the trash upon
+/// subscription, always preserving the directory currently referenced by
+/// ShipItState.plist so that quitAndInstall remains safe to call mid-check.
 ///
 /// Safe to call in any state. Sends each removed directory then completes on
 /// an unspecified thread. Errors reading the staged request are swallowed
 /// (treated as "nothing staged").
 - (RACSignal *)pruneOrphanedUpdateDirectories {
-	return [[[[[SQRLShipItRequest
+	return [[[[[[SQRLShipItRequest
 		readUsingURL:self.shipItStateURL]
 		map:^(SQRLShipItRequest *request) {
 			// The request holds the URL to the staged .app bundle; its parent
@@ -712,10 +1426,86 @@ BOOL isVersionStandard(NSString* version) {
 					return [self removeUpdateDirectoriesInStorageURL:storageURL excludingURL:stagedDirectoryURL];
 				}];
 		}]
+		doCompleted:^{
+			[self cleanUpInBackground];
+		}]
 		setNameWithFormat:@"%@ -pruneOrphanedUpdateDirectories", self];
 }
 
-/// Shared enumerate-and-delete logic for update temp directories.
+- (RACSignal *)storageQuota {
+	return [[[RACSignal
+		defer:^{
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+			return [directoryManager storageURL];
+		}]
+		map:^(NSURL *storageURL) {
+			return [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:self.maximumStorageSize];
+		}]
+		setNameWithFormat:@"%@ -storageQuota", self];
+}
+
+/// Lazily evicts the least recently used update directories and rotated logs
+/// until the storage directory fits within `maximumStorageSize`, always
+/// preserving the update referenced by ShipItState.plist and any update still
+/// being downloaded or prepared.
+///
+/// Sends each evicted URL then completes, or errors, on a background thread.
+- (RACSignal *)enforceStorageQuota {
+	RACSignal *protectedURLs = [RACSignal defer:^{
+		// Downloads are only forgotten once their update has been staged, so
+		// look at them before ShipItState.plist, lest one slip between the two.
+		NSArray *downloadDirectoryURLs;
+		@synchronized (self) {
+			downloadDirectoryURLs = self.downloadDirectoryURLs.allObjects;
+		}
+
+		return [[[SQRLShipItRequest
+			readUsingURL:self.shipItStateURL]
+			map:^(SQRLShipItRequest *request) {
+				return [downloadDirectoryURLs arrayByAddingObject:request.updateBundleURL];
+			}]
+			catch:^(NSError *error) {
+				// No staged request (or unreadable) — only the downloads to
+				// protect.
+				return [RACSignal return:downloadDirectoryURLs];
+			}];
+	}];
+
+	return [[[self
+		storageQuota]
+		flattenMap:^(SQRLStorageQuota *quota) {
+			return [quota evictProtectingURLs:protectedURLs];
+		}]
+		setNameWithFormat:@"%@ -enforceStorageQuota", self];
+}
+
+- (RACSignal *)storageUsage {
+	return [[[[[self
+		storageQuota]
+		flattenMap:^(SQRLStorageQuota *quota) {
+			return [quota usage];
+		}]
+		map:^(NSDictionary *usage) {
+			unsigned long long updates = [usage[@(SQRLStorageArtifactClassUpdate)] unsignedLongLongValue];
+			unsigned long long logs = [usage[@(SQRLStorageArtifactClassLog)] unsignedLongLongValue];
+			unsigned long long other = [usage[@(SQRLStorageArtifactClassOther)] unsignedLongLongValue];
+
+			return @{
+				SQRLUpdaterStorageUpdatesKey: @(updates),
+				SQRLUpdaterStorageLogsKey: @(logs),
+				SQRLUpdaterStorageOtherKey: @(other),
+				SQRLUpdaterStorageTotalKey: @(updates + logs + other),
+			};
+		}]
+		deliverOn:RACScheduler.mainThreadScheduler]
+		setNameWithFormat:@"%@ -storageUsage", self];
+}
+
+/// Shared enumerate-and-trash logic for update temp directories.
+///
+/// Directories are renamed into the trash, so this takes about the same time
+/// however large they are, and the trash is emptied in the background later.
+/// Directories that can't be moved are deleted in place instead.
 ///
 /// storageURL  - The Squirrel storage root to enumerate. Must not be nil.
 /// excludedURL - Directory to skip (compared by standardized path). May be nil.
@@ -729,20 +1519,36 @@ BOOL isVersionStandard(NSString* version) {
 	}];
 
 	NSString *excludedPath = excludedURL.URLByStandardizingPath.path;
+	SQRLTrash *trash = [[SQRLTrash alloc] initWithStorageURL:storageURL];
 
-	return [[enumerator.rac_sequence.signal
+	// Each removal already fans out across the volume's workers, so remove the
+	// directories one at a time rather than multiplying the concurrency.
+	return [[[enumerator.rac_sequence.signal
 		filter:^(NSURL *enumeratedURL) {
 			NSString *name = enumeratedURL.lastPathComponent;
 			if (![name hasPrefix:SQRLUpdaterUniqueTemporaryDirectoryPrefix]) return NO;
 			if (excludedPath != nil && [enumeratedURL.URLByStandardizingPath.path isEqualToString:excludedPath]) return NO;
 			return YES;
 		}]
-		doNext:^(NSURL *directoryURL) {
-			NSError *error = nil;
-			if (![manager removeItemAtURL:directoryURL error:&error]) {
-				NSLog(@"Error removing old update directory at %@: %@", directoryURL, error.sqrl_verboseDescription);
-			}
-		}];
+		map:^(NSURL *directoryURL) {
+			RACSignal *removal = [[[[SQRLFileTreeWalker alloc]
+				initWithRootURL:directoryURL]
+				removeItems]
+				concat:[RACSignal return:directoryURL]];
+
+			return [[[[trash
+				trashItemAtURL:directoryURL]
+				mapReplace:directoryURL]
+				catch:^(NSError *error) {
+					NSLog(@"Error moving old update directory at %@ to the trash, deleting it instead: %@", directoryURL, error.sqrl_verboseDescription);
+					return removal;
+				}]
+				catch:^(NSError *error) {
+					NSLog(@"Error removing old update directory at %@: %@", directoryURL, error.sqrl_verboseDescription);
+					return [RACSignal empty];
+				}];
+		}]
+		concat];
 }
 
 #pragma mark Installing Updates
@@ -802,9 +1608,14 @@ BOOL isVersionStandard(NSString* version) {
 			return [RACSignal return:downloadedUpdate];
 		}]
 		flattenMap:^(SQRLDownloadedUpdate *downloadedUpdate) {
-			return [[self prepareUpdateForInstallation:downloadedUpdate] then:^{
-				return [RACSignal return:downloadedUpdate];
-			}];
+			return [[[self
+				prepareUpdateForInstallation:downloadedUpdate]
+				then:^{
+					return [self saveStagedUpdate:downloadedUpdate];
+				}]
+				then:^{
+					return [RACSignal return:downloadedUpdate];
+				}];
 		}]
 		setNameWithFormat:@"%@ -verifyAndPrepareUpdate: %@ fromBundle: %@", self, update, updateBundle];
 }
@@ -14,14 +14,19 @@
 #import <ReactiveObjC/RACScheduler.h>
 
 #include <spawn.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <mach/mach.h>
 #include <servers/bootstrap.h>
 
 #import "NSError+SQRLVerbosityExtensions.h"
 #import "RACSignal+SQRLTransactionExtensions.h"
+#import "SQRLInstallationBackoff.h"
 #import "SQRLInstaller.h"
 #import "SQRLInstaller+Private.h"
+#import "SQRLInstallMetrics.h"
+#import "SQRLProcessStatistics.h"
 #import "SQRLTerminationListener.h"
 #import "SQRLShipItRequest.h"
 
@@ -43,11 +48,29 @@ __attribute__((availability(macos,introduced=10.14),weak_import));
 // an attempt to update.
 //
 // If ShipIt is launched in the same state more than this number of times,
-// updating will abort.
-static const NSUInteger SQRLShipItMaximumInstallationAttempts = 3;
+// updating will abort. Failed attempts are spaced out by
+// `SQRLInstallationBackoff`, so these cover a couple of minutes.
+static const NSUInteger SQRLShipItMaximumInstallationAttempts = 5;
+
+// The longest ShipIt should spend removing temporary directories leaked by
+// earlier installations, before getting on with the update.
+static const NSTimeInterval SQRLShipItCollectionTimeout = 10;
+
+// How long processes running from inside the target bundle, like helpers, get
+// to exit by themselves once the application has terminated.
+static const NSTimeInterval SQRLShipItHelperTerminationTimeout = 10;
+
+// How long ShipIt waits after sending SIGTERM, then SIGKILL, to processes that
+// are still running from inside the target bundle, if the application opted
+// into terminating them.
+static const NSTimeInterval SQRLShipItHelperEscalationDelay = 5;
 
 static NSString * launchSignal = @"___launch___";
 
+// The name of the executable, beside ShipIt's own, that relaunches updated
+// applications without loading ShipIt's frameworks.
+static NSString * const SQRLShipItRelaunchExecutableName = @"ShipItRelaunch";
+
 // The domain for errors generated here.
 static NSString * const SQRLShipItErrorDomain = @"SQRLShipItErrorDomain";
 
@@ -87,50 +110,211 @@ static void drainMachServicePort(const char *serviceName) {
 	}
 }
 
+// The device and inode of ShipIt's executable when it was launched.
+static struct stat launchedExecutableInfo;
+
+// Records which file ShipIt was launched from, for
+// isLaunchedExecutableOnDisk().
+static void recordLaunchedExecutable(void) {
+	if (stat(NSProcessInfo.processInfo.arguments[0].fileSystemRepresentation, &launchedExecutableInfo) != 0) {
+		memset(&launchedExecutableInfo, 0, sizeof(launchedExecutableInfo));
+	}
+}
+
+// Whether the file ShipIt was launched from is still at the same path.
+//
+// Installing usually moves it aside along with the rest of the old bundle, but
+// when it's unchanged by a differential install, it stays in place.
+static BOOL isLaunchedExecutableOnDisk(void) {
+	if (launchedExecutableInfo.st_ino == 0) return NO;
+
+	struct stat info;
+	if (stat(NSProcessInfo.processInfo.arguments[0].fileSystemRepresentation, &info) != 0) return NO;
+
+	return info.st_dev == launchedExecutableInfo.st_dev && info.st_ino == launchedExecutableInfo.st_ino;
+}
+
+// Launches the application at `bundleURL` from this process.
+//
+// Returns whether the application was launched.
+static BOOL launchApplication(NSURL *bundleURL) {
+	NSError *error;
+// TODO: https://github.com/electron/electron/issues/43168
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+	if (![NSWorkspace.sharedWorkspace launchApplicationAtURL:bundleURL options:NSWorkspaceLaunchDefault configuration:@{} error:&error]) {
+		NSLog(@"Could not launch application at %@: %@", bundleURL, error);
+		return NO;
+	}
+#pragma clang diagnostic pop
+
+	NSLog(@"Application launched at %@", bundleURL);
+	return YES;
+}
+
 // Waits for all instances of the target application (as described in the
-// `request`) to exit, then sends completed.
-static RACSignal *waitForTerminationIfNecessary(SQRLShipItRequest *request) {
+// `request`) to exit, then for any other processes running from inside its
+// bundle, then sends completed.
+//
+// The application itself may be left running for as long as the user likes.
+// Lingering helpers are only waited for until a deadline, then logged, unless
+// the installer terminates bundle processes, in which case they're signaled.
+static RACSignal *waitForTerminationIfNecessary(SQRLInstaller *installer, SQRLShipItRequest *request) {
 	return [[RACSignal
 		defer:^{
 			if (request.bundleIdentifier == nil) return [RACSignal empty];
 
+			NSTimeInterval escalationDelay = (installer.terminatesBundleProcesses ? SQRLShipItHelperEscalationDelay : 0);
+
 			SQRLTerminationListener *listener = [[SQRLTerminationListener alloc] initWithURL:request.targetBundleURL bundleIdentifier:request.bundleIdentifier];
-			return [listener waitForTermination];
+			RACSignal *helpers = [[[listener
+				waitForTerminationOfBundleProcessesWithTimeout:SQRLShipItHelperTerminationTimeout escalationDelay:escalationDelay]
+				doNext:^(NSDictionary *exit) {
+					int signal = [exit[SQRLTerminationListenerSignalKey] intValue];
+					NSLog(@"Process %@ (%@) exited after %.3fs%@", exit[SQRLTerminationListenerProcessIdentifierKey], exit[SQRLTerminationListenerExecutablePathKey], [exit[SQRLTerminationListenerDurationKey] doubleValue], (signal == 0 ? @"" : [NSString stringWithFormat:@", after %s", strsignal(signal)]));
+				}]
+				catch:^(NSError *error) {
+					// Installation checks for running instances itself, so
+					// let it decide whether this is fatal.
+					NSLog(@"Processes are still running from the target bundle: %@", error.sqrl_verboseDescription);
+					return [RACSignal empty];
+				}];
+
+			return [[listener waitForTermination] concat:helpers];
 		}]
 		setNameWithFormat:@"waitForTerminationIfNecessary"];
 }
 
-static void installRequest(RACSignal *readRequestSignal, NSString *applicationIdentifier) {
-	[[[[[readRequestSignal
+// Prepares the update described by `request` while the target application may
+// still be running, so that only the final swap is left once it terminates.
+//
+// Failing to prepare early isn't fatal, since installation will prepare the
+// update itself.
+static RACSignal *prepareUpdate(SQRLInstaller *installer, SQRLShipItRequest *request) {
+	return [[[[installer.prepareUpdateCommand
+		execute:request]
+		initially:^{
+			NSLog(@"Preparing update ahead of installation");
+		}]
+		catch:^(NSError *error) {
+			NSLog(@"Couldn't prepare update ahead of installation: %@", error.sqrl_verboseDescription);
+			return [RACSignal empty];
+		}]
+		setNameWithFormat:@"prepareUpdate"];
+}
+
+// Removes the temporary directories that earlier installations leaked.
+//
+// The leaked directories are found as soon as this is subscribed to, so as long
+// as that happens before the update starts being prepared, the directories
+// that preparation creates are never removed.
+static RACSignal *removeLeakedTemporaryDirectories(SQRLInstaller *installer) {
+	return [[[installer
+		removeLeakedTemporaryDirectoriesWithTimeout:SQRLShipItCollectionTimeout]
+		doNext:^(NSNumber *byteCount) {
+			NSLog(@"Reclaimed %@ from leaked temporary directories", [NSByteCountFormatter stringFromByteCount:byteCount.longLongValue countStyle:NSByteCountFormatterCountStyleFile]);
+		}]
+		setNameWithFormat:@"removeLeakedTemporaryDirectories"];
+}
+
+// Waits until the delay after a failed installation attempt has passed, so that
+// transient problems have a chance to clear up.
+static RACSignal *waitForNextAttempt(SQRLInstallationBackoff *backoff) {
+	return [[[backoff
+		waitForNextAttempt]
+		initially:^{
+			NSTimeInterval delay = backoff.nextAttemptDate.timeIntervalSinceNow;
+			if (delay > 0) NSLog(@"Waiting %.1fs before the next installation attempt", delay);
+		}]
+		setNameWithFormat:@"waitForNextAttempt"];
+}
+
+// Deletes the bundles left over from installation.
+//
+// This runs after the updated application has been relaunched, with throttled
+// disk I/O so that it doesn't slow the application down as it starts.
+static RACSignal *removeLeftoverBundles(SQRLInstaller *installer) {
+	return [[[installer
+		removeLeftoverBundles]
+		initially:^{
+			// This is the last thing ShipIt does, so it's fine for this to
+			// apply to the whole process.
+			if (setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_PROCESS, IOPOL_THROTTLE) != 0) {
+				NSLog(@"Couldn't lower I/O priority for removing leftover bundles: %s", strerror(errno));
+			}
+		}]
+		setNameWithFormat:@"removeLeftoverBundles"];
+}
+
+// Writes a record of the phases measured by `metrics` into `storageURL`, for
+// diagnosing slow updates.
+static void writeInstallMetrics(SQRLInstallMetrics *metrics, NSURL *storageURL, NSError *installError) {
+	NSError *error;
+	if (![metrics writeRecordToDirectoryURL:storageURL installError:installError error:&error]) {
+		NSLog(@"Couldn't write install metrics to %@: %@", storageURL, error.sqrl_verboseDescription);
+	}
+}
+
+static void installRequest(RACSignal *readRequestSignal, NSString *applicationIdentifier, NSURL *storageURL) {
+	SQRLInstallMetrics *metrics = [[SQRLInstallMetrics alloc] init];
+
+	// Shared between preparation and installation, so the latter can reuse the
+	// former's work.
+	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+	installer.metrics = metrics;
+
+	SQRLInstallationBackoff *backoff = [[SQRLInstallationBackoff alloc] initWithApplicationIdentifier:applicationIdentifier];
+
+	[[[[[[readRequestSignal
 		flattenMap:^(SQRLShipItRequest *request) {
-			return waitForTerminationIfNecessary(request);
+			// Collection is subscribed to first, so that it runs alongside
+			// preparation without seeing its directories.
+			return [RACSignal merge:@[
+				[[metrics measurePhase:@"collect" ofSignal:removeLeakedTemporaryDirectories(installer)] ignoreValues],
+				[metrics measurePhase:@"prepare" ofSignal:prepareUpdate(installer, request)],
+				[metrics measurePhase:@"waitForTermination" ofSignal:waitForTerminationIfNecessary(installer, request)],
+			]];
 		}]
 		ignoreValues]
+		concat:[metrics measurePhase:@"backoff" ofSignal:waitForNextAttempt(backoff)]]
 		concat:readRequestSignal]
 		flattenMap:^(SQRLShipItRequest *request) {
-			SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
-
 			NSUInteger attempt = installationAttempts(applicationIdentifier) + 1;
 			setInstallationAttempts(applicationIdentifier, attempt);
+			[metrics recordRequest:request attempt:attempt];
+
+			// Executing the command is deferred, since aborting is only
+			// sometimes needed.
+			//
+			// After a fatal error, `installUpdateCommand` only stops executing
+			// once that's delivered to the main thread, and the abort command
+			// is disabled until then, so wait for it rather than fail.
+			RACSignal *abort = [[[metrics
+				measurePhase:@"abort" ofSignal:[[[installer.abortInstallationCommand.enabled
+					filter:^(NSNumber *enabled) {
+						return enabled.boolValue;
+					}]
+					take:1]
+					flattenMap:^(id _) {
+						return [installer.abortInstallationCommand execute:request];
+					}]]
+				catch:^(NSError *error) {
+					NSLog(@"Error aborting installation: %@", error);
+
+					// Exit successfully so launchd doesn't restart us
+					// again.
+					return [RACSignal empty];
+				}]
+				concat:[RACSignal return:request]];
 
 			RACSignal *action;
 			if (attempt > SQRLShipItMaximumInstallationAttempts) {
-				action = [[[[installer.abortInstallationCommand
-					execute:request]
-					initially:^{
-						NSLog(@"Too many attempts to install, aborting update");
-					}]
-					catch:^(NSError *error) {
-						NSLog(@"Error aborting installation: %@", error);
-
-						// Exit successfully so launchd doesn't restart us
-						// again.
-						return [RACSignal empty];
-					}]
-					concat:[RACSignal return:request]];
+				action = [abort initially:^{
+					NSLog(@"Too many attempts to install, aborting update");
+				}];
 			} else {
-				action = [[[[installer.installUpdateCommand
-					execute:request]
+				action = [[[[metrics
+					measurePhase:@"install" ofSignal:[installer.installUpdateCommand execute:request]]
 					initially:^{
 						BOOL freshInstall = (attempt == 1);
 						if (freshInstall) {
@@ -143,12 +327,34 @@ static void installRequest(RACSignal *readRequestSignal, NSString *applicationId
 						NSLog(@"Installation completed successfully");
 					}]
 					sqrl_addTransactionWithName:NSLocalizedString(@"Updating", nil) description:NSLocalizedString(@"%@ is being updated, and interrupting the process could corrupt the application", nil), request.targetBundleURL.path];
+
+				action = [action catch:^(NSError *error) {
+					// Cancelling isn't a failure, and is handled below.
+					if ([error.domain isEqual:SQRLInstallerErrorDomain] && error.code == SQRLInstallerErrorAppStillRunning) {
+						return [RACSignal error:error];
+					}
+
+					if ([SQRLInstallationBackoff classifyError:error] == SQRLInstallationErrorFatal) {
+						NSLog(@"Installation failed permanently, aborting update: %@", error.sqrl_verboseDescription);
+						return abort;
+					}
+
+					// The next launch aborts after the last attempt, so there's
+					// no need to wait for it.
+					if (attempt < SQRLShipItMaximumInstallationAttempts) {
+						[backoff scheduleRetryAfterAttempt:attempt];
+						NSLog(@"Installation attempt %i failed, retrying after %@", (int)attempt, backoff.nextAttemptDate);
+					}
+
+					return [RACSignal error:error];
+				}];
 			}
 
 			// Clear the installation attempts for a successful abort or
 			// install.
 			action = [action doCompleted:^{
 				clearInstallationAttempts(applicationIdentifier);
+				[backoff reset];
 			}];
 
 			if (request.launchAfterInstallation) {
@@ -156,80 +362,93 @@ static void installRequest(RACSignal *readRequestSignal, NSString *applicationId
 				action = [[action
 					deliverOn:RACScheduler.mainThreadScheduler]
 					doNext:^(SQRLShipItRequest *finalRequest) {
-						NSLog(@"On main thread and launching: %@", finalRequest.targetBundleURL);
-						NSURL *bundleURL = finalRequest.targetBundleURL;
-						if (bundleURL == nil) {
-							NSLog(@"Missing target bundle URL, cannot launch application");
-							return;
-						}
-
-						NSLog(@"Bundle URL is valid");
-
-						NSError *error;
-						// Temporary workaround, on Big Sur and higher the executable
-						// using NSWorkspace needs to actually exist on disk, at this point
-						// this executable no longer exists on disk so we need to launch the
-						// new one (which should be in the exact same spot) and ask for it
-						// to launch the new app bundle URL
-						if (@available(macOS 11.0, *)) {
-							NSLog(@"Attempting to launch app on 11.0 or higher");
-
-							NSString *exe = NSProcessInfo.processInfo.arguments[0];
-							NSLog(@"Launching new ShipIt at %@ with instructions to launch %@", exe, bundleURL);
-
-							posix_spawnattr_t attr;
-							CHECK_ERR(posix_spawnattr_init(&attr));
-
-							// Disclaim TCC responsibilities
-							if (responsibility_spawnattrs_setdisclaim)
-									CHECK_ERR(responsibility_spawnattrs_setdisclaim(&attr, 1));
-
-							pid_t pid = 0;
-
-							const char* launchPath = [exe fileSystemRepresentation];
-							const char* signal = [launchSignal fileSystemRepresentation];
-							const char* path = [bundleURL.path fileSystemRepresentation];
-							const char* args[] = { launchPath, signal, path, 0 };
-							int status = posix_spawn(&pid, [exe UTF8String], NULL, &attr, (char *const*)args, environ);
-							if (status == 0) {
-								NSLog(@"New ShipIt pid: %i", pid);
-								do {
-									if (waitpid(pid, &status, 0) != -1) {
-										NSLog(@"ShipIt status %d", WEXITSTATUS(status));
-									} else {
-										perror("waitpid");
-										exit(1);
-									}
-								} while (!WIFEXITED(status) && !WIFSIGNALED(status));
-							} else {
-								NSLog(@"posix_spawn: %s", strerror(status));
-							}
-
-							posix_spawnattr_destroy(&attr);
-
-							NSLog(@"New ShipIt exited");
-						} else {
-							NSLog(@"Attempting to launch app on lower than 11.0");
-// TODO: https://github.com/electron/electron/issues/43168
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-							if (![NSWorkspace.sharedWorkspace launchApplicationAtURL:bundleURL options:NSWorkspaceLaunchDefault configuration:@{} error:&error]) {
-								NSLog(@"Could not launch application at %@: %@", bundleURL, error);
+						[metrics measurePhase:@"relaunch" usingBlock:^{
+							NSLog(@"On main thread and launching: %@", finalRequest.targetBundleURL);
+							NSURL *bundleURL = finalRequest.targetBundleURL;
+							if (bundleURL == nil) {
+								NSLog(@"Missing target bundle URL, cannot launch application");
 								return;
 							}
-#pragma clang diagnostic pop
 
-							NSLog(@"Application launched at %@", bundleURL);
-						}
+							NSLog(@"Bundle URL is valid");
+
+							// Temporary workaround, on Big Sur and higher the executable
+							// using NSWorkspace needs to actually exist on disk, at this point
+							// this executable usually no longer exists on disk so we need to launch the
+							// new one (which should be in the exact same spot) and ask for it
+							// to launch the new app bundle URL
+							if (@available(macOS 11.0, *)) {
+								// Skip the extra process when this executable
+								// was left in place.
+								if (isLaunchedExecutableOnDisk()) {
+									NSLog(@"ShipIt executable is still on disk, launching app directly");
+									if (launchApplication(bundleURL)) return;
+								}
+
+								NSLog(@"Attempting to launch app on 11.0 or higher");
+
+								NSString *exe = NSProcessInfo.processInfo.arguments[0];
+
+								// Prefer the lean relauncher from the updated
+								// bundle, but fall back to ShipIt itself if
+								// the update doesn't have one.
+								NSString *relaunchExe = [exe.stringByDeletingLastPathComponent stringByAppendingPathComponent:SQRLShipItRelaunchExecutableName];
+								BOOL useRelaunchExe = [NSFileManager.defaultManager isExecutableFileAtPath:relaunchExe];
+								if (useRelaunchExe) exe = relaunchExe;
+
+								NSLog(@"Launching new %@ at %@ with instructions to launch %@", exe.lastPathComponent, exe, bundleURL);
+
+								posix_spawnattr_t attr;
+								CHECK_ERR(posix_spawnattr_init(&attr));
+
+								// Disclaim TCC responsibilities
+								if (responsibility_spawnattrs_setdisclaim)
+										CHECK_ERR(responsibility_spawnattrs_setdisclaim(&attr, 1));
+
+								pid_t pid = 0;
+
+								const char* launchPath = [exe fileSystemRepresentation];
+								const char* signal = [launchSignal fileSystemRepresentation];
+								const char* path = [bundleURL.path fileSystemRepresentation];
+								const char* shipItArgs[] = { launchPath, signal, path, 0 };
+								const char* relaunchArgs[] = { launchPath, path, 0 };
+								const char** args = useRelaunchExe ? relaunchArgs : shipItArgs;
+								int status = posix_spawn(&pid, [exe UTF8String], NULL, &attr, (char *const*)args, environ);
+								if (status == 0) {
+									NSLog(@"New %@ pid: %i", exe.lastPathComponent, pid);
+									do {
+										if (waitpid(pid, &status, 0) != -1) {
+											NSLog(@"%@ status %d", exe.lastPathComponent, WEXITSTATUS(status));
+										} else {
+											perror("waitpid");
+											exit(1);
+										}
+									} while (!WIFEXITED(status) && !WIFSIGNALED(status));
+								} else {
+									NSLog(@"posix_spawn: %s", strerror(status));
+								}
+
+								posix_spawnattr_destroy(&attr);
+
+								NSLog(@"New %@ exited", exe.lastPathComponent);
+							} else {
+								NSLog(@"Attempting to launch app on lower than 11.0");
+								launchApplication(bundleURL);
+							}
+						}];
 					}];
 			}
 
-			return action;
+			// Only once the application is running again.
+			return [action concat:[metrics measurePhase:@"cleanup" ofSignal:removeLeftoverBundles(installer)]];
 		}]
 		subscribeError:^(NSError *error) {
+			writeInstallMetrics(metrics, storageURL, error);
+
 			if ([[error domain] isEqual:SQRLInstallerErrorDomain] && [error code] == SQRLInstallerErrorAppStillRunning) {
 				NSLog(@"Installation cancelled: %@", error);
 				clearInstallationAttempts(applicationIdentifier);
+				[backoff reset];
 				drainMachServicePort(applicationIdentifier.UTF8String);
 				exit(EXIT_SUCCESS);
 			} else {
@@ -237,6 +456,7 @@ static void installRequest(RACSignal *readRequestSignal, NSString *applicationId
 				exit(EXIT_FAILURE);
 			}
 		} completed:^{
+			writeInstallMetrics(metrics, storageURL, nil);
 			drainMachServicePort(applicationIdentifier.UTF8String);
 			exit(EXIT_SUCCESS);
 		}];
@@ -265,20 +485,16 @@ int main(int argc, const char * argv[]) {
 
 		if (strcmp(jobLabel, [launchSignal UTF8String]) == 0) {
 			NSLog(@"Detected this as a launch request");
-// TODO: https://github.com/electron/electron/issues/43168
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wdeprecated-declarations"
-			NSError *error;
-			if (![NSWorkspace.sharedWorkspace launchApplicationAtURL:shipItStateURL options:NSWorkspaceLaunchDefault configuration:@{} error:&error]) {
-				NSLog(@"Could not launch application at %@: %@", shipItStateURL, error);
-			} else {
-				NSLog(@"Successfully launched application at %@", shipItStateURL);
-			}
-#pragma clang diagnostic pop
+			SQRLProcessLogStartupStatistics(@"ShipIt");
+
+			launchApplication(shipItStateURL);
 			exit(EXIT_SUCCESS);
 		} else {
 			NSLog(@"Detected this as an install request");
-			installRequest([SQRLShipItRequest readUsingURL:[RACSignal return:shipItStateURL]], @(jobLabel));
+			SQRLProcessLogStartupStatistics(@"ShipIt");
+			recordLaunchedExecutable();
+
+			installRequest([SQRLShipItRequest readUsingURL:[RACSignal return:shipItStateURL]], @(jobLabel), shipItStateURL.URLByDeletingLastPathComponent);
 			dispatch_main();
 		}
 	}
@@ -0,0 +1,48 @@
+//
+//  ShipItRelaunch-main.m
+//  ShipItRelaunch
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Cocoa/Cocoa.h>
+
+#import "SQRLProcessStatistics.h"
+
+// Relaunches an updated application on behalf of ShipIt.
+//
+// On macOS 11 and later, the executable that launches the application has to
+// still exist on disk, which ShipIt's own executable might not after an
+// update. ShipIt spawns this from the updated bundle instead. It only links
+// system frameworks, so it doesn't load ReactiveObjC or Mantle just to make
+// one NSWorkspace call. Both executables log their startup statistics, so the
+// two can be compared.
+//
+// Usage: ShipItRelaunch <application path>
+int main(int argc, const char * argv[]) {
+	@autoreleasepool {
+		if (argc < 2) {
+			NSLog(@"Missing application path for ShipItRelaunch (%d)", argc);
+			return EXIT_FAILURE;
+		}
+
+		SQRLProcessLogStartupStatistics(@"ShipItRelaunch");
+
+		NSURL *applicationURL = [NSURL fileURLWithPath:@(argv[1])];
+
+// TODO: https://github.com/electron/electron/issues/43168
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+		NSError *error;
+		if (![NSWorkspace.sharedWorkspace launchApplicationAtURL:applicationURL options:NSWorkspaceLaunchDefault configuration:@{} error:&error]) {
+			NSLog(@"Could not launch application at %@: %@", applicationURL, error);
+			return EXIT_FAILURE;
+		}
+#pragma clang diagnostic pop
+
+		NSLog(@"Successfully launched application at %@", applicationURL);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -337,6 +337,9 @@ static NSNumber *SQRLShipItLastExitStatus(NSString *jobLabel) {
 		BOOL installed = [[installer.installUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&installedError];
 		expect(@(installed)).to(beTruthy());
 		expect(installedError).to(beNil());
+
+		// Like ShipIt does after relaunching.
+		expect(@([[installer removeLeftoverBundles] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
 	}
 }
 
@@ -0,0 +1,183 @@
+//
+//  SQRLBundleDifferenceSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLBundleDifference.h"
+
+#import "QuickSpec+SQRLFixtures.h"
+
+#import <sys/stat.h>
+#import <sys/xattr.h>
+
+// An extended attribute value given to directories.
+static const char SQRLBundleDifferenceSpecAttributeValue[] = "value";
+
+QuickSpecBegin(SQRLBundleDifferenceSpec)
+
+__block NSURL *targetURL;
+__block NSURL *sourceURL;
+__block SQRLBundleDifference *difference;
+
+void (^writeFile)(NSURL *, NSString *, NSString *) = ^(NSURL *rootURL, NSString *path, NSString *contents) {
+	NSURL *fileURL = [rootURL URLByAppendingPathComponent:path];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:fileURL.URLByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+	expect(@([[contents dataUsingEncoding:NSUTF8StringEncoding] writeToURL:fileURL atomically:NO])).to(beTruthy());
+};
+
+NSString * (^readFile)(NSURL *, NSString *) = ^(NSURL *rootURL, NSString *path) {
+	return [NSString stringWithContentsOfURL:[rootURL URLByAppendingPathComponent:path] encoding:NSUTF8StringEncoding error:NULL];
+};
+
+ino_t (^inodeOfFile)(NSURL *, NSString *) = ^(NSURL *rootURL, NSString *path) {
+	struct stat info;
+	expect(@(lstat([rootURL URLByAppendingPathComponent:path].path.fileSystemRepresentation, &info))).to(equal(@0));
+	return info.st_ino;
+};
+
+beforeEach(^{
+	targetURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"Target" isDirectory:YES];
+	sourceURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"Source" isDirectory:YES];
+
+	writeFile(targetURL, @"Unchanged", @"same");
+	writeFile(sourceURL, @"Unchanged", @"same");
+	writeFile(targetURL, @"Changed", @"old");
+	writeFile(sourceURL, @"Changed", @"new");
+	writeFile(targetURL, @"Removed/Nested", @"removed");
+	writeFile(sourceURL, @"Added/Nested", @"added");
+
+	difference = [[SQRLBundleDifference alloc] initWithTargetURL:targetURL sourceURL:sourceURL];
+});
+
+it(@"should find only the items that differ", ^{
+	NSError *error = nil;
+	NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:&error];
+	expect(error).to(beNil());
+
+	NSDictionary *kindsByPath = [NSDictionary dictionaryWithObjects:[changes valueForKey:SQRLBundleDifferenceChangeKindKey] forKeys:[changes valueForKey:SQRLBundleDifferenceChangePathKey]];
+	expect(kindsByPath).to(equal(@{
+		@"Changed": SQRLBundleDifferenceChangeKindReplace,
+		@"Added": SQRLBundleDifferenceChangeKindAdd,
+		@"Removed": SQRLBundleDifferenceChangeKindRemove,
+	}));
+});
+
+it(@"should apply changes without touching unchanged files", ^{
+	ino_t unchangedInode = inodeOfFile(targetURL, @"Unchanged");
+
+	NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect(changes).notTo(beNil());
+
+	NSError *error = nil;
+	expect(@([[difference applyChanges:changes] waitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+
+	expect(readFile(targetURL, @"Changed")).to(equal(@"new"));
+	expect(readFile(targetURL, @"Added/Nested")).to(equal(@"added"));
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[targetURL URLByAppendingPathComponent:@"Removed"].path])).to(beFalsy());
+	expect(@(inodeOfFile(targetURL, @"Unchanged"))).to(equal(@(unchangedInode)));
+
+	// The replaced items are moved into the source.
+	expect(readFile(sourceURL, @"Changed")).to(equal(@"old"));
+	expect(readFile(sourceURL, @"Removed/Nested")).to(equal(@"removed"));
+});
+
+it(@"should revert applied changes", ^{
+	NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect(@([[difference applyChanges:changes] waitUntilCompleted:NULL])).to(beTruthy());
+
+	NSError *error = nil;
+	expect(@([[difference revertChanges:changes] waitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+
+	expect(readFile(targetURL, @"Changed")).to(equal(@"old"));
+	expect(readFile(targetURL, @"Removed/Nested")).to(equal(@"removed"));
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[targetURL URLByAppendingPathComponent:@"Added"].path])).to(beFalsy());
+	expect(readFile(sourceURL, @"Changed")).to(equal(@"new"));
+});
+
+it(@"should revert changes that were only partly applied", ^{
+	NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect(@([[difference applyChanges:[changes subarrayWithRange:NSMakeRange(0, 1)]] waitUntilCompleted:NULL])).to(beTruthy());
+
+	expect(@([[difference revertChanges:changes] waitUntilCompleted:NULL])).to(beTruthy());
+
+	expect(readFile(targetURL, @"Changed")).to(equal(@"old"));
+	expect(readFile(targetURL, @"Removed/Nested")).to(equal(@"removed"));
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[targetURL URLByAppendingPathComponent:@"Added"].path])).to(beFalsy());
+});
+
+it(@"should treat files with different permissions as changed", ^{
+	expect(@(chmod([targetURL URLByAppendingPathComponent:@"Unchanged"].path.fileSystemRepresentation, 0755))).to(equal(@0));
+
+	NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect([changes valueForKey:SQRLBundleDifferenceChangePathKey]).to(contain(@"Unchanged"));
+});
+
+it(@"should treat files with different extended attributes as changed", ^{
+	const char value[] = "signature";
+	expect(@(setxattr([sourceURL URLByAppendingPathComponent:@"Unchanged"].path.fileSystemRepresentation, "com.apple.cs.CodeSignature", value, sizeof(value), 0, XATTR_NOFOLLOW))).to(equal(@0));
+
+	NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect([changes valueForKey:SQRLBundleDifferenceChangePathKey]).to(contain(@"Unchanged"));
+});
+
+describe(@"directories in both trees", ^{
+	__block NSURL *sourceDirectoryURL;
+	__block NSURL *targetDirectoryURL;
+
+	beforeEach(^{
+		writeFile(targetURL, @"Shared/File", @"same");
+		writeFile(sourceURL, @"Shared/File", @"same");
+
+		sourceDirectoryURL = [sourceURL URLByAppendingPathComponent:@"Shared"];
+		targetDirectoryURL = [targetURL URLByAppendingPathComponent:@"Shared"];
+
+		expect(@(chmod(targetDirectoryURL.path.fileSystemRepresentation, 0755))).to(equal(@0));
+		expect(@(chmod(sourceDirectoryURL.path.fileSystemRepresentation, 0700))).to(equal(@0));
+		expect(@(setxattr(sourceDirectoryURL.path.fileSystemRepresentation, "com.github.Squirrel.test", SQRLBundleDifferenceSpecAttributeValue, sizeof(SQRLBundleDifferenceSpecAttributeValue), 0, XATTR_NOFOLLOW))).to(equal(@0));
+	});
+
+	it(@"should give the target directory the source's metadata", ^{
+		NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+		NSDictionary *kindsByPath = [NSDictionary dictionaryWithObjects:[changes valueForKey:SQRLBundleDifferenceChangeKindKey] forKeys:[changes valueForKey:SQRLBundleDifferenceChangePathKey]];
+		expect(kindsByPath[@"Shared"]).to(equal(SQRLBundleDifferenceChangeKindAttributes));
+		expect(kindsByPath[@"Shared/File"]).to(beNil());
+
+		NSError *error = nil;
+		expect(@([[difference applyChanges:changes] waitUntilCompleted:&error])).to(beTruthy());
+		expect(error).to(beNil());
+
+		struct stat info;
+		expect(@(lstat(targetDirectoryURL.path.fileSystemRepresentation, &info))).to(equal(@0));
+		expect(@(info.st_mode & ALLPERMS)).to(equal(@0700));
+		expect(@(getxattr(targetDirectoryURL.path.fileSystemRepresentation, "com.github.Squirrel.test", NULL, 0, 0, XATTR_NOFOLLOW))).to(equal(@(sizeof(SQRLBundleDifferenceSpecAttributeValue))));
+
+		// The directory itself was never moved.
+		expect(readFile(targetURL, @"Shared/File")).to(equal(@"same"));
+	});
+
+	it(@"should put back the target directory's metadata when reverting", ^{
+		NSArray *changes = [[difference changes] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+		expect(@([[difference applyChanges:changes] waitUntilCompleted:NULL])).to(beTruthy());
+
+		NSError *error = nil;
+		expect(@([[difference revertChanges:changes] waitUntilCompleted:&error])).to(beTruthy());
+		expect(error).to(beNil());
+
+		struct stat info;
+		expect(@(lstat(targetDirectoryURL.path.fileSystemRepresentation, &info))).to(equal(@0));
+		expect(@(info.st_mode & ALLPERMS)).to(equal(@0755));
+		expect(@(getxattr(targetDirectoryURL.path.fileSystemRepresentation, "com.github.Squirrel.test", NULL, 0, 0, XATTR_NOFOLLOW))).to(equal(@(-1)));
+	});
+});
+
+QuickSpecEnd
@@ -0,0 +1,258 @@
+//
+//  SQRLCBORSerializationSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <Squirrel/Squirrel.h>
+#import <malloc/malloc.h>
+
+#import "QuickSpec+SQRLFixtures.h"
+#import "SQRLCBORSerialization.h"
+
+QuickSpecBegin(SQRLCBORSerializationSpec)
+
+NSData * (^bytes)(NSString *) = ^(NSString *hex) {
+	NSMutableData *data = [NSMutableData dataWithCapacity:hex.length / 2];
+	for (NSUInteger i = 0; i + 1 < hex.length; i += 2) {
+		uint8_t byte = (uint8_t)strtoul([hex substringWithRange:NSMakeRange(i, 2)].UTF8String, NULL, 16);
+		[data appendBytes:&byte length:1];
+	}
+
+	return data;
+};
+
+id (^decode)(NSString *) = ^(NSString *hex) {
+	return [SQRLCBORSerialization objectWithData:bytes(hex) error:NULL];
+};
+
+describe(@"decoding", ^{
+	// Examples from RFC 8949, appendix A.
+	it(@"should decode integers", ^{
+		expect(decode(@"00")).to(equal(@0));
+		expect(decode(@"17")).to(equal(@23));
+		expect(decode(@"1818")).to(equal(@24));
+		expect(decode(@"1903e8")).to(equal(@1000));
+		expect(decode(@"1a000f4240")).to(equal(@1000000));
+		expect(decode(@"1b000000e8d4a51000")).to(equal(@1000000000000));
+		expect(decode(@"1bffffffffffffffff")).to(equal(@(UINT64_MAX)));
+		expect(decode(@"20")).to(equal(@(-1)));
+		expect(decode(@"3903e7")).to(equal(@(-1000)));
+	});
+
+	it(@"should decode floats", ^{
+		expect(decode(@"f93c00")).to(equal(@1.0));
+		expect(decode(@"f9c400")).to(equal(@(-4.0)));
+		expect(decode(@"f90001")).to(equal(@(ldexp(1, -24))));
+		expect(decode(@"fa47c35000")).to(equal(@100000.0));
+		expect(decode(@"fb3ff199999999999a")).to(equal(@1.1));
+	});
+
+	it(@"should decode simple values", ^{
+		expect(decode(@"f4")).to(equal(@NO));
+		expect(decode(@"f5")).to(equal(@YES));
+		expect(decode(@"f6")).to(equal(NSNull.null));
+		expect(decode(@"f7")).to(equal(NSNull.null));
+	});
+
+	it(@"should decode strings", ^{
+		expect(decode(@"60")).to(equal(@""));
+		expect(decode(@"6449455446")).to(equal(@"IETF"));
+		expect(decode(@"62c3bc")).to(equal(@"ü"));
+		expect(decode(@"4401020304")).to(equal(bytes(@"01020304")));
+		expect(decode(@"7f657374726561646d696e67ff")).to(equal(@"streaming"));
+		expect(decode(@"5f42010243030405ff")).to(equal(bytes(@"0102030405")));
+	});
+
+	it(@"should decode arrays and maps", ^{
+		expect(decode(@"80")).to(equal(@[]));
+		expect(decode(@"8301820203820405")).to(equal(@[ @1, @[ @2, @3 ], @[ @4, @5 ] ]));
+		expect(decode(@"a26161016162820203")).to(equal(@{ @"a": @1, @"b": @[ @2, @3 ] }));
+		expect(decode(@"9f018202039f0405ffff")).to(equal(@[ @1, @[ @2, @3 ], @[ @4, @5 ] ]));
+		expect(decode(@"bf61610161629f0203ffff")).to(equal(@{ @"a": @1, @"b": @[ @2, @3 ] }));
+	});
+
+	it(@"should drop tags", ^{
+		expect(decode(@"c074323031332d30332d32315432303a30343a30305a")).to(equal(@"2013-03-21T20:04:00Z"));
+		expect(decode(@"c11a514b67b0")).to(equal(@1363896240));
+	});
+
+	it(@"should reject invalid documents", ^{
+		NSArray *invalidDocuments = @[
+			@"",
+			// Truncated heads, strings and containers.
+			@"19", @"6449", @"8301", @"a16161",
+			// Reserved additional information.
+			@"1c",
+			// Indefinite integers and tags.
+			@"1f", @"df00",
+			// A break outside of anything indefinite.
+			@"ff",
+			// A chunk of the wrong type.
+			@"7f4161ff",
+			// Keys that aren't strings.
+			@"a10102",
+			// Invalid UTF-8.
+			@"61ff",
+			// Trailing data.
+			@"0000",
+			// A count larger than the document.
+			@"9bffffffffffffffff",
+		];
+
+		for (NSString *hex in invalidDocuments) {
+			NSError *error = nil;
+			expect([SQRLCBORSerialization objectWithData:bytes(hex) error:&error]).to(beNil());
+			expect(@(error.code)).to(equal(@(NSPropertyListReadCorruptError)));
+		}
+	});
+
+	it(@"should reject documents nested too deeply", ^{
+		NSMutableData *data = [NSMutableData data];
+		for (NSUInteger i = 0; i < 1000; i++) {
+			[data appendData:bytes(@"81")];
+		}
+
+		[data appendData:bytes(@"00")];
+		expect([SQRLCBORSerialization objectWithData:data error:NULL]).to(beNil());
+	});
+
+	it(@"should reject documents with too many nested tags", ^{
+		NSMutableData *data = [NSMutableData dataWithLength:100000];
+		memset(data.mutableBytes, 0xc0, data.length);
+		[data appendData:bytes(@"00")];
+
+		NSError *error = nil;
+		expect([SQRLCBORSerialization objectWithData:data error:&error]).to(beNil());
+		expect(@(error.code)).to(equal(@(NSPropertyListReadCorruptError)));
+
+		// Tags nested no deeper than containers may be are still dropped.
+		expect(decode(@"c0c0c000")).to(equal(@0));
+	});
+});
+
+describe(@"encoding", ^{
+	it(@"should use the shortest encodings", ^{
+		expect([SQRLCBORSerialization dataWithObject:@[ @0, @24, @1000, @(-1000), @YES, NSNull.null, @"IETF" ] error:NULL]).to(equal(bytes(@"870018181903e83903e7f5f66449455446")));
+	});
+
+	it(@"should round-trip update documents", ^{
+		NSDictionary *update = @{
+			@"url": @"https://fake/app.zip",
+			@"name": @"1.0 — \U0001F43F",
+			@"notes": @"",
+			@"pub_date": @"2026-10-18T00:00:00Z",
+			@"size": @(UINT64_MAX),
+			@"ratio": @0.5,
+			@"delta": @NO,
+			@"digest": bytes(@"00ff00ff"),
+			@"files": @[ @{ @"path": @"Contents/Info.plist", @"mode": @420 }, NSNull.null ],
+		};
+
+		NSData *data = [SQRLCBORSerialization dataWithObject:update error:NULL];
+		expect(data).notTo(beNil());
+		expect([SQRLCBORSerialization objectWithData:data error:NULL]).to(equal(update));
+	});
+
+	it(@"should reject objects JSON can't represent", ^{
+		NSError *error = nil;
+		expect([SQRLCBORSerialization dataWithObject:@{ @1: @"a" } error:&error]).to(beNil());
+		expect(@(error.code)).to(equal(@(NSPropertyListWriteInvalidError)));
+
+		expect([SQRLCBORSerialization dataWithObject:@[ NSDate.date ] error:NULL]).to(beNil());
+	});
+});
+
+describe(@"benchmark", ^{
+	// Set SQRL_CBOR_DECODE_BUDGET_MS to fail when decoding the manifest takes
+	// longer than that.
+	it(@"should decode a manifest of 50,000 files faster and smaller than JSON", ^{
+		const NSUInteger fileCount = 50000;
+
+		NSMutableArray *JSONFiles = [NSMutableArray arrayWithCapacity:fileCount];
+		NSMutableArray *CBORFiles = [NSMutableArray arrayWithCapacity:fileCount];
+		for (NSUInteger i = 0; i < fileCount; i++) {
+			uint8_t digest[32];
+			arc4random_buf(digest, sizeof(digest));
+
+			NSData *digestData = [NSData dataWithBytes:digest length:sizeof(digest)];
+			NSMutableString *digestString = [NSMutableString stringWithCapacity:64];
+			for (NSUInteger j = 0; j < sizeof(digest); j++) {
+				[digestString appendFormat:@"%02x", digest[j]];
+			}
+
+			NSDictionary *file = @{
+				@"path": [NSString stringWithFormat:@"Contents/Resources/app/node_modules/module-%lu/lib/file-%lu.js", (unsigned long)(i / 100), (unsigned long)i],
+				@"size": @(arc4random_uniform(1 << 20)),
+				@"mode": @420,
+			};
+
+			NSMutableDictionary *JSONFile = [file mutableCopy];
+			JSONFile[@"sha256"] = digestString;
+			[JSONFiles addObject:JSONFile];
+
+			NSMutableDictionary *CBORFile = [file mutableCopy];
+			CBORFile[@"sha256"] = digestData;
+			[CBORFiles addObject:CBORFile];
+		}
+
+		NSData *JSONData = [NSJSONSerialization dataWithJSONObject:@{ @"version": @"1.0.0", @"files": JSONFiles } options:0 error:NULL];
+		NSData *CBORData = [SQRLCBORSerialization dataWithObject:@{ @"version": @"1.0.0", @"files": CBORFiles } error:NULL];
+
+		// Decode from mappings, as a manifest saved alongside an update would be.
+		NSURL *JSONURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"manifest.json"];
+		NSURL *CBORURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"manifest.cbor"];
+		expect(@([JSONData writeToURL:JSONURL atomically:YES])).to(beTruthy());
+		expect(@([CBORData writeToURL:CBORURL atomically:YES])).to(beTruthy());
+
+		// Runs the block in an autorelease pool, and logs how long it took and
+		// how much it left allocated before the pool drained.
+		//
+		// Returns the number of milliseconds taken.
+		double (^measure)(NSString *, NSURL *, id (^)(NSData *)) = ^(NSString *name, NSURL *URL, id (^block)(NSData *)) {
+			malloc_statistics_t before, after;
+			uint64_t start, end;
+
+			@autoreleasepool {
+				NSData *data = [NSData dataWithContentsOfURL:URL options:NSDataReadingMappedAlways error:NULL];
+				expect(data).notTo(beNil());
+
+				malloc_zone_statistics(NULL, &before);
+				start = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+
+				id manifest = block(data);
+
+				end = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+				malloc_zone_statistics(NULL, &after);
+
+				expect(@([manifest[@"files"] count])).to(equal(@(fileCount)));
+			}
+
+			double milliseconds = (end - start) / (double)NSEC_PER_MSEC;
+			NSLog(@"%@ manifest of %.1fMB: %.2fms, %ld blocks and %ldKB allocated", name, [[NSFileManager.defaultManager attributesOfItemAtPath:URL.path error:NULL] fileSize] / 1048576.0, milliseconds, (long)after.blocks_in_use - (long)before.blocks_in_use, ((long)after.size_in_use - (long)before.size_in_use) / 1024);
+
+			return milliseconds;
+		};
+
+		measure(@"JSON", JSONURL, ^(NSData *data) {
+			return [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+		});
+
+		double CBORMS = measure(@"CBOR", CBORURL, ^(NSData *data) {
+			return [SQRLCBORSerialization objectWithData:data error:NULL];
+		});
+
+		expect(@(CBORData.length)).to(beLessThan(@(JSONData.length)));
+
+		NSString *budgetString = NSProcessInfo.processInfo.environment[@"SQRL_CBOR_DECODE_BUDGET_MS"];
+		if (budgetString != nil) {
+			expect(@(CBORMS)).to(beLessThanOrEqualTo(@(budgetString.doubleValue)));
+		}
+	});
+});
+
+QuickSpecEnd
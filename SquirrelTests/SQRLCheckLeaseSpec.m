@@ -0,0 +1,130 @@
+//
+//  SQRLCheckLeaseSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "QuickSpec+SQRLFixtures.h"
+#import "SQRLCheckLease.h"
+
+QuickSpecBegin(SQRLCheckLeaseSpec)
+
+__block NSURL *lockURL;
+__block SQRLCheckLease *leader;
+__block SQRLCheckLease *follower;
+
+beforeEach(^{
+	lockURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"UpdateCheck.lock"];
+
+	leader = [[SQRLCheckLease alloc] initWithURL:lockURL];
+	leader.pollInterval = 0.05;
+
+	follower = [[SQRLCheckLease alloc] initWithURL:lockURL];
+	follower.pollInterval = 0.05;
+});
+
+afterEach(^{
+	[leader relinquishWithOutcome:nil];
+	[follower relinquishWithOutcome:nil];
+});
+
+it(@"should lead when nobody else holds the lease", ^{
+	NSError *error = nil;
+	NSNumber *acquired = [[leader acquire] firstOrDefault:nil success:NULL error:&error];
+	expect(acquired).to(equal(@YES));
+	expect(error).to(beNil());
+
+	expect(@(leader.leader)).to(beTruthy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:lockURL.path])).to(beTruthy());
+});
+
+it(@"should follow while another updater holds the lease", ^{
+	expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+	expect([[follower acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@NO));
+
+	expect(@(follower.leader)).to(beFalsy());
+});
+
+it(@"should lead once the leader relinquishes the lease", ^{
+	expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+	[leader relinquishWithOutcome:nil];
+	expect(@(leader.leader)).to(beFalsy());
+
+	expect([[follower acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+});
+
+it(@"should error if the lock file can't be opened", ^{
+	SQRLCheckLease *lease = [[SQRLCheckLease alloc] initWithURL:[self.temporaryDirectoryURL URLByAppendingPathComponent:@"missing/UpdateCheck.lock"]];
+
+	NSError *error = nil;
+	BOOL success = [[lease acquire] waitUntilCompleted:&error];
+	expect(@(success)).to(beFalsy());
+	expect(error.domain).to(equal(NSPOSIXErrorDomain));
+});
+
+it(@"should send the leader's progress, then its outcome", ^{
+	expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+	[leader recordProgress:@{ @"state": @1 }];
+
+	RACScheduler *scheduler = [RACScheduler scheduler];
+	[scheduler afterDelay:0.3 schedule:^{
+		[leader recordProgress:@{ @"state": @2 }];
+	}];
+
+	[scheduler afterDelay:0.6 schedule:^{
+		[leader relinquishWithOutcome:@{ @"result": @"noUpdate" }];
+	}];
+
+	NSError *error = nil;
+	BOOL success = NO;
+	NSArray *progress = [[[follower waitForLeader] collect] asynchronousFirstOrDefault:nil success:&success error:&error];
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+
+	expect(progress).to(equal((@[ @{ @"state": @1 }, @{ @"state": @2 } ])));
+	expect(follower.outcome).to(equal(@{ @"result": @"noUpdate" }));
+});
+
+it(@"should finish without an outcome if the leader left none", ^{
+	expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+
+	[[RACScheduler scheduler] afterDelay:0.2 schedule:^{
+		[leader relinquishWithOutcome:nil];
+	}];
+
+	NSError *error = nil;
+	expect(@([[follower waitForLeader] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+	expect(follower.outcome).to(beNil());
+});
+
+it(@"should ignore outcomes left before it was initialized", ^{
+	expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+	[leader relinquishWithOutcome:@{ @"result": @"noUpdate" }];
+
+	SQRLCheckLease *lateFollower = [[SQRLCheckLease alloc] initWithURL:lockURL];
+
+	NSError *error = nil;
+	expect(@([[lateFollower waitForLeader] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+	expect(lateFollower.outcome).to(beNil());
+});
+
+it(@"should error once the lease expires", ^{
+	leader.duration = 0.1;
+	expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+
+	NSError *error = nil;
+	expect(@([[follower waitForLeader] asynchronouslyWaitUntilCompleted:&error])).to(beFalsy());
+	expect(error.domain).to(equal(SQRLCheckLeaseErrorDomain));
+	expect(@(error.code)).to(equal(@(SQRLCheckLeaseErrorExpired)));
+});
+
+QuickSpecEnd
@@ -0,0 +1,222 @@
+//
+//  SQRLCheckSchedulerSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLCheckScheduler.h"
+
+QuickSpecBegin(SQRLCheckSchedulerSpec)
+
+NSHTTPURLResponse * (^response)(NSDictionary *) = ^(NSDictionary *headers) {
+	return [[NSHTTPURLResponse alloc] initWithURL:[NSURL URLWithString:@"http://fake/releases"] statusCode:200 HTTPVersion:@"HTTP/1.1" headerFields:headers];
+};
+
+describe(@"+hintFromResponse:", ^{
+	it(@"should read Retry-After in seconds", ^{
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Retry-After": @"120" })])).to(equal(@120));
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"retry-after": @" 30 " })])).to(equal(@30));
+	});
+
+	it(@"should read Retry-After as a date", ^{
+		NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+		formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+		formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+		formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss 'GMT'";
+
+		NSString *date = [formatter stringFromDate:[NSDate dateWithTimeIntervalSinceNow:600]];
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Retry-After": date })])).to(beCloseTo(@600).within(5));
+
+		date = [formatter stringFromDate:[NSDate dateWithTimeIntervalSinceNow:-600]];
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Retry-After": date })])).to(equal(@0));
+	});
+
+	it(@"should read Cache-Control max-age, less the response's age", ^{
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Cache-Control": @"public, max-age=300" })])).to(equal(@300));
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Cache-Control": @"max-age=300", @"Age": @"100" })])).to(equal(@200));
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Cache-Control": @"no-cache" })])).to(equal(@0));
+	});
+
+	it(@"should use the longer of both hints", ^{
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Cache-Control": @"max-age=300", @"Retry-After": @"60" })])).to(equal(@300));
+	});
+
+	it(@"should not find a hint without headers", ^{
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{})])).to(equal(@0));
+		expect(@([SQRLCheckScheduler hintFromResponse:response(@{ @"Retry-After": @"soon" })])).to(equal(@0));
+		expect(@([SQRLCheckScheduler hintFromResponse:nil])).to(equal(@0));
+	});
+});
+
+describe(@"+hintFromNextCheckAfter:", ^{
+	it(@"should read a number of seconds", ^{
+		expect(@([SQRLCheckScheduler hintFromNextCheckAfter:@3600])).to(equal(@3600));
+		expect(@([SQRLCheckScheduler hintFromNextCheckAfter:@(-1)])).to(equal(@0));
+	});
+
+	it(@"should read an ISO 8601 date", ^{
+		NSString *date = [[[NSISO8601DateFormatter alloc] init] stringFromDate:[NSDate dateWithTimeIntervalSinceNow:900]];
+		expect(@([SQRLCheckScheduler hintFromNextCheckAfter:date])).to(beCloseTo(@900).within(5));
+	});
+
+	it(@"should ignore anything else", ^{
+		expect(@([SQRLCheckScheduler hintFromNextCheckAfter:nil])).to(equal(@0));
+		expect(@([SQRLCheckScheduler hintFromNextCheckAfter:@"tomorrow"])).to(equal(@0));
+		expect(@([SQRLCheckScheduler hintFromNextCheckAfter:@[ @60 ]])).to(equal(@0));
+	});
+});
+
+describe(@"scheduling", ^{
+	__block SQRLCheckScheduler *scheduler;
+
+	beforeEach(^{
+		scheduler = [[SQRLCheckScheduler alloc] initWithInterval:1000];
+	});
+
+	it(@"should jitter delays within the interval's jitter", ^{
+		NSTimeInterval shortest = INFINITY;
+		NSTimeInterval longest = 0;
+
+		for (NSUInteger i = 0; i < 1000; i++) {
+			NSTimeInterval delay = [scheduler delayWithHint:0];
+			shortest = MIN(shortest, delay);
+			longest = MAX(longest, delay);
+		}
+
+		expect(@(shortest)).to(beGreaterThanOrEqualTo(@800));
+		expect(@(longest)).to(beLessThanOrEqualTo(@1200));
+		expect(@(longest - shortest)).to(beGreaterThan(@200));
+	});
+
+	it(@"should not jitter without any jitter", ^{
+		scheduler.jitter = 0;
+		expect(@([scheduler delayWithHint:0])).to(equal(@1000));
+	});
+
+	it(@"should wait at least as long as a hint", ^{
+		for (NSUInteger i = 0; i < 100; i++) {
+			NSTimeInterval delay = [scheduler delayWithHint:5000];
+			expect(@(delay)).to(beGreaterThanOrEqualTo(@5000));
+			expect(@(delay)).to(beLessThanOrEqualTo(@6000));
+		}
+	});
+
+	it(@"should ignore hints shorter than the interval", ^{
+		scheduler.jitter = 0;
+		expect(@([scheduler delayWithHint:10])).to(equal(@1000));
+	});
+
+	it(@"should cap hints", ^{
+		scheduler.jitter = 0;
+		scheduler.maximumHint = 2000;
+		expect(@([scheduler delayWithHint:1e9])).to(equal(@2000));
+	});
+
+	it(@"should default the leeway to a tenth of the interval, up to a minute", ^{
+		expect(@(scheduler.leeway)).to(equal(@60));
+		expect(@([[SQRLCheckScheduler alloc] initWithInterval:100].leeway)).to(equal(@10));
+	});
+
+	it(@"should wait for the next check", ^{
+		scheduler = [[SQRLCheckScheduler alloc] initWithInterval:0.1];
+
+		NSDate *start = [NSDate date];
+		expect(@([[scheduler waitWithHint:0] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+		expect(@(-start.timeIntervalSinceNow)).to(beGreaterThanOrEqualTo(@0.08));
+	});
+
+	it(@"should not complete once disposed", ^{
+		scheduler = [[SQRLCheckScheduler alloc] initWithInterval:0.1];
+
+		__block BOOL completed = NO;
+		RACDisposable *disposable = [[scheduler waitWithHint:0] subscribeCompleted:^{
+			completed = YES;
+		}];
+
+		[disposable dispose];
+		[NSRunLoop.currentRunLoop runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+		expect(@(completed)).to(beFalsy());
+	});
+});
+
+describe(@"fleet simulation", ^{
+	// Simulates a fleet of clients which were all launched in the same
+	// minute, like after an update is pushed, checking hourly for 12 hours.
+	//
+	// Set SQRL_CHECK_SIMULATION_CLIENTS to simulate a fleet of more than
+	// 10,000 clients. Smaller fleets are too noisy to compare.
+	//
+	// Returns the number of checks in each minute.
+	NSArray * (^simulate)(SQRLCheckScheduler *, NSTimeInterval) = ^(SQRLCheckScheduler *scheduler, NSTimeInterval firstHint) {
+		NSString *clientCountString = NSProcessInfo.processInfo.environment[@"SQRL_CHECK_SIMULATION_CLIENTS"];
+		NSUInteger clientCount = MAX((NSUInteger)clientCountString.integerValue, 10000);
+		const NSUInteger minutes = 12 * 60;
+
+		NSUInteger *checksPerMinute = calloc(minutes, sizeof(*checksPerMinute));
+		for (NSUInteger client = 0; client < clientCount; client++) {
+			NSTimeInterval time = arc4random_uniform(60);
+			NSTimeInterval hint = firstHint;
+
+			while (time < minutes * 60) {
+				checksPerMinute[(NSUInteger)(time / 60)]++;
+
+				time += [scheduler delayWithHint:hint];
+				hint = 0;
+			}
+		}
+
+		NSMutableArray *counts = [NSMutableArray arrayWithCapacity:minutes];
+		for (NSUInteger minute = 0; minute < minutes; minute++) {
+			[counts addObject:@(checksPerMinute[minute])];
+		}
+
+		free(checksPerMinute);
+		return counts;
+	};
+
+	// Logs the peak and mean of the checks per minute, after the launch
+	// itself, and returns the peak.
+	NSUInteger (^summarize)(NSString *, NSArray *) = ^(NSString *name, NSArray *counts) {
+		NSArray *afterLaunch = [counts subarrayWithRange:NSMakeRange(1, counts.count - 1)];
+		NSUInteger peak = [[afterLaunch valueForKeyPath:@"@max.self"] unsignedIntegerValue];
+		double mean = [[afterLaunch valueForKeyPath:@"@avg.self"] doubleValue];
+
+		NSLog(@"%@: peak of %lu checks per minute, mean of %.1f (%.1fx)", name, (unsigned long)peak, mean, peak / MAX(mean, 1));
+		return peak;
+	};
+
+	it(@"should smooth out the check rate of clients launched together", ^{
+		SQRLCheckScheduler *fixed = [[SQRLCheckScheduler alloc] initWithInterval:60 * 60];
+		fixed.jitter = 0;
+
+		SQRLCheckScheduler *jittered = [[SQRLCheckScheduler alloc] initWithInterval:60 * 60];
+
+		NSUInteger fixedPeak = summarize(@"Fixed interval", simulate(fixed, 0));
+		NSUInteger jitteredPeak = summarize(@"Jittered interval", simulate(jittered, 0));
+
+		expect(@(jitteredPeak * 10)).to(beLessThan(@(fixedPeak)));
+	});
+
+	it(@"should spread out clients sent the same hint", ^{
+		// The server is overloaded by the launch, and sends every client the
+		// same Retry-After.
+		SQRLCheckScheduler *scheduler = [[SQRLCheckScheduler alloc] initWithInterval:60 * 60];
+		NSArray *counts = simulate(scheduler, 2 * 60 * 60);
+
+		// Nobody comes back before the server asked.
+		NSUInteger earlyChecks = [[[counts subarrayWithRange:NSMakeRange(1, 119)] valueForKeyPath:@"@sum.self"] unsignedIntegerValue];
+		expect(@(earlyChecks)).to(equal(@0));
+
+		NSUInteger peak = summarize(@"Jittered interval after a shared hint", counts);
+		expect(@(peak * 10)).to(beLessThan(@([counts[0] unsignedIntegerValue])));
+	});
+});
+
+QuickSpecEnd
@@ -46,6 +46,17 @@ it(@"should fail to verify with different code signing requirements", ^{
 	expect(error).notTo(beNil());
 });
 
+it(@"should verify a bundle using a signature recreated from its requirement data", ^{
+	NSError *error = nil;
+	SQRLCodeSignature *signature = [SQRLCodeSignature signatureWithRequirementData:self.testApplicationSignature.requirementData error:&error];
+	expect(signature).notTo(beNil());
+	expect(error).to(beNil());
+
+	BOOL success = [[signature verifyBundleAtURL:bundle.bundleURL] waitUntilCompleted:&error];
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+});
+
 describe(@"code signature changes", ^{
 	__block NSURL *codeSignatureURL;
 
@@ -58,4 +58,51 @@ it(@"should send a ShipIt state URL", ^{
 	expect(error).to(beNil());
 });
 
+it(@"should send a release feed validators URL", ^{
+	SQRLDirectoryManager *manager = SQRLDirectoryManager.currentApplicationManager;
+
+	NSError *error = nil;
+	NSURL *validatorsURL = [[manager releaseFeedValidatorsURL] firstOrDefault:nil success:NULL error:&error];
+	expect(validatorsURL).notTo(beNil());
+	expect(error).to(beNil());
+});
+
+it(@"should send an update check lease URL", ^{
+	SQRLDirectoryManager *manager = SQRLDirectoryManager.currentApplicationManager;
+
+	NSError *error = nil;
+	NSURL *leaseURL = [[manager updateCheckLeaseURL] firstOrDefault:nil success:NULL error:&error];
+	expect(leaseURL).notTo(beNil());
+	expect(error).to(beNil());
+});
+
+it(@"should send a staged update URL", ^{
+	SQRLDirectoryManager *manager = SQRLDirectoryManager.currentApplicationManager;
+
+	NSError *error = nil;
+	NSURL *stagedUpdateURL = [[manager stagedUpdateURL] firstOrDefault:nil success:NULL error:&error];
+	expect(stagedUpdateURL).notTo(beNil());
+	expect(error).to(beNil());
+});
+
+it(@"should rotate ShipIt's logs", ^{
+	SQRLDirectoryManager *manager = SQRLDirectoryManager.currentApplicationManager;
+
+	NSError *error = nil;
+	NSURL *stdoutURL = [[manager shipItStdoutURL] firstOrDefault:nil success:NULL error:&error];
+	expect(stdoutURL).notTo(beNil());
+	expect(error).to(beNil());
+
+	NSURL *rotatedURL = [stdoutURL URLByAppendingPathExtension:@"1.gz"];
+	expect(@([[@"installing\n" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:stdoutURL atomically:NO])).to(beTruthy());
+
+	expect(@([[manager rotateShipItLogs] waitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:stdoutURL.path])).to(beFalsy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:rotatedURL.path])).to(beTruthy());
+
+	[NSFileManager.defaultManager removeItemAtURL:rotatedURL error:NULL];
+});
+
 QuickSpecEnd
@@ -0,0 +1,330 @@
+//
+//  SQRLFileTreeWalkerSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLFileTreeWalker.h"
+
+#import "QuickSpec+SQRLFixtures.h"
+
+#import <membership.h>
+#import <sys/acl.h>
+#import <sys/stat.h>
+#import <sys/xattr.h>
+
+QuickSpecBegin(SQRLFileTreeWalkerSpec)
+
+__block NSURL *rootURL;
+__block NSSet *expectedPaths;
+
+beforeEach(^{
+	rootURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"tree" isDirectory:YES];
+
+	NSMutableSet *paths = [NSMutableSet setWithObject:rootURL.URLByStandardizingPath.path];
+	for (NSUInteger i = 0; i < 8; i++) {
+		NSURL *directoryURL = [rootURL URLByAppendingPathComponent:[NSString stringWithFormat:@"directory %lu/nested", (unsigned long)i] isDirectory:YES];
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+		[paths addObject:directoryURL.URLByDeletingLastPathComponent.URLByStandardizingPath.path];
+		[paths addObject:directoryURL.URLByStandardizingPath.path];
+
+		for (NSUInteger j = 0; j < 16; j++) {
+			NSURL *fileURL = [directoryURL URLByAppendingPathComponent:[NSString stringWithFormat:@"file %lu", (unsigned long)j]];
+			expect(@([[NSData data] writeToURL:fileURL atomically:NO])).to(beTruthy());
+			[paths addObject:fileURL.URLByStandardizingPath.path];
+		}
+	}
+
+	expectedPaths = paths;
+});
+
+it(@"should visit every item, including the root", ^{
+	NSMutableSet *visitedPaths = [NSMutableSet set];
+	NSLock *lock = [[NSLock alloc] init];
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+	NSError *error = nil;
+	BOOL success = [[walker visitItemsWithBlock:^(NSURL *itemURL, NSError **errorRef) {
+		[lock lock];
+		[visitedPaths addObject:itemURL.URLByStandardizingPath.path];
+		[lock unlock];
+		return YES;
+	}] asynchronouslyWaitUntilCompleted:&error];
+
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+	expect(visitedPaths).to(equal(expectedPaths));
+	expect(@(walker.visitedItemCount)).to(equal(@(expectedPaths.count)));
+	expect(@(walker.visitedByteCount)).to(equal(@0));
+});
+
+it(@"should count the bytes of visited files", ^{
+	NSData *data = [NSMutableData dataWithLength:1024];
+	expect(@([data writeToURL:[rootURL URLByAppendingPathComponent:@"directory 0/nested/file 0"] atomically:NO])).to(beTruthy());
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+	BOOL success = [[walker visitItemsWithBlock:^(NSURL *itemURL, NSError **errorRef) {
+		return YES;
+	}] asynchronouslyWaitUntilCompleted:NULL];
+
+	expect(@(success)).to(beTruthy());
+	expect(@(walker.visitedByteCount)).to(equal(@1024));
+});
+
+it(@"should not follow symbolic links", ^{
+	NSURL *outsideURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"outside" isDirectory:YES];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:outsideURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+	expect(@([[NSData data] writeToURL:[outsideURL URLByAppendingPathComponent:@"file"] atomically:NO])).to(beTruthy());
+
+	NSURL *linkURL = [rootURL URLByAppendingPathComponent:@"link"];
+	expect(@([NSFileManager.defaultManager createSymbolicLinkAtURL:linkURL withDestinationURL:outsideURL error:NULL])).to(beTruthy());
+
+	NSMutableSet *visitedPaths = [NSMutableSet set];
+	NSLock *lock = [[NSLock alloc] init];
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+	BOOL success = [[walker visitItemsWithBlock:^(NSURL *itemURL, NSError **errorRef) {
+		[lock lock];
+		[visitedPaths addObject:itemURL.URLByStandardizingPath.path];
+		[lock unlock];
+		return YES;
+	}] asynchronouslyWaitUntilCompleted:NULL];
+
+	expect(@(success)).to(beTruthy());
+	expect(@([visitedPaths containsObject:linkURL.URLByStandardizingPath.path])).to(beTruthy());
+	expect(@([visitedPaths containsObject:[linkURL URLByAppendingPathComponent:@"file"].URLByStandardizingPath.path])).to(beFalsy());
+});
+
+it(@"should stop and error when the block fails", ^{
+	NSError *expectedError = [NSError errorWithDomain:@"SQRLFileTreeWalkerSpecErrorDomain" code:1 userInfo:nil];
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+	NSError *error = nil;
+	BOOL success = [[walker visitItemsWithBlock:^(NSURL *itemURL, NSError **errorRef) {
+		if ([itemURL.lastPathComponent isEqual:@"file 3"]) {
+			*errorRef = expectedError;
+			return NO;
+		}
+
+		return YES;
+	}] asynchronouslyWaitUntilCompleted:&error];
+
+	expect(@(success)).to(beFalsy());
+	expect(error).to(equal(expectedError));
+});
+
+it(@"should remove the whole tree", ^{
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+	NSError *error = nil;
+	BOOL success = [[walker removeItems] asynchronouslyWaitUntilCompleted:&error];
+
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:rootURL.path])).to(beFalsy());
+});
+
+it(@"should remove read-only directories and immutable files", ^{
+	NSURL *directoryURL = [rootURL URLByAppendingPathComponent:@"directory 3/nested"];
+	NSURL *fileURL = [directoryURL URLByAppendingPathComponent:@"file 3"];
+	expect(@(chflags(fileURL.path.fileSystemRepresentation, UF_IMMUTABLE))).to(equal(@0));
+	expect(@([NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0555 } ofItemAtPath:directoryURL.path error:NULL])).to(beTruthy());
+
+	NSError *error = nil;
+	BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] removeItems] asynchronouslyWaitUntilCompleted:&error];
+
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:rootURL.path])).to(beFalsy());
+});
+
+it(@"should skip directories that can't be listed when asked to", ^{
+	NSURL *directoryURL = [rootURL URLByAppendingPathComponent:@"directory 4/nested"];
+	expect(@([NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0 } ofItemAtPath:directoryURL.path error:NULL])).to(beTruthy());
+
+	NSMutableSet *visitedPaths = [NSMutableSet set];
+	NSMutableArray *failedURLs = [NSMutableArray array];
+	NSLock *lock = [[NSLock alloc] init];
+
+	BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] visitItemsWithBlock:^(NSURL *itemURL, NSError **errorRef) {
+		[lock lock];
+		[visitedPaths addObject:itemURL.URLByStandardizingPath.path];
+		[lock unlock];
+		return YES;
+	} errorHandler:^(NSURL *URL, NSError *error) {
+		[lock lock];
+		[failedURLs addObject:URL.URLByStandardizingPath];
+		[lock unlock];
+		return YES;
+	}] asynchronouslyWaitUntilCompleted:NULL];
+
+	// Let the fixtures clean up.
+	[NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0755 } ofItemAtPath:directoryURL.path error:NULL];
+
+	expect(@(success)).to(beTruthy());
+	expect(failedURLs).to(equal(@[ directoryURL.URLByStandardizingPath ]));
+	expect(@([visitedPaths containsObject:[rootURL URLByAppendingPathComponent:@"directory 5/nested/file 15"].URLByStandardizingPath.path])).to(beTruthy());
+	expect(@([visitedPaths containsObject:[directoryURL URLByAppendingPathComponent:@"file 0"].URLByStandardizingPath.path])).to(beFalsy());
+});
+
+it(@"should remove the tree when walking serially", ^{
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+	walker.maximumConcurrentOperations = 1;
+
+	BOOL success = [[walker removeItems] asynchronouslyWaitUntilCompleted:NULL];
+
+	expect(@(success)).to(beTruthy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:rootURL.path])).to(beFalsy());
+});
+
+it(@"should error when the root does not exist", ^{
+	NSURL *missingURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"missing"];
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:missingURL];
+	NSError *error = nil;
+	BOOL success = [[walker removeItems] asynchronouslyWaitUntilCompleted:&error];
+
+	expect(@(success)).to(beFalsy());
+	expect(error.domain).to(equal(NSCocoaErrorDomain));
+	expect(@(error.code)).to(equal(@(NSFileNoSuchFileError)));
+});
+
+describe(@"-copyItemsToURL:", ^{
+	__block NSURL *destinationURL;
+
+	beforeEach(^{
+		destinationURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"copy" isDirectory:YES];
+	});
+
+	it(@"should copy every item", ^{
+		NSURL *fileURL = [rootURL URLByAppendingPathComponent:@"directory 0/nested/file 0"];
+		NSData *data = [NSMutableData dataWithLength:5 * 1024 * 1024];
+		expect(@([data writeToURL:fileURL atomically:NO])).to(beTruthy());
+		expect(@([NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0755 } ofItemAtPath:fileURL.path error:NULL])).to(beTruthy());
+
+		SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:rootURL];
+		NSError *error = nil;
+		BOOL success = [[walker copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:&error];
+
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+
+		for (NSString *path in expectedPaths) {
+			NSString *relativePath = [path substringFromIndex:rootURL.URLByStandardizingPath.path.length];
+			expect(@([NSFileManager.defaultManager fileExistsAtPath:[destinationURL.path stringByAppendingString:relativePath]])).to(beTruthy());
+		}
+
+		NSURL *copiedFileURL = [destinationURL URLByAppendingPathComponent:@"directory 0/nested/file 0"];
+		expect([NSData dataWithContentsOfURL:copiedFileURL]).to(equal(data));
+		expect([NSFileManager.defaultManager attributesOfItemAtPath:copiedFileURL.path error:NULL][NSFilePosixPermissions]).to(equal(@0755));
+	});
+
+	it(@"should copy symbolic links without following them", ^{
+		NSURL *linkURL = [rootURL URLByAppendingPathComponent:@"link"];
+		expect(@([NSFileManager.defaultManager createSymbolicLinkAtPath:linkURL.path withDestinationPath:@"directory 0" error:NULL])).to(beTruthy());
+
+		BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:NULL];
+		expect(@(success)).to(beTruthy());
+
+		NSString *linkDestination = [NSFileManager.defaultManager destinationOfSymbolicLinkAtPath:[destinationURL URLByAppendingPathComponent:@"link"].path error:NULL];
+		expect(linkDestination).to(equal(@"directory 0"));
+	});
+
+	it(@"should copy read-only directories and their contents", ^{
+		NSURL *directoryURL = [rootURL URLByAppendingPathComponent:@"directory 1"];
+		expect(@([NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0555 } ofItemAtPath:directoryURL.path error:NULL])).to(beTruthy());
+
+		BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:NULL];
+
+		// Let the fixtures clean up.
+		[NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0755 } ofItemAtPath:directoryURL.path error:NULL];
+
+		expect(@(success)).to(beTruthy());
+
+		NSURL *copiedDirectoryURL = [destinationURL URLByAppendingPathComponent:@"directory 1"];
+		expect([NSFileManager.defaultManager attributesOfItemAtPath:copiedDirectoryURL.path error:NULL][NSFilePosixPermissions]).to(equal(@0555));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:[copiedDirectoryURL URLByAppendingPathComponent:@"nested/file 15"].path])).to(beTruthy());
+
+		[NSFileManager.defaultManager setAttributes:@{ NSFilePosixPermissions: @0755 } ofItemAtPath:copiedDirectoryURL.path error:NULL];
+	});
+
+	it(@"should copy extended attributes", ^{
+		NSURL *fileURL = [rootURL URLByAppendingPathComponent:@"directory 2/nested/file 2"];
+		const char value[] = "value";
+		expect(@(setxattr(fileURL.path.fileSystemRepresentation, "com.github.Squirrel.test", value, sizeof(value), 0, 0))).to(equal(@0));
+
+		BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:NULL];
+		expect(@(success)).to(beTruthy());
+
+		char copiedValue[sizeof(value)] = { 0 };
+		NSURL *copiedFileURL = [destinationURL URLByAppendingPathComponent:@"directory 2/nested/file 2"];
+		expect(@(getxattr(copiedFileURL.path.fileSystemRepresentation, "com.github.Squirrel.test", copiedValue, sizeof(copiedValue), 0, 0))).to(equal(@(sizeof(value))));
+		expect(@(copiedValue)).to(equal(@"value"));
+	});
+
+	it(@"should copy access control lists", ^{
+		NSURL *fileURL = [rootURL URLByAppendingPathComponent:@"directory 3/nested/file 3"];
+		NSURL *directoryURL = [rootURL URLByAppendingPathComponent:@"directory 3"];
+
+		uuid_t userUUID;
+		expect(@(mbr_uid_to_uuid(geteuid(), userUUID))).to(equal(@0));
+
+		acl_t acl = acl_init(1);
+		acl_entry_t entry;
+		acl_permset_t permissions;
+		expect(@(acl_create_entry(&acl, &entry))).to(equal(@0));
+		expect(@(acl_set_tag_type(entry, ACL_EXTENDED_ALLOW))).to(equal(@0));
+		expect(@(acl_set_qualifier(entry, userUUID))).to(equal(@0));
+		expect(@(acl_get_permset(entry, &permissions))).to(equal(@0));
+		expect(@(acl_add_perm(permissions, ACL_READ_DATA))).to(equal(@0));
+		expect(@(acl_set_permset(entry, permissions))).to(equal(@0));
+
+		expect(@(acl_set_file(fileURL.path.fileSystemRepresentation, ACL_TYPE_EXTENDED, acl))).to(equal(@0));
+		expect(@(acl_set_file(directoryURL.path.fileSystemRepresentation, ACL_TYPE_EXTENDED, acl))).to(equal(@0));
+		acl_free(acl);
+
+		BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:NULL];
+		expect(@(success)).to(beTruthy());
+
+		for (NSString *path in @[ @"directory 3/nested/file 3", @"directory 3" ]) {
+			acl_t copiedACL = acl_get_file([destinationURL URLByAppendingPathComponent:path].path.fileSystemRepresentation, ACL_TYPE_EXTENDED);
+			expect(@(copiedACL != NULL)).to(beTruthy());
+			if (copiedACL != NULL) acl_free(copiedACL);
+		}
+	});
+
+	it(@"should keep hard links within the tree", ^{
+		NSURL *fileURL = [rootURL URLByAppendingPathComponent:@"directory 4/nested/file 4"];
+		NSURL *linkURL = [rootURL URLByAppendingPathComponent:@"directory 5/nested/link"];
+		expect(@(link(fileURL.path.fileSystemRepresentation, linkURL.path.fileSystemRepresentation))).to(equal(@0));
+
+		BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:NULL];
+		expect(@(success)).to(beTruthy());
+
+		struct stat fileInfo;
+		struct stat linkInfo;
+		expect(@(lstat([destinationURL URLByAppendingPathComponent:@"directory 4/nested/file 4"].path.fileSystemRepresentation, &fileInfo))).to(equal(@0));
+		expect(@(lstat([destinationURL URLByAppendingPathComponent:@"directory 5/nested/link"].path.fileSystemRepresentation, &linkInfo))).to(equal(@0));
+		expect(@(linkInfo.st_ino)).to(equal(@(fileInfo.st_ino)));
+		expect(@(fileInfo.st_nlink)).to(equal(@2));
+	});
+
+	it(@"should error if the destination already exists", ^{
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:destinationURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+
+		NSError *error = nil;
+		BOOL success = [[[[SQRLFileTreeWalker alloc] initWithRootURL:rootURL] copyItemsToURL:destinationURL] asynchronouslyWaitUntilCompleted:&error];
+
+		expect(@(success)).to(beFalsy());
+		expect(error.domain).to(equal(NSPOSIXErrorDomain));
+		expect(@(error.code)).to(equal(@(EEXIST)));
+	});
+});
+
+QuickSpecEnd
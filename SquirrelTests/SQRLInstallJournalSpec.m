@@ -0,0 +1,85 @@
+//
+//  SQRLInstallJournalSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLInstallJournal.h"
+
+#import "QuickSpec+SQRLFixtures.h"
+
+QuickSpecBegin(SQRLInstallJournalSpec)
+
+__block NSURL *journalURL;
+__block SQRLInstallJournal *journal;
+
+beforeEach(^{
+	journalURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"journal"];
+	journal = [[SQRLInstallJournal alloc] initWithURL:journalURL];
+});
+
+it(@"should have no records before anything is appended", ^{
+	expect(journal.records).to(equal(@[]));
+});
+
+it(@"should read back appended records in order", ^{
+	NSError *error = nil;
+	expect(@([journal appendRecord:@{ @"step": @"first" } error:&error])).to(beTruthy());
+	expect(@([journal appendRecord:@{ @"step": @"second", @"payload": @{ @"count": @2 } } error:&error])).to(beTruthy());
+	expect(error).to(beNil());
+
+	SQRLInstallJournal *reopenedJournal = [[SQRLInstallJournal alloc] initWithURL:journalURL];
+	expect(reopenedJournal.records).to(equal(@[
+		@{ @"step": @"first" },
+		@{ @"step": @"second", @"payload": @{ @"count": @2 } },
+	]));
+});
+
+it(@"should only be readable by the owner", ^{
+	expect(@([journal appendRecord:@{ @"step": @"first" } error:NULL])).to(beTruthy());
+
+	NSDictionary *attributes = [NSFileManager.defaultManager attributesOfItemAtPath:journalURL.path error:NULL];
+	expect(attributes[NSFilePosixPermissions]).to(equal(@0600));
+});
+
+it(@"should discard a torn record and append after it", ^{
+	expect(@([journal appendRecord:@{ @"step": @"first" } error:NULL])).to(beTruthy());
+
+	NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:journalURL error:NULL];
+	[handle seekToEndOfFile];
+	[handle writeData:[@"{\"step\":\"sec" dataUsingEncoding:NSUTF8StringEncoding]];
+	[handle closeFile];
+
+	SQRLInstallJournal *reopenedJournal = [[SQRLInstallJournal alloc] initWithURL:journalURL];
+	expect(reopenedJournal.records).to(equal(@[ @{ @"step": @"first" } ]));
+
+	expect(@([reopenedJournal appendRecord:@{ @"step": @"third" } error:NULL])).to(beTruthy());
+	expect(reopenedJournal.records).to(equal(@[ @{ @"step": @"first" }, @{ @"step": @"third" } ]));
+});
+
+it(@"should fail to append a record that isn't JSON", ^{
+	NSError *error = nil;
+	expect(@([journal appendRecord:@{ @"date": NSDate.date } error:&error])).to(beFalsy());
+	expect(error.domain).to(equal(SQRLInstallJournalErrorDomain));
+	expect(@(error.code)).to(equal(@(SQRLInstallJournalErrorWritingRecord)));
+});
+
+it(@"should remove every record", ^{
+	expect(@([journal appendRecord:@{ @"step": @"first" } error:NULL])).to(beTruthy());
+
+	NSError *error = nil;
+	expect(@([journal removeJournal:&error])).to(beTruthy());
+	expect(error).to(beNil());
+	expect(journal.records).to(equal(@[]));
+
+	// Removing a journal that doesn't exist isn't an error.
+	expect(@([journal removeJournal:&error])).to(beTruthy());
+});
+
+QuickSpecEnd
@@ -0,0 +1,98 @@
+//
+//  SQRLInstallMetricsSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLFileTreeWalker.h"
+#import "SQRLInstallMetrics.h"
+#import "SQRLShipItRequest.h"
+
+#import "QuickSpec+SQRLFixtures.h"
+
+QuickSpecBegin(SQRLInstallMetricsSpec)
+
+__block SQRLInstallMetrics *metrics;
+
+beforeEach(^{
+	metrics = [[SQRLInstallMetrics alloc] init];
+});
+
+it(@"should record each phase in order", ^{
+	expect(@([[metrics measurePhase:@"first" ofSignal:[RACSignal empty]] waitUntilCompleted:NULL])).to(beTruthy());
+
+	NSError *error = [NSError errorWithDomain:@"SQRLInstallMetricsSpecErrorDomain" code:1 userInfo:nil];
+	expect(@([[metrics measurePhase:@"second" ofSignal:[RACSignal error:error]] waitUntilCompleted:NULL])).to(beFalsy());
+
+	[metrics measurePhase:@"third" usingBlock:^{}];
+
+	NSArray *phases = [metrics recordWithError:nil][@"phases"];
+	expect([phases valueForKey:@"name"]).to(equal(@[ @"first", @"second", @"third" ]));
+	expect([phases valueForKey:@"succeeded"]).to(equal(@[ @YES, @NO, @YES ]));
+
+	for (NSDictionary *phase in phases) {
+		expect(phase[@"start"]).to(beGreaterThanOrEqualTo(@0));
+		expect(phase[@"duration"]).to(beGreaterThanOrEqualTo(@0));
+	}
+});
+
+it(@"should record the counts of a walker", ^{
+	NSURL *directoryURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"walked" isDirectory:YES];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+	expect(@([[NSMutableData dataWithLength:100] writeToURL:[directoryURL URLByAppendingPathComponent:@"file"] atomically:NO])).to(beTruthy());
+
+	SQRLFileTreeWalker *walker = [[SQRLFileTreeWalker alloc] initWithRootURL:directoryURL];
+	RACSignal *visit = [walker visitItemsWithBlock:^(NSURL *itemURL, NSError **errorRef) {
+		return YES;
+	}];
+
+	expect(@([[metrics measurePhase:@"walk" ofSignal:visit countingItemsOfWalker:walker] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+
+	NSDictionary *phase = [[metrics recordWithError:nil][@"phases"] firstObject];
+	expect(phase[@"items"]).to(equal(@2));
+	expect(phase[@"bytes"]).to(equal(@100));
+});
+
+it(@"should include the request and outcome in the record", ^{
+	SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:self.testApplicationURL targetBundleURL:self.testApplicationURL bundleIdentifier:@"com.github.Squirrel.TestApplication" launchAfterInstallation:YES useUpdateBundleName:NO];
+	[metrics recordRequest:request attempt:2];
+
+	NSError *error = [NSError errorWithDomain:@"SQRLInstallMetricsSpecErrorDomain" code:5 userInfo:nil];
+	NSDictionary *record = [metrics recordWithError:error];
+
+	expect(record[@"bundleIdentifier"]).to(equal(@"com.github.Squirrel.TestApplication"));
+	expect(record[@"attempt"]).to(equal(@2));
+	expect(record[@"succeeded"]).to(equal(@NO));
+	expect(record[@"error"][@"code"]).to(equal(@5));
+	expect(@([NSJSONSerialization isValidJSONObject:record])).to(beTruthy());
+});
+
+it(@"should write records and keep only the most recent", ^{
+	NSURL *directoryURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"records" isDirectory:YES];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+
+	for (NSUInteger i = 0; i < 12; i++) {
+		NSString *name = [NSString stringWithFormat:@"%@20000101T0000%02luZ_1.json", SQRLInstallMetricsRecordFilePrefix, (unsigned long)i];
+		expect(@([[NSData data] writeToURL:[directoryURL URLByAppendingPathComponent:name] atomically:NO])).to(beTruthy());
+	}
+
+	NSError *error = nil;
+	expect(@([metrics writeRecordToDirectoryURL:directoryURL installError:nil error:&error])).to(beTruthy());
+	expect(error).to(beNil());
+
+	NSArray *names = [[NSFileManager.defaultManager contentsOfDirectoryAtPath:directoryURL.path error:NULL] sortedArrayUsingSelector:@selector(compare:)];
+	expect(@(names.count)).to(equal(@10));
+
+	NSData *data = [NSData dataWithContentsOfURL:[directoryURL URLByAppendingPathComponent:names.lastObject]];
+	NSDictionary *record = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+	expect(record[@"succeeded"]).to(equal(@YES));
+});
+
+QuickSpecEnd
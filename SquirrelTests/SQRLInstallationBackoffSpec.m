@@ -0,0 +1,143 @@
+//
+//  SQRLInstallationBackoffSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLCodeSignature.h"
+#import "SQRLInstallationBackoff.h"
+#import "SQRLInstaller.h"
+
+QuickSpecBegin(SQRLInstallationBackoffSpec)
+
+describe(@"classifying errors", ^{
+	it(@"should treat unknown errors as retryable", ^{
+		NSError *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOSPC userInfo:nil];
+		expect(@([SQRLInstallationBackoff classifyError:error])).to(equal(@(SQRLInstallationErrorRetryable)));
+
+		error = [NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorReplacingTarget userInfo:nil];
+		expect(@([SQRLInstallationBackoff classifyError:error])).to(equal(@(SQRLInstallationErrorRetryable)));
+	});
+
+	it(@"should treat permanent errors as fatal", ^{
+		NSError *error = [NSError errorWithDomain:SQRLCodeSignatureErrorDomain code:SQRLCodeSignatureErrorDidNotPass userInfo:nil];
+		expect(@([SQRLInstallationBackoff classifyError:error])).to(equal(@(SQRLInstallationErrorFatal)));
+
+		error = [NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorInvalidBundleVersion userInfo:nil];
+		expect(@([SQRLInstallationBackoff classifyError:error])).to(equal(@(SQRLInstallationErrorFatal)));
+
+		error = [NSError errorWithDomain:SQRLInstallerErrorDomain code:SQRLInstallerErrorInvalidState userInfo:nil];
+		expect(@([SQRLInstallationBackoff classifyError:error])).to(equal(@(SQRLInstallationErrorFatal)));
+	});
+
+	it(@"should look at underlying errors", ^{
+		NSError *underlyingError = [NSError errorWithDomain:SQRLCodeSignatureErrorDomain code:SQRLCodeSignatureErrorDidNotPass userInfo:nil];
+		NSError *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:@{ NSUnderlyingErrorKey: underlyingError }];
+		expect(@([SQRLInstallationBackoff classifyError:error])).to(equal(@(SQRLInstallationErrorFatal)));
+	});
+});
+
+describe(@"scheduling", ^{
+	__block NSString *applicationIdentifier;
+	__block SQRLInstallationBackoff *backoff;
+
+	beforeEach(^{
+		applicationIdentifier = [NSString stringWithFormat:@"com.github.Squirrel.SQRLInstallationBackoffSpec.%@", NSUUID.UUID.UUIDString];
+		backoff = [[SQRLInstallationBackoff alloc] initWithApplicationIdentifier:applicationIdentifier];
+		expect(backoff).notTo(beNil());
+	});
+
+	afterEach(^{
+		expect(@([backoff reset])).to(beTruthy());
+	});
+
+	it(@"should double the delay after each attempt, up to the maximum", ^{
+		backoff.initialDelay = 1;
+		backoff.maximumDelay = 5;
+		backoff.jitter = 0;
+
+		expect(@([backoff delayAfterAttempt:1])).to(equal(@1));
+		expect(@([backoff delayAfterAttempt:2])).to(equal(@2));
+		expect(@([backoff delayAfterAttempt:3])).to(equal(@4));
+		expect(@([backoff delayAfterAttempt:4])).to(equal(@5));
+		expect(@([backoff delayAfterAttempt:1000])).to(equal(@5));
+	});
+
+	it(@"should randomize delays within the jitter", ^{
+		backoff.initialDelay = 10;
+		backoff.jitter = 0.5;
+
+		NSMutableSet *delays = [NSMutableSet set];
+		for (NSUInteger i = 0; i < 100; i++) {
+			NSTimeInterval delay = [backoff delayAfterAttempt:1];
+			expect(@(delay)).to(beGreaterThanOrEqualTo(@5));
+			expect(@(delay)).to(beLessThanOrEqualTo(@15));
+
+			[delays addObject:@(delay)];
+		}
+
+		expect(@(delays.count)).to(beGreaterThan(@1));
+	});
+
+	it(@"should save the next attempt across instances", ^{
+		backoff.initialDelay = 60;
+		backoff.jitter = 0;
+
+		expect(backoff.nextAttemptDate).to(beNil());
+		expect(@([backoff scheduleRetryAfterAttempt:1])).to(beTruthy());
+
+		SQRLInstallationBackoff *otherBackoff = [[SQRLInstallationBackoff alloc] initWithApplicationIdentifier:applicationIdentifier];
+		expect(@(otherBackoff.nextAttemptDate.timeIntervalSinceNow)).to(beCloseTo(@60).within(5));
+
+		expect(@([otherBackoff reset])).to(beTruthy());
+		expect(backoff.nextAttemptDate).to(beNil());
+	});
+
+	it(@"should not wait when no attempt is scheduled", ^{
+		__block BOOL completed = NO;
+		[[backoff waitForNextAttempt] subscribeCompleted:^{
+			completed = YES;
+		}];
+
+		expect(@(completed)).to(beTruthy());
+	});
+
+	it(@"should wait until the next attempt is due", ^{
+		backoff.initialDelay = 0.5;
+		backoff.jitter = 0;
+		expect(@([backoff scheduleRetryAfterAttempt:1])).to(beTruthy());
+
+		__block BOOL completed = NO;
+		[[backoff waitForNextAttempt] subscribeCompleted:^{
+			completed = YES;
+		}];
+
+		expect(@(completed)).to(beFalsy());
+		expect(@(completed)).toEventually(beTruthy());
+	});
+
+	it(@"should not wait longer than the maximum delay", ^{
+		backoff.initialDelay = 3600;
+		backoff.maximumDelay = 3600;
+		backoff.jitter = 0;
+		expect(@([backoff scheduleRetryAfterAttempt:1])).to(beTruthy());
+
+		backoff.maximumDelay = 0.1;
+
+		__block BOOL completed = NO;
+		[[backoff waitForNextAttempt] subscribeCompleted:^{
+			completed = YES;
+		}];
+
+		expect(@(completed)).toEventually(beTruthy());
+	});
+});
+
+QuickSpecEnd
@@ -13,16 +13,22 @@
 
 #import "SQRLCodeSignature.h"
 #import "SQRLDirectoryManager.h"
+#import "SQRLInstallJournal.h"
+#import "SQRLInstallMetrics.h"
 #import "SQRLInstaller+Private.h"
 #import "SQRLInstallerOwnedBundle.h"
 #import "SQRLShipItRequest.h"
+#import "SQRLTerminationListener.h"
 
 #import "QuickSpec+SQRLFixtures.h"
 
+#import <stdio.h>
+#import <sys/stat.h>
 #import <sys/xattr.h>
 
 @interface SQRLInstaller (SQRLTestingHooks)
 - (RACSignal *)deleteOwnedBundleAtURL:(NSURL *)bundleURL;
+- (void)recordSwappedRequest:(SQRLShipItRequest *)request leftoverURLs:(NSArray *)leftoverURLs;
 @end
 
 QuickSpecBegin(SQRLInstallerSpec)
@@ -43,6 +49,10 @@ __block NSURL *updateURL;
 
 beforeEach(^{
 	updateURL = [self createTestApplicationUpdate];
+
+	// Don't resume anything journaled by an earlier example.
+	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+	expect(@([installer.journal removeJournal:NULL])).to(beTruthy());
 });
 
 it(@"should install an update using ShipIt", ^{
@@ -53,19 +63,108 @@ it(@"should install an update using ShipIt", ^{
 	expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
 });
 
-it(@"should round-trip the owned bundle through CFPreferences", ^{
+it(@"should round-trip the owned bundle through the install journal", ^{
 	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
 	SQRLInstallerOwnedBundle *original = [[SQRLInstallerOwnedBundle alloc] initWithOriginalURL:self.testApplicationURL temporaryURL:updateURL codeSignature:self.testApplicationSignature];
 
 	[installer setValue:original forKey:@"ownedBundle"];
 
-	SQRLInstallerOwnedBundle *restored = [installer valueForKey:@"ownedBundle"];
+	// A relaunched installer should see the same bundle.
+	SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+	SQRLInstallerOwnedBundle *restored = [relaunchedInstaller valueForKey:@"ownedBundle"];
 	expect(restored).notTo(beNil());
 	expect(restored.originalURL).to(equal(original.originalURL));
 	expect(restored.temporaryURL).to(equal(original.temporaryURL));
+	expect(restored.codeSignature.requirementData).to(equal(original.codeSignature.requirementData));
 
 	[installer setValue:nil forKey:@"ownedBundle"];
 	expect([installer valueForKey:@"ownedBundle"]).to(beNil());
+
+	relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+	expect([relaunchedInstaller valueForKey:@"ownedBundle"]).to(beNil());
+});
+
+it(@"should put back a target that was moved aside but never replaced", ^{
+	NSURL *targetURL = [self.testApplicationURL URLByAppendingPathComponent:@"Contents" isDirectory:YES];
+	NSURL *stagingURL = [self.testApplicationURL URLByAppendingPathComponent:@".Contents.AAAAAAAA" isDirectory:YES];
+	NSURL *asideURL = [stagingURL URLByAppendingPathComponent:@"Replaced" isDirectory:YES];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:stagingURL withIntermediateDirectories:NO attributes:@{ NSFilePosixPermissions: @0700 } error:NULL])).to(beTruthy());
+	expect(@([NSFileManager.defaultManager moveItemAtURL:targetURL toURL:asideURL error:NULL])).to(beTruthy());
+
+	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+	expect(@([installer.journal appendRecord:@{ @"step": @"staging", @"payload": @{ @"path": stagingURL.path } } error:NULL])).to(beTruthy());
+	expect(@([installer.journal appendRecord:@{ @"step": @"aside", @"payload": @{ @"targetPath": targetURL.path, @"asidePath": asideURL.path } } error:NULL])).to(beTruthy());
+
+	SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:asideURL.path])).to(beFalsy());
+	expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationOriginalShortVersionString));
+
+	expect(@([[relaunchedInstaller removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:stagingURL.path])).to(beFalsy());
+});
+
+it(@"should move an owned bundle from the preferences into the install journal", ^{
+	SQRLInstallerOwnedBundle *original = [[SQRLInstallerOwnedBundle alloc] initWithOriginalURL:self.testApplicationURL temporaryURL:updateURL codeSignature:self.testApplicationSignature];
+	NSData *archive = [NSKeyedArchiver archivedDataWithRootObject:original requiringSecureCoding:NO error:NULL];
+	expect(archive).notTo(beNil());
+
+	NSString *applicationIdentifier = self.shipItDirectoryManager.applicationIdentifier;
+	CFPreferencesSetValue((__bridge CFStringRef)SQRLInstallerOwnedBundleKey, (__bridge CFDataRef)archive, (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+	expect(@(CFPreferencesSynchronize((__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost))).to(beTruthy());
+
+	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+	expect([[installer valueForKey:@"ownedBundle"] originalURL]).to(equal(original.originalURL));
+	expect(CFBridgingRelease(CFPreferencesCopyValue((__bridge CFStringRef)SQRLInstallerOwnedBundleKey, (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost))).to(beNil());
+
+	SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+	expect([[relaunchedInstaller valueForKey:@"ownedBundle"] originalURL]).to(equal(original.originalURL));
+});
+
+it(@"should finish an install that was interrupted after replacing the target", ^{
+	SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:self.testApplicationURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+
+	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+	[installer recordSwappedRequest:request leftoverURLs:@[ updateURL ]];
+
+	SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+
+	NSError *error = nil;
+	SQRLShipItRequest *installedRequest = [[relaunchedInstaller.installUpdateCommand execute:request] asynchronousFirstOrDefault:nil success:NULL error:&error];
+	expect(installedRequest.targetBundleURL).to(equal(request.targetBundleURL));
+	expect(error).to(beNil());
+
+	// The target was never actually replaced, so this shows that installation
+	// wasn't started again.
+	expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationOriginalShortVersionString));
+
+	expect(@([[relaunchedInstaller removeLeftoverBundles] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:updateURL.path])).to(beFalsy());
+	expect(installer.journal.records).to(beEmpty());
+});
+
+it(@"should leave the replaced bundle until leftover bundles are removed", ^{
+	SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:self.testApplicationURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+
+	SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+
+	NSError *error = nil;
+	expect(@([[installer.installUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+	expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+
+	// Still tracked, so a relaunched installer would delete them too.
+	NSArray *leftoverURLs = [installer valueForKey:@"swappedLeftoverURLs"];
+	expect(leftoverURLs).notTo(beEmpty());
+	expect([[[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier] valueForKey:@"swappedLeftoverURLs"]).to(equal(leftoverURLs));
+
+	expect(@([[installer removeLeftoverBundles] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+
+	for (NSURL *leftoverURL in leftoverURLs) {
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:leftoverURL.path])).to(beFalsy());
+	}
+
+	expect(installer.journal.records).to(beEmpty());
 });
 
 it(@"should install an update in process", ^{
@@ -107,6 +206,125 @@ describe(@"with SquirrelMacEnableDirectContentsWrite enabled", ^{
 	});
 });
 
+describe(@"with SquirrelMacEnableDifferentialContentsWrite enabled", ^{
+	beforeEach(^{
+		[NSUserDefaults.standardUserDefaults setBool:YES forKey:@"SquirrelMacEnableDirectContentsWrite"];
+		[NSUserDefaults.standardUserDefaults setBool:YES forKey:@"SquirrelMacEnableDifferentialContentsWrite"];
+
+		[self addCleanupBlock:^{
+			[NSUserDefaults.standardUserDefaults removeObjectForKey:@"SquirrelMacEnableDirectContentsWrite"];
+			[NSUserDefaults.standardUserDefaults removeObjectForKey:@"SquirrelMacEnableDifferentialContentsWrite"];
+		}];
+	});
+
+	it(@"should install an update while leaving unchanged files in place", ^{
+		// PkgInfo is the same in both versions of the test application.
+		NSURL *unchangedURL = [self.testApplicationURL URLByAppendingPathComponent:@"Contents/PkgInfo"];
+		struct stat unchangedInfo;
+		expect(@(lstat(unchangedURL.fileSystemRepresentation, &unchangedInfo))).to(equal(@0));
+
+		SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:self.testApplicationURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+		[self installWithRequest:request remote:NO];
+
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+
+		struct stat installedInfo;
+		expect(@(lstat(unchangedURL.fileSystemRepresentation, &installedInfo))).to(equal(@0));
+		expect(@(installedInfo.st_ino)).to(equal(@(unchangedInfo.st_ino)));
+
+		NSError *error;
+		BOOL success = [[self.testApplicationSignature verifyBundleAtURL:self.testApplicationURL] waitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+	});
+});
+
+describe(@"terminating bundle processes", ^{
+	it(@"should leave processes running from the bundle alone by default", ^{
+		SKIP_IF_RUNNING_ON_TRAVIS
+
+		SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+		expect(@(installer.terminatesBundleProcesses)).to(beFalsy());
+
+		NSRunningApplication *app = [self launchTestApplicationWithEnvironment:nil];
+
+		// As ShipIt waits for helpers.
+		SQRLTerminationListener *listener = [[SQRLTerminationListener alloc] initWithURL:self.testApplicationURL bundleIdentifier:self.testApplicationBundle.bundleIdentifier];
+		NSError *error = nil;
+		BOOL success = [[listener waitForTerminationOfBundleProcessesWithTimeout:0.1 escalationDelay:(installer.terminatesBundleProcesses ? 1 : 0)] waitUntilCompleted:&error];
+		expect(@(success)).to(beFalsy());
+		expect(@(error.code)).to(equal(@(SQRLTerminationListenerErrorTimedOut)));
+		expect(@(app.terminated)).to(beFalsy());
+
+		[app forceTerminate];
+		expect(@(app.terminated)).toEventually(beTruthy());
+	});
+
+	it(@"should terminate them when SquirrelMacTerminateBundleProcesses is set", ^{
+		[NSUserDefaults.standardUserDefaults setBool:YES forKey:@"SquirrelMacTerminateBundleProcesses"];
+
+		[self addCleanupBlock:^{
+			[NSUserDefaults.standardUserDefaults removeObjectForKey:@"SquirrelMacTerminateBundleProcesses"];
+		}];
+
+		SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+		expect(@(installer.terminatesBundleProcesses)).to(beTruthy());
+	});
+});
+
+describe(@"with SquirrelMacEnableAtomicBundleExchange enabled", ^{
+	beforeEach(^{
+		[NSUserDefaults.standardUserDefaults setBool:YES forKey:@"SquirrelMacEnableAtomicBundleExchange"];
+
+		[self addCleanupBlock:^{
+			[NSUserDefaults.standardUserDefaults removeObjectForKey:@"SquirrelMacEnableAtomicBundleExchange"];
+		}];
+	});
+
+	it(@"should install an update by exchanging it with the target", ^{
+		SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:self.testApplicationURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+		[self installWithRequest:request remote:NO];
+
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:updateURL.path])).to(beFalsy());
+
+		NSError *error;
+		BOOL success = [[self.testApplicationSignature verifyBundleAtURL:self.testApplicationURL] waitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+	});
+
+	it(@"should restore an exchanged bundle when aborting", ^{
+		NSURL *targetURL = self.testApplicationURL;
+		NSURL *stagedURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"Staged.app"];
+		expect(@([NSFileManager.defaultManager moveItemAtURL:updateURL toURL:stagedURL error:NULL])).to(beTruthy());
+
+		struct stat targetInfo;
+		expect(@(lstat(targetURL.fileSystemRepresentation, &targetInfo))).to(equal(@0));
+
+		SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+		SQRLInstallerOwnedBundle *ownedBundle = [[SQRLInstallerOwnedBundle alloc] initWithOriginalURL:targetURL temporaryURL:stagedURL codeSignature:self.testApplicationSignature originalInode:@(targetInfo.st_ino)];
+		[installer setValue:ownedBundle forKey:@"ownedBundle"];
+
+		// Simulate being interrupted just after the exchange.
+		expect(@(renamex_np(targetURL.fileSystemRepresentation, stagedURL.fileSystemRepresentation, RENAME_SWAP))).to(equal(@0));
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+
+		NSError *error;
+		BOOL success = [[installer.abortInstallationCommand execute:nil] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationOriginalShortVersionString));
+		expect([installer valueForKey:@"ownedBundle"]).to(beNil());
+
+		// Aborting again must not swap the bundles back.
+		success = [[installer.abortInstallationCommand execute:nil] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationOriginalShortVersionString));
+	});
+});
+
 it(@"should refuse to install when the target bundle path traverses a symlink", ^{
 	NSURL *symlinkURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"symlinked.app"];
 	expect(@([NSFileManager.defaultManager createSymbolicLinkAtURL:symlinkURL withDestinationURL:self.testApplicationURL error:NULL])).to(beTruthy());
@@ -175,6 +393,38 @@ it(@"should install an update to another volume", ^{
 	expect([NSDictionary dictionaryWithContentsOfURL:plistURL][SQRLBundleShortVersionStringKey]).to(equal(SQRLTestApplicationUpdatedShortVersionString));
 });
 
+describe(@"install metrics", ^{
+	NSDictionary * (^installMeasuringPhase)(NSString *, NSURL *) = ^(NSString *phaseName, NSURL *targetURL) {
+		SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:targetURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+
+		SQRLInstaller *installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+		SQRLInstallMetrics *metrics = [[SQRLInstallMetrics alloc] init];
+		installer.metrics = metrics;
+
+		NSError *error = nil;
+		expect(@([[installer.installUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+		expect(error).to(beNil());
+
+		NSArray *phases = [metrics recordWithError:nil][@"phases"];
+		return [phases filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"name == %@", phaseName]].firstObject;
+	};
+
+	it(@"should count the items and bytes copied while preparing the update", ^{
+		NSDictionary *phase = installMeasuringPhase(@"copy", self.testApplicationURL);
+		expect(phase[@"items"]).to(beGreaterThan(@0));
+		expect(phase[@"bytes"]).to(beGreaterThan(@0));
+	});
+
+	it(@"should count the items and bytes copied while swapping across volumes", ^{
+		NSURL *diskImageURL = [self createAndMountDiskImageNamed:@"TestApplication" fromDirectory:self.testApplicationURL.URLByDeletingLastPathComponent];
+		NSURL *targetURL = [diskImageURL URLByAppendingPathComponent:self.testApplicationURL.lastPathComponent];
+
+		NSDictionary *phase = installMeasuringPhase(@"swap", targetURL);
+		expect(phase[@"items"]).to(beGreaterThan(@0));
+		expect(phase[@"bytes"]).to(beGreaterThan(@0));
+	});
+});
+
 describe(@"with backup restoration", ^{
 	__block NSURL *targetURL;
 
@@ -194,7 +444,7 @@ describe(@"with backup restoration", ^{
 		// installation.
 		NSString *applicationIdentifier = self.shipItDirectoryManager.applicationIdentifier;
 
-		CFPreferencesSetValue((__bridge CFStringRef)SQRLShipItInstallationAttemptsKey, (__bridge CFPropertyListRef)@(4), (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+		CFPreferencesSetValue((__bridge CFStringRef)SQRLShipItInstallationAttemptsKey, (__bridge CFPropertyListRef)@(6), (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
 		CFPreferencesSetValue((__bridge CFStringRef)SQRLInstallerOwnedBundleKey, (__bridge CFDataRef)ownedBundleArchive, (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
 
 		BOOL synchronized = CFPreferencesSynchronize((__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
@@ -212,6 +462,32 @@ describe(@"with backup restoration", ^{
 		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationOriginalShortVersionString));
 	});
 
+	it(@"should abort and drop the request when the update fails code signing", ^{
+		NSString *applicationIdentifier = self.shipItDirectoryManager.applicationIdentifier;
+		CFPreferencesSetValue((__bridge CFStringRef)SQRLShipItInstallationAttemptsKey, (__bridge CFPropertyListRef)@(1), (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+		expect(@(CFPreferencesSynchronize((__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost))).to(beTruthy());
+
+		NSURL *executableURL = [NSBundle bundleWithURL:updateURL].executableURL;
+		expect(@([[@"corrupt" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:executableURL atomically:YES])).to(beTruthy());
+
+		SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:targetURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+		[self installWithRequest:request remote:YES];
+
+		// The bundle owned by the interrupted attempt has been put back.
+		__block NSError *error;
+		expect(@([[self.testApplicationSignature verifyBundleAtURL:targetURL] waitUntilCompleted:&error])).to(beTruthy());
+		expect(error).to(beNil());
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationOriginalShortVersionString));
+
+		SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+		expect([relaunchedInstaller valueForKey:@"ownedBundle"]).to(beNil());
+
+		// Without a retry pending.
+		CFPreferencesSynchronize((__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost);
+		id attempts = CFBridgingRelease(CFPreferencesCopyValue((__bridge CFStringRef)SQRLShipItInstallationAttemptsKey, (__bridge CFStringRef)applicationIdentifier, kCFPreferencesCurrentUser, kCFPreferencesCurrentHost));
+		expect(attempts).to(beNil());
+	});
+
 	it(@"should relaunch even after failing to install an update", ^{
 		SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:targetURL bundleIdentifier:nil launchAfterInstallation:YES useUpdateBundleName:NO];
 		[self installWithRequest:request remote:YES];
@@ -311,6 +587,94 @@ describe(@"signal handling", ^{
 	});
 });
 
+describe(@"prepareUpdateCommand", ^{
+	__block SQRLInstaller *installer;
+	__block SQRLShipItRequest *request;
+
+	beforeEach(^{
+		installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+		request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:updateURL targetBundleURL:self.testApplicationURL bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+
+		NSError *error = nil;
+		BOOL success = [[installer.prepareUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+	});
+
+	it(@"should install the prepared update without preparing it again", ^{
+		// If the update were prepared again, it would be copied from here.
+		expect(@([NSFileManager.defaultManager removeItemAtURL:updateURL error:NULL])).to(beTruthy());
+
+		NSError *error = nil;
+		BOOL success = [[installer.installUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+	});
+
+	it(@"should prepare the update again if the prepared update was made writable", ^{
+		NSURL *stagedURL = [installer valueForKey:@"stagedUpdateBundleURL"];
+		expect(stagedURL).notTo(beNil());
+
+		NSString *command = [NSString stringWithFormat:@"chmod -R 0777 '%@'", stagedURL.path];
+		expect(@(system(command.UTF8String))).to(equal(@0));
+
+		NSError *error = nil;
+		BOOL success = [[installer.installUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+		expect(@(modeOfURL(self.testApplicationURL))).to(equal(@0755));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:stagedURL.path])).to(beFalsy());
+	});
+
+	it(@"should not prepare the update again after relaunching", ^{
+		NSURL *stagedURL = [installer valueForKey:@"stagedUpdateBundleURL"];
+		expect(stagedURL).notTo(beNil());
+
+		// If the update were prepared again, it would be copied from here.
+		expect(@([NSFileManager.defaultManager removeItemAtURL:updateURL error:NULL])).to(beTruthy());
+
+		SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+
+		NSError *error = nil;
+		BOOL success = [[relaunchedInstaller.prepareUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+
+		expect([relaunchedInstaller valueForKey:@"stagedUpdateBundleURL"]).to(equal(stagedURL));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:stagedURL.path])).to(beTruthy());
+
+		success = [[relaunchedInstaller.installUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+	});
+
+	it(@"should remove an unusable prepared update before preparing it again after relaunching", ^{
+		NSURL *stagedURL = [installer valueForKey:@"stagedUpdateBundleURL"];
+		expect(stagedURL).notTo(beNil());
+
+		NSString *command = [NSString stringWithFormat:@"chmod -R 0777 '%@'", stagedURL.path];
+		expect(@(system(command.UTF8String))).to(equal(@0));
+
+		SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:self.shipItDirectoryManager.applicationIdentifier];
+
+		NSError *error = nil;
+		BOOL success = [[relaunchedInstaller.prepareUpdateCommand execute:request] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+
+		NSURL *preparedAgainURL = [relaunchedInstaller valueForKey:@"stagedUpdateBundleURL"];
+		expect(preparedAgainURL).notTo(beNil());
+		expect(preparedAgainURL).notTo(equal(stagedURL));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:stagedURL.path])).to(beFalsy());
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:preparedAgainURL.path])).to(beTruthy());
+	});
+});
+
 describe(@"-deleteOwnedBundleAtURL:", ^{
 	__block SQRLInstaller *installer;
 	__block NSURL *parentURL;
@@ -361,4 +725,98 @@ describe(@"-deleteOwnedBundleAtURL:", ^{
 	});
 });
 
+describe(@"-removeLeakedTemporaryDirectoriesWithTimeout:", ^{
+	__block NSString *applicationIdentifier;
+	__block SQRLInstaller *installer;
+
+	NSURL * (^createOwnedDirectory)(void) = ^{
+		NSString *template = [[NSTemporaryDirectory() stringByResolvingSymlinksInPath] stringByAppendingPathComponent:[applicationIdentifier stringByAppendingString:@".XXXXXXXX"]];
+		char *path = strdup(template.fileSystemRepresentation);
+		expect(@(mkdtemp(path) != NULL)).to(beTruthy());
+
+		NSURL *URL = [NSURL fileURLWithPath:@(path) isDirectory:YES];
+		free(path);
+
+		[self addCleanupBlock:^{
+			[NSFileManager.defaultManager removeItemAtURL:URL error:NULL];
+		}];
+
+		return URL;
+	};
+
+	beforeEach(^{
+		applicationIdentifier = [NSString stringWithFormat:@"com.github.SquirrelTests.%@", NSProcessInfo.processInfo.globallyUniqueString];
+		installer = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+
+		[self addCleanupBlock:^{
+			[installer.journal removeJournal:NULL];
+		}];
+	});
+
+	it(@"should remove unreferenced directories and report the bytes reclaimed", ^{
+		NSURL *leakedURL = createOwnedDirectory();
+		expect(@([[NSMutableData dataWithLength:1000] writeToURL:[leakedURL URLByAppendingPathComponent:@"file"] atomically:NO])).to(beTruthy());
+
+		NSError *error = nil;
+		NSNumber *byteCount = [[installer removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronousFirstOrDefault:nil success:NULL error:&error];
+		expect(byteCount).to(equal(@1000));
+		expect(error).to(beNil());
+
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:leakedURL.path])).to(beFalsy());
+	});
+
+	it(@"should keep the directory of the owned bundle", ^{
+		NSURL *ownedURL = createOwnedDirectory();
+		NSURL *bundleURL = [ownedURL URLByAppendingPathComponent:@"TestApplication.app" isDirectory:YES];
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:bundleURL withIntermediateDirectories:NO attributes:nil error:NULL])).to(beTruthy());
+
+		SQRLInstallerOwnedBundle *ownedBundle = [[SQRLInstallerOwnedBundle alloc] initWithOriginalURL:self.testApplicationURL temporaryURL:bundleURL codeSignature:self.testApplicationSignature];
+		[installer setValue:ownedBundle forKey:@"ownedBundle"];
+
+		NSNumber *byteCount = [[installer removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+		expect(byteCount).to(equal(@0));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:bundleURL.path])).to(beTruthy());
+	});
+
+	it(@"should remove staging directories journaled by an interrupted copy across volumes", ^{
+		NSURL *stagingURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@".Contents.AAAAAAAA" isDirectory:YES];
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:[stagingURL URLByAppendingPathComponent:@"Contents"] withIntermediateDirectories:YES attributes:@{ NSFilePosixPermissions: @0700 } error:NULL])).to(beTruthy());
+		expect(@([installer.journal appendRecord:@{ @"step": @"staging", @"payload": @{ @"path": stagingURL.path } } error:NULL])).to(beTruthy());
+
+		SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+		expect(@([[relaunchedInstaller removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:stagingURL.path])).to(beFalsy());
+	});
+
+	it(@"should keep a journaled staging directory holding a target that was moved aside", ^{
+		NSURL *stagingURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@".Contents.AAAAAAAA" isDirectory:YES];
+		NSURL *asideURL = [stagingURL URLByAppendingPathComponent:@"Replaced" isDirectory:YES];
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:asideURL withIntermediateDirectories:YES attributes:@{ NSFilePosixPermissions: @0700 } error:NULL])).to(beTruthy());
+		expect(@([installer.journal appendRecord:@{ @"step": @"staging", @"payload": @{ @"path": stagingURL.path } } error:NULL])).to(beTruthy());
+
+		SQRLInstaller *relaunchedInstaller = [[SQRLInstaller alloc] initWithApplicationIdentifier:applicationIdentifier];
+		expect(@([[relaunchedInstaller removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:asideURL.path])).to(beTruthy());
+
+		// Once the target is back in place, the staging directory is only
+		// leftovers.
+		NSURL *targetURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"Contents" isDirectory:YES];
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:targetURL withIntermediateDirectories:NO attributes:nil error:NULL])).to(beTruthy());
+
+		expect(@([[relaunchedInstaller removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:stagingURL.path])).to(beFalsy());
+	});
+
+	it(@"should ignore directories that don't match the template", ^{
+		NSURL *otherURL = [NSURL fileURLWithPath:[[NSTemporaryDirectory() stringByResolvingSymlinksInPath] stringByAppendingPathComponent:[applicationIdentifier stringByAppendingString:@".Helper"]] isDirectory:YES];
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:otherURL withIntermediateDirectories:NO attributes:@{ NSFilePosixPermissions: @0700 } error:NULL])).to(beTruthy());
+		[self addCleanupBlock:^{
+			[NSFileManager.defaultManager removeItemAtURL:otherURL error:NULL];
+		}];
+
+		expect(@([[installer removeLeakedTemporaryDirectoriesWithTimeout:SQRLLongTimeout] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:otherURL.path])).to(beTruthy());
+	});
+});
+
 QuickSpecEnd
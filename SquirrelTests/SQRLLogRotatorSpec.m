@@ -0,0 +1,148 @@
+//
+//  SQRLLogRotatorSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+#import <zlib.h>
+
+#import "QuickSpec+SQRLFixtures.h"
+#import "SQRLLogRotator.h"
+
+QuickSpecBegin(SQRLLogRotatorSpec)
+
+__block NSURL *logURL;
+__block SQRLLogRotator *rotator;
+
+beforeEach(^{
+	logURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"ShipIt_stdout.log"];
+	rotator = [[SQRLLogRotator alloc] initWithLogURL:logURL];
+});
+
+// Appends a line to the given file, as launchd would.
+void (^appendLine)(NSURL *, NSString *) = ^(NSURL *URL, NSString *line) {
+	if (![NSFileManager.defaultManager fileExistsAtPath:URL.path]) {
+		expect(@([NSData.data writeToURL:URL atomically:NO])).to(beTruthy());
+	}
+
+	NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:URL error:NULL];
+	expect(handle).notTo(beNil());
+
+	[handle seekToEndOfFile];
+	[handle writeData:[[line stringByAppendingString:@"\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+	[handle closeFile];
+};
+
+// Decompresses a rotated segment, or returns nil if it doesn't exist.
+NSString * (^readSegment)(NSURL *) = ^ NSString * (NSURL *URL) {
+	gzFile file = gzopen(URL.path.fileSystemRepresentation, "rb");
+	if (file == NULL) return nil;
+
+	NSMutableData *data = [NSMutableData data];
+	char buffer[4096];
+	int count;
+	while ((count = gzread(file, buffer, sizeof(buffer))) > 0) {
+		[data appendBytes:buffer length:(NSUInteger)count];
+	}
+
+	gzclose(file);
+	return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+};
+
+void (^rotate)(void) = ^{
+	NSError *error = nil;
+	expect(@([[rotator rotate] waitUntilCompleted:&error])).to(beTruthy());
+	expect(error).to(beNil());
+};
+
+it(@"should compress the log into the newest segment and remove it", ^{
+	appendLine(logURL, @"installing");
+
+	rotate();
+
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:logURL.path])).to(beFalsy());
+	expect(readSegment([rotator URLForGeneration:1])).to(equal(@"installing\n"));
+});
+
+it(@"should not rotate an empty or missing log", ^{
+	rotate();
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[rotator URLForGeneration:1].path])).to(beFalsy());
+
+	expect(@([NSData.data writeToURL:logURL atomically:NO])).to(beTruthy());
+	rotate();
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[rotator URLForGeneration:1].path])).to(beFalsy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:logURL.path])).to(beTruthy());
+});
+
+it(@"should renumber older segments", ^{
+	appendLine(logURL, @"first");
+	rotate();
+
+	appendLine(logURL, @"second");
+	rotate();
+
+	expect(readSegment([rotator URLForGeneration:1])).to(equal(@"second\n"));
+	expect(readSegment([rotator URLForGeneration:2])).to(equal(@"first\n"));
+});
+
+it(@"should keep a bounded number of segments", ^{
+	rotator.maximumGenerations = 3;
+
+	for (NSUInteger i = 0; i < 5; i++) {
+		appendLine(logURL, [NSString stringWithFormat:@"run %lu", (unsigned long)i]);
+		rotate();
+	}
+
+	expect(readSegment([rotator URLForGeneration:1])).to(equal(@"run 4\n"));
+	expect(readSegment([rotator URLForGeneration:3])).to(equal(@"run 2\n"));
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[rotator URLForGeneration:4].path])).to(beFalsy());
+});
+
+it(@"should only keep the end of large segments", ^{
+	rotator.maximumSegmentSize = 100;
+
+	for (NSUInteger i = 0; i < 100; i++) {
+		appendLine(logURL, [NSString stringWithFormat:@"line %03lu", (unsigned long)i]);
+	}
+
+	rotate();
+
+	NSString *segment = readSegment([rotator URLForGeneration:1]);
+	expect(segment).to(beginWith(@"["));
+	expect(segment).to(contain(@"discarded"));
+	expect(segment).to(endWith(@"line 099\n"));
+	expect(segment).notTo(contain(@"line 000"));
+});
+
+it(@"should rotate numbered logs left when the log wasn't writable", ^{
+	NSURL *fallbackURL = [logURL URLByAppendingPathExtension:@"1"];
+	appendLine(fallbackURL, @"fallback");
+
+	// Make sure the log itself is newer.
+	[NSFileManager.defaultManager setAttributes:@{ NSFileModificationDate: [NSDate dateWithTimeIntervalSinceNow:-60] } ofItemAtPath:fallbackURL.path error:NULL];
+	appendLine(logURL, @"current");
+
+	rotate();
+
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:fallbackURL.path])).to(beFalsy());
+	expect(readSegment([rotator URLForGeneration:1])).to(equal(@"current\n"));
+	expect(readSegment([rotator URLForGeneration:2])).to(equal(@"fallback\n"));
+});
+
+it(@"should leave unrelated files alone", ^{
+	NSURL *otherURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"ShipIt_stderr.log"];
+	appendLine(otherURL, @"error");
+	appendLine(logURL, @"output");
+
+	rotate();
+
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:otherURL.path])).to(beTruthy());
+});
+
+QuickSpecEnd
@@ -0,0 +1,28 @@
+//
+//  SQRLProcessStatisticsSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+
+#import "SQRLProcessStatistics.h"
+
+QuickSpecBegin(SQRLProcessStatisticsSpec)
+
+it(@"should measure the time since the process launched", ^{
+	NSTimeInterval first = SQRLProcessTimeSinceLaunch();
+	expect(@(first)).to(beGreaterThan(@0));
+
+	[NSThread sleepForTimeInterval:0.01];
+	expect(@(SQRLProcessTimeSinceLaunch())).to(beGreaterThan(@(first)));
+});
+
+it(@"should measure the resident size of the process", ^{
+	expect(@(SQRLProcessResidentSize())).to(beGreaterThan(@0));
+});
+
+QuickSpecEnd
@@ -0,0 +1,292 @@
+//
+//  SQRLReleaseFeedScannerSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <Squirrel/Squirrel.h>
+#import <malloc/malloc.h>
+
+#import "SQRLReleaseFeedScanner.h"
+
+QuickSpecBegin(SQRLReleaseFeedScannerSpec)
+
+NSData * (^feedData)(id) = ^(id feed) {
+	return [NSJSONSerialization dataWithJSONObject:feed options:0 error:NULL];
+};
+
+NSData * (^stringData)(NSString *) = ^(NSString *string) {
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+};
+
+id (^JSONObject)(NSData *) = ^(NSData *data) {
+	return [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:NULL];
+};
+
+describe(@"scanning", ^{
+	__block NSString *currentRelease;
+	__block NSData *updateData;
+	__block NSError *error;
+
+	beforeEach(^{
+		currentRelease = nil;
+		updateData = nil;
+		error = nil;
+	});
+
+	it(@"should find the current release and its update", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feedData(@{
+			@"currentRelease": @"1.1.0",
+			@"releases": @[
+				@{ @"version": @"1.0.0", @"updateTo": @{ @"url": @"http://fake/1.0.0.zip" } },
+				@{ @"version": @"1.1.0", @"updateTo": @{ @"url": @"http://fake/1.1.0.zip", @"notes": @[ @"[a]", @{ @"b": @"}" } ] } },
+			],
+		})];
+
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(currentRelease).to(equal(@"1.1.0"));
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{ @"url": @"http://fake/1.1.0.zip", @"notes": @[ @"[a]", @{ @"b": @"}" } ] }));
+		expect(error).to(beNil());
+	});
+
+	it(@"should skip a UTF-8 byte order mark", ^{
+		NSMutableData *data = [NSMutableData dataWithBytes:"\xEF\xBB\xBF" length:3];
+		[data appendData:stringData(@"{\"currentRelease\":\"1.0\",\"releases\":[{\"version\":\"1.0\",\"updateTo\":{\"url\":\"http://fake/1.0.zip\"}}]}")];
+
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:data];
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(currentRelease).to(equal(@"1.0"));
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{ @"url": @"http://fake/1.0.zip" }));
+		expect(error).to(beNil());
+	});
+
+	it(@"should scan feeds in UTF-16", ^{
+		NSString *feed = @"{\"currentRelease\":\"1.0\",\"releases\":[{\"version\":\"1.0\",\"updateTo\":{\"url\":\"http://fake/1.0.zip\"}}]}";
+
+		for (NSNumber *encoding in @[ @(NSUTF16StringEncoding), @(NSUTF16LittleEndianStringEncoding), @(NSUTF16BigEndianStringEncoding) ]) {
+			SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:[feed dataUsingEncoding:encoding.unsignedIntegerValue]];
+			expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+			expect(currentRelease).to(equal(@"1.0"));
+
+			expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+			expect(JSONObject(updateData)).to(equal(@{ @"url": @"http://fake/1.0.zip" }));
+			expect(error).to(beNil());
+		}
+	});
+
+	it(@"should find the current release after the releases", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:stringData(@" { \"releases\" : [ { \"updateTo\" : { \"url\" : \"http://fake/2.zip\" } , \"version\" : \"2.0\" } ] , \"other\" : [ true, null, -1.5e3 ] , \"currentRelease\" : \"2.0\" } ")];
+
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(currentRelease).to(equal(@"2.0"));
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{ @"url": @"http://fake/2.zip" }));
+	});
+
+	it(@"should decode escaped strings", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:stringData(@"{\"current\\u0052elease\":\"1.0\\u002d\\\"beta\\\"\",\"releases\":[{\"version\":\"1.0-\\\"beta\\\"\",\"updateTo\":{\"name\":\"\\\\\"}}]}")];
+
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(currentRelease).to(equal(@"1.0-\"beta\""));
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{ @"name": @"\\" }));
+	});
+
+	it(@"should use the first listing of a release", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feedData(@{
+			@"releases": @[
+				@{ @"version": @"1.0", @"updateTo": @{ @"url": @"http://fake/first.zip" } },
+				@{ @"version": @"1.0", @"updateTo": @{ @"url": @"http://fake/second.zip" } },
+			],
+		})];
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:@"1.0" error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{ @"url": @"http://fake/first.zip" }));
+	});
+
+	it(@"should not find a release that isn't listed", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feedData(@{
+			@"currentRelease": @"3.0",
+			@"releases": @[ @"not a release", @{ @"version": @"2.0", @"updateTo": @{} }, @{ @"version": @3 } ],
+		})];
+
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(updateData).to(beNil());
+		expect(error).to(beNil());
+	});
+
+	it(@"should find the next check hint without losing the releases", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:stringData(@"{\"currentRelease\":\"1.0\",\"releases\":[{\"version\":\"1.0\",\"updateTo\":{}}],\"nextCheckAfter\":3600}")];
+
+		id nextCheckAfter = nil;
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(@([scanner scanNextCheckAfter:&nextCheckAfter error:&error])).to(beTruthy());
+		expect(nextCheckAfter).to(equal(@3600));
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{}));
+
+		scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feedData(@{ @"currentRelease": @"1.0" })];
+		expect(@([scanner scanNextCheckAfter:&nextCheckAfter error:&error])).to(beTruthy());
+		expect(nextCheckAfter).to(beNil());
+	});
+
+	it(@"should treat a missing or non-string current release as nil", ^{
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feedData(@{ @"currentRelease": @[ @"1.0" ] })];
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(currentRelease).to(beNil());
+
+		scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feedData(@{ @"releases": @{} })];
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(currentRelease).to(beNil());
+
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:@"1.0" error:&error])).to(beTruthy());
+		expect(updateData).to(beNil());
+	});
+
+	it(@"should stop scanning once it has found the update", ^{
+		// Everything after the matching release is garbage, which a full
+		// parse would reject.
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:stringData(@"{\"currentRelease\":\"1.0\",\"releases\":[{\"version\":\"1.0\",\"updateTo\":{\"url\":\"http://fake/1.0.zip\"}}, this is not JSON")];
+
+		expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beTruthy());
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:&error])).to(beTruthy());
+		expect(JSONObject(updateData)).to(equal(@{ @"url": @"http://fake/1.0.zip" }));
+	});
+
+	it(@"should error on invalid JSON", ^{
+		for (NSString *invalidFeed in @[ @"", @"[]", @"{\"currentRelease\":", @"{\"a\":\"unterminated}", @"{\"a\":1 \"currentRelease\":\"1.0\"}", @"{\"a\":{\"b\":[1,2}" ]) {
+			SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:stringData(invalidFeed)];
+
+			error = nil;
+			expect(@([scanner scanCurrentRelease:&currentRelease error:&error])).to(beFalsy());
+			expect(error.domain).to(equal(NSCocoaErrorDomain));
+			expect(@(error.code)).to(equal(@(NSPropertyListReadCorruptError)));
+		}
+
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:stringData(@"{\"releases\":[{\"version\":\"1.0\"} {}]}")];
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:@"2.0" error:&error])).to(beFalsy());
+		expect(error).notTo(beNil());
+	});
+});
+
+describe(@"benchmark", ^{
+	const NSUInteger releaseCount = 20000;
+
+	__block NSData *currentFirstFeed;
+	__block NSData *currentLastFeed;
+
+	beforeEach(^{
+		NSString *notes = [@"" stringByPaddingToLength:200 withString:@"Fixed a bug. " startingAtIndex:0];
+
+		NSMutableArray *releases = [NSMutableArray arrayWithCapacity:releaseCount];
+		for (NSUInteger i = 0; i < releaseCount; i++) {
+			NSString *version = [NSString stringWithFormat:@"%lu.%lu.%lu", (unsigned long)(i / 1000), (unsigned long)(i / 10 % 100), (unsigned long)(i % 10)];
+			[releases addObject:@{
+				@"version": version,
+				@"updateTo": @{
+					@"version": version,
+					@"url": [NSString stringWithFormat:@"https://fake/app-%@.zip", version],
+					@"notes": notes,
+					@"pub_date": @"2026-10-18T00:00:00Z",
+				},
+			}];
+		}
+
+		// Feeds are usually oldest first, so the latest release is at the end.
+		NSData *releasesData = feedData(releases);
+		NSData *currentReleaseData = stringData(@"\"currentRelease\":\"19.99.9\"");
+
+		NSMutableData *data = [stringData(@"{") mutableCopy];
+		[data appendData:currentReleaseData];
+		[data appendData:stringData(@",\"releases\":")];
+		[data appendData:releasesData];
+		[data appendData:stringData(@"}")];
+		currentFirstFeed = data;
+
+		data = [stringData(@"{\"releases\":") mutableCopy];
+		[data appendData:releasesData];
+		[data appendData:stringData(@",")];
+		[data appendData:currentReleaseData];
+		[data appendData:stringData(@"}")];
+		currentLastFeed = data;
+	});
+
+	// Runs the block in an autorelease pool, and logs how long it took and how
+	// much was still allocated at its end, before the pool drained.
+	//
+	// Returns the number of milliseconds taken.
+	double (^measure)(NSString *, NSData *, void (^)(NSData *)) = ^(NSString *name, NSData *feed, void (^block)(NSData *)) {
+		malloc_statistics_t before, after;
+		uint64_t start, end;
+
+		@autoreleasepool {
+			malloc_zone_statistics(NULL, &before);
+			start = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+
+			block(feed);
+
+			end = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+			malloc_zone_statistics(NULL, &after);
+		}
+
+		double milliseconds = (end - start) / (double)NSEC_PER_MSEC;
+		NSLog(@"%@ over %.1fMB: %.2fms, %ld blocks and %ldKB still allocated", name, feed.length / 1048576.0, milliseconds, (long)after.blocks_in_use - (long)before.blocks_in_use, ((long)after.size_in_use - (long)before.size_in_use) / 1024);
+
+		return milliseconds;
+	};
+
+	void (^parse)(NSData *) = ^(NSData *feed) {
+		NSDictionary *dict = [NSJSONSerialization JSONObjectWithData:feed options:0 error:NULL];
+		NSString *currentRelease = dict[@"currentRelease"];
+
+		NSData *updateData = nil;
+		for (NSDictionary *release in dict[@"releases"]) {
+			if (![release[@"version"] isEqual:currentRelease]) continue;
+
+			updateData = [NSJSONSerialization dataWithJSONObject:release[@"updateTo"] options:0 error:NULL];
+			break;
+		}
+
+		expect(updateData).notTo(beNil());
+	};
+
+	void (^scan)(NSData *) = ^(NSData *feed) {
+		SQRLReleaseFeedScanner *scanner = [[SQRLReleaseFeedScanner alloc] initWithData:feed];
+
+		NSString *currentRelease = nil;
+		NSData *updateData = nil;
+		expect(@([scanner scanCurrentRelease:&currentRelease error:NULL])).to(beTruthy());
+		expect(@([scanner scanUpdateData:&updateData forReleaseVersion:currentRelease error:NULL])).to(beTruthy());
+		expect(updateData).notTo(beNil());
+	};
+
+	// Set SQRL_RELEASE_FEED_SCAN_BUDGET_MS to fail when scanning either feed
+	// takes longer than that.
+	it(@"should scan a large feed faster than parsing it", ^{
+		measure(@"Parsing, current release first", currentFirstFeed, parse);
+		double currentFirstMS = measure(@"Scanning, current release first", currentFirstFeed, scan);
+
+		measure(@"Parsing, current release last", currentLastFeed, parse);
+		double currentLastMS = measure(@"Scanning, current release last", currentLastFeed, scan);
+
+		NSString *budgetString = NSProcessInfo.processInfo.environment[@"SQRL_RELEASE_FEED_SCAN_BUDGET_MS"];
+		if (budgetString != nil) {
+			expect(@(currentFirstMS)).to(beLessThanOrEqualTo(@(budgetString.doubleValue)));
+			expect(@(currentLastMS)).to(beLessThanOrEqualTo(@(budgetString.doubleValue)));
+		}
+	});
+});
+
+QuickSpecEnd
@@ -0,0 +1,89 @@
+//
+//  SQRLRolloutSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <Squirrel/Squirrel.h>
+
+#import "SQRLRollout.h"
+
+QuickSpecBegin(SQRLRolloutSpec)
+
+__block NSString *suiteName;
+__block NSUserDefaults *userDefaults;
+__block SQRLRollout *rollout;
+
+beforeEach(^{
+	suiteName = [@"com.github.Squirrel.SQRLRolloutSpec." stringByAppendingString:NSProcessInfo.processInfo.globallyUniqueString];
+	userDefaults = [[NSUserDefaults alloc] initWithSuiteName:suiteName];
+	rollout = [[SQRLRollout alloc] initWithUserDefaults:userDefaults];
+});
+
+afterEach(^{
+	[userDefaults removePersistentDomainForName:suiteName];
+});
+
+it(@"should create and keep an install identifier", ^{
+	NSString *identifier = rollout.installIdentifier;
+	expect(identifier).notTo(beNil());
+	expect(rollout.installIdentifier).to(equal(identifier));
+	expect([[SQRLRollout alloc] initWithUserDefaults:userDefaults].installIdentifier).to(equal(identifier));
+});
+
+it(@"should keep an install in the same bucket for a release", ^{
+	double bucket = [rollout bucketForVersion:@"1.2.3"];
+	expect(@(bucket)).to(beGreaterThanOrEqualTo(@0));
+	expect(@(bucket)).to(beLessThan(@100));
+
+	expect(@([[[SQRLRollout alloc] initWithUserDefaults:userDefaults] bucketForVersion:@"1.2.3"])).to(equal(@(bucket)));
+});
+
+it(@"should stay included as the percentage is raised", ^{
+	double bucket = [rollout bucketForVersion:@"1.2.3"];
+
+	expect(@([rollout includesVersion:@"1.2.3" rolloutPercentage:bucket])).to(beFalsy());
+	expect(@([rollout includesVersion:@"1.2.3" rolloutPercentage:bucket + 0.01])).to(beTruthy());
+	expect(@([rollout includesVersion:@"1.2.3" rolloutPercentage:100])).to(beTruthy());
+});
+
+it(@"should include nobody at 0% and everybody at 100%", ^{
+	for (NSUInteger i = 0; i < 100; i++) {
+		NSString *version = [NSString stringWithFormat:@"1.0.%lu", (unsigned long)i];
+		expect(@([rollout includesVersion:version rolloutPercentage:0])).to(beFalsy());
+		expect(@([rollout includesVersion:version rolloutPercentage:-5])).to(beFalsy());
+		expect(@([rollout includesVersion:version rolloutPercentage:100])).to(beTruthy());
+	}
+});
+
+it(@"should spread installs evenly, and differently for each release", ^{
+	const NSUInteger installCount = 10000;
+
+	NSUInteger includedInFirst = 0;
+	NSUInteger includedInSecond = 0;
+	NSUInteger includedInBoth = 0;
+
+	for (NSUInteger i = 0; i < installCount; i++) {
+		[userDefaults removeObjectForKey:@"SQRLRolloutInstallIdentifier"];
+
+		BOOL first = [rollout includesVersion:@"2.0.0" rolloutPercentage:10];
+		BOOL second = [rollout includesVersion:@"2.0.1" rolloutPercentage:10];
+
+		includedInFirst += first;
+		includedInSecond += second;
+		includedInBoth += (first && second);
+	}
+
+	// 10% of installs, give or take a few standard deviations.
+	expect(@(includedInFirst)).to(beCloseTo(@1000).within(120));
+	expect(@(includedInSecond)).to(beCloseTo(@1000).within(120));
+
+	// If the buckets were the same for every release, these would be equal.
+	expect(@(includedInBoth)).to(beCloseTo(@100).within(50));
+});
+
+QuickSpecEnd
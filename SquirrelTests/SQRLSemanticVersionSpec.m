@@ -0,0 +1,372 @@
+//
+//  SQRLSemanticVersionSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <Squirrel/Squirrel.h>
+#import <malloc/malloc.h>
+
+#import "SQRLSemanticVersion.h"
+
+QuickSpecBegin(SQRLSemanticVersionSpec)
+
+BOOL (^parse)(NSString *, SQRLSemanticVersionOptions) = ^(NSString *string, SQRLSemanticVersionOptions options) {
+	char buffer[SQRLSemanticVersionMaximumStringLength];
+	return SQRLSemanticVersionParseString(string, options, NULL, buffer);
+};
+
+NSComparisonResult (^compare)(NSString *, NSString *) = ^(NSString *version, NSString *otherVersion) {
+	return SQRLSemanticVersionCompareStrings(version, otherVersion);
+};
+
+describe(@"parsing", ^{
+	it(@"should accept valid semantic versions", ^{
+		NSArray *versions = @[
+			@"0.0.4", @"1.2.3", @"10.20.30", @"1.1.2-prerelease+meta", @"1.1.2+meta",
+			@"1.1.2+meta-valid", @"1.0.0-alpha", @"1.0.0-alpha.beta.1", @"1.0.0-alpha0.valid",
+			@"1.0.0-alpha.0valid", @"1.0.0-alpha-a.b-c-somethinglong+build.1-aef.1-its-okay",
+			@"2.0.0-rc.1+build.123", @"10.2.3-DEV-SNAPSHOT", @"1.0.0+0.build.1-rc.10000aaa-kk-0.1",
+			@"99999999999999999.999999999999999999.99999999999999999", @"1.0.0-0A.is.legal",
+		];
+
+		for (NSString *version in versions) {
+			expect(@(parse(version, SQRLSemanticVersionOptionsStrict))).to(beTruthy());
+		}
+	});
+
+	it(@"should reject invalid semantic versions", ^{
+		NSArray *versions = @[
+			@"", @"1", @"1.2", @"1.2.3.4", @"v1.2.3", @"01.1.1", @"1.01.1", @"1.1.01",
+			@"1.2.3-0123", @"1.2.3-0123.0123", @"1.1.2+.123", @"+invalid", @"-invalid",
+			@"alpha", @"1.2.3.DEV", @"1.2-SNAPSHOT", @"9.8.7+meta+meta", @"1.2.3-", @"1.2.3+",
+			@"1.2.3-a..b", @"1.2.3-beta_1", @"1.2.3 ", @"1.2.3-bêta",
+			@"99999999999999999999999.999999999999999999.99999999999999999",
+		];
+
+		for (NSString *version in versions) {
+			expect(@(parse(version, SQRLSemanticVersionOptionsStrict))).to(beFalsy());
+		}
+	});
+
+	it(@"should accept common variations when parsing leniently", ^{
+		for (NSString *version in @[ @"v1.2.3", @"V1.2.3", @"1", @"1.2", @"01.02.03", @"1.2.3-beta.01" ]) {
+			expect(@(parse(version, SQRLSemanticVersionOptionsStrict))).to(beFalsy());
+			expect(@(parse(version, SQRLSemanticVersionOptionsLenient))).to(beTruthy());
+		}
+
+		expect(@(parse(@"1.2.3.4", SQRLSemanticVersionOptionsLenient))).to(beFalsy());
+		expect(@(parse(@"1.", SQRLSemanticVersionOptionsLenient))).to(beFalsy());
+	});
+
+	it(@"should only accept leading zeroes when asked to", ^{
+		for (NSString *version in @[ @"01.02.03", @"1.02.3", @"1.2.3-beta.01" ]) {
+			expect(@(parse(version, SQRLSemanticVersionOptionsStrict))).to(beFalsy());
+			expect(@(parse(version, SQRLSemanticVersionOptionsLeadingZeroes))).to(beTruthy());
+		}
+
+		for (NSString *version in @[ @"v1.2.3", @"1", @"1.2" ]) {
+			expect(@(parse(version, SQRLSemanticVersionOptionsLeadingZeroes))).to(beFalsy());
+		}
+	});
+
+	it(@"should parse each part of a version", ^{
+		const char *string = "1.22.333-rc.1+build.5";
+
+		SQRLSemanticVersion version;
+		expect(@(SQRLSemanticVersionParse(string, strlen(string), SQRLSemanticVersionOptionsStrict, &version))).to(beTruthy());
+		expect(@(version.major)).to(equal(@1));
+		expect(@(version.minor)).to(equal(@22));
+		expect(@(version.patch)).to(equal(@333));
+		expect([[NSString alloc] initWithBytes:version.prerelease length:version.prereleaseLength encoding:NSUTF8StringEncoding]).to(equal(@"rc.1"));
+		expect([[NSString alloc] initWithBytes:version.build length:version.buildLength encoding:NSUTF8StringEncoding]).to(equal(@"build.5"));
+	});
+
+	it(@"should fill in missing numbers with zero when parsing leniently", ^{
+		const char *string = "v7";
+
+		SQRLSemanticVersion version;
+		expect(@(SQRLSemanticVersionParse(string, strlen(string), SQRLSemanticVersionOptionsLenient, &version))).to(beTruthy());
+		expect(@(version.major)).to(equal(@7));
+		expect(@(version.minor)).to(equal(@0));
+		expect(@(version.patch)).to(equal(@0));
+		expect(@(version.prereleaseLength)).to(equal(@0));
+	});
+
+	it(@"should only parse the given length", ^{
+		SQRLSemanticVersion version;
+		expect(@(SQRLSemanticVersionParse("1.2.3garbage", 5, SQRLSemanticVersionOptionsStrict, &version))).to(beTruthy());
+		expect(@(version.patch)).to(equal(@3));
+	});
+
+	it(@"should reject strings too long to copy", ^{
+		NSString *prerelease = [@"" stringByPaddingToLength:SQRLSemanticVersionMaximumStringLength withString:@"a" startingAtIndex:0];
+		expect(@(parse([@"1.2.3-" stringByAppendingString:prerelease], SQRLSemanticVersionOptionsStrict))).to(beFalsy());
+	});
+});
+
+describe(@"ordering", ^{
+	it(@"should follow the precedence in the specification", ^{
+		NSArray *versions = @[
+			@"1.0.0-alpha", @"1.0.0-alpha.1", @"1.0.0-alpha.beta", @"1.0.0-beta", @"1.0.0-beta.2",
+			@"1.0.0-beta.9", @"1.0.0-beta.10", @"1.0.0-beta.11", @"1.0.0-rc.1", @"1.0.0",
+			@"1.0.1", @"1.9.0", @"1.10.0", @"2.0.0",
+		];
+
+		for (NSUInteger i = 0; i < versions.count; i++) {
+			for (NSUInteger j = 0; j < versions.count; j++) {
+				NSComparisonResult expected = (i < j ? NSOrderedAscending : (i > j ? NSOrderedDescending : NSOrderedSame));
+				expect(@(compare(versions[i], versions[j]))).to(equal(@(expected)));
+			}
+		}
+	});
+
+	it(@"should ignore build metadata", ^{
+		expect(@(compare(@"1.0.0+abc", @"1.0.0+def"))).to(equal(@(NSOrderedSame)));
+		expect(@(compare(@"1.0.0-rc.1+abc", @"1.0.0-rc.1"))).to(equal(@(NSOrderedSame)));
+	});
+
+	it(@"should compare numeric identifiers of any length", ^{
+		expect(@(compare(@"1.0.0-99999999999999999999999", @"1.0.0-100000000000000000000000"))).to(equal(@(NSOrderedAscending)));
+		expect(@(compare(@"1.0.0-beta.01", @"1.0.0-beta.1"))).to(equal(@(NSOrderedSame)));
+	});
+
+	it(@"should order leniently parsed versions like their strict forms", ^{
+		expect(@(compare(@"v1.2.3", @"1.2.3"))).to(equal(@(NSOrderedSame)));
+		expect(@(compare(@"1.2", @"1.2.0"))).to(equal(@(NSOrderedSame)));
+		expect(@(compare(@"1.10", @"1.9.9"))).to(equal(@(NSOrderedDescending)));
+	});
+
+	it(@"should order strings that aren't versions before versions", ^{
+		expect(@(compare(@"nightly", @"0.0.1"))).to(equal(@(NSOrderedAscending)));
+		expect(@(compare(@"0.0.1", @"nightly"))).to(equal(@(NSOrderedDescending)));
+		expect(@(compare(@"1.2.3.10", @"1.2.3.9"))).to(equal(@(NSOrderedDescending)));
+	});
+});
+
+describe(@"properties", ^{
+	const NSUInteger sampleCount = 2000;
+
+	__block NSArray *versions;
+
+	// A simple generator, so that failures can be reproduced.
+	__block uint64_t state;
+	uint32_t (^nextRandom)(uint32_t) = ^(uint32_t upperBound) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (uint32_t)(state >> 33) % upperBound;
+	};
+
+	NSString * (^generateIdentifier)(void) = ^{
+		NSArray *words = @[ @"alpha", @"beta", @"rc", @"a", @"b-c", @"0a", @"x1" ];
+		if (nextRandom(2) == 0) return [NSString stringWithFormat:@"%u", nextRandom(12)];
+		return words[nextRandom((uint32_t)words.count)];
+	};
+
+	// Returns the parts of a generated version, as the major, minor and patch
+	// numbers, then the array of prerelease identifiers, then the build
+	// metadata.
+	NSArray * (^generate)(void) = ^{
+		NSMutableArray *prerelease = [NSMutableArray array];
+		if (nextRandom(2) == 0) {
+			NSUInteger count = nextRandom(3) + 1;
+			for (NSUInteger i = 0; i < count; i++) {
+				[prerelease addObject:generateIdentifier()];
+			}
+		}
+
+		NSString *build = (nextRandom(4) == 0 ? [NSString stringWithFormat:@"build.%u", nextRandom(100)] : @"");
+		return @[ @(nextRandom(3)), @(nextRandom(3)), @(nextRandom(12)), prerelease, build ];
+	};
+
+	NSString * (^format)(NSArray *) = ^(NSArray *parts) {
+		NSMutableString *string = [NSMutableString stringWithFormat:@"%@.%@.%@", parts[0], parts[1], parts[2]];
+		if ([parts[3] count] > 0) [string appendFormat:@"-%@", [parts[3] componentsJoinedByString:@"."]];
+		if ([parts[4] length] > 0) [string appendFormat:@"+%@", parts[4]];
+		return string;
+	};
+
+	// A straightforward model of the specification, to check the parser
+	// against.
+	NSComparisonResult (^modelCompare)(NSArray *, NSArray *) = ^(NSArray *parts, NSArray *otherParts) {
+		for (NSUInteger i = 0; i < 3; i++) {
+			NSComparisonResult result = [parts[i] compare:otherParts[i]];
+			if (result != NSOrderedSame) return result;
+		}
+
+		NSArray *prerelease = parts[3];
+		NSArray *otherPrerelease = otherParts[3];
+		if (prerelease.count == 0 || otherPrerelease.count == 0) return [@(otherPrerelease.count) compare:@(prerelease.count)];
+
+		NSCharacterSet *nonDigits = NSCharacterSet.decimalDigitCharacterSet.invertedSet;
+		for (NSUInteger i = 0; i < MIN(prerelease.count, otherPrerelease.count); i++) {
+			NSString *identifier = prerelease[i];
+			NSString *otherIdentifier = otherPrerelease[i];
+
+			BOOL numeric = [identifier rangeOfCharacterFromSet:nonDigits].location == NSNotFound;
+			BOOL otherNumeric = [otherIdentifier rangeOfCharacterFromSet:nonDigits].location == NSNotFound;
+
+			NSComparisonResult result;
+			if (numeric && otherNumeric) {
+				result = [@(identifier.integerValue) compare:@(otherIdentifier.integerValue)];
+			} else if (numeric != otherNumeric) {
+				result = (numeric ? NSOrderedAscending : NSOrderedDescending);
+			} else {
+				result = [identifier compare:otherIdentifier options:NSLiteralSearch];
+			}
+
+			if (result != NSOrderedSame) return result;
+		}
+
+		return [@(prerelease.count) compare:@(otherPrerelease.count)];
+	};
+
+	__block NSArray *samples;
+
+	beforeEach(^{
+		state = 0x5351524cULL;
+
+		NSMutableArray *generatedSamples = [NSMutableArray arrayWithCapacity:sampleCount];
+		NSMutableArray *generatedVersions = [NSMutableArray arrayWithCapacity:sampleCount];
+		for (NSUInteger i = 0; i < sampleCount; i++) {
+			NSArray *parts = generate();
+			[generatedSamples addObject:parts];
+			[generatedVersions addObject:format(parts)];
+		}
+
+		samples = generatedSamples;
+		versions = generatedVersions;
+	});
+
+	it(@"should parse every generated version strictly", ^{
+		for (NSString *version in versions) {
+			expect(@(parse(version, SQRLSemanticVersionOptionsStrict))).to(beTruthy());
+		}
+	});
+
+	it(@"should agree with the model of the specification", ^{
+		for (NSUInteger i = 0; i + 1 < sampleCount; i++) {
+			NSComparisonResult expected = modelCompare(samples[i], samples[i + 1]);
+			expect(@(compare(versions[i], versions[i + 1]))).to(equal(@(expected)));
+		}
+	});
+
+	it(@"should be reflexive and antisymmetric", ^{
+		for (NSUInteger i = 0; i + 1 < sampleCount; i++) {
+			expect(@(compare(versions[i], versions[i]))).to(equal(@(NSOrderedSame)));
+			expect(@(compare(versions[i], versions[i + 1]))).to(equal(@(-compare(versions[i + 1], versions[i]))));
+		}
+	});
+
+	it(@"should be transitive", ^{
+		NSArray *sorted = [versions sortedArrayUsingComparator:^(NSString *version, NSString *otherVersion) {
+			return compare(version, otherVersion);
+		}];
+
+		// With a total order, every version after another in the sorted list
+		// must be at least as new, not just its neighbours.
+		for (NSUInteger i = 0; i < 200; i++) {
+			NSUInteger first = nextRandom((uint32_t)sampleCount);
+			NSUInteger second = nextRandom((uint32_t)sampleCount);
+			if (first > second) {
+				NSUInteger swap = first;
+				first = second;
+				second = swap;
+			}
+
+			expect(@(compare(sorted[first], sorted[second]))).notTo(equal(@(NSOrderedDescending)));
+		}
+	});
+
+	it(@"should ignore build metadata for any version", ^{
+		for (NSString *version in versions) {
+			if ([version rangeOfString:@"+"].location != NSNotFound) continue;
+
+			expect(@(compare(version, [version stringByAppendingString:@"+build.1"]))).to(equal(@(NSOrderedSame)));
+		}
+	});
+});
+
+describe(@"benchmark", ^{
+	const NSUInteger comparisonCount = 200000;
+
+	__block NSArray *versions;
+
+	beforeEach(^{
+		NSMutableArray *generatedVersions = [NSMutableArray arrayWithCapacity:1000];
+		for (NSUInteger i = 0; i < 1000; i++) {
+			NSString *version = [NSString stringWithFormat:@"%lu.%lu.%lu", (unsigned long)(i / 100), (unsigned long)(i / 10 % 10), (unsigned long)(i % 10)];
+			if (i % 3 == 0) version = [version stringByAppendingFormat:@"-beta.%lu", (unsigned long)(i % 17)];
+
+			[generatedVersions addObject:version];
+		}
+
+		versions = generatedVersions;
+	});
+
+	// Runs the comparator over pairs of versions in an autorelease pool, and
+	// logs how long it took and how much was still allocated at its end,
+	// before the pool drained.
+	//
+	// Returns the number of milliseconds taken.
+	double (^measure)(NSString *, NSComparisonResult (^)(NSString *, NSString *)) = ^(NSString *name, NSComparisonResult (^comparator)(NSString *, NSString *)) {
+		malloc_statistics_t before, after;
+		uint64_t start, end;
+		NSInteger total = 0;
+
+		@autoreleasepool {
+			malloc_zone_statistics(NULL, &before);
+			start = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+
+			for (NSUInteger i = 0; i < comparisonCount; i++) {
+				total += comparator(versions[i % versions.count], versions[(i * 7 + 3) % versions.count]);
+			}
+
+			end = clock_gettime_nsec_np(CLOCK_MONOTONIC_RAW);
+			malloc_zone_statistics(NULL, &after);
+		}
+
+		double milliseconds = (end - start) / (double)NSEC_PER_MSEC;
+		NSLog(@"%@ for %lu comparisons: %.2fms, %ld blocks and %ldKB still allocated (checksum %ld)", name, (unsigned long)comparisonCount, milliseconds, (long)after.blocks_in_use - (long)before.blocks_in_use, ((long)after.size_in_use - (long)before.size_in_use) / 1024, (long)total);
+
+		return milliseconds;
+	};
+
+	// How versions were compared before, splitting off the prerelease and
+	// comparing with NSNumericSearch.
+	NSComparisonResult (^numericSearch)(NSString *, NSString *) = ^(NSString *version, NSString *otherVersion) {
+		NSRange dashRange = [version rangeOfString:@"-"];
+		NSRange otherDashRange = [otherVersion rangeOfString:@"-"];
+
+		NSString *core = (dashRange.location == NSNotFound ? version : [version substringToIndex:dashRange.location]);
+		NSString *otherCore = (otherDashRange.location == NSNotFound ? otherVersion : [otherVersion substringToIndex:otherDashRange.location]);
+
+		NSComparisonResult result = [core compare:otherCore options:NSNumericSearch];
+		if (result != NSOrderedSame) return result;
+
+		if (dashRange.location == NSNotFound && otherDashRange.location == NSNotFound) return NSOrderedSame;
+		if (dashRange.location == NSNotFound) return NSOrderedDescending;
+		if (otherDashRange.location == NSNotFound) return NSOrderedAscending;
+
+		return [[version substringFromIndex:NSMaxRange(dashRange)] compare:[otherVersion substringFromIndex:NSMaxRange(otherDashRange)] options:NSNumericSearch];
+	};
+
+	// Set SQRL_SEMANTIC_VERSION_COMPARE_BUDGET_MS to fail when the comparisons
+	// take longer than that.
+	it(@"should compare versions without allocating", ^{
+		measure(@"NSNumericSearch", numericSearch);
+		double milliseconds = measure(@"SQRLSemanticVersionCompareStrings", ^(NSString *version, NSString *otherVersion) {
+			return SQRLSemanticVersionCompareStrings(version, otherVersion);
+		});
+
+		NSString *budgetString = NSProcessInfo.processInfo.environment[@"SQRL_SEMANTIC_VERSION_COMPARE_BUDGET_MS"];
+		if (budgetString != nil) {
+			expect(@(milliseconds)).to(beLessThanOrEqualTo(@(budgetString.doubleValue)));
+		}
+	});
+});
+
+QuickSpecEnd
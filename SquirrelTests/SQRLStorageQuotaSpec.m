@@ -0,0 +1,200 @@
+//
+//  SQRLStorageQuotaSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+#import <sys/time.h>
+
+#import "QuickSpec+SQRLFixtures.h"
+#import "SQRLStorageQuota.h"
+
+QuickSpecBegin(SQRLStorageQuotaSpec)
+
+__block NSURL *storageURL;
+
+beforeEach(^{
+	storageURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"storage"];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:storageURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+});
+
+// Creates an item in the storage directory, containing `size` bytes, which was
+// last used `age` seconds ago.
+//
+// Items named like update directories are created as directories, and others
+// as files.
+NSURL * (^createItem)(NSString *, NSUInteger, NSTimeInterval) = ^(NSString *name, NSUInteger size, NSTimeInterval age) {
+	NSURL *itemURL = [storageURL URLByAppendingPathComponent:name];
+	NSURL *fileURL = itemURL;
+
+	if ([SQRLStorageQuota artifactClassForItemNamed:name] == SQRLStorageArtifactClassUpdate) {
+		expect(@([NSFileManager.defaultManager createDirectoryAtURL:itemURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+		fileURL = [itemURL URLByAppendingPathComponent:@"TestApplication.zip"];
+	}
+
+	expect(@([[NSMutableData dataWithLength:size] writeToURL:fileURL atomically:NO])).to(beTruthy());
+
+	struct timeval times[2];
+	gettimeofday(&times[0], NULL);
+	times[0].tv_sec -= (time_t)age;
+	times[1] = times[0];
+
+	expect(@(utimes(fileURL.path.fileSystemRepresentation, times))).to(equal(@0));
+	expect(@(utimes(itemURL.path.fileSystemRepresentation, times))).to(equal(@0));
+
+	return itemURL;
+};
+
+NSArray * (^remainingNames)(void) = ^{
+	NSArray *contents = [NSFileManager.defaultManager contentsOfDirectoryAtPath:storageURL.path error:NULL];
+	return [contents sortedArrayUsingSelector:@selector(compare:)];
+};
+
+it(@"should classify items by name", ^{
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"update.Ab3dE9x"])).to(equal(@(SQRLStorageArtifactClassUpdate)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"Trash"])).to(equal(@(SQRLStorageArtifactClassUpdate)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"ShipIt_stdout.log.1.gz"])).to(equal(@(SQRLStorageArtifactClassLog)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"ShipIt_stderr.log.2.gz"])).to(equal(@(SQRLStorageArtifactClassLog)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"ShipIt_stdout.log"])).to(equal(@(SQRLStorageArtifactClassOther)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"ShipIt_stderr.log"])).to(equal(@(SQRLStorageArtifactClassOther)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"ShipIt_stderr.log.2"])).to(equal(@(SQRLStorageArtifactClassOther)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"ShipItState.plist"])).to(equal(@(SQRLStorageArtifactClassOther)));
+	expect(@([SQRLStorageQuota artifactClassForItemNamed:@"UpdateCheck.lock"])).to(equal(@(SQRLStorageArtifactClassOther)));
+});
+
+it(@"should measure usage for each kind of item", ^{
+	createItem(@"update.AAAAAAA", 3000, 0);
+	createItem(@"update.BBBBBBB", 2000, 0);
+	createItem(@"ShipIt_stdout.log", 500, 0);
+	createItem(@"ShipIt_stderr.log.1.gz", 250, 0);
+	createItem(@"ShipItState.plist", 100, 0);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:0];
+
+	NSError *error = nil;
+	BOOL success = NO;
+	NSDictionary *usage = [[quota usage] asynchronousFirstOrDefault:nil success:&success error:&error];
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+
+	expect(usage).to(equal((@{
+		@(SQRLStorageArtifactClassUpdate): @5000,
+		@(SQRLStorageArtifactClassLog): @250,
+		@(SQRLStorageArtifactClassOther): @600,
+	})));
+});
+
+it(@"should not evict anything within the maximum", ^{
+	createItem(@"update.AAAAAAA", 3000, 100);
+	createItem(@"ShipIt_stdout.log", 500, 200);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:3500];
+
+	NSError *error = nil;
+	NSArray *evicted = [[[quota evictProtectingURLs:[RACSignal return:@[]]] collect] asynchronousFirstOrDefault:nil success:NULL error:&error];
+	expect(evicted).to(equal(@[]));
+	expect(error).to(beNil());
+	expect(remainingNames()).to(equal((@[ @"ShipIt_stdout.log", @"update.AAAAAAA" ])));
+});
+
+it(@"should not look for protected items unless something needs evicting", ^{
+	createItem(@"update.AAAAAAA", 3000, 100);
+
+	__block BOOL subscribed = NO;
+	RACSignal *protectedURLs = [RACSignal defer:^{
+		subscribed = YES;
+		return [RACSignal return:@[]];
+	}];
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:3500];
+	expect(@([[quota evictProtectingURLs:protectedURLs] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+	expect(@(subscribed)).to(beFalsy());
+});
+
+it(@"should not evict anything without a maximum", ^{
+	createItem(@"update.AAAAAAA", 3000, 100);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:0];
+	expect(@([[quota evictProtectingURLs:[RACSignal return:@[]]] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+	expect(remainingNames()).to(equal(@[ @"update.AAAAAAA" ]));
+});
+
+it(@"should evict the least recently used items until within the maximum", ^{
+	NSURL *oldestURL = createItem(@"update.AAAAAAA", 3000, 300);
+	NSURL *olderURL = createItem(@"ShipIt_stdout.log.1.gz", 1000, 200);
+	createItem(@"update.BBBBBBB", 3000, 100);
+	createItem(@"ShipIt_stdout.log", 1000, 0);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:4000];
+
+	NSError *error = nil;
+	NSArray *evicted = [[[quota evictProtectingURLs:[RACSignal return:@[]]] collect] asynchronousFirstOrDefault:nil success:NULL error:&error];
+	expect(error).to(beNil());
+	expect([evicted valueForKey:@"lastPathComponent"]).to(equal((@[ oldestURL.lastPathComponent, olderURL.lastPathComponent ])));
+	expect(remainingNames()).to(equal((@[ @"ShipIt_stdout.log", @"update.BBBBBBB" ])));
+});
+
+it(@"should count recently read items as recently used", ^{
+	NSURL *readURL = createItem(@"update.AAAAAAA", 3000, 300);
+	createItem(@"update.BBBBBBB", 3000, 100);
+
+	NSURL *fileURL = [readURL URLByAppendingPathComponent:@"TestApplication.zip"];
+	struct timeval times[2];
+	gettimeofday(&times[0], NULL);
+	times[1] = times[0];
+	times[1].tv_sec -= 300;
+	expect(@(utimes(fileURL.path.fileSystemRepresentation, times))).to(equal(@0));
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:3000];
+	expect(@([[quota evictProtectingURLs:[RACSignal return:@[]]] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+	expect(remainingNames()).to(equal(@[ @"update.AAAAAAA" ]));
+});
+
+it(@"should never evict the item containing a protected URL", ^{
+	NSURL *stagedURL = createItem(@"update.AAAAAAA", 3000, 300);
+	createItem(@"update.BBBBBBB", 3000, 100);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:1000];
+
+	NSURL *protectedURL = [stagedURL URLByAppendingPathComponent:@"TestApplication.app"];
+	expect(@([[quota evictProtectingURLs:[RACSignal return:@[ protectedURL ]]] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+
+	// The staged update is still over the maximum on its own, but must be
+	// kept.
+	expect(remainingNames()).to(equal(@[ @"update.AAAAAAA" ]));
+});
+
+it(@"should never evict other items", ^{
+	createItem(@"ShipItState.plist", 2000, 300);
+	createItem(@"ShipIt_stdout.log.1.gz", 1000, 100);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:500];
+	expect(@([[quota evictProtectingURLs:[RACSignal return:@[]]] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+	expect(remainingNames()).to(equal(@[ @"ShipItState.plist" ]));
+});
+
+it(@"should never evict the logs ShipIt is writing to", ^{
+	createItem(@"ShipIt_stdout.log", 1000, 300);
+	createItem(@"ShipIt_stderr.log.1", 1000, 300);
+	createItem(@"ShipIt_stderr.log.1.gz", 1000, 100);
+
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:storageURL maximumSize:500];
+	expect(@([[quota evictProtectingURLs:[RACSignal return:@[]]] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+	expect(remainingNames()).to(equal((@[ @"ShipIt_stderr.log.1", @"ShipIt_stdout.log" ])));
+});
+
+it(@"should error if the storage directory can't be read", ^{
+	SQRLStorageQuota *quota = [[SQRLStorageQuota alloc] initWithStorageURL:[storageURL URLByAppendingPathComponent:@"missing"] maximumSize:1];
+
+	NSError *error = nil;
+	expect(@([[quota evictProtectingURLs:[RACSignal return:@[]]] asynchronouslyWaitUntilCompleted:&error])).to(beFalsy());
+	expect(error).notTo(beNil());
+});
+
+QuickSpecEnd
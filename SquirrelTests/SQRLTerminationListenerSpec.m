@@ -76,4 +76,83 @@ it(@"should wait until multiple instances terminate", ^{
 	expect(@(completed)).toEventually(beTruthy());
 });
 
+describe(@"waiting for bundle processes", ^{
+	it(@"should complete immediately when nothing is running from the bundle", ^{
+		NSError *error = nil;
+		BOOL success = [[listener waitForTerminationOfBundleProcessesWithTimeout:1 escalationDelay:0] waitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+	});
+
+	it(@"should error when processes are still running after the timeout", ^{
+		SKIP_IF_RUNNING_ON_TRAVIS
+
+		NSRunningApplication *app = [self launchTestApplicationWithEnvironment:nil];
+
+		NSError *error = nil;
+		BOOL success = [[listener waitForTerminationOfBundleProcessesWithTimeout:0.1 escalationDelay:0] waitUntilCompleted:&error];
+		expect(@(success)).to(beFalsy());
+		expect(error.domain).to(equal(SQRLTerminationListenerErrorDomain));
+		expect(@(error.code)).to(equal(@(SQRLTerminationListenerErrorTimedOut)));
+		expect(error.userInfo[SQRLTerminationListenerRunningProcessIdentifiersErrorKey]).to(contain(@(app.processIdentifier)));
+		expect(@(app.terminated)).to(beFalsy());
+
+		[app forceTerminate];
+		expect(@(app.terminated)).toEventually(beTruthy());
+	});
+
+	it(@"should signal processes that are still running after the timeout", ^{
+		SKIP_IF_RUNNING_ON_TRAVIS
+
+		NSRunningApplication *app = [self launchTestApplicationWithEnvironment:nil];
+
+		NSError *error = nil;
+		NSArray *exits = [[[listener waitForTerminationOfBundleProcessesWithTimeout:0.1 escalationDelay:5] collect] asynchronousFirstOrDefault:nil success:NULL error:&error];
+		expect(error).to(beNil());
+		expect(@(app.terminated)).toEventually(beTruthy());
+
+		NSDictionary *exit = [exits filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"%K == %@", SQRLTerminationListenerProcessIdentifierKey, @(app.processIdentifier)]].firstObject;
+		expect(exit).notTo(beNil());
+		expect(exit[SQRLTerminationListenerSignalKey]).notTo(equal(@0));
+		expect(exit[SQRLTerminationListenerDurationKey]).to(beGreaterThanOrEqualTo(@0.1));
+		expect(exit[SQRLTerminationListenerExecutablePathKey]).to(equal(app.executableURL.URLByResolvingSymlinksInPath.path));
+	});
+
+	it(@"should leave alone processes owned by other users", ^{
+		SKIP_IF_RUNNING_ON_TRAVIS
+
+		NSRunningApplication *app = [self launchTestApplicationWithEnvironment:nil];
+
+		// As if the application that exited belonged to someone else.
+		[listener setValue:[NSSet setWithObject:@(getuid() + 1)] forKey:@"applicationUserIdentifiers"];
+
+		NSError *error = nil;
+		BOOL success = [[listener waitForTerminationOfBundleProcessesWithTimeout:0.1 escalationDelay:1] waitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+		expect(@(app.terminated)).to(beFalsy());
+
+		[app forceTerminate];
+		expect(@(app.terminated)).toEventually(beTruthy());
+	});
+
+	it(@"should report processes that exit by themselves", ^{
+		SKIP_IF_RUNNING_ON_TRAVIS
+
+		NSRunningApplication *app = [self launchTestApplicationWithEnvironment:nil];
+
+		__block NSDictionary *exit = nil;
+		__block BOOL completed = NO;
+		[[listener waitForTerminationOfBundleProcessesWithTimeout:30 escalationDelay:0] subscribeNext:^(NSDictionary *x) {
+			if ([x[SQRLTerminationListenerProcessIdentifierKey] isEqual:@(app.processIdentifier)]) exit = x;
+		} completed:^{
+			completed = YES;
+		}];
+
+		[app forceTerminate];
+		expect(exit[SQRLTerminationListenerSignalKey]).toEventually(equal(@0));
+		expect(@(completed)).toEventually(beTruthy());
+	});
+});
+
 QuickSpecEnd
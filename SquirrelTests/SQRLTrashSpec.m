@@ -0,0 +1,122 @@
+//
+//  SQRLTrashSpec.m
+//  Squirrel
+//
+//  Created by agent on 2026-10-18.
+//  Copyright (c) 2026 GitHub. All rights reserved.
+//
+
+#import <Nimble/Nimble.h>
+#import <Quick/Quick.h>
+#import <ReactiveObjC/ReactiveObjC.h>
+#import <Squirrel/Squirrel.h>
+
+#import "QuickSpec+SQRLFixtures.h"
+#import "SQRLTrash.h"
+
+QuickSpecBegin(SQRLTrashSpec)
+
+__block NSURL *storageURL;
+__block SQRLTrash *trash;
+
+beforeEach(^{
+	storageURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"storage"];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:storageURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+
+	trash = [[SQRLTrash alloc] initWithStorageURL:storageURL];
+});
+
+// Creates an update directory in the storage directory with the given number
+// of files in it.
+NSURL * (^createUpdateDirectory)(NSString *, NSUInteger) = ^(NSString *name, NSUInteger fileCount) {
+	NSURL *directoryURL = [storageURL URLByAppendingPathComponent:name];
+	NSURL *contentsURL = [directoryURL URLByAppendingPathComponent:@"TestApplication.app/Contents/Resources"];
+	expect(@([NSFileManager.defaultManager createDirectoryAtURL:contentsURL withIntermediateDirectories:YES attributes:nil error:NULL])).to(beTruthy());
+
+	for (NSUInteger i = 0; i < fileCount; i++) {
+		NSURL *fileURL = [contentsURL URLByAppendingPathComponent:[NSString stringWithFormat:@"%lu.dat", (unsigned long)i]];
+		expect(@([NSData.data writeToURL:fileURL atomically:NO])).to(beTruthy());
+	}
+
+	return directoryURL;
+};
+
+NSArray * (^trashContents)(void) = ^{
+	return [NSFileManager.defaultManager contentsOfDirectoryAtURL:trash.trashURL includingPropertiesForKeys:nil options:0 error:NULL] ?: @[];
+};
+
+it(@"should keep its trash in the storage directory", ^{
+	expect(trash.trashURL.URLByDeletingLastPathComponent.path).to(equal(storageURL.path));
+	expect(trash.trashURL.lastPathComponent).to(equal(SQRLTrashDirectoryName));
+});
+
+it(@"should move items into the trash", ^{
+	NSURL *directoryURL = createUpdateDirectory(@"update.AAAAAAA", 3);
+
+	NSError *error = nil;
+	NSURL *trashedURL = [[trash trashItemAtURL:directoryURL] firstOrDefault:nil success:NULL error:&error];
+	expect(trashedURL).notTo(beNil());
+	expect(error).to(beNil());
+
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:directoryURL.path])).to(beFalsy());
+	expect(@([NSFileManager.defaultManager fileExistsAtPath:[trashedURL URLByAppendingPathComponent:@"TestApplication.app/Contents/Resources/2.dat"].path])).to(beTruthy());
+	expect(trashedURL.URLByDeletingLastPathComponent.path).to(equal(trash.trashURL.path));
+});
+
+it(@"should trash items with the same name more than once", ^{
+	NSURL *directoryURL = createUpdateDirectory(@"update.AAAAAAA", 1);
+	expect(@([[trash trashItemAtURL:directoryURL] waitUntilCompleted:NULL])).to(beTruthy());
+
+	createUpdateDirectory(@"update.AAAAAAA", 1);
+	expect(@([[trash trashItemAtURL:directoryURL] waitUntilCompleted:NULL])).to(beTruthy());
+
+	expect(@(trashContents().count)).to(equal(@2));
+});
+
+it(@"should error if the item can't be moved", ^{
+	NSError *error = nil;
+	BOOL success = [[trash trashItemAtURL:[storageURL URLByAppendingPathComponent:@"update.MISSING"]] waitUntilCompleted:&error];
+	expect(@(success)).to(beFalsy());
+	expect(error.domain).to(equal(NSPOSIXErrorDomain));
+	expect(@(error.code)).to(equal(@(ENOENT)));
+});
+
+it(@"should delete everything in the trash", ^{
+	for (NSUInteger i = 0; i < 3; i++) {
+		NSURL *directoryURL = createUpdateDirectory([NSString stringWithFormat:@"update.%lu", (unsigned long)i], 10);
+		expect(@([[trash trashItemAtURL:directoryURL] waitUntilCompleted:NULL])).to(beTruthy());
+	}
+
+	NSError *error = nil;
+	BOOL success = NO;
+	NSNumber *emptied = [[trash emptyWithTimeBudget:60] asynchronousFirstOrDefault:nil success:&success error:&error];
+	expect(@(success)).to(beTruthy());
+	expect(error).to(beNil());
+
+	expect(emptied).to(equal(@YES));
+	expect(trashContents()).to(equal(@[]));
+});
+
+it(@"should be empty if nothing was ever trashed", ^{
+	NSNumber *emptied = [[trash emptyWithTimeBudget:60] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect(emptied).to(equal(@YES));
+});
+
+it(@"should stop deleting once the time budget runs out, and finish later", ^{
+	for (NSUInteger i = 0; i < 5; i++) {
+		NSURL *directoryURL = createUpdateDirectory([NSString stringWithFormat:@"update.%lu", (unsigned long)i], 500);
+		expect(@([[trash trashItemAtURL:directoryURL] waitUntilCompleted:NULL])).to(beTruthy());
+	}
+
+	// However much was deleted in that time, the trash must only be reported
+	// as empty if it is.
+	NSNumber *emptied = [[trash emptyWithTimeBudget:0.001] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect(emptied).notTo(beNil());
+	if (emptied.boolValue) expect(trashContents()).to(equal(@[]));
+
+	emptied = [[trash emptyWithTimeBudget:60] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+	expect(emptied).to(equal(@YES));
+	expect(trashContents()).to(equal(@[]));
+});
+
+QuickSpecEnd
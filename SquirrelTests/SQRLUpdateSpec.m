@@ -43,6 +43,24 @@ it(@"should validate release name and notes", ^{
 	expect(update.releaseNotes).to(beNil());
 });
 
+it(@"should parse the release version and update digest", ^{
+	SQRLUpdate *update = [MTLJSONAdapter modelOfClass:SQRLUpdate.class fromJSONDictionary:@{ @"url": @"http://example.com/update", @"version": @"1.2.3", @"sha256": @"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" } error:NULL];
+	expect(update.releaseVersion).to(equal(@"1.2.3"));
+	expect(update.updateSHA256).to(equal(@"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+});
+
+it(@"should validate release version and update digest", ^{
+	SQRLUpdate *update = [[SQRLUpdate alloc] initWithDictionary:@{
+		@"updateURL": [NSURL URLWithString:@"http://example.com/update"],
+		@"releaseVersion": @5,
+		@"updateSHA256": @[]
+	} error:NULL];
+
+	expect(update).notTo(beNil());
+	expect(update.releaseVersion).to(beNil());
+	expect(update.updateSHA256).to(beNil());
+});
+
 it(@"should parse Central style dates", ^{
 	SQRLUpdate *update = [MTLJSONAdapter modelOfClass:SQRLUpdate.class fromJSONDictionary:@{ @"url": @"http://example.com/update", @"pub_date": @"Tue Sep 17 10:24:27 -0700 2013" } error:NULL];
 	expect(update.releaseDate).to(equal([NSDate dateWithTimeIntervalSince1970:1379438667]));
@@ -11,8 +11,11 @@
 #import <ReactiveObjC/ReactiveObjC.h>
 #import <Squirrel/Squirrel.h>
 
+#import "SQRLCBORSerialization.h"
+#import "SQRLCheckLease.h"
 #import "SQRLDirectoryManager.h"
 #import "SQRLShipItLauncher.h"
+#import "SQRLShipItRequest.h"
 #import "SQRLUpdater.h"
 #import "SQRLZipArchiver.h"
 
@@ -24,6 +27,9 @@
 
 @interface SQRLUpdater (SQRLTestingHooks)
 - (RACSignal *)removeUpdateDirectoriesInStorageURL:(NSURL *)storageURL excludingURL:(NSURL *)excludedURL;
+- (RACSignal *)leadCheck:(RACSignal *)check withLease:(SQRLCheckLease *)lease;
+- (RACSignal *)uniqueTemporaryDirectoryForUpdate;
+- (RACSignal *)enforceStorageQuota;
 @property (nonatomic, strong, readonly) RACSignal *shipItLauncher;
 @end
 
@@ -257,6 +263,144 @@ describe(@"checkForUpdatesCommand", ^{
 		expect(seenHeader).to(equal(@"this-is-a-test"));
 	});
 
+	it(@"should decode an update sent as CBOR", ^{
+		__block NSString *seenAccept = nil;
+		OHHTTPStubs *stubs = [OHHTTPStubs shouldStubRequestsPassingTest:^(NSURLRequest *request) {
+			return [request.URL.absoluteString isEqualToString:@"http://fake/cbor"];
+		} withStubResponse:^(NSURLRequest *request) {
+			seenAccept = request.allHTTPHeaderFields[@"Accept"];
+
+			// Without a URL, the decoded update is rejected before anything
+			// is downloaded.
+			NSData *data = [SQRLCBORSerialization dataWithObject:@{ @"name": @"cbor-release" } error:NULL];
+			return [OHHTTPStubsResponse responseWithData:data statusCode:200 responseTime:0 headers:@{ @"Content-Type": SQRLCBORContentType }];
+		}];
+		[self addCleanupBlock:^{ [OHHTTPStubs removeRequestHandler:stubs]; }];
+
+		NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/cbor"]];
+		SQRLUpdater *updater = [[SQRLUpdater alloc] initWithUpdateRequest:request];
+
+		NSError *error = nil;
+		BOOL result = [[updater.checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:&error];
+
+		expect(@(result)).to(beFalsy());
+		expect(@(error.code)).to(equal(@(SQRLUpdaterErrorInvalidJSON)));
+		expect(error.userInfo[SQRLUpdaterJSONObjectErrorKey]).to(equal(@{ @"name": @"cbor-release" }));
+		expect((BOOL)updateFromJSONDataIsCalled).to(beFalse());
+		expect(seenAccept).to(beginWith(SQRLCBORContentType));
+	});
+
+	it(@"should skip updates that haven't been rolled out to this install", ^{
+		OHHTTPStubs *stubs = [OHHTTPStubs shouldStubRequestsPassingTest:^(NSURLRequest *request) {
+			return [request.URL.absoluteString isEqualToString:@"http://fake/rollout"];
+		} withStubResponse:^(NSURLRequest *request) {
+			// Decoded as CBOR, so that updateFromJSONData: isn't stubbed out.
+			NSDictionary *update = @{ @"version": @"9.9.9", @"url": @"http://fake/unreachable.zip", @"rolloutPercentage": @0 };
+			NSData *data = [SQRLCBORSerialization dataWithObject:update error:NULL];
+			return [OHHTTPStubsResponse responseWithData:data statusCode:200 responseTime:0 headers:@{ @"Content-Type": SQRLCBORContentType }];
+		}];
+		[self addCleanupBlock:^{ [OHHTTPStubs removeRequestHandler:stubs]; }];
+
+		NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/rollout"]];
+		SQRLUpdater *updater = [[SQRLUpdater alloc] initWithUpdateRequest:request];
+
+		NSError *error = nil;
+		BOOL result = [[updater.checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:&error];
+
+		expect(@(result)).to(beTruthy());
+		expect(error).to(beNil());
+		expect((int)updater.state).toEventually(equal((int)SQRLUpdaterStateIdle));
+	});
+
+	it(@"should send the prepared update instead of downloading the same release again", ^{
+		Method launchPrivileged = class_getClassMethod(SQRLShipItLauncher.class, @selector(launchPrivileged:));
+		IMP originalLaunchPrivileged = method_setImplementation(launchPrivileged, (IMP)launchPrivilegedImp);
+		launchPrivilegedStub = nil;
+
+		SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+		NSURL *shipItStateURL = [[directoryManager shipItStateURL] first];
+		NSURL *stagedUpdateURL = [[directoryManager stagedUpdateURL] first];
+
+		[self addCleanupBlock:^{
+			method_setImplementation(launchPrivileged, originalLaunchPrivileged);
+			[NSFileManager.defaultManager removeItemAtURL:shipItStateURL error:NULL];
+			[NSFileManager.defaultManager removeItemAtURL:stagedUpdateURL error:NULL];
+		}];
+
+		NSURL *bundleURL = [self createTestApplicationUpdate];
+		SQRLUpdate *update = [[SQRLUpdate alloc] initWithDictionary:@{
+			@"updateURL": [NSURL URLWithString:@"http://fake/staged.zip"],
+			@"releaseVersion": @"9.9.9",
+			@"updateSHA256": @"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+		} error:NULL];
+		SQRLDownloadedUpdate *stagedUpdate = [[SQRLDownloadedUpdate alloc] initWithUpdate:update bundle:[NSBundle bundleWithURL:bundleURL]];
+
+		SQRLShipItRequest *request = [[SQRLShipItRequest alloc] initWithUpdateBundleURL:bundleURL targetBundleURL:[self.temporaryDirectoryURL URLByAppendingPathComponent:@"Target.app"] bundleIdentifier:nil launchAfterInstallation:NO useUpdateBundleName:NO];
+		expect(@([[request writeUsingURL:[RACSignal return:shipItStateURL]] waitUntilCompleted:NULL])).to(beTruthy());
+		expect(@([[NSKeyedArchiver archivedDataWithRootObject:stagedUpdate] writeToURL:stagedUpdateURL atomically:YES])).to(beTruthy());
+
+		__block BOOL downloadRequested = NO;
+		OHHTTPStubs *stubs = [OHHTTPStubs shouldStubRequestsPassingTest:^(NSURLRequest *request) {
+			return [request.URL.host isEqualToString:@"fake"];
+		} withStubResponse:^(NSURLRequest *request) {
+			if ([request.URL.path isEqualToString:@"/staged.zip"]) {
+				downloadRequested = YES;
+				return [OHHTTPStubsResponse responseWithData:NSData.data statusCode:404 responseTime:0 headers:nil];
+			}
+
+			// The digest's case doesn't matter. Decoded as CBOR, so that
+			// updateFromJSONData: isn't stubbed out.
+			NSDictionary *JSON = @{ @"version": @"9.9.9", @"sha256": @"E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855", @"url": @"http://fake/staged.zip" };
+			NSData *data = [SQRLCBORSerialization dataWithObject:JSON error:NULL];
+			return [OHHTTPStubsResponse responseWithData:data statusCode:200 responseTime:0 headers:@{ @"Content-Type": SQRLCBORContentType }];
+		}];
+		[self addCleanupBlock:^{ [OHHTTPStubs removeRequestHandler:stubs]; }];
+
+		NSURLRequest *updateRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/staged"]];
+		SQRLUpdater *updater = [[SQRLUpdater alloc] initWithUpdateRequest:updateRequest];
+
+		BOOL success = NO;
+		NSError *error = nil;
+		SQRLDownloadedUpdate *sentUpdate = [[updater.checkForUpdatesCommand execute:nil] asynchronousFirstOrDefault:nil success:&success error:&error];
+
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+		expect(sentUpdate.update.releaseVersion).to(equal(@"9.9.9"));
+		expect(sentUpdate.bundle.bundleURL.URLByResolvingSymlinksInPath).to(equal(bundleURL.URLByResolvingSymlinksInPath));
+		expect(@(downloadRequested)).to(beFalsy());
+		expect((int)updater.state).toEventually(equal((int)SQRLUpdaterStateAwaitingRelaunch));
+	});
+
+	it(@"should reject a downloaded update that doesn't match its digest", ^{
+		OHHTTPStubs *stubs = [OHHTTPStubs shouldStubRequestsPassingTest:^(NSURLRequest *request) {
+			return [request.URL.host isEqualToString:@"fake"];
+		} withStubResponse:^(NSURLRequest *request) {
+			if ([request.URL.path isEqualToString:@"/tampered.zip"]) {
+				NSData *data = [@"not the update" dataUsingEncoding:NSUTF8StringEncoding];
+				return [OHHTTPStubsResponse responseWithData:data statusCode:200 responseTime:0 headers:@{ @"ETag": @"tampered" }];
+			}
+
+			// Decoded as CBOR, so that updateFromJSONData: isn't stubbed out.
+			NSDictionary *JSON = @{ @"version": @"9.9.9", @"sha256": @"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", @"url": @"http://fake/tampered.zip" };
+			NSData *data = [SQRLCBORSerialization dataWithObject:JSON error:NULL];
+			return [OHHTTPStubsResponse responseWithData:data statusCode:200 responseTime:0 headers:@{ @"Content-Type": SQRLCBORContentType }];
+		}];
+		[self addCleanupBlock:^{ [OHHTTPStubs removeRequestHandler:stubs]; }];
+
+		NSURLRequest *updateRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/tampered"]];
+		SQRLUpdater *updater = [[SQRLUpdater alloc] initWithUpdateRequest:updateRequest];
+
+		NSError *error = nil;
+		BOOL success = [[updater.checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:&error];
+
+		expect(@(success)).to(beFalsy());
+		expect(error.domain).to(equal(SQRLUpdaterErrorDomain));
+		expect(@(error.code)).to(equal(@(SQRLUpdaterErrorUpdateDigestMismatch)));
+
+		// The tampered archive mustn't be skipped by the next check.
+		expect([updater valueForKey:@"etag"]).to(beNil());
+	});
+
 	describe(@"JSONFILE mode", ^{
 		OHHTTPStubsResponse * (^jsonResponse)(NSDictionary *) = ^(NSDictionary *body) {
 			NSData *data = [NSJSONSerialization dataWithJSONObject:body options:0 error:NULL];
@@ -268,6 +412,14 @@ describe(@"checkForUpdatesCommand", ^{
 			return [[SQRLUpdater alloc] initWithUpdateRequest:request forVersion:currentVersion];
 		};
 
+		beforeEach(^{
+			// Don't let validators saved by another example make the feed
+			// request conditional.
+			SQRLDirectoryManager *directoryManager = [[SQRLDirectoryManager alloc] initWithApplicationIdentifier:SQRLShipItLauncher.shipItJobLabel];
+			NSURL *validatorsURL = [directoryManager.releaseFeedValidatorsURL firstOrDefault:nil success:NULL error:NULL];
+			if (validatorsURL != nil) [NSFileManager.defaultManager removeItemAtURL:validatorsURL error:NULL];
+		});
+
 		it(@"should pick the matching release's updateTo when currentRelease is newer than the running version", ^{
 			NSDictionary *updateTo = @{
 				@"version": @"2.0.0",
@@ -367,6 +519,64 @@ describe(@"checkForUpdatesCommand", ^{
 			expect(updateFromJSONDataLastBody).to(equal(updateTo));
 		});
 
+		describe(@"conditional requests", ^{
+			__block NSMutableArray *ifNoneMatchValues;
+
+			beforeEach(^{
+				ifNoneMatchValues = [NSMutableArray array];
+
+				OHHTTPStubs *stubs = [OHHTTPStubs shouldStubRequestsPassingTest:^(NSURLRequest *request) {
+					return [request.URL.absoluteString isEqualToString:@"http://fake/releases.json"];
+				} withStubResponse:^(NSURLRequest *request) {
+					NSString *ifNoneMatch = [request valueForHTTPHeaderField:@"If-None-Match"];
+					@synchronized (ifNoneMatchValues) {
+						[ifNoneMatchValues addObject:ifNoneMatch ?: NSNull.null];
+					}
+
+					if ([ifNoneMatch isEqual:@"\"feed-1\""]) {
+						return [OHHTTPStubsResponse responseWithData:[NSData data] statusCode:304 responseTime:0 headers:nil];
+					}
+
+					NSData *data = [NSJSONSerialization dataWithJSONObject:@{
+						@"currentRelease": @"1.0.0",
+						@"releases": @[
+							@{ @"version": @"1.0.0", @"updateTo": @{ @"version": @"1.0.0", @"url": @"http://fake/app-1.0.0.zip" } },
+						],
+					} options:0 error:NULL];
+
+					return [OHHTTPStubsResponse responseWithData:data statusCode:200 responseTime:0 headers:@{ @"ETag": @"\"feed-1\"" }];
+				}];
+
+				[self addCleanupBlock:^{ [OHHTTPStubs removeRequestHandler:stubs]; }];
+			});
+
+			it(@"should treat an unchanged feed as no update once the running version is up to date", ^{
+				SQRLUpdater *updater = makeUpdater(@"1.0.0");
+
+				NSError *error = nil;
+				expect(@([[updater.checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+				expect(error).to(beNil());
+
+				expect(@([[updater.checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:&error])).to(beTruthy());
+				expect(error).to(beNil());
+
+				expect(ifNoneMatchValues).to(equal(@[ NSNull.null, @"\"feed-1\"" ]));
+				expect((BOOL)updateFromJSONDataIsCalled).to(beFalse());
+			});
+
+			it(@"should not use validators for another version, or after finding an update", ^{
+				expect(@([[makeUpdater(@"1.0.0").checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+
+				// An older version has an update in the same feed.
+				expect(@([[makeUpdater(@"0.9.0").checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+				expect((BOOL)updateFromJSONDataIsCalled).to(beTrue());
+
+				expect(@([[makeUpdater(@"1.0.0").checkForUpdatesCommand execute:nil] asynchronouslyWaitUntilCompleted:NULL])).to(beTruthy());
+
+				expect(ifNoneMatchValues).to(equal(@[ NSNull.null, NSNull.null, NSNull.null ]));
+			});
+		});
+
 		it(@"should error when the JSON file is invalid", ^{
 			OHHTTPStubs *stubs = [OHHTTPStubs shouldStubRequestsPassingTest:^(NSURLRequest *request) {
 				return [request.URL.absoluteString isEqualToString:@"http://fake/releases.json"];
@@ -414,6 +624,63 @@ describe(@"updating", ^{
 		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
 	});
 
+	it(@"should relaunch the updated application and report the update downtime", ^{
+		SKIP_IF_RUNNING_ON_TRAVIS
+
+		SQRLTestUpdate *update = [SQRLTestUpdate modelWithDictionary:@{
+			@"updateURL": zipUpdate(updateURL),
+			@"final": @YES
+		} error:NULL];
+
+		writeUpdate(update);
+
+		__block NSNumber *relaunchingTimestamp = nil;
+		__block NSNumber *readyTimestamp = nil;
+
+		RACDisposable *relaunchingDisposable = [[NSDistributedNotificationCenter.defaultCenter
+			rac_addObserverForName:SQRLTestAppRelaunchingNotificationName object:nil]
+			subscribeNext:^(NSNotification *notification) {
+				relaunchingTimestamp = notification.userInfo[SQRLTestAppTimestampKey];
+			}];
+
+		RACDisposable *readyDisposable = [[[NSDistributedNotificationCenter.defaultCenter
+			rac_addObserverForName:SQRLTestAppReadyNotificationName object:nil]
+			filter:^(NSNotification *notification) {
+				return [notification.userInfo[SQRLTestAppVersionKey] isEqual:SQRLTestApplicationUpdatedShortVersionString];
+			}]
+			subscribeNext:^(NSNotification *notification) {
+				readyTimestamp = notification.userInfo[SQRLTestAppTimestampKey];
+			}];
+
+		[self addCleanupBlock:^{
+			[relaunchingDisposable dispose];
+			[readyDisposable dispose];
+
+			for (NSRunningApplication *app in [NSRunningApplication runningApplicationsWithBundleIdentifier:@"com.github.Squirrel.TestApplication"]) {
+				[app forceTerminate];
+			}
+		}];
+
+		NSRunningApplication *app = launchWithEnvironment(@{ @"SQRLRelaunchToInstall": @"1" });
+		expect(@(app.terminated)).withTimeout(SQRLLongTimeout).toEventually(beTruthy());
+		expect(readyTimestamp).withTimeout(SQRLLongTimeout).toEventuallyNot(beNil());
+		expect(relaunchingTimestamp).notTo(beNil());
+
+		// Both timestamps come from the application itself, so notification
+		// delivery isn't counted.
+		NSTimeInterval downtime = readyTimestamp.doubleValue - relaunchingTimestamp.doubleValue;
+		NSLog(@"Update downtime: %.0fms", downtime * 1000);
+		expect(@(downtime)).to(beGreaterThan(@0));
+
+		// Lets CI enforce the downtime objective.
+		NSString *budgetString = NSProcessInfo.processInfo.environment[@"SQRL_UPDATE_DOWNTIME_BUDGET_MS"];
+		if (budgetString != nil) {
+			expect(@(downtime * 1000)).to(beLessThanOrEqualTo(@(budgetString.doubleValue)));
+		}
+
+		expect(self.testApplicationBundleVersion).to(equal(SQRLTestApplicationUpdatedShortVersionString));
+	});
+
 	it(@"should not install a corrupt update", ^{
 		SKIP_IF_RUNNING_ON_TRAVIS
 
@@ -774,6 +1041,11 @@ describe(@"isVersionStandard", ^{
 		expect(@(isVersionStandard(@"100.0.1"))).to(beTruthy());
 	});
 
+	it(@"should accept version strings with leading zeroes", ^{
+		expect(@(isVersionStandard(@"01.2.3"))).to(beTruthy());
+		expect(@(isVersionStandard(@"1.02.003"))).to(beTruthy());
+	});
+
 	it(@"should reject version strings without exactly three parts", ^{
 		expect(@(isVersionStandard(@"1.2"))).to(beFalsy());
 		expect(@(isVersionStandard(@"1.2.3.4"))).to(beFalsy());
@@ -795,6 +1067,52 @@ describe(@"isVersionStandard", ^{
 	});
 });
 
+describe(@"-enforceStorageQuota", ^{
+	it(@"should never evict an update that's still being downloaded", ^{
+		SQRLUpdater *updater = [[SQRLUpdater alloc] initWithUpdateRequest:[NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/quota"]]];
+		updater.maximumStorageSize = 1;
+
+		NSURL *downloadDirectoryURL = [[updater uniqueTemporaryDirectoryForUpdate] asynchronousFirstOrDefault:nil success:NULL error:NULL];
+		expect(downloadDirectoryURL).notTo(beNil());
+		[self addCleanupBlock:^{
+			[NSFileManager.defaultManager removeItemAtURL:downloadDirectoryURL error:NULL];
+		}];
+
+		NSURL *archiveURL = [downloadDirectoryURL URLByAppendingPathComponent:@"TestApplication.zip"];
+		expect(@([[NSMutableData dataWithLength:1024] writeToURL:archiveURL atomically:NO])).to(beTruthy());
+
+		NSError *error = nil;
+		NSArray *evicted = [[[updater enforceStorageQuota] collect] asynchronousFirstOrDefault:nil success:NULL error:&error];
+		expect(error).to(beNil());
+		expect(evicted).notTo(contain(downloadDirectoryURL));
+		expect(@([NSFileManager.defaultManager fileExistsAtPath:archiveURL.path])).to(beTruthy());
+	});
+});
+
+describe(@"-leadCheck:withLease:", ^{
+	it(@"should keep renewing the lease while a check outlasts it", ^{
+		NSURL *lockURL = [self.temporaryDirectoryURL URLByAppendingPathComponent:@"UpdateCheck.lock"];
+
+		SQRLCheckLease *leader = [[SQRLCheckLease alloc] initWithURL:lockURL];
+		leader.duration = 0.3;
+		expect([[leader acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@YES));
+
+		SQRLCheckLease *follower = [[SQRLCheckLease alloc] initWithURL:lockURL];
+		follower.pollInterval = 0.05;
+		expect([[follower acquire] firstOrDefault:nil success:NULL error:NULL]).to(equal(@NO));
+
+		// The state never changes while this check runs.
+		SQRLUpdater *updater = [[SQRLUpdater alloc] initWithUpdateRequest:[NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/update-check"]]];
+		[[updater leadCheck:[[RACSignal empty] delay:1] withLease:leader] subscribeCompleted:^{}];
+
+		NSError *error = nil;
+		BOOL success = [[follower waitForLeader] asynchronouslyWaitUntilCompleted:&error];
+		expect(@(success)).to(beTruthy());
+		expect(error).to(beNil());
+		expect(follower.outcome).notTo(beNil());
+	});
+});
+
 describe(@"-initWithUpdateRequest:requestForDownload:", ^{
 	it(@"should use the provided requestForDownload block", ^{
 		NSURLRequest *updateRequest = [NSURLRequest requestWithURL:[NSURL URLWithString:@"http://fake/update-check"]];
@@ -823,6 +1141,19 @@ describe(@"+isVersionAllowedForUpdate:from:", ^{
 	it(@"should allow updating to the same version", ^{
 		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"1.2.3" from:@"1.2.3"])).to(beTruthy());
 	});
+
+	it(@"should compare versions with leading zeroes numerically", ^{
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"1.2.4" from:@"01.2.3"])).to(beTruthy());
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"01.2.3" from:@"1.2.3"])).to(beTruthy());
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"01.2.3" from:@"1.2.4"])).to(beFalsy());
+	});
+
+	it(@"should order prereleases by semantic version precedence", ^{
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"1.2.0-beta.10" from:@"1.2.0-beta.9"])).to(beTruthy());
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"1.2.0-beta.9" from:@"1.2.0-beta.10"])).to(beFalsy());
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"1.2.0" from:@"1.2.0-rc.1"])).to(beTruthy());
+		expect(@([SQRLUpdater isVersionAllowedForUpdate:@"1.2.0-rc.1" from:@"1.2.0"])).to(beFalsy());
+	});
 });
 
 QuickSpecEnd
@@ -20,3 +20,25 @@ extern NSString * const SQRLTestAppUpdaterStateTransitionNotificationName;
 
 // The state of the updater, an NSNumber.
 extern NSString * const SQRLTestAppUpdaterStateKey;
+
+// This notification is posted to the distributed notification center once the
+// application has finished launching.
+//
+// The user info dictionary includes the bundle's short version string under
+// the `SQRLTestAppVersionKey` key, and the time it was posted under the
+// `SQRLTestAppTimestampKey` key.
+extern NSString * const SQRLTestAppReadyNotificationName;
+
+// This notification is posted to the distributed notification center right
+// before the application calls `-[SQRLUpdater relaunchToInstallUpdate]`, when
+// launched with `SQRLRelaunchToInstall` set in its environment.
+//
+// The user info dictionary includes the time it was posted under the
+// `SQRLTestAppTimestampKey` key.
+extern NSString * const SQRLTestAppRelaunchingNotificationName;
+
+// The short version string of the application, an NSString.
+extern NSString * const SQRLTestAppVersionKey;
+
+// The `CFAbsoluteTime` at which a notification was posted, an NSNumber.
+extern NSString * const SQRLTestAppTimestampKey;
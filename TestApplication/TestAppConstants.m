@@ -11,3 +11,11 @@
 NSString * const SQRLTestAppUpdaterStateTransitionNotificationName = @"com.github.Squirrel.TestApplication.state-changed";
 
 NSString * const SQRLTestAppUpdaterStateKey = @"state";
+
+NSString * const SQRLTestAppReadyNotificationName = @"com.github.Squirrel.TestApplication.ready";
+
+NSString * const SQRLTestAppRelaunchingNotificationName = @"com.github.Squirrel.TestApplication.relaunching";
+
+NSString * const SQRLTestAppVersionKey = @"version";
+
+NSString * const SQRLTestAppTimestampKey = @"timestamp";
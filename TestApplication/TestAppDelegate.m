@@ -54,6 +54,9 @@
 		NSLog(@"Could not remove all preferences for %@: %@", directoryManager, error);
 	}
 
+	NSString *version = [NSBundle bundleWithIdentifier:@"com.github.Squirrel.TestApplication"].infoDictionary[@"CFBundleShortVersionString"];
+	[NSDistributedNotificationCenter.defaultCenter postNotificationName:SQRLTestAppReadyNotificationName object:nil userInfo:@{ SQRLTestAppVersionKey: version ?: @"", SQRLTestAppTimestampKey: @(CFAbsoluteTimeGetCurrent()) } deliverImmediately:YES];
+
 	NSString *updateURLString = NSProcessInfo.processInfo.environment[@"SQRLUpdateFromURL"];
 	if (updateURLString == nil) {
 		NSLog(@"Skipping update installation");
@@ -109,7 +112,17 @@
 			return (RACSignal *)[[RACSignal interval:delayString.doubleValue onScheduler:RACScheduler.mainThreadScheduler] take:1];
 		}]
 		subscribeCompleted:^{
-			[NSApp terminate:self];
+			if (NSProcessInfo.processInfo.environment[@"SQRLRelaunchToInstall"] == nil) {
+				[NSApp terminate:self];
+				return;
+			}
+
+			[NSDistributedNotificationCenter.defaultCenter postNotificationName:SQRLTestAppRelaunchingNotificationName object:nil userInfo:@{ SQRLTestAppTimestampKey: @(CFAbsoluteTimeGetCurrent()) } deliverImmediately:YES];
+
+			[[self.updater relaunchToInstallUpdate] subscribeError:^(NSError *error) {
+				NSLog(@"Error relaunching to install update: %@", error);
+				[NSApp terminate:self];
+			}];
 		}];
 }
 